@@ -28,6 +28,7 @@
 #include <EntityScriptingInterface.h> // TODO: consider moving to scriptengine.h
 
 #include "avatars/ScriptableAvatar.h"
+#include "ScriptHost.h"
 
 #include "Agent.h"
 
@@ -40,7 +41,8 @@ Agent::Agent(const QByteArray& packet) :
         InboundAudioStream::Settings(0, false, RECEIVED_AUDIO_STREAM_CAPACITY_FRAMES, false,
         DEFAULT_WINDOW_STARVE_THRESHOLD, DEFAULT_WINDOW_SECONDS_FOR_DESIRED_CALC_ON_TOO_MANY_STARVES,
         DEFAULT_WINDOW_SECONDS_FOR_DESIRED_REDUCTION, false)),
-    _avatarHashMap()
+    _avatarHashMap(),
+    _scriptHost(NULL)
 {
     // be the parent of the script engine so it gets moved when we do
     _scriptEngine.setParent(this);
@@ -48,6 +50,10 @@ Agent::Agent(const QByteArray& packet) :
     _scriptEngine.getEntityScriptingInterface()->setPacketSender(&_entityEditSender);
 }
 
+Agent::~Agent() {
+    delete _scriptHost;
+}
+
 void Agent::readPendingDatagrams() {
     QByteArray receivedPacket;
     HifiSockAddr senderSockAddr;
@@ -157,6 +163,11 @@ void Agent::run() {
                                                  << NodeType::EntityServer
                                                 );
     
+    QNetworkDiskCache* cache = new QNetworkDiskCache();
+    QString cachePath = QStandardPaths::writableLocation(QStandardPaths::DataLocation);
+    cache->setCacheDirectory(!cachePath.isEmpty() ? cachePath : "agentCache");
+    NetworkAccessManager::getInstance().setCache(cache);
+    
     // figure out the URL for the script for this agent assignment
     QUrl scriptURL;
     if (_payload.isEmpty())  {
@@ -165,28 +176,34 @@ void Agent::run() {
             .arg(DOMAIN_SERVER_HTTP_PORT)
             .arg(uuidStringWithoutCurlyBraces(_uuid)));
     } else {
-        scriptURL = QUrl(_payload);
+        // the payload can also list several scripts for us to host, one per line, each optionally preceded by how many
+        // instances of it to run
+        QList<QPair<int, QUrl> > scripts;
+        int numInstances = 0;
+        foreach (QString line, QString(_payload).split('\n', QString::SkipEmptyParts)) {
+            line = line.trimmed();
+            int separator = line.indexOf(' ');
+            bool hasCount = false;
+            int count = (separator > 0) ? line.left(separator).toInt(&hasCount) : 1;
+            if (hasCount) {
+                line = line.mid(separator + 1).trimmed();
+            } else {
+                count = 1;
+            }
+            if (line.isEmpty() || count < 1) {
+                continue;
+            }
+            scripts.append(QPair<int, QUrl>(count, QUrl(line)));
+            numInstances += count;
+        }
+        if (numInstances > 1) {
+            runHostedScripts(scripts);
+            return;
+        }
+        scriptURL = scripts.isEmpty() ? QUrl(_payload) : scripts.first().second;
     }
-   
-    QNetworkAccessManager& networkAccessManager = NetworkAccessManager::getInstance();
-    QNetworkReply *reply = networkAccessManager.get(QNetworkRequest(scriptURL));
-    
-    QNetworkDiskCache* cache = new QNetworkDiskCache();
-    QString cachePath = QStandardPaths::writableLocation(QStandardPaths::DataLocation);
-    cache->setCacheDirectory(!cachePath.isEmpty() ? cachePath : "agentCache");
-    networkAccessManager.setCache(cache);
-    
-    qDebug() << "Downloading script at" << scriptURL.toString();
-    
-    QEventLoop loop;
-    QObject::connect(reply, SIGNAL(finished()), &loop, SLOT(quit()));
-    
-    loop.exec();
-    
-    QString scriptContents(reply->readAll());
-    delete reply;
     
-    qDebug() << "Downloaded script:" << scriptContents;
+    QString scriptContents = downloadScript(scriptURL);
     
     // setup an Avatar for the script to use
     ScriptableAvatar scriptedAvatar(&_scriptEngine);
@@ -217,7 +234,80 @@ void Agent::run() {
     setFinished(true);
 }
 
+QString Agent::downloadScript(const QUrl& scriptURL) {
+    QNetworkReply *reply = NetworkAccessManager::getInstance().get(QNetworkRequest(scriptURL));
+    
+    qDebug() << "Downloading script at" << scriptURL.toString();
+    
+    QEventLoop loop;
+    QObject::connect(reply, SIGNAL(finished()), &loop, SLOT(quit()));
+    
+    loop.exec();
+    
+    QString scriptContents(reply->readAll());
+    delete reply;
+    
+    qDebug() << "Downloaded script:" << scriptContents;
+    return scriptContents;
+}
+
+void Agent::runHostedScripts(const QList<QPair<int, QUrl> >& scripts) {
+    _scriptEngine.init(); // must be done before we set up the viewers
+    
+    // the hosted scripts share our entity tree through the Entities object, but not the avatar list, which only we can
+    // touch. Each has its own EntityViewer, whose view our viewer takes in turn for its queries
+    _entityViewer.setJurisdictionListener(_scriptEngine.getEntityScriptingInterface()->getJurisdictionListener());
+    _entityViewer.init();
+    _scriptEngine.getEntityScriptingInterface()->setEntityTree(_entityViewer.getTree());
+    
+    _scriptHost = new ScriptHost(this, QThread::idealThreadCount());
+    connect(_scriptHost, &ScriptHost::allScriptsFinished, this, &Agent::hostedScriptsFinished);
+    
+    for (int i = 0; i < scripts.size(); i++) {
+        const QUrl& scriptURL = scripts.at(i).second;
+        QString scriptContents = downloadScript(scriptURL);
+        for (int j = 0; j < scripts.at(i).first; j++) {
+            HostedScript* script = new HostedScript(*_scriptHost, scriptContents, scriptURL.toString());
+            if (j == 0) {
+                // wait for the script's includes here rather than on the host's threads, where other scripts are running
+                script->getScriptEngine()->loadIncludes();
+            }
+            _scriptHost->addScript(script);
+        }
+    }
+    
+    // the scripts' entity edits are sent from here, once per frame for all of them
+    QTimer* entityEditTimer = new QTimer(this);
+    connect(entityEditTimer, &QTimer::timeout, this, &Agent::releaseEntityEditPackets);
+    entityEditTimer->start(SCRIPT_DATA_CALLBACK_USECS / USECS_PER_MSEC);
+
+    queryHostedEntityViews();
+}
+
+void Agent::queryHostedEntityViews() {
+    if (!_scriptHost) {
+        return;
+    }
+    if (_scriptHost->copyNextEntityView(_entityViewer)) {
+        _entityViewer.queryOctree();
+    }
+
+    // the more scripts there are the sooner the next, so that each script's view is queried for in good time
+    QTimer::singleShot(_scriptHost->getEntityQueryIntervalMsecs(), this, SLOT(queryHostedEntityViews()));
+}
+
+void Agent::hostedScriptsFinished() {
+    if (!_isFinished) {
+        setFinished(true);
+    }
+}
+
 void Agent::aboutToFinish() {
-    _scriptEngine.stop();
+    if (_scriptHost) {
+        delete _scriptHost;
+        _scriptHost = NULL;
+    } else {
+        _scriptEngine.stop();
+    }
     NetworkAccessManager::getInstance().clearAccessCache();
 }
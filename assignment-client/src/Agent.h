@@ -27,6 +27,7 @@
 
 #include "MixedAudioStream.h"
 
+class ScriptHost;
 
 class Agent : public ThreadedAssignment {
     Q_OBJECT
@@ -37,6 +38,7 @@ class Agent : public ThreadedAssignment {
     Q_PROPERTY(float lastReceivedAudioLoudness READ getLastReceivedAudioLoudness)
 public:
     Agent(const QByteArray& packet);
+    ~Agent();
     
     void setIsAvatar(bool isAvatar) { QMetaObject::invokeMethod(&_scriptEngine, "setIsAvatar", Q_ARG(bool, isAvatar)); }
     bool isAvatar() const { return _scriptEngine.isAvatar(); }
@@ -56,8 +58,17 @@ public slots:
     void readPendingDatagrams();
     void playAvatarSound(Sound* avatarSound) { _scriptEngine.setAvatarSound(avatarSound); }
 
+private slots:
+    void releaseEntityEditPackets() { ScriptEngine::releaseEntityEditPackets(); }
+    void hostedScriptsFinished();
+    void queryHostedEntityViews();
+
 private:
+    QString downloadScript(const QUrl& scriptURL);
+    void runHostedScripts(const QList<QPair<int, QUrl> >& scripts);
+
     ScriptEngine _scriptEngine;
+    ScriptHost* _scriptHost;
     EntityEditPacketSender _entityEditSender;
     EntityTreeHeadlessViewer _entityViewer;
     
@@ -0,0 +1,471 @@
+//
+//  ScriptHost.cpp
+//  assignment-client/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+
+#include <QtCore/QDebug>
+
+#include <NodeList.h>
+#include <OctreeHeadlessViewer.h>
+#include <PacketHeaders.h>
+#include <SharedUtil.h>
+#include <SoundCache.h>
+
+#include "avatars/ScriptableAvatar.h"
+#include "Agent.h"
+
+#include "ScriptHost.h"
+
+static int hostedScriptPointerTypeId = qRegisterMetaType<HostedScript*>();
+
+// the weight of the latest frame in a script's average frame time
+const float FRAME_USECS_SMOOTHING = 0.1f;
+
+HostedEntityViewer::HostedEntityViewer(ScriptHost& host) :
+    _host(host),
+    _position(0.0f),
+    _orientation(),
+    _voxelSizeScale(DEFAULT_OCTREE_SIZE_SCALE),
+    _boundaryLevelAdjust(0),
+    _maxPacketsPerSecond(DEFAULT_MAX_OCTREE_PPS)
+{
+    _host.addEntityViewer(this);
+}
+
+HostedEntityViewer::~HostedEntityViewer() {
+    _host.removeEntityViewer(this);
+}
+
+void HostedEntityViewer::copyViewTo(OctreeHeadlessViewer& viewer) const {
+    QMutexLocker locker(&_mutex);
+    viewer.setPosition(_position);
+    viewer.setOrientation(_orientation);
+    viewer.setVoxelSizeScale(_voxelSizeScale);
+    viewer.setBoundaryLevelAdjust(_boundaryLevelAdjust);
+    viewer.setMaxPacketsPerSecond(_maxPacketsPerSecond);
+}
+
+void HostedEntityViewer::queryOctree() {
+    _host.requestEntityQuery(this);
+}
+
+void HostedEntityViewer::setPosition(const glm::vec3& position) {
+    QMutexLocker locker(&_mutex);
+    _position = position;
+}
+
+void HostedEntityViewer::setOrientation(const glm::quat& orientation) {
+    QMutexLocker locker(&_mutex);
+    _orientation = orientation;
+}
+
+void HostedEntityViewer::setVoxelSizeScale(float sizeScale) {
+    QMutexLocker locker(&_mutex);
+    _voxelSizeScale = sizeScale;
+}
+
+void HostedEntityViewer::setBoundaryLevelAdjust(int boundaryLevelAdjust) {
+    QMutexLocker locker(&_mutex);
+    _boundaryLevelAdjust = boundaryLevelAdjust;
+}
+
+void HostedEntityViewer::setMaxPacketsPerSecond(int maxPacketsPerSecond) {
+    QMutexLocker locker(&_mutex);
+    _maxPacketsPerSecond = maxPacketsPerSecond;
+}
+
+glm::vec3 HostedEntityViewer::getPosition() const {
+    QMutexLocker locker(&_mutex);
+    return _position;
+}
+
+glm::quat HostedEntityViewer::getOrientation() const {
+    QMutexLocker locker(&_mutex);
+    return _orientation;
+}
+
+float HostedEntityViewer::getVoxelSizeScale() const {
+    QMutexLocker locker(&_mutex);
+    return _voxelSizeScale;
+}
+
+int HostedEntityViewer::getBoundaryLevelAdjust() const {
+    QMutexLocker locker(&_mutex);
+    return _boundaryLevelAdjust;
+}
+
+int HostedEntityViewer::getMaxPacketsPerSecond() const {
+    QMutexLocker locker(&_mutex);
+    return _maxPacketsPerSecond;
+}
+
+HostedScript::HostedScript(ScriptHost& host, const QString& scriptContents, const QString& fileName) :
+    _host(host),
+    _scriptEngine(new ScriptEngine(scriptContents, fileName)),
+    _avatar(NULL),
+    _entityViewer(NULL),
+    _frameDeadline(0),
+    _averageFrameUsecs(0.0f)
+{
+    // the engine, the avatar and the viewer are our children so that they go with us to whichever thread runs us
+    _scriptEngine->setParent(this);
+
+    // setup an Avatar for the script to use, which the avatar mixer tells apart from those of our other scripts by its
+    // session UUID - a key only we and the mixer use, which the mixer swaps for a UUID of its own making for everyone else
+    _avatar = new ScriptableAvatar(_scriptEngine);
+    _avatar->setParent(this);
+    _avatar->setForceFaceshiftConnected(true);
+    _avatar->setSessionUUID(QUuid::createUuid());
+    _scriptEngine->setIsHostedAvatar(true);
+
+    // call model URL setters with empty URLs so our avatar, if user, will have the default models
+    _avatar->setFaceModelURL(QUrl());
+    _avatar->setSkeletonModelURL(QUrl());
+
+    _scriptEngine->setAvatarData(_avatar, "Avatar");
+    _scriptEngine->registerGlobalObject("Agent", this);
+
+    _entityViewer = new HostedEntityViewer(_host);
+    _entityViewer->setParent(this);
+
+    _scriptEngine->init();
+
+    _scriptEngine->registerGlobalObject("SoundCache", &SoundCache::getInstance());
+    _scriptEngine->registerGlobalObject("EntityViewer", _entityViewer);
+}
+
+HostedScript::~HostedScript() {
+    if (_scriptEngine->isAvatar()) {
+        sendKillAvatar();
+    }
+}
+
+void HostedScript::setIsAvatar(bool isAvatar) {
+    if (!isAvatar && _scriptEngine->isAvatar()) {
+        sendKillAvatar();
+    }
+    _scriptEngine->setIsAvatar(isAvatar);
+}
+
+void HostedScript::setIsListeningToAudioStream(bool isListeningToAudioStream) {
+    if (isListeningToAudioStream) {
+        if (!_host.claimAudio(this)) {
+            qDebug() << "Another hosted script is already sending audio, ignoring Agent.isListeningToAudioStream.";
+            return;
+        }
+    } else if (!_scriptEngine->isPlayingAvatarSound()) {
+        _host.releaseAudio(this);
+    }
+    _scriptEngine->setIsListeningToAudioStream(isListeningToAudioStream);
+}
+
+void HostedScript::playAvatarSound(Sound* avatarSound) {
+    if (avatarSound) {
+        if (!_host.claimAudio(this)) {
+            qDebug() << "Another hosted script is already sending audio, ignoring Agent.playAvatarSound.";
+            return;
+        }
+    } else if (!_scriptEngine->isListeningToAudioStream()) {
+        _host.releaseAudio(this);
+    }
+    _scriptEngine->setAvatarSound(avatarSound);
+}
+
+void HostedScript::sendKillAvatar() {
+    QByteArray killPacket = byteArrayWithPopulatedHeader(PacketTypeKillAvatar);
+    killPacket.append(_avatar->getSessionUUID().toRfc4122());
+    NodeList::getInstance()->broadcastToNodes(killPacket, NodeSet() << NodeType::AvatarMixer);
+}
+
+float HostedScript::getLastReceivedAudioLoudness() const {
+    return _host.getAgent()->getLastReceivedAudioLoudness();
+}
+
+void HostedScript::addFrameUsecs(quint64 frameUsecs) {
+    _averageFrameUsecs += ((float)frameUsecs - _averageFrameUsecs) * FRAME_USECS_SMOOTHING;
+}
+
+static bool hasEarlierFrameDeadline(const HostedScript* a, const HostedScript* b) {
+    return a->getFrameDeadline() < b->getFrameDeadline();
+}
+
+ScriptHostWorker::ScriptHostWorker(ScriptHost& host) :
+    _host(host),
+    _scripts(),
+    _frameTimer(new QTimer(this)),
+    _nextRebalance(0)
+{
+    _frameTimer->setSingleShot(true);
+    _frameTimer->setTimerType(Qt::PreciseTimer);
+    connect(_frameTimer, &QTimer::timeout, this, &ScriptHostWorker::runDueFrames);
+}
+
+void ScriptHostWorker::addScript(HostedScript* script) {
+    ScriptEngine* scriptEngine = script->getScriptEngine();
+    if (!scriptEngine->isRunning()) {
+        scriptEngine->startRunning();
+        script->setFrameDeadline(usecTimestampNow());
+    }
+    _scripts.append(script);
+    scheduleNextFrame();
+}
+
+void ScriptHostWorker::stopScripts() {
+    _frameTimer->stop();
+    foreach (HostedScript* script, _scripts) {
+        script->getScriptEngine()->stop();
+        finishScript(script);
+    }
+    _scripts.clear();
+}
+
+void ScriptHostWorker::runDueFrames() {
+    std::sort(_scripts.begin(), _scripts.end(), hasEarlierFrameDeadline);
+
+    // the avatar and audio packets of all of our scripts go out together. The batch is this thread's own, and the
+    // LimitedNodeList serializes the socket writes of every thread's flush with its direct sends
+    NodeList* nodeList = NodeList::getInstance();
+    nodeList->beginDatagramBatch();
+
+    for (int i = 0; i < _scripts.size(); ) {
+        HostedScript* script = _scripts.at(i);
+        ScriptEngine* scriptEngine = script->getScriptEngine();
+        if (scriptEngine->isFinished()) {
+            _scripts.remove(i);
+            finishScript(script);
+            continue;
+        }
+        i++;
+
+        quint64 frameStart = usecTimestampNow();
+        if (script->getFrameDeadline() > frameStart) {
+            break; // the rest are due later still
+        }
+        scriptEngine->runFrame();
+        quint64 frameEnd = usecTimestampNow();
+        script->addFrameUsecs(frameEnd - frameStart);
+
+        // a script that fell a whole frame behind goes on from here instead of bursting to catch up
+        quint64 nextDeadline = script->getFrameDeadline() + SCRIPT_DATA_CALLBACK_USECS;
+        script->setFrameDeadline(std::max(nextDeadline, frameEnd));
+    }
+
+    nodeList->flushDatagramBatch();
+
+    quint64 now = usecTimestampNow();
+    if (now >= _nextRebalance) {
+        _nextRebalance = now + SCRIPT_HOST_REBALANCE_INTERVAL_USECS;
+
+        ScriptHostWorker* targetWorker = NULL;
+        HostedScript* script = _host.rebalance(this, _scripts, targetWorker);
+        if (script) {
+            // the script's timers and pending replies go with it
+            _scripts.remove(_scripts.indexOf(script));
+            script->moveToThread(targetWorker->thread());
+            QMetaObject::invokeMethod(targetWorker, "addScript", Q_ARG(HostedScript*, script));
+        }
+    }
+
+    scheduleNextFrame();
+}
+
+void ScriptHostWorker::finishScript(HostedScript* script) {
+    script->getScriptEngine()->finishRunning();
+    _host.scriptFinished(this, script);
+    delete script;
+}
+
+void ScriptHostWorker::scheduleNextFrame() {
+    if (_scripts.isEmpty()) {
+        _frameTimer->stop();
+        return;
+    }
+    quint64 earliestDeadline = (*std::min_element(_scripts.constBegin(), _scripts.constEnd(),
+        hasEarlierFrameDeadline))->getFrameDeadline();
+    quint64 now = usecTimestampNow();
+
+    // round up so that we don't wake just short of the deadline and spin
+    int msecsToWait = (earliestDeadline > now) ? (earliestDeadline - now + USECS_PER_MSEC - 1) / USECS_PER_MSEC : 0;
+    _frameTimer->start(msecsToWait);
+}
+
+ScriptHost::ScriptHost(Agent* agent, int numThreads) :
+    _agent(agent),
+    _numScripts(0),
+    _audioScript(NULL),
+    _numEntityQueryRequests(0)
+{
+    if (numThreads < 1) {
+        numThreads = std::max(1, QThread::idealThreadCount());
+    }
+
+    qDebug() << "Hosting scripts on" << numThreads << "threads.";
+
+    for (int i = 0; i < numThreads; i++) {
+        QThread* thread = new QThread();
+        ScriptHostWorker* worker = new ScriptHostWorker(*this);
+        worker->moveToThread(thread);
+        thread->start();
+
+        _threads.append(thread);
+        _workers.append(worker);
+        _workerUsecs.append(0.0f);
+        _workerNumScripts.append(0);
+    }
+}
+
+ScriptHost::~ScriptHost() {
+    foreach (ScriptHostWorker* worker, _workers) {
+        QMetaObject::invokeMethod(worker, "stopScripts", Qt::BlockingQueuedConnection);
+    }
+    for (int i = 0; i < _threads.size(); i++) {
+        _threads.at(i)->quit();
+        _threads.at(i)->wait();
+        delete _workers.at(i);
+        delete _threads.at(i);
+    }
+}
+
+void ScriptHost::addScript(HostedScript* script) {
+    int index;
+    {
+        QMutexLocker locker(&_scheduleMutex);
+        index = findLeastBusyWorker();
+        _workerNumScripts[index]++;
+        _numScripts++;
+    }
+    script->moveToThread(_threads.at(index));
+    QMetaObject::invokeMethod(_workers.at(index), "addScript", Q_ARG(HostedScript*, script));
+}
+
+bool ScriptHost::claimAudio(HostedScript* script) {
+    QMutexLocker locker(&_scheduleMutex);
+    if (_audioScript && _audioScript != script) {
+        return false;
+    }
+    _audioScript = script;
+    return true;
+}
+
+void ScriptHost::releaseAudio(HostedScript* script) {
+    QMutexLocker locker(&_scheduleMutex);
+    if (_audioScript == script) {
+        _audioScript = NULL;
+    }
+}
+
+void ScriptHost::addEntityViewer(HostedEntityViewer* entityViewer) {
+    QMutexLocker locker(&_scheduleMutex);
+    _entityViewers.append(entityViewer);
+}
+
+void ScriptHost::removeEntityViewer(HostedEntityViewer* entityViewer) {
+    QMutexLocker locker(&_scheduleMutex);
+    _entityViewers.removeOne(entityViewer);
+    _entityQueryTurns.removeOne(entityViewer);
+    _numEntityQueryRequests = std::min(_numEntityQueryRequests, _entityQueryTurns.size());
+}
+
+void ScriptHost::requestEntityQuery(HostedEntityViewer* entityViewer) {
+    QMutexLocker locker(&_scheduleMutex);
+
+    // a viewer that asks goes ahead of those that didn't, but only within the round, so that viewers that ask all the
+    // time can't keep the others from their turns
+    int index = _entityQueryTurns.indexOf(entityViewer);
+    if (index >= _numEntityQueryRequests) {
+        _entityQueryTurns.move(index, _numEntityQueryRequests++);
+    }
+}
+
+bool ScriptHost::copyNextEntityView(OctreeHeadlessViewer& viewer) {
+    QMutexLocker locker(&_scheduleMutex);
+    if (_entityQueryTurns.isEmpty()) {
+        _entityQueryTurns = _entityViewers;
+        if (_entityQueryTurns.isEmpty()) {
+            return false;
+        }
+    }
+    _numEntityQueryRequests = std::max(0, _numEntityQueryRequests - 1);
+    _entityQueryTurns.takeFirst()->copyViewTo(viewer);
+    return true;
+}
+
+int ScriptHost::getEntityQueryIntervalMsecs() {
+    QMutexLocker locker(&_scheduleMutex);
+    return std::max(SCRIPT_HOST_MIN_ENTITY_QUERY_INTERVAL_MSECS,
+                    SCRIPT_HOST_MAX_ENTITY_VIEW_AGE_MSECS / std::max(1, _entityViewers.size()));
+}
+
+HostedScript* ScriptHost::rebalance(ScriptHostWorker* worker, const QVector<HostedScript*>& scripts,
+                                    ScriptHostWorker*& targetWorker) {
+    float workerUsecs = 0.0f;
+    foreach (HostedScript* script, scripts) {
+        workerUsecs += script->getAverageFrameUsecs();
+    }
+
+    QMutexLocker locker(&_scheduleMutex);
+    int index = _workers.indexOf(worker);
+    _workerUsecs[index] = workerUsecs;
+    if (workerUsecs <= SCRIPT_HOST_THREAD_BUDGET_USECS || scripts.size() < 2) {
+        return NULL;
+    }
+    int targetIndex = findLeastBusyWorker();
+    if (targetIndex == index) {
+        return NULL;
+    }
+
+    // hand off the busiest script that fits, so a script too slow to fit anywhere is left with the thread to itself
+    HostedScript* scriptToMove = NULL;
+    foreach (HostedScript* script, scripts) {
+        float scriptUsecs = script->getAverageFrameUsecs();
+        if (_workerUsecs.at(targetIndex) + scriptUsecs <= SCRIPT_HOST_THREAD_BUDGET_USECS &&
+                (!scriptToMove || scriptUsecs > scriptToMove->getAverageFrameUsecs())) {
+            scriptToMove = script;
+        }
+    }
+    if (scriptToMove) {
+        float scriptUsecs = scriptToMove->getAverageFrameUsecs();
+        _workerUsecs[index] -= scriptUsecs;
+        _workerUsecs[targetIndex] += scriptUsecs;
+        _workerNumScripts[index]--;
+        _workerNumScripts[targetIndex]++;
+        targetWorker = _workers.at(targetIndex);
+    }
+    return scriptToMove;
+}
+
+void ScriptHost::scriptFinished(ScriptHostWorker* worker, HostedScript* script) {
+    bool allFinished;
+    {
+        QMutexLocker locker(&_scheduleMutex);
+        int index = _workers.indexOf(worker);
+        _workerUsecs[index] = std::max(0.0f, _workerUsecs.at(index) - script->getAverageFrameUsecs());
+        _workerNumScripts[index]--;
+        if (_audioScript == script) {
+            _audioScript = NULL;
+        }
+        allFinished = (--_numScripts == 0);
+    }
+    if (allFinished) {
+        emit allScriptsFinished();
+    }
+}
+
+int ScriptHost::findLeastBusyWorker() const {
+    int leastBusy = 0;
+    for (int i = 1; i < _workers.size(); i++) {
+        if (_workerUsecs.at(i) < _workerUsecs.at(leastBusy) || (_workerUsecs.at(i) == _workerUsecs.at(leastBusy) &&
+                _workerNumScripts.at(i) < _workerNumScripts.at(leastBusy))) {
+            leastBusy = i;
+        }
+    }
+    return leastBusy;
+}
@@ -0,0 +1,233 @@
+//
+//  ScriptHost.h
+//  assignment-client/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_ScriptHost_h
+#define hifi_ScriptHost_h
+
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+#include <QtCore/QVector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <ScriptEngine.h>
+
+class Agent;
+class OctreeHeadlessViewer;
+class ScriptableAvatar;
+class ScriptHost;
+class Sound;
+
+// a thread whose scripts' frames together take longer than this hands one of its scripts to a less busy thread
+const quint64 SCRIPT_HOST_THREAD_BUDGET_USECS = SCRIPT_DATA_CALLBACK_USECS * 3 / 4;
+
+// how often each thread checks whether it should hand off a script
+const quint64 SCRIPT_HOST_REBALANCE_INTERVAL_USECS = USECS_PER_SECOND;
+
+// how old the entities in a hosted script's view may get, as long as there are few enough scripts to query for them all
+// in that time
+const int SCRIPT_HOST_MAX_ENTITY_VIEW_AGE_MSECS = 1000;
+
+// how often at most the agent changes the view it queries with, since with each change the entity server sends all that
+// the new view sees and the last one didn't
+const int SCRIPT_HOST_MIN_ENTITY_QUERY_INTERVAL_MSECS = 50;
+
+/// The EntityViewer of a hosted script. The entity server knows the host as a single node with a single view, so
+/// rather than querying for itself the viewer asks the agent to query with its view, which the agent does for each
+/// script's viewer in turn. Every viewer has one turn a round, and the rounds are spread over
+/// SCRIPT_HOST_MAX_ENTITY_VIEW_AGE_MSECS - so the entities a script sees are at most that old, or with more than
+/// SCRIPT_HOST_MAX_ENTITY_VIEW_AGE_MSECS / SCRIPT_HOST_MIN_ENTITY_QUERY_INTERVAL_MSECS scripts, the number of scripts
+/// times SCRIPT_HOST_MIN_ENTITY_QUERY_INTERVAL_MSECS. The entities all go into the one tree the scripts share through
+/// Entities.
+class HostedEntityViewer : public QObject {
+    Q_OBJECT
+public:
+    HostedEntityViewer(ScriptHost& host);
+    ~HostedEntityViewer();
+
+    /// copies this view into the agent's viewer, for its next query
+    void copyViewTo(OctreeHeadlessViewer& viewer) const;
+
+public slots:
+    /// asks for the next of the agent's queries to be made with this view, if it hasn't had its turn this round
+    void queryOctree();
+
+    // setters for camera attributes
+    void setPosition(const glm::vec3& position);
+    void setOrientation(const glm::quat& orientation);
+
+    // setters for LOD and PPS
+    void setVoxelSizeScale(float sizeScale);
+    void setBoundaryLevelAdjust(int boundaryLevelAdjust);
+    void setMaxPacketsPerSecond(int maxPacketsPerSecond);
+
+    // getters for camera attributes
+    glm::vec3 getPosition() const;
+    glm::quat getOrientation() const;
+
+    // getters for LOD and PPS
+    float getVoxelSizeScale() const;
+    int getBoundaryLevelAdjust() const;
+    int getMaxPacketsPerSecond() const;
+
+private:
+    ScriptHost& _host;
+
+    mutable QMutex _mutex; // the agent's thread reads the view the script's thread sets
+    glm::vec3 _position;
+    glm::quat _orientation;
+    float _voxelSizeScale;
+    int _boundaryLevelAdjust;
+    int _maxPacketsPerSecond;
+};
+
+/// One of the scripts run by a ScriptHost, which is the script's Agent object. Everything the script creates lives on
+/// whichever of the host's threads is running it, including its own avatar and EntityViewer.
+class HostedScript : public QObject {
+    Q_OBJECT
+
+    Q_PROPERTY(bool isAvatar READ isAvatar WRITE setIsAvatar)
+    Q_PROPERTY(bool isPlayingAvatarSound READ isPlayingAvatarSound)
+    Q_PROPERTY(bool isListeningToAudioStream READ isListeningToAudioStream WRITE setIsListeningToAudioStream)
+    Q_PROPERTY(float lastReceivedAudioLoudness READ getLastReceivedAudioLoudness)
+public:
+    HostedScript(ScriptHost& host, const QString& scriptContents, const QString& fileName);
+    ~HostedScript();
+
+    ScriptEngine* getScriptEngine() { return _scriptEngine; }
+
+    void setIsAvatar(bool isAvatar);
+    bool isAvatar() const { return _scriptEngine->isAvatar(); }
+
+    bool isPlayingAvatarSound() const { return _scriptEngine->isPlayingAvatarSound(); }
+
+    bool isListeningToAudioStream() const { return _scriptEngine->isListeningToAudioStream(); }
+    void setIsListeningToAudioStream(bool isListeningToAudioStream);
+
+    float getLastReceivedAudioLoudness() const;
+
+    quint64 getFrameDeadline() const { return _frameDeadline; }
+    void setFrameDeadline(quint64 frameDeadline) { _frameDeadline = frameDeadline; }
+
+    /// a moving average of how long the script's frames take
+    float getAverageFrameUsecs() const { return _averageFrameUsecs; }
+    void addFrameUsecs(quint64 frameUsecs);
+
+public slots:
+    void playAvatarSound(Sound* avatarSound);
+
+private:
+    /// tells the avatar mixer our avatar is gone
+    void sendKillAvatar();
+
+    ScriptHost& _host;
+    ScriptEngine* _scriptEngine;
+    ScriptableAvatar* _avatar;
+    HostedEntityViewer* _entityViewer;
+    quint64 _frameDeadline;
+    float _averageFrameUsecs;
+};
+
+/// Runs the frames of the scripts on one of a ScriptHost's threads, earliest deadline first, and processes the
+/// scripts' events between them.
+class ScriptHostWorker : public QObject {
+    Q_OBJECT
+public:
+    ScriptHostWorker(ScriptHost& host);
+
+public slots:
+    /// starts the script if it hasn't been, and takes over running its frames - the script must already have been
+    /// moved to this worker's thread
+    void addScript(HostedScript* script);
+
+    /// stops and deletes every script
+    void stopScripts();
+
+private slots:
+    void runDueFrames();
+
+private:
+    void finishScript(HostedScript* script);
+    void scheduleNextFrame();
+
+    ScriptHost& _host;
+    QVector<HostedScript*> _scripts;
+    QTimer* _frameTimer;
+    quint64 _nextRebalance;
+};
+
+/// Runs many scripts in one assignment-client on a fixed set of threads. The scripts share the process's node socket
+/// and the entity edit packet sender. A thread kept too busy by one slow script hands its other scripts to the
+/// threads with time to spare, so that the slow script only delays itself.
+class ScriptHost : public QObject {
+    Q_OBJECT
+public:
+    ScriptHost(Agent* agent, int numThreads);
+    ~ScriptHost();
+
+    Agent* getAgent() const { return _agent; }
+
+    /// Starts running a script set up on the calling thread, on the least busy of the host's threads. The host takes
+    /// ownership of the script.
+    void addScript(HostedScript* script);
+
+    /// only one of the hosted scripts can send and hear audio, since the audio mixer knows the host as a single stream
+    bool claimAudio(HostedScript* script);
+    void releaseAudio(HostedScript* script);
+
+    /// the EntityViewers of the hosted scripts, whose views the agent's entity queries take in turn
+    void addEntityViewer(HostedEntityViewer* entityViewer);
+    void removeEntityViewer(HostedEntityViewer* entityViewer);
+    void requestEntityQuery(HostedEntityViewer* entityViewer);
+
+    /// Called on the agent's thread to set up its next entity query with the view of the viewer whose turn it is, which
+    /// is one that asked for a query if any did.
+    /// \return false if there are no viewers
+    bool copyNextEntityView(OctreeHeadlessViewer& viewer);
+
+    /// how long the agent waits between entity queries, for each viewer to have its turn within the maximum view age
+    int getEntityQueryIntervalMsecs();
+
+    /// Called by the workers now and then to record how long their scripts' frames take. A worker over its budget is
+    /// given the script it should hand to the worker with the most time to spare, if any of its scripts fit there.
+    /// \param[out] targetWorker the worker to hand the script to
+    HostedScript* rebalance(ScriptHostWorker* worker, const QVector<HostedScript*>& scripts,
+                            ScriptHostWorker*& targetWorker);
+
+    /// called by the workers as their scripts finish, before deleting them
+    void scriptFinished(ScriptHostWorker* worker, HostedScript* script);
+
+signals:
+    void allScriptsFinished();
+
+private:
+    int findLeastBusyWorker() const;
+
+    Agent* _agent;
+    QVector<QThread*> _threads;
+    QVector<ScriptHostWorker*> _workers;
+
+    QMutex _scheduleMutex;
+    QVector<float> _workerUsecs; // the sum of the frame averages of each worker's scripts
+    QVector<int> _workerNumScripts;
+    int _numScripts;
+    HostedScript* _audioScript;
+
+    QList<HostedEntityViewer*> _entityViewers;
+    QList<HostedEntityViewer*> _entityQueryTurns; // the viewers yet to have their turn this round, those that asked first
+    int _numEntityQueryRequests; // how many of the viewers at the front of the turns asked
+};
+
+#endif // hifi_ScriptHost_h
@@ -9,8 +9,10 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <algorithm>
 #include <errno.h>
 #include <fcntl.h>
+#include <float.h>
 #include <fstream>
 #include <iostream>
 #include <math.h>
@@ -51,6 +53,7 @@
 #include <StDev.h>
 #include <UUID.h>
 
+#include "AudioMixKernels.h"
 #include "AudioRingBuffer.h"
 #include "AudioMixerClientData.h"
 #include "AudioMixerDatagramProcessor.h"
@@ -66,6 +69,12 @@ const QString AUDIO_MIXER_LOGGING_TARGET_NAME = "audio-mixer";
 const QString AUDIO_ENV_GROUP_KEY = "audio_env";
 const QString AUDIO_BUFFER_GROUP_KEY = "audio_buffer";
 
+// sources are bucketed into cells of this size, and a listener visits at most this many cells out in each direction
+const float SOURCE_GRID_CELL_SIZE = 32.0f;
+const int SOURCE_GRID_MAX_CELL_REACH = 2;
+
+const int MIN_STREAMS_MIXED_WHEN_THROTTLED = 4;
+
 void attachNewNodeDataToNode(Node *newNode) {
     if (!newNode->getLinkedData()) {
         newNode->setLinkedData(new AudioMixerClientData());
@@ -88,10 +97,12 @@ AudioMixer::AudioMixer(const QByteArray& packet) :
     _minAudibilityThreshold(LOUDNESS_TO_DISTANCE_RATIO / 2.0f),
     _performanceThrottlingRatio(0.0f),
     _attenuationPerDoublingInDistance(DEFAULT_ATTENUATION_PER_DOUBLING_IN_DISTANCE),
+    _maxAudibleDistance(FLT_MAX),
     _noiseMutingThreshold(DEFAULT_NOISE_MUTING_THRESHOLD),
     _numStatFrames(0),
-    _sumListeners(0),
-    _sumMixes(0),
+    _numMixWorkers(1),
+    _mixWorkerPool(NULL),
+    _sourceGrid(SOURCE_GRID_CELL_SIZE, SOURCE_GRID_MAX_CELL_REACH),
     _lastPerSecondCallbackTime(usecTimestampNow()),
     _sendAudioStreamStats(false),
     _datagramsReadPerCallStats(0, READ_DATAGRAMS_STATS_WINDOW_SECONDS),
@@ -109,7 +120,9 @@ const float RADIUS_OF_HEAD = 0.076f;
 int AudioMixer::addStreamToMixForListeningNodeWithStream(AudioMixerClientData* listenerNodeData,
                                                          const QUuid& streamUUID,
                                                          PositionalAudioStream* streamToAdd,
-                                                         AvatarAudioStream* listeningNodeStream) {
+                                                         AvatarAudioStream* listeningNodeStream,
+                                                         float attenuationPerDoublingInDistance,
+                                                         AudioMixerWorker& worker) {
     // If repetition with fade is enabled:
     // If streamToAdd could not provide a frame (it was starved), then we'll mix its previously-mixed frame
     // This is preferable to not mixing it at all since that's equivalent to inserting silence.
@@ -157,13 +170,9 @@ int AudioMixer::addStreamToMixForListeningNodeWithStream(AudioMixerClientData* l
         distanceBetween = EPSILON;
     }
     
-    if (streamToAdd->getLastPopOutputTrailingLoudness() / distanceBetween <= _minAudibilityThreshold) {
-        // according to mixer performance we have decided this does not get to be mixed in
-        // bail out
-        return 0;
-    }
+    // the source grid has already culled the streams that are too quiet to be heard at this distance
     
-    ++_sumMixes;
+    ++worker.sumMixes;
     
     if (streamToAdd->getType() == PositionalAudioStream::Injector) {
         attenuationCoefficient *= reinterpret_cast<InjectedAudioStream*>(streamToAdd)->getAttenuationRatio();
@@ -200,15 +209,6 @@ int AudioMixer::addStreamToMixForListeningNodeWithStream(AudioMixerClientData* l
         attenuationCoefficient *= offAxisCoefficient;
     }
     
-    float attenuationPerDoublingInDistance = _attenuationPerDoublingInDistance;
-    for (int i = 0; i < _zonesSettings.length(); ++i) {
-        if (_audioZones[_zonesSettings[i].source].contains(streamToAdd->getPosition()) &&
-            _audioZones[_zonesSettings[i].listener].contains(listeningNodeStream->getPosition())) {
-            attenuationPerDoublingInDistance = _zonesSettings[i].coefficient;
-            break;
-        }
-    }
-    
     if (distanceBetween >= ATTENUATION_BEGINS_AT_DISTANCE) {
         // calculate the distance coefficient using the distance to this node
         float distanceCoefficient = 1 - (logf(distanceBetween / ATTENUATION_BEGINS_AT_DISTANCE) / logf(2.0f)
@@ -259,107 +259,59 @@ int AudioMixer::addStreamToMixForListeningNodeWithStream(AudioMixerClientData* l
     
     AudioRingBuffer::ConstIterator streamPopOutput = streamToAdd->getLastPopOutput();
     
+    // attenuation and fade applied to all samples
+    float attenuationAndFade = attenuationCoefficient * repeatedFrameFadeFactor;
+    
+    // a source that gets the penumbra filter is mixed on its own first so that the filter only sees this source,
+    // every other source is accumulated straight into the listener's mix
+    bool applyPenumbraFilter = !sourceIsSelf && _enableFilter && !streamToAdd->ignorePenumbraFilter();
+    float* mixDestination = worker.mixSamples;
+    
+    if (applyPenumbraFilter) {
+        memset(worker.preMixSamples, 0, sizeof(worker.preMixSamples));
+        mixDestination = worker.preMixSamples;
+    }
+    
     if (!streamToAdd->isStereo()) {
         // this is a mono stream, which means it gets full attenuation and spatialization
         
         // we need to do several things in this process:
         //    1) convert from mono to stereo by copying each input sample into the left and right output samples
-        //    2) 
         //    2) apply an attenuation AND fade to all samples (left and right)
         //    3) based on the bearing relative angle to the source we will weaken and delay either the left or
         //       right channel of the input into the output
         //    4) because one of these channels is delayed, we will need to use historical samples from 
         //       the input stream for that delayed channel
+        // AudioMixKernels::addMonoToStereo handles 1 and 2, we set it up for 3 and 4 here
 
-        // Mono input to stereo output (item 1 above)
-        int OUTPUT_SAMPLES_PER_INPUT_SAMPLE = 2;
-        int inputSampleCount = AudioConstants::NETWORK_FRAME_SAMPLES_STEREO / OUTPUT_SAMPLES_PER_INPUT_SAMPLE;
-        int maxOutputIndex = AudioConstants::NETWORK_FRAME_SAMPLES_STEREO;
-
-        // attenuation and fade applied to all samples (item 2 above)
-        float attenuationAndFade = attenuationCoefficient * repeatedFrameFadeFactor;
+        int inputSampleCount = AudioConstants::NETWORK_FRAME_SAMPLES_PER_CHANNEL;
 
         // determine which side is weak and delayed (item 3 above)
         bool rightSideWeakAndDelayed = (bearingRelativeAngleToSource > 0.0f);
         
-        // since we're converting from mono to stereo, we'll use these two indices to step through
-        // the output samples. we'll increment each index independently in the loop
-        int leftDestinationIndex = 0;
-        int rightDestinationIndex = 1;
-        
-        // One of our two channels will be delayed (determined below). We'll use this index to step
-        // through filling in our output with the historical samples for the delayed channel.  (item 4 above)
-        int delayedChannelHistoricalAudioOutputIndex;
-
-        // All samples will be attenuated by at least this much
-        float leftSideAttenuation = attenuationAndFade;
-        float rightSideAttenuation = attenuationAndFade;
-        
         // The weak/delayed channel will be attenuated by this additional amount
         float attenuationAndWeakChannelRatioAndFade = attenuationAndFade * weakChannelAmplitudeRatio;
         
-        // Now, based on the determination of which side is weak and delayed, set up our true starting point
-        // for our indexes, as well as the appropriate attenuation for each channel
-        if (rightSideWeakAndDelayed) {
-            delayedChannelHistoricalAudioOutputIndex = rightDestinationIndex; 
-            rightSideAttenuation = attenuationAndWeakChannelRatioAndFade;
-            rightDestinationIndex += (numSamplesDelay * OUTPUT_SAMPLES_PER_INPUT_SAMPLE);
-        } else {
-            delayedChannelHistoricalAudioOutputIndex = leftDestinationIndex;
-            leftSideAttenuation = attenuationAndWeakChannelRatioAndFade;
-            leftDestinationIndex += (numSamplesDelay * OUTPUT_SAMPLES_PER_INPUT_SAMPLE);
-        }
-
-        // If there was a sample delay for this stream, we need to pull samples prior to the official start of the input
-        // and stick those samples at the beginning of the output. We only need to loop through this for the weak/delayed
-        // side, since the normal side is fully handled below. (item 4 above)
-        if (numSamplesDelay > 0) {
-
-            // TODO: delayStreamSourceSamples may be inside the last frame written if the ringbuffer is completely full
-            // maybe make AudioRingBuffer have 1 extra frame in its buffer
-            AudioRingBuffer::ConstIterator delayStreamSourceSamples = streamPopOutput - numSamplesDelay;
-
-            for (int i = 0; i < numSamplesDelay; i++) {
-                int16_t originalHistoricalSample = *delayStreamSourceSamples;
-
-                _preMixSamples[delayedChannelHistoricalAudioOutputIndex] += originalHistoricalSample 
-                                                                                 * attenuationAndWeakChannelRatioAndFade;
-                ++delayStreamSourceSamples; // move our input pointer
-                delayedChannelHistoricalAudioOutputIndex += OUTPUT_SAMPLES_PER_INPUT_SAMPLE; // move our output sample
-            }
-        }
-
-        // Here's where we copy the MONO input to the STEREO output, and account for delay and weak side attenuation
-        for (int inputSample = 0; inputSample < inputSampleCount; inputSample++) {
-            int16_t originalSample = streamPopOutput[inputSample];
-            int16_t leftSideSample = originalSample * leftSideAttenuation;
-            int16_t rightSideSample = originalSample * rightSideAttenuation;
-
-            // since we might be delayed, don't write beyond our maxOutputIndex
-            if (leftDestinationIndex <= maxOutputIndex) {
-                _preMixSamples[leftDestinationIndex] += leftSideSample;
-            }
-            if (rightDestinationIndex <= maxOutputIndex) {
-                _preMixSamples[rightDestinationIndex] += rightSideSample;
-            }
-
-            leftDestinationIndex += OUTPUT_SAMPLES_PER_INPUT_SAMPLE;
-            rightDestinationIndex += OUTPUT_SAMPLES_PER_INPUT_SAMPLE;
-        }
-        
+        float leftSideAttenuation = rightSideWeakAndDelayed ? attenuationAndFade : attenuationAndWeakChannelRatioAndFade;
+        float rightSideAttenuation = rightSideWeakAndDelayed ? attenuationAndWeakChannelRatioAndFade : attenuationAndFade;
+
+        // copy the frame out of the ring buffer, preceded by the historical samples the delayed channel
+        // starts with (item 4 above), so that the kernel can read contiguous samples
+        // TODO: the historical samples may be inside the last frame written if the ringbuffer is completely full
+        // maybe make AudioRingBuffer have 1 extra frame in its buffer
+        (streamPopOutput - numSamplesDelay).readSamples(worker.sourceSamples, numSamplesDelay + inputSampleCount);
+
+        AudioMixKernels::addMonoToStereo(mixDestination, worker.sourceSamples, inputSampleCount,
+                                         leftSideAttenuation, rightSideAttenuation,
+                                         numSamplesDelay, rightSideWeakAndDelayed);
     } else {
-        int stereoDivider = streamToAdd->isStereo() ? 1 : 2;
-
-       float attenuationAndFade = attenuationCoefficient * repeatedFrameFadeFactor;
-
-        for (int s = 0; s < AudioConstants::NETWORK_FRAME_SAMPLES_STEREO; s++) {
-            _preMixSamples[s] = glm::clamp(_preMixSamples[s] + (int)(streamPopOutput[s / stereoDivider] * attenuationAndFade),
-                                            AudioConstants::MIN_SAMPLE_VALUE,
-                                           AudioConstants::MAX_SAMPLE_VALUE);
-        }
+        streamPopOutput.readSamples(worker.sourceSamples, AudioConstants::NETWORK_FRAME_SAMPLES_STEREO);
+        
+        AudioMixKernels::addStereo(mixDestination, worker.sourceSamples, AudioConstants::NETWORK_FRAME_SAMPLES_STEREO,
+                                   attenuationAndFade);
     }
 
-    if (!sourceIsSelf && _enableFilter && !streamToAdd->ignorePenumbraFilter()) {
+    if (applyPenumbraFilter) {
 
         const float TWO_OVER_PI = 2.0f / PI;
         
@@ -419,67 +371,205 @@ int AudioMixer::addStreamToMixForListeningNodeWithStream(AudioMixerClientData* l
         // set the gain on both filter channels
         penumbraFilter.setParameters(0, 0, AudioConstants::SAMPLE_RATE, penumbraFilterFrequency, penumbraFilterGainL, penumbraFilterSlope);
         penumbraFilter.setParameters(0, 1, AudioConstants::SAMPLE_RATE, penumbraFilterFrequency, penumbraFilterGainR, penumbraFilterSlope);
-        penumbraFilter.render(_preMixSamples, _preMixSamples, AudioConstants::NETWORK_FRAME_SAMPLES_STEREO / 2);
-    }
-    
-    // Actually mix the _preMixSamples into the _mixSamples here.
-    for (int s = 0; s < AudioConstants::NETWORK_FRAME_SAMPLES_STEREO; s++) {
-        _mixSamples[s] = glm::clamp(_mixSamples[s] + _preMixSamples[s], AudioConstants::MIN_SAMPLE_VALUE,
-                                    AudioConstants::MAX_SAMPLE_VALUE);
+        
+        // the filter works on int16 samples, so this source's pre-mix is saturated on its own before it is filtered
+        AudioMixKernels::saturateToInt16(worker.filterSamples, worker.preMixSamples,
+                                         AudioConstants::NETWORK_FRAME_SAMPLES_STEREO);
+        penumbraFilter.render(worker.filterSamples, worker.filterSamples, AudioConstants::NETWORK_FRAME_SAMPLES_STEREO / 2);
+        
+        // Actually mix the filtered samples into the mixSamples here.
+        AudioMixKernels::addSamples(worker.mixSamples, worker.filterSamples, AudioConstants::NETWORK_FRAME_SAMPLES_STEREO);
     }
 
     return 1;
 }
 
-int AudioMixer::prepareMixForListeningNode(Node* node) {
+static bool isMoreAudible(const AudioMixerWorker::AudibleSource& a, const AudioMixerWorker::AudibleSource& b) {
+    return a.audibility > b.audibility;
+}
+
+int AudioMixer::prepareMixForListeningNode(Node* node, quint64 listenerZones, const AudioSourceGrid& sourceGrid,
+                                           AudioMixerWorker& worker) {
     AvatarAudioStream* nodeAudioStream = static_cast<AudioMixerClientData*>(node->getLinkedData())->getAvatarAudioStream();
     AudioMixerClientData* listenerNodeData = static_cast<AudioMixerClientData*>(node->getLinkedData());
     
     // zero out the client mix for this node
-    memset(_preMixSamples, 0, sizeof(_preMixSamples));
-    memset(_mixSamples, 0, sizeof(_mixSamples));
-
-    // loop through all other nodes that have sufficient audio to mix
-    int streamsMixed = 0;
+    memset(worker.mixSamples, 0, sizeof(worker.mixSamples));
     
-    NodeList::getInstance()->eachNode([&](const SharedNodePointer& otherNode){
-        if (otherNode->getLinkedData()) {
-            AudioMixerClientData* otherNodeClientData = (AudioMixerClientData*) otherNode->getLinkedData();
-            
-            // enumerate the ARBs attached to the otherNode and add all that should be added to mix
-            
-            const QHash<QUuid, PositionalAudioStream*>& otherNodeAudioStreams = otherNodeClientData->getAudioStreams();
-            QHash<QUuid, PositionalAudioStream*>::ConstIterator i;
-            for (i = otherNodeAudioStreams.constBegin(); i != otherNodeAudioStreams.constEnd(); i++) {
-                PositionalAudioStream* otherNodeStream = i.value();
-                QUuid streamUUID = i.key();
-                
-                if (otherNodeStream->getType() == PositionalAudioStream::Microphone) {
-                    streamUUID = otherNode->getUUID();
-                }
-                
-                if (*otherNode != *node || otherNodeStream->shouldLoopbackForNode()) {
-                    streamsMixed += addStreamToMixForListeningNodeWithStream(listenerNodeData, streamUUID,
-                                                                             otherNodeStream, nodeAudioStream);
-                }
-            }
+    // gather the sources that are loud enough to be heard from where this listener is
+    std::vector<AudioMixerWorker::AudibleSource>& audibleSources = worker.audibleSources;
+    audibleSources.clear();
+    
+    sourceGrid.eachAudibleSourceAt(nodeAudioStream->getPosition(), [&](const AudioSourceGrid::Source& source,
+                                                                       float distance) {
+        if (source.node != node || source.stream->shouldLoopbackForNode()) {
+            AudioMixerWorker::AudibleSource audibleSource = { &source, source.loudness / glm::max(distance, EPSILON) };
+            audibleSources.push_back(audibleSource);
         }
     });
     
+    worker.sumAudibleSources += audibleSources.size();
+    
+    // when the mixer is struggling, only the most audible share of the sources gets mixed for each listener
+    size_t numSourcesToMix = audibleSources.size();
+    if (_performanceThrottlingRatio > 0.0f) {
+        size_t maxSources = glm::max(MIN_STREAMS_MIXED_WHEN_THROTTLED,
+                                     (int)ceilf(audibleSources.size() * (1.0f - _performanceThrottlingRatio)));
+        if (maxSources < numSourcesToMix) {
+            std::nth_element(audibleSources.begin(), audibleSources.begin() + maxSources, audibleSources.end(),
+                             isMoreAudible);
+            numSourcesToMix = maxSources;
+        }
+    }
+    
+    int streamsMixed = 0;
+    
+    for (size_t i = 0; i < numSourcesToMix; i++) {
+        const AudioSourceGrid::Source& source = *audibleSources[i].source;
+        float attenuationPerDoublingInDistance = getAttenuationPerDoublingInDistance(source.zones, listenerZones);
+        streamsMixed += addStreamToMixForListeningNodeWithStream(listenerNodeData, source.streamUUID,
+                                                                 source.stream, nodeAudioStream,
+                                                                 attenuationPerDoublingInDistance, worker);
+    }
+    
     return streamsMixed;
 }
 
-void AudioMixer::sendAudioEnvironmentPacket(SharedNodePointer node) {
-    static char clientEnvBuffer[MAX_PACKET_SIZE];
+void AudioMixer::addStreamsToSourceGrid(Node* node, AudioMixerClientData* nodeData) {
+    const QHash<QUuid, PositionalAudioStream*>& audioStreams = nodeData->getAudioStreams();
+    QHash<QUuid, PositionalAudioStream*>::ConstIterator i;
+    for (i = audioStreams.constBegin(); i != audioStreams.constEnd(); i++) {
+        PositionalAudioStream* stream = i.value();
+        
+        // skip the streams that have nothing to mix this frame, starved streams can still repeat their last frame
+        if (!stream->lastPopSucceeded() && !(_streamSettings._repetitionWithFade && !stream->getLastPopOutput().isNull())) {
+            continue;
+        }
+        
+        if (stream->getLastPopOutputLoudness() == 0.0f) {
+            continue;
+        }
+        
+        // past this radius the stream's trailing loudness over distance drops below the audibility threshold
+        float audibleRadius = glm::min(stream->getLastPopOutputTrailingLoudness() / _minAudibilityThreshold,
+                                       _maxAudibleDistance);
+        if (audibleRadius <= 0.0f) {
+            continue;
+        }
+        
+        AudioSourceGrid::Source source;
+        source.node = node;
+        source.stream = stream;
+        source.streamUUID = (stream->getType() == PositionalAudioStream::Microphone) ? node->getUUID() : i.key();
+        source.position = stream->getPosition();
+        source.loudness = stream->getLastPopOutputTrailingLoudness();
+        source.audibleRadius = audibleRadius;
+        source.zones = getZonesContaining(source.position);
+        
+        _sourceGrid.addSource(source);
+    }
+}
+
+void AudioMixer::updateMaxAudibleDistance() {
+    // a source is fully attenuated once log2(distance / ATTENUATION_BEGINS_AT_DISTANCE) * coefficient reaches 1,
+    // so the zone pair with the smallest coefficient is the one that carries sound the furthest
+    float minCoefficient = _attenuationPerDoublingInDistance;
+    for (int i = 0; i < _zonesSettings.length(); ++i) {
+        minCoefficient = glm::min(minCoefficient, _zonesSettings[i].coefficient);
+    }
+    
+    if (minCoefficient > 0.0f) {
+        _maxAudibleDistance = ATTENUATION_BEGINS_AT_DISTANCE * powf(2.0f, 1.0f / minCoefficient);
+    } else {
+        _maxAudibleDistance = FLT_MAX;
+    }
+}
+
+quint64 AudioMixer::getZonesContaining(const glm::vec3& position) const {
+    quint64 zones = 0;
+    for (int i = 0; i < _audioZones.size(); ++i) {
+        if (_audioZones[i].contains(position)) {
+            zones |= 1ULL << i;
+        }
+    }
+    return zones;
+}
+
+float AudioMixer::getAttenuationPerDoublingInDistance(quint64 sourceZones, quint64 listenerZones) const {
+    if (sourceZones == 0 || listenerZones == 0 || _zonesSettings.isEmpty()) {
+        return _attenuationPerDoublingInDistance;
+    }
+    
+    // zones can overlap, in which case the coefficient listed first in the settings wins - with the memberships as
+    // masks that's one pass over the settings, stopping at the first that both are in
+    for (int i = 0; i < _zonesSettings.size(); ++i) {
+        const ZonesSettings& settings = _zonesSettings[i];
+        if ((sourceZones & (1ULL << settings.sourceZone)) && (listenerZones & (1ULL << settings.listenerZone))) {
+            return settings.coefficient;
+        }
+    }
+    return _attenuationPerDoublingInDistance;
+}
+
+void AudioMixer::mixAndSendToListeningNode(const SharedNodePointer& node, const AudioSourceGrid& sourceGrid,
+                                           AudioMixerWorker& worker) {
+    AudioMixerClientData* nodeData = (AudioMixerClientData*)node->getLinkedData();
+    char* clientMixBuffer = worker.clientMixBuffer;
+    
+    // work out which zones the listener is in once for every source it hears and its environment packet
+    quint64 listenerZones = getZonesContaining(nodeData->getAvatarAudioStream()->getPosition());
+    
+    int streamsMixed = prepareMixForListeningNode(node.data(), listenerZones, sourceGrid, worker);
+
+    char* mixDataAt;
+    if (streamsMixed > 0) {
+        // pack header
+        int numBytesMixPacketHeader = populatePacketHeader(clientMixBuffer, PacketTypeMixedAudio);
+        mixDataAt = clientMixBuffer + numBytesMixPacketHeader;
+
+        // pack sequence number
+        quint16 sequence = nodeData->getOutgoingSequenceNumber();
+        memcpy(mixDataAt, &sequence, sizeof(quint16));
+        mixDataAt  += sizeof(quint16);
+        
+        // pack mixed audio samples, saturating the accumulated mix now that every stream is in it
+        AudioMixKernels::saturateToInt16(worker.clampedMixSamples, worker.mixSamples,
+                                         AudioConstants::NETWORK_FRAME_SAMPLES_STEREO);
+        memcpy(mixDataAt, worker.clampedMixSamples, AudioConstants::NETWORK_FRAME_BYTES_STEREO);
+        mixDataAt += AudioConstants::NETWORK_FRAME_BYTES_STEREO;
+    } else {
+        // pack header
+        int numBytesPacketHeader = populatePacketHeader(clientMixBuffer, PacketTypeSilentAudioFrame);
+        mixDataAt = clientMixBuffer + numBytesPacketHeader;
+
+        // pack sequence number
+        quint16 sequence = nodeData->getOutgoingSequenceNumber();
+        memcpy(mixDataAt, &sequence, sizeof(quint16));
+        mixDataAt += sizeof(quint16);
+
+        // pack number of silent audio samples
+        quint16 numSilentSamples = AudioConstants::NETWORK_FRAME_SAMPLES_STEREO;
+        memcpy(mixDataAt, &numSilentSamples, sizeof(quint16));
+        mixDataAt += sizeof(quint16);
+    }
+    
+    // Send audio environment
+    sendAudioEnvironmentPacket(node, listenerZones, worker);
+
+    // send mixed audio packet
+    NodeList::getInstance()->writeDatagram(clientMixBuffer, mixDataAt - clientMixBuffer, node);
+    nodeData->incrementOutgoingMixedAudioSequenceNumber();
+}
+
+void AudioMixer::sendAudioEnvironmentPacket(SharedNodePointer node, quint64 listenerZones, AudioMixerWorker& worker) {
+    char* clientEnvBuffer = worker.clientEnvBuffer;
     
     // Send stream properties
     bool hasReverb = false;
     float reverbTime, wetLevel;
     // find reverb properties
     for (int i = 0; i < _zoneReverbSettings.size(); ++i) {
-        AudioMixerClientData* data = static_cast<AudioMixerClientData*>(node->getLinkedData());
-        glm::vec3 streamPosition = data->getAvatarAudioStream()->getPosition();
-        if (_audioZones[_zoneReverbSettings[i].zone].contains(streamPosition)) {
+        if (listenerZones & (1ULL << _zoneReverbSettings[i].zoneIndex)) {
             hasReverb = true;
             reverbTime = _zoneReverbSettings[i].reverbTime;
             wetLevel = _zoneReverbSettings[i].wetLevel;
@@ -562,17 +652,39 @@ void AudioMixer::sendStatsPacket() {
     statsObject["trailing_sleep_percentage"] = _trailingSleepRatio * 100.0f;
     statsObject["performance_throttling_ratio"] = _performanceThrottlingRatio;
 
-    statsObject["average_listeners_per_frame"] = (float) _sumListeners / (float) _numStatFrames;
+    int sumListeners = 0;
+    int sumMixes = 0;
+    int sumAudibleSources = 0;
     
-    if (_sumListeners > 0) {
-        statsObject["average_mixes_per_listener"] = (float) _sumMixes / (float) _sumListeners;
+    if (_mixWorkerPool) {
+        statsObject["mix_workers"] = _mixWorkerPool->getNumWorkers();
+        
+        for (int i = 0; i < _mixWorkerPool->getNumWorkers(); i++) {
+            AudioMixerWorker& worker = _mixWorkerPool->getWorker(i);
+            sumListeners += worker.sumListeners;
+            sumMixes += worker.sumMixes;
+            sumAudibleSources += worker.sumAudibleSources;
+            
+            worker.sumListeners = 0;
+            worker.sumMixes = 0;
+            worker.sumAudibleSources = 0;
+        }
+    }
+
+    statsObject["average_listeners_per_frame"] = (float) sumListeners / (float) _numStatFrames;
+    
+    if (sumListeners > 0) {
+        statsObject["average_mixes_per_listener"] = (float) sumMixes / (float) sumListeners;
+        statsObject["average_audible_sources_per_listener"] = (float) sumAudibleSources / (float) sumListeners;
     } else {
         statsObject["average_mixes_per_listener"] = 0.0;
+        statsObject["average_audible_sources_per_listener"] = 0.0;
     }
+    
+    statsObject["grid_sources"] = _sourceGrid.getNumSources();
+    statsObject["grid_global_sources"] = _sourceGrid.getNumGlobalSources();
 
     ThreadedAssignment::addPacketStatsAndSendStatsPacket(statsObject);
-    _sumListeners = 0;
-    _sumMixes = 0;
     _numStatFrames = 0;
 
 
@@ -608,6 +720,16 @@ void AudioMixer::sendStatsPacket() {
     somethingToSend = true;
     sizeOfStats += property.size() + value.size();
     
+    if (_mixWorkerPool) {
+        // report how long each worker spends mixing per frame, so the size of the pool can be tuned
+        for (int i = 0; i < _mixWorkerPool->getNumWorkers(); i++) {
+            property = "mix_worker_" + QString::number(i) + "_frame_time_stats";
+            value = getMixWorkerFrameTimeStatsString(_mixWorkerPool->getWorker(i));
+            statsObject2[qPrintable(property)] = value;
+            sizeOfStats += property.size() + value.size();
+        }
+    }
+    
     NodeList* nodeList = NodeList::getInstance();
     int clientNumber = 0;
     
@@ -698,11 +820,14 @@ void AudioMixer::run() {
     // check the settings object to see if we have anything we can parse out
     parseSettingsObject(settingsObject);
     
+    _mixWorkerPool = new AudioMixerWorkerPool(*this, _numMixWorkers);
+    
     int nextFrame = 0;
     QElapsedTimer timer;
     timer.start();
 
-    char clientMixBuffer[MAX_PACKET_SIZE];
+    QVector<SharedNodePointer> frameNodes;
+    QVector<SharedNodePointer> listeners;
     
     int usecToSleep = AudioConstants::NETWORK_FRAME_USECS;
     
@@ -750,9 +875,9 @@ void AudioMixer::run() {
             }
             
             if (hasRatioChanged) {
-                // set out min audability threshold from the new ratio
-                _minAudibilityThreshold = LOUDNESS_TO_DISTANCE_RATIO / (2.0f * (1.0f - _performanceThrottlingRatio));
-                qDebug() << "Minimum audability required to be mixed is now" << _minAudibilityThreshold;
+                // listeners now only get the most audible share of their sources mixed
+                qDebug() << "Listeners will now have the loudest" << (1.0f - _performanceThrottlingRatio) * 100
+                    << "% of their audible sources mixed";
                 
                 framesSinceCutoffEvent = 0;
             }
@@ -768,6 +893,10 @@ void AudioMixer::run() {
             _lastPerSecondCallbackTime = now;
         }
         
+        frameNodes.clear();
+        listeners.clear();
+        _sourceGrid.clear();
+        
         nodeList->eachNode([&](const SharedNodePointer& node) {
             
             if (node->getLinkedData()) {
@@ -785,59 +914,28 @@ void AudioMixer::run() {
                     nodeList->writeDatagram(packet, node);
                 }
                 
+                // hold on to the node until the frame is mixed, the source grid only keeps pointers into it
+                frameNodes.append(node);
+                addStreamsToSourceGrid(node.data(), nodeData);
+                
                 if (node->getType() == NodeType::Agent && node->getActiveSocket()
                     && nodeData->getAvatarAudioStream()) {
-
-                    int streamsMixed = prepareMixForListeningNode(node.data());
-
-                    char* mixDataAt;
-                    if (streamsMixed > 0) {
-                        // pack header
-                        int numBytesMixPacketHeader = populatePacketHeader(clientMixBuffer, PacketTypeMixedAudio);
-                        mixDataAt = clientMixBuffer + numBytesMixPacketHeader;
-
-                        // pack sequence number
-                        quint16 sequence = nodeData->getOutgoingSequenceNumber();
-                        memcpy(mixDataAt, &sequence, sizeof(quint16));
-                        mixDataAt  += sizeof(quint16);
-                        
-                        // pack mixed audio samples
-                        memcpy(mixDataAt, _mixSamples, AudioConstants::NETWORK_FRAME_BYTES_STEREO);
-                        mixDataAt += AudioConstants::NETWORK_FRAME_BYTES_STEREO;
-                    } else {
-                        // pack header
-                        int numBytesPacketHeader = populatePacketHeader(clientMixBuffer, PacketTypeSilentAudioFrame);
-                        mixDataAt = clientMixBuffer + numBytesPacketHeader;
-
-                        // pack sequence number
-                        quint16 sequence = nodeData->getOutgoingSequenceNumber();
-                        memcpy(mixDataAt, &sequence, sizeof(quint16));
-                        mixDataAt += sizeof(quint16);
-
-                        // pack number of silent audio samples
-                        quint16 numSilentSamples = AudioConstants::NETWORK_FRAME_SAMPLES_STEREO;
-                        memcpy(mixDataAt, &numSilentSamples, sizeof(quint16));
-                        mixDataAt += sizeof(quint16);
-                    }
                     
-                    // Send audio environment
-                    sendAudioEnvironmentPacket(node);
-
-                    // send mixed audio packet
-                    nodeList->writeDatagram(clientMixBuffer, mixDataAt - clientMixBuffer, node);
-                    nodeData->incrementOutgoingMixedAudioSequenceNumber();
+                    listeners.append(node);
 
                     // send an audio stream stats packet if it's time
                     if (_sendAudioStreamStats) {
                         nodeData->sendAudioStreamStatsPackets(node);
                         _sendAudioStreamStats = false;
                     }
-
-                    ++_sumListeners;
                 }
             }
         });
         
+        // every stream has popped its frame for this send, now mix for each of the listeners on the workers
+        _sourceGrid.finalize();
+        _mixWorkerPool->mixFrame(_sourceGrid, listeners);
+        
         ++_numStatFrames;
         
         QCoreApplication::processEvents();
@@ -852,6 +950,9 @@ void AudioMixer::run() {
             usleep(usecToSleep);
         }
     }
+    
+    delete _mixWorkerPool;
+    _mixWorkerPool = NULL;
 }
 
 void AudioMixer::perSecondActions() {
@@ -910,6 +1011,10 @@ void AudioMixer::perSecondActions() {
     _datagramsReadPerCallStats.currentIntervalComplete();
     _timeSpentPerCallStats.currentIntervalComplete();
     _timeSpentPerHashMatchCallStats.currentIntervalComplete();
+    
+    if (_mixWorkerPool) {
+        _mixWorkerPool->currentStatsIntervalComplete();
+    }
 }
 
 QString AudioMixer::getReadPendingDatagramsCallsPerSecondsStatsString() const {
@@ -940,6 +1045,14 @@ QString AudioMixer::getReadPendingDatagramsHashMatchTimeStatsString() const {
     return result;
 }
 
+QString AudioMixer::getMixWorkerFrameTimeStatsString(const AudioMixerWorker& worker) const {
+    QString result = "usecs_per_frame_avg_30s: " + QString::number(worker.frameTimeStats.getWindowAverage(), 'f', 2)
+        + " usecs_per_frame_max_30s: " + QString::number(worker.frameTimeStats.getWindowMax())
+        + " usecs_per_frame_avg_1s: " + QString::number(worker.frameTimeStats.getLastCompleteIntervalStats().getAverage(), 'f', 2)
+        + " prct_of_frame_30s: " + QString::number(worker.frameTimeStats.getWindowAverage() / AudioConstants::NETWORK_FRAME_USECS * 100.0, 'f', 2) + "%";
+    return result;
+}
+
 void AudioMixer::parseSettingsObject(const QJsonObject &settingsObject) {
     if (settingsObject.contains(AUDIO_BUFFER_GROUP_KEY)) {
         QJsonObject audioBufferGroupObject = settingsObject[AUDIO_BUFFER_GROUP_KEY].toObject();
@@ -1043,6 +1156,16 @@ void AudioMixer::parseSettingsObject(const QJsonObject &settingsObject) {
             qDebug() << "Filter enabled";
         }
         
+        const QString MIXER_THREADS = "mixer_threads";
+        if (audioEnvGroupObject[MIXER_THREADS].isString()) {
+            bool ok = false;
+            int numMixWorkers = audioEnvGroupObject[MIXER_THREADS].toString().toInt(&ok);
+            if (ok && numMixWorkers >= 1) {
+                _numMixWorkers = numMixWorkers;
+                qDebug() << "Number of mixer threads changed to" << _numMixWorkers;
+            }
+        }
+        
         const QString AUDIO_ZONES = "zones";
         if (audioEnvGroupObject[AUDIO_ZONES].isObject()) {
             const QJsonObject& zones = audioEnvGroupObject[AUDIO_ZONES].toObject();
@@ -1078,9 +1201,16 @@ void AudioMixer::parseSettingsObject(const QJsonObject &settingsObject) {
                             glm::vec3 corner(xMin, yMin, zMin);
                             glm::vec3 dimensions(xMax - xMin, yMax - yMin, zMax - zMin);
                             AABox zoneAABox(corner, dimensions);
-                            _audioZones.insert(zone, zoneAABox);
-                            qDebug() << "Added zone:" << zone << "(corner:" << corner
-                                     << ", dimensions:" << dimensions << ")";
+                            
+                            if (_audioZones.size() < MAX_AUDIO_ZONES) {
+                                _audioZoneIndices.insert(zone, _audioZones.size());
+                                _audioZones.append(zoneAABox);
+                                qDebug() << "Added zone:" << zone << "(corner:" << corner
+                                         << ", dimensions:" << dimensions << ")";
+                            } else {
+                                qDebug() << "Ignoring zone" << zone << "- the audio-mixer supports at most"
+                                         << MAX_AUDIO_ZONES << "zones";
+                            }
                         }
                     }
                 }
@@ -1109,8 +1239,10 @@ void AudioMixer::parseSettingsObject(const QJsonObject &settingsObject) {
                     settings.coefficient = coefficientObject.value(COEFFICIENT).toString().toFloat(&ok);
                     
                     if (ok && settings.coefficient >= 0.0f && settings.coefficient <= 1.0f &&
-                        _audioZones.contains(settings.source) && _audioZones.contains(settings.listener)) {
+                        _audioZoneIndices.contains(settings.source) && _audioZoneIndices.contains(settings.listener)) {
                         
+                        settings.sourceZone = _audioZoneIndices.value(settings.source);
+                        settings.listenerZone = _audioZoneIndices.value(settings.listener);
                         _zonesSettings.push_back(settings);
                         qDebug() << "Added Coefficient:" << settings.source << settings.listener << settings.coefficient;
                     }
@@ -1118,6 +1250,8 @@ void AudioMixer::parseSettingsObject(const QJsonObject &settingsObject) {
             }
         }
         
+        updateMaxAudibleDistance();
+        
         const QString REVERB = "reverb";
         if (audioEnvGroupObject[REVERB].isArray()) {
             const QJsonArray& reverb = audioEnvGroupObject[REVERB].toArray();
@@ -1137,9 +1271,10 @@ void AudioMixer::parseSettingsObject(const QJsonObject &settingsObject) {
                     float reverbTime = reverbObject.value(REVERB_TIME).toString().toFloat(&okReverbTime);
                     float wetLevel = reverbObject.value(WET_LEVEL).toString().toFloat(&okWetLevel);
                     
-                    if (okReverbTime && okWetLevel && _audioZones.contains(zone)) {
+                    if (okReverbTime && okWetLevel && _audioZoneIndices.contains(zone)) {
                         ReverbSettings settings;
                         settings.zone = zone;
+                        settings.zoneIndex = _audioZoneIndices.value(zone);
                         settings.reverbTime = reverbTime;
                         settings.wetLevel = wetLevel;
                         
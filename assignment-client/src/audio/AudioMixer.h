@@ -16,14 +16,18 @@
 #include <AudioRingBuffer.h>
 #include <ThreadedAssignment.h>
 
+#include "AudioMixerWorkerPool.h"
+#include "AudioSourceGrid.h"
+
 class PositionalAudioStream;
 class AvatarAudioStream;
 class AudioMixerClientData;
 
-const int SAMPLE_PHASE_DELAY_AT_90 = 20;
-
 const int READ_DATAGRAMS_STATS_WINDOW_SECONDS = 30;
 
+// zone membership is tracked as a bitmask, zones past this many are ignored
+const int MAX_AUDIO_ZONES = 64;
+
 /// Handles assignments of type AudioMixer - mixing streams of audio and re-distributing to various clients.
 class AudioMixer : public ThreadedAssignment {
     Q_OBJECT
@@ -41,25 +45,38 @@ public slots:
     static const InboundAudioStream::Settings& getStreamSettings() { return _streamSettings; }
     
 private:
+    friend class AudioMixerWorkerPool;
+
     /// adds one stream to the mix for a listening node
     int addStreamToMixForListeningNodeWithStream(AudioMixerClientData* listenerNodeData,
                                                     const QUuid& streamUUID,
                                                     PositionalAudioStream* streamToAdd,
-                                                    AvatarAudioStream* listeningNodeStream);
+                                                    AvatarAudioStream* listeningNodeStream,
+                                                    float attenuationPerDoublingInDistance,
+                                                    AudioMixerWorker& worker);
     
-    /// prepares and sends a mix to one Node
-    int prepareMixForListeningNode(Node* node);
+    /// prepares a mix for one Node in the worker's mix buffers from the sources audible at its position
+    int prepareMixForListeningNode(Node* node, quint64 listenerZones, const AudioSourceGrid& sourceGrid,
+                                   AudioMixerWorker& worker);
     
-    /// Send Audio Environment packet for a single node
-    void sendAudioEnvironmentPacket(SharedNodePointer node);
-
-    // used on a per stream basis to run the filter on before mixing, large enough to handle the historical
-    // data from a phase delay as well as an entire network buffer
-    int16_t _preMixSamples[AudioConstants::NETWORK_FRAME_SAMPLES_STEREO + (SAMPLE_PHASE_DELAY_AT_90 * 2)];
+    /// prepares and sends a mix to one Node, called from the mixer worker threads
+    void mixAndSendToListeningNode(const SharedNodePointer& node, const AudioSourceGrid& sourceGrid,
+                                   AudioMixerWorker& worker);
     
-    // client samples capacity is larger than what will be sent to optimize mixing
-    // we are MMX adding 4 samples at a time so we need client samples to have an extra 4
-    int16_t _mixSamples[AudioConstants::NETWORK_FRAME_SAMPLES_STEREO + (SAMPLE_PHASE_DELAY_AT_90 * 2)];
+    /// adds the streams of a node that have a frame to mix this frame to the source grid
+    void addStreamsToSourceGrid(Node* node, AudioMixerClientData* nodeData);
+    
+    /// recomputes the distance past which no zone's attenuation leaves a source audible
+    void updateMaxAudibleDistance();
+    
+    /// returns the bitmask of the audio zones that contain position
+    quint64 getZonesContaining(const glm::vec3& position) const;
+    
+    /// returns the attenuation for a source and listener in the given zones, from the first coefficient setting they match
+    float getAttenuationPerDoublingInDistance(quint64 sourceZones, quint64 listenerZones) const;
+    
+    /// Send Audio Environment packet for a single node
+    void sendAudioEnvironmentPacket(SharedNodePointer node, quint64 listenerZones, AudioMixerWorker& worker);
 
     void perSecondActions();
     
@@ -69,6 +86,7 @@ private:
     QString getReadPendingDatagramsPacketsPerCallStatsString() const;
     QString getReadPendingDatagramsTimeStatsString() const;
     QString getReadPendingDatagramsHashMatchTimeStatsString() const;
+    QString getMixWorkerFrameTimeStatsString(const AudioMixerWorker& worker) const;
     
     void parseSettingsObject(const QJsonObject& settingsObject);
     
@@ -76,20 +94,26 @@ private:
     float _minAudibilityThreshold;
     float _performanceThrottlingRatio;
     float _attenuationPerDoublingInDistance;
+    float _maxAudibleDistance;
     float _noiseMutingThreshold;
     int _numStatFrames;
-    int _sumListeners;
-    int _sumMixes;
+    int _numMixWorkers;
+    AudioMixerWorkerPool* _mixWorkerPool;
+    AudioSourceGrid _sourceGrid;
     
-    QHash<QString, AABox> _audioZones;
+    QHash<QString, int> _audioZoneIndices;
+    QVector<AABox> _audioZones; // indexed by zone, bit i of a zone mask is set when _audioZones[i] contains the point
     struct ZonesSettings {
         QString source;
         QString listener;
+        int sourceZone;
+        int listenerZone;
         float coefficient;
     };
     QVector<ZonesSettings> _zonesSettings;
     struct ReverbSettings {
         QString zone;
+        int zoneIndex;
         float reverbTime;
         float wetLevel;
     };
@@ -18,7 +18,8 @@
 
 AudioMixerDatagramProcessor::AudioMixerDatagramProcessor(QUdpSocket& nodeSocket, QThread* previousNodeSocketThread) :
     _nodeSocket(nodeSocket),
-    _previousNodeSocketThread(previousNodeSocketThread)
+    _previousNodeSocketThread(previousNodeSocketThread),
+    _receiveBatch()
 {
     
 }
@@ -30,18 +31,11 @@ AudioMixerDatagramProcessor::~AudioMixerDatagramProcessor() {
 
 void AudioMixerDatagramProcessor::readPendingDatagrams() {
     
-    HifiSockAddr senderSockAddr;
-    static QByteArray incomingPacket;
-    
-    // read everything that is available
-    while (_nodeSocket.hasPendingDatagrams()) {
-        incomingPacket.resize(_nodeSocket.pendingDatagramSize());
-        
-        // just get this packet off the stack
-        _nodeSocket.readDatagram(incomingPacket.data(), incomingPacket.size(),
-                                  senderSockAddr.getAddressPointer(), senderSockAddr.getPortPointer());
-        
-        // emit the signal to tell AudioMixer it needs to process a packet
-        emit packetRequiresProcessing(incomingPacket, senderSockAddr);
+    // read everything that is available, a batch at a time
+    while (_receiveBatch.readPendingDatagrams(_nodeSocket) > 0) {
+        for (int i = 0; i < _receiveBatch.size(); i++) {
+            // emit the signal to tell AudioMixer it needs to process a packet
+            emit packetRequiresProcessing(_receiveBatch.getDatagram(i), _receiveBatch.getSenderSockAddr(i));
+        }
     }
 }
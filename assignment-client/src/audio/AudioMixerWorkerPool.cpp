@@ -0,0 +1,160 @@
+//
+//  AudioMixerWorkerPool.cpp
+//  assignment-client/src/audio
+//
+//  Created on 3/2/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+
+#include <NodeList.h>
+
+#include "AudioMixer.h"
+
+#include "AudioMixerWorkerPool.h"
+
+AudioMixerWorker::AudioMixerWorker() :
+    sumMixes(0),
+    sumListeners(0),
+    sumAudibleSources(0),
+    frameTimeStats(0, MIX_WORKER_STATS_WINDOW_SECONDS)
+{
+    memset(preMixSamples, 0, sizeof(preMixSamples));
+    memset(mixSamples, 0, sizeof(mixSamples));
+}
+
+AudioMixerWorkerThread::AudioMixerWorkerThread(AudioMixerWorkerPool& pool, AudioMixerWorker& worker) :
+    _pool(pool),
+    _worker(worker)
+{
+
+}
+
+void AudioMixerWorkerThread::run() {
+    quint64 lastFrameNumber = 0;
+
+    while (true) {
+        {
+            // wait for the mixer to hand us the next frame
+            QMutexLocker locker(&_pool._frameMutex);
+            while (_pool._frameNumber == lastFrameNumber && !_pool._isStopping) {
+                _pool._frameStarted.wait(&_pool._frameMutex);
+            }
+
+            if (_pool._isStopping) {
+                return;
+            }
+
+            lastFrameNumber = _pool._frameNumber;
+        }
+
+        _pool.mixListeners(_worker);
+
+        QMutexLocker locker(&_pool._frameMutex);
+        if (--_pool._numBusyThreads == 0) {
+            _pool._frameFinished.wakeAll();
+        }
+    }
+}
+
+AudioMixerWorkerPool::AudioMixerWorkerPool(AudioMixer& mixer, int numWorkers) :
+    _mixer(mixer),
+    _workers(),
+    _threads(),
+    _sourceGrid(NULL),
+    _listeners(NULL),
+    _nextListenerIndex(0),
+    _frameNumber(0),
+    _numBusyThreads(0),
+    _isStopping(false)
+{
+    if (numWorkers < 1) {
+        numWorkers = 1;
+    }
+
+    for (int i = 0; i < numWorkers; i++) {
+        _workers.append(new AudioMixerWorker());
+    }
+
+    if (numWorkers > 1) {
+        qDebug() << "Mixing listeners on" << numWorkers << "worker threads.";
+
+        foreach(AudioMixerWorker* worker, _workers) {
+            AudioMixerWorkerThread* thread = new AudioMixerWorkerThread(*this, *worker);
+            thread->start(QThread::HighestPriority);
+            _threads.append(thread);
+        }
+    }
+}
+
+AudioMixerWorkerPool::~AudioMixerWorkerPool() {
+    {
+        QMutexLocker locker(&_frameMutex);
+        _isStopping = true;
+        _frameStarted.wakeAll();
+    }
+
+    foreach(AudioMixerWorkerThread* thread, _threads) {
+        thread->wait();
+        delete thread;
+    }
+
+    foreach(AudioMixerWorker* worker, _workers) {
+        delete worker;
+    }
+}
+
+void AudioMixerWorkerPool::mixFrame(const AudioSourceGrid& sourceGrid, const QVector<SharedNodePointer>& listeners) {
+    _sourceGrid = &sourceGrid;
+    _listeners = &listeners;
+    _nextListenerIndex.store(0);
+
+    if (_threads.isEmpty()) {
+        // single worker, mix everyone right here on the mixer thread
+        mixListeners(*_workers[0]);
+    } else {
+        QMutexLocker locker(&_frameMutex);
+
+        _numBusyThreads = _threads.size();
+        ++_frameNumber;
+        _frameStarted.wakeAll();
+
+        while (_numBusyThreads > 0) {
+            _frameFinished.wait(&_frameMutex);
+        }
+    }
+
+    _sourceGrid = NULL;
+    _listeners = NULL;
+}
+
+void AudioMixerWorkerPool::mixListeners(AudioMixerWorker& worker) {
+    QElapsedTimer frameTimer;
+    frameTimer.start();
+
+    // the mixes this worker sends go out together at the end of its share of the frame
+    NodeList* nodeList = NodeList::getInstance();
+    nodeList->beginDatagramBatch();
+
+    // each worker grabs the next listener that hasn't been claimed, so a slow listener doesn't hold up a whole slice
+    int listenerIndex;
+    while ((listenerIndex = _nextListenerIndex.fetchAndAddOrdered(1)) < _listeners->size()) {
+        _mixer.mixAndSendToListeningNode(_listeners->at(listenerIndex), *_sourceGrid, worker);
+        ++worker.sumListeners;
+    }
+
+    nodeList->flushDatagramBatch();
+
+    worker.frameTimeStats.update(frameTimer.nsecsElapsed() / 1000); // ns to us
+}
+
+void AudioMixerWorkerPool::currentStatsIntervalComplete() {
+    foreach(AudioMixerWorker* worker, _workers) {
+        worker->frameTimeStats.currentIntervalComplete();
+    }
+}
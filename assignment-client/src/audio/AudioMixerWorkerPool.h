@@ -0,0 +1,119 @@
+//
+//  AudioMixerWorkerPool.h
+//  assignment-client/src/audio
+//
+//  Created on 3/2/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioMixerWorkerPool_h
+#define hifi_AudioMixerWorkerPool_h
+
+#include <vector>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+#include <QtCore/QVector>
+#include <QtCore/QWaitCondition>
+
+#include <AudioConstants.h>
+#include <LimitedNodeList.h>
+#include <MovingMinMaxAvg.h>
+
+#include "AudioSourceGrid.h"
+
+class AudioMixer;
+class AudioMixerWorkerPool;
+
+const int SAMPLE_PHASE_DELAY_AT_90 = 20;
+
+const int MIX_WORKER_STATS_WINDOW_SECONDS = 30;
+
+/// Scratch state for one mixer worker - every listener handled by a worker is mixed into and packed from these buffers
+class AudioMixerWorker {
+public:
+    AudioMixerWorker();
+
+    // the frame of the stream being mixed copied out of its ring buffer, large enough to handle the historical
+    // data from a phase delay as well as an entire network buffer
+    int16_t sourceSamples[AudioConstants::NETWORK_FRAME_SAMPLES_STEREO + SAMPLE_PHASE_DELAY_AT_90];
+
+    // used on a per stream basis to run the filter on before mixing
+    float preMixSamples[AudioConstants::NETWORK_FRAME_SAMPLES_STEREO];
+    int16_t filterSamples[AudioConstants::NETWORK_FRAME_SAMPLES_STEREO];
+
+    // the listener's mix is accumulated without clamping and only saturated to int16 once every stream is in it
+    float mixSamples[AudioConstants::NETWORK_FRAME_SAMPLES_STEREO];
+    int16_t clampedMixSamples[AudioConstants::NETWORK_FRAME_SAMPLES_STEREO];
+
+    char clientMixBuffer[MAX_PACKET_SIZE];
+    char clientEnvBuffer[MAX_PACKET_SIZE];
+
+    // the sources audible to the listener being mixed, ranked by audibility when the mixer is throttling
+    struct AudibleSource {
+        const AudioSourceGrid::Source* source;
+        float audibility;
+    };
+    std::vector<AudibleSource> audibleSources;
+
+    int sumMixes;
+    int sumListeners;
+    int sumAudibleSources;
+
+    MovingMinMaxAvg<quint64> frameTimeStats; // update with usecs this worker spent mixing each frame
+};
+
+class AudioMixerWorkerThread : public QThread {
+public:
+    AudioMixerWorkerThread(AudioMixerWorkerPool& pool, AudioMixerWorker& worker);
+
+protected:
+    void run();
+
+private:
+    AudioMixerWorkerPool& _pool;
+    AudioMixerWorker& _worker;
+};
+
+/// Splits the listeners of a mixer frame across a fixed set of worker threads, each mixing into its own buffers.
+/// With a single worker the listeners are mixed on the calling thread and no threads are started.
+class AudioMixerWorkerPool {
+public:
+    AudioMixerWorkerPool(AudioMixer& mixer, int numWorkers);
+    ~AudioMixerWorkerPool();
+
+    /// mixes and sends to every listener, returns once all of them have been handled
+    void mixFrame(const AudioSourceGrid& sourceGrid, const QVector<SharedNodePointer>& listeners);
+
+    int getNumWorkers() const { return _workers.size(); }
+    AudioMixerWorker& getWorker(int index) { return *_workers[index]; }
+
+    void currentStatsIntervalComplete();
+
+private:
+    friend class AudioMixerWorkerThread;
+
+    void mixListeners(AudioMixerWorker& worker);
+
+    AudioMixer& _mixer;
+
+    QVector<AudioMixerWorker*> _workers;
+    QVector<AudioMixerWorkerThread*> _threads;
+
+    const AudioSourceGrid* _sourceGrid;
+    const QVector<SharedNodePointer>* _listeners;
+    QAtomicInt _nextListenerIndex;
+
+    QMutex _frameMutex;
+    QWaitCondition _frameStarted;
+    QWaitCondition _frameFinished;
+    quint64 _frameNumber;
+    int _numBusyThreads;
+    bool _isStopping;
+};
+
+#endif // hifi_AudioMixerWorkerPool_h
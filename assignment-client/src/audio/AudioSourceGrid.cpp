@@ -0,0 +1,72 @@
+//
+//  AudioSourceGrid.cpp
+//  assignment-client/src/audio
+//
+//  Created on 3/6/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+
+#include "AudioSourceGrid.h"
+
+AudioSourceGrid::AudioSourceGrid(float cellSize, int maxCellReach) :
+    _cellSize(cellSize),
+    _maxCellReach(maxCellReach),
+    _maxLocalRadius(0.0f)
+{
+
+}
+
+void AudioSourceGrid::clear() {
+    _sources.clear();
+    _globalSources.clear();
+    _sortedLocalSources.clear();
+    _cellRanges.clear();
+    _maxLocalRadius = 0.0f;
+}
+
+void AudioSourceGrid::addSource(const Source& source) {
+    _sources.push_back(source);
+}
+
+glm::ivec3 AudioSourceGrid::cellForPosition(const glm::vec3& position) const {
+    return glm::ivec3(glm::floor(position / _cellSize));
+}
+
+AudioSourceGrid::CellKey AudioSourceGrid::keyForCell(const glm::ivec3& cell) const {
+    // 21 bits per axis is plenty for any domain at the cell sizes the mixer uses
+    const CellKey AXIS_MASK = (1 << 21) - 1;
+    return (((CellKey)cell.x & AXIS_MASK) << 42) | (((CellKey)cell.y & AXIS_MASK) << 21) | ((CellKey)cell.z & AXIS_MASK);
+}
+
+void AudioSourceGrid::finalize() {
+    float maxLocalRadius = _maxCellReach * _cellSize;
+
+    std::vector<std::pair<CellKey, int> > keyedSources;
+    keyedSources.reserve(_sources.size());
+
+    for (size_t i = 0; i < _sources.size(); i++) {
+        if (_sources[i].audibleRadius > maxLocalRadius) {
+            _globalSources.push_back(i);
+        } else {
+            keyedSources.push_back(std::make_pair(keyForCell(cellForPosition(_sources[i].position)), (int)i));
+            _maxLocalRadius = glm::max(_maxLocalRadius, _sources[i].audibleRadius);
+        }
+    }
+
+    // sort by cell so that each cell's sources are contiguous
+    std::sort(keyedSources.begin(), keyedSources.end());
+
+    _sortedLocalSources.reserve(keyedSources.size());
+    for (size_t i = 0; i < keyedSources.size(); i++) {
+        if (i == 0 || keyedSources[i].first != keyedSources[i - 1].first) {
+            _cellRanges.insert(keyedSources[i].first, qMakePair((int)i, 0));
+        }
+        ++_cellRanges[keyedSources[i].first].second;
+        _sortedLocalSources.push_back(keyedSources[i].second);
+    }
+}
@@ -0,0 +1,111 @@
+//
+//  AudioSourceGrid.h
+//  assignment-client/src/audio
+//
+//  Created on 3/6/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioSourceGrid_h
+#define hifi_AudioSourceGrid_h
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <QtCore/QHash>
+#include <QtCore/QUuid>
+
+class Node;
+class PositionalAudioStream;
+
+/// Uniform grid of the audio sources that have something to mix this frame, rebuilt by the mixer once per frame so that
+/// each listener only visits the sources that could be loud enough to be heard at its position.
+class AudioSourceGrid {
+public:
+    struct Source {
+        Node* node;
+        PositionalAudioStream* stream;
+        QUuid streamUUID;
+        glm::vec3 position;
+        float loudness;
+        float audibleRadius; // beyond this distance the source is below the mixer's audibility threshold
+        quint64 zones; // bitmask of the mixer's audio zones that contain the source this frame
+    };
+
+    AudioSourceGrid(float cellSize, int maxCellReach);
+
+    void clear();
+    void addSource(const Source& source);
+
+    /// sorts the sources into their cells, call once every source for the frame has been added
+    void finalize();
+
+    /// calls functor(source, distance) for every source whose audible radius reaches position
+    template<typename SourceLambda>
+    void eachAudibleSourceAt(const glm::vec3& position, SourceLambda functor) const;
+
+    int getNumSources() const { return _sources.size(); }
+    int getNumGlobalSources() const { return _globalSources.size(); }
+
+private:
+    typedef quint64 CellKey;
+
+    glm::ivec3 cellForPosition(const glm::vec3& position) const;
+    CellKey keyForCell(const glm::ivec3& cell) const;
+
+    template<typename SourceLambda>
+    void testSource(int sourceIndex, const glm::vec3& position, SourceLambda& functor) const;
+
+    float _cellSize;
+    int _maxCellReach;
+    float _maxLocalRadius;
+
+    std::vector<Source> _sources;
+    std::vector<int> _globalSources; // sources audible further than _maxCellReach cells away, tested by every listener
+    std::vector<int> _sortedLocalSources;
+    QHash<CellKey, QPair<int, int> > _cellRanges; // offset and count into _sortedLocalSources
+};
+
+template<typename SourceLambda>
+void AudioSourceGrid::testSource(int sourceIndex, const glm::vec3& position, SourceLambda& functor) const {
+    const Source& source = _sources[sourceIndex];
+    float distance = glm::distance(source.position, position);
+    if (distance < source.audibleRadius) {
+        functor(source, distance);
+    }
+}
+
+template<typename SourceLambda>
+void AudioSourceGrid::eachAudibleSourceAt(const glm::vec3& position, SourceLambda functor) const {
+    for (size_t i = 0; i < _globalSources.size(); i++) {
+        testSource(_globalSources[i], position, functor);
+    }
+
+    if (_sortedLocalSources.empty()) {
+        return;
+    }
+
+    // only visit the cells the loudest local source could be heard from
+    int reach = glm::min((int)ceilf(_maxLocalRadius / _cellSize), _maxCellReach);
+    glm::ivec3 center = cellForPosition(position);
+
+    for (int x = center.x - reach; x <= center.x + reach; x++) {
+        for (int y = center.y - reach; y <= center.y + reach; y++) {
+            for (int z = center.z - reach; z <= center.z + reach; z++) {
+                QHash<CellKey, QPair<int, int> >::const_iterator cell = _cellRanges.constFind(keyForCell(glm::ivec3(x, y, z)));
+                if (cell != _cellRanges.constEnd()) {
+                    int end = cell.value().first + cell.value().second;
+                    for (int i = cell.value().first; i < end; i++) {
+                        testSource(_sortedLocalSources[i], position, functor);
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif // hifi_AudioSourceGrid_h
@@ -9,8 +9,12 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <algorithm>
+#include <climits>
+
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDateTime>
+#include <QtCore/QEventLoop>
 #include <QtCore/QJsonObject>
 #include <QtCore/QTimer>
 #include <QtCore/QThread>
@@ -26,9 +30,12 @@
 #include "AvatarMixer.h"
 
 const QString AVATAR_MIXER_LOGGING_NAME = "avatar-mixer";
+const QString AVATAR_MIXER_SETTINGS_KEY = "avatar_mixer";
 
 const unsigned int AVATAR_DATA_SEND_INTERVAL_MSECS = (1.0f / 60.0f) * 1000;
 
+const int DEFAULT_LISTENER_KBPS = 2000;
+
 AvatarMixer::AvatarMixer(const QByteArray& packet) :
     ThreadedAssignment(packet),
     _broadcastThread(),
@@ -37,8 +44,16 @@ AvatarMixer::AvatarMixer(const QByteArray& packet) :
     _performanceThrottlingRatio(0.0f),
     _sumListeners(0),
     _numStatFrames(0),
+    _broadcastFrameNumber(0),
     _sumBillboardPackets(0),
-    _sumIdentityPackets(0)
+    _sumIdentityPackets(0),
+    _sumKeyframes(0),
+    _sumListenerBytes(0),
+    _sumStarvedAvatars(0),
+    _maxFramesAvatarStarved(0),
+    _jointRotationBits(DEFAULT_JOINT_ROTATION_BITS),
+    _listenerBytesPerFrame(DEFAULT_LISTENER_KBPS * AVATAR_DATA_SEND_INTERVAL_MSECS / CHAR_BIT),
+    _prioritizedAvatars()
 {
     // make sure we hear about node kills so we can tell the other nodes
     connect(NodeList::getInstance(), &NodeList::nodeKilled, this, &AvatarMixer::nodeKilled);
@@ -57,15 +72,43 @@ void attachAvatarDataToNode(Node* newNode) {
 
 const float BILLBOARD_AND_IDENTITY_SEND_PROBABILITY = 1.0f / 300.0f;
 
-// NOTE: some additional optimizations to consider.
-//    1) use the view frustum to cull those avatars that are out of view. Since avatar data doesn't need to be present
-//       if the avatar is not in view or in the keyhole.
+//  The full rate distance is the distance inside of which avatars get the highest distance priority,
+//  at twice the full rate distance an avatar has half the priority
+const float FULL_RATE_DISTANCE = 2.0f;
+
+// avatars straight behind the listener still get sent, at this fraction of the priority of those straight ahead
+const float BEHIND_LISTENER_PRIORITY_RATIO = 0.25f;
+
+static float calculateAvatarPriority(const glm::vec3& listenerPosition, const glm::vec3& listenerViewDirection,
+                                     const glm::vec3& avatarPosition, quint64 framesSinceSent) {
+    glm::vec3 listenerToAvatar = avatarPosition - listenerPosition;
+    float distanceToAvatar = glm::length(listenerToAvatar);
+    
+    float distancePriority = FULL_RATE_DISTANCE / glm::max(distanceToAvatar, FULL_RATE_DISTANCE);
+    
+    float viewPriority = 1.0f;
+    if (distanceToAvatar > EPSILON) {
+        float cosViewAngle = glm::dot(listenerViewDirection, listenerToAvatar / distanceToAvatar);
+        viewPriority = BEHIND_LISTENER_PRIORITY_RATIO + (1.0f - BEHIND_LISTENER_PRIORITY_RATIO) * 0.5f * (1.0f + cosViewAngle);
+    }
+    
+    // the longer an avatar has waited the more it needs an update, so far away avatars still get their turn
+    return distancePriority * viewPriority * framesSinceSent;
+}
+
+static bool hasHigherPriority(const PrioritizedAvatar& a, const PrioritizedAvatar& b) {
+    return a.priority > b.priority;
+}
+
 void AvatarMixer::broadcastAvatarData() {
     
     int idleTime = QDateTime::currentMSecsSinceEpoch() - _lastFrameTimestamp;
     
     ++_numStatFrames;
     
+    // avatars are encoded at most once per frame, the first time they are sent to someone
+    ++_broadcastFrameNumber;
+    
     const float STRUGGLE_TRIGGER_SLEEP_PERCENTAGE_THRESHOLD = 0.10f;
     const float BACK_OFF_TRIGGER_SLEEP_PERCENTAGE_THRESHOLD = 0.20f;
     
@@ -122,6 +165,12 @@ void AvatarMixer::broadcastAvatarData() {
     AvatarMixerClientData* nodeData = NULL;
     AvatarMixerClientData* otherNodeData = NULL;
     
+    // when we're struggling every listener's budget shrinks, rather than randomly dropping avatars
+    int listenerBudgetBytes = (int) ((1.0f - _performanceThrottlingRatio) * _listenerBytesPerFrame);
+    
+    // the frame's packets to every listener go out together
+    nodeList->beginDatagramBatch();
+    
     nodeList->eachNode([&](const SharedNodePointer& node) {
         if (node->getLinkedData() && node->getType() == NodeType::Agent && node->getActiveSocket()
             && (nodeData = reinterpret_cast<AvatarMixerClientData*>(node->getLinkedData()))->getMutex().tryLock()) {
@@ -132,98 +181,182 @@ void AvatarMixer::broadcastAvatarData() {
             
             AvatarData& avatar = nodeData->getAvatar();
             glm::vec3 myPosition = avatar.getPosition();
+            glm::vec3 myViewDirection = avatar.getHeadOrientation() * IDENTITY_FRONT;
+            
+            // rank every other avatar by how much this listener needs an update for it - closer avatars, ones in front
+            // of the listener and ones that have waited longer since they were last sent come first
+            _prioritizedAvatars.clear();
+            
+            auto prioritizeAvatar = [&](const SharedNodePointer& otherNode, const QUuid& avatarUUID,
+                                        const glm::vec3& otherPosition) {
+                quint64 framesSinceSent = nodeData->getFramesSinceAvatarSent(avatarUUID, _broadcastFrameNumber);
+                
+                PrioritizedAvatar prioritizedAvatar = { otherNode, avatarUUID,
+                    calculateAvatarPriority(myPosition, myViewDirection, otherPosition, framesSinceSent),
+                    framesSinceSent };
+                _prioritizedAvatars.push_back(prioritizedAvatar);
+            };
             
-            // this is an AGENT we have received head data from
-            // send back a packet with other active node data to this node
             nodeList->eachNode([&](const SharedNodePointer& otherNode) {
                 if (otherNode->getLinkedData() && otherNode->getUUID() != node->getUUID()
                     && (otherNodeData = reinterpret_cast<AvatarMixerClientData*>(otherNode->getLinkedData()))->getMutex().tryLock()) {
+                    prioritizeAvatar(otherNode, otherNode->getUUID(), otherNodeData->getAvatar().getPosition());
                     
-                    AvatarMixerClientData* otherNodeData = reinterpret_cast<AvatarMixerClientData*>(otherNode->getLinkedData());
-                    AvatarData& otherAvatar = otherNodeData->getAvatar();
-                    glm::vec3 otherPosition = otherAvatar.getPosition();
-            
-                    float distanceToAvatar = glm::length(myPosition - otherPosition);
-                    //  The full rate distance is the distance at which EVERY update will be sent for this avatar
-                    //  at a distance of twice the full rate distance, there will be a 50% chance of sending this avatar's update
-                    const float FULL_RATE_DISTANCE = 2.0f;
-                    
-                    //  Decide whether to send this avatar's data based on it's distance from us
-                    if ((_performanceThrottlingRatio == 0 || randFloat() < (1.0f - _performanceThrottlingRatio))
-                        && (distanceToAvatar == 0.0f || randFloat() < FULL_RATE_DISTANCE / distanceToAvatar)) {
-                        QByteArray avatarByteArray;
-                        avatarByteArray.append(otherNode->getUUID().toRfc4122());
-                        avatarByteArray.append(otherAvatar.toByteArray());
-                        
-                        if (avatarByteArray.size() + mixedAvatarByteArray.size() > MAX_PACKET_SIZE) {
-                            nodeList->writeDatagram(mixedAvatarByteArray, node);
-                            
-                            // reset the packet
-                            mixedAvatarByteArray.resize(numPacketHeaderBytes);
-                        }
-                        
-                        // copy the avatar into the mixedAvatarByteArray packet
-                        mixedAvatarByteArray.append(avatarByteArray);
-                        
-                        // if the receiving avatar has just connected make sure we send out the mesh and billboard
-                        // for this avatar (assuming they exist)
-                        bool forceSend = !nodeData->checkAndSetHasReceivedFirstPackets();
-                        
-                        // we will also force a send of billboard or identity packet
-                        // if either has changed in the last frame
-                        
-                        if (otherNodeData->getBillboardChangeTimestamp() > 0
-                            && (forceSend
-                                || otherNodeData->getBillboardChangeTimestamp() > _lastFrameTimestamp
-                                || randFloat() < BILLBOARD_AND_IDENTITY_SEND_PROBABILITY)) {
-                            QByteArray billboardPacket = byteArrayWithPopulatedHeader(PacketTypeAvatarBillboard);
-                            billboardPacket.append(otherNode->getUUID().toRfc4122());
-                            billboardPacket.append(otherNodeData->getAvatar().getBillboard());
-                            nodeList->writeDatagram(billboardPacket, node);
-                            
-                            ++_sumBillboardPackets;
-                        }
-                        
-                        if (otherNodeData->getIdentityChangeTimestamp() > 0
-                            && (forceSend
-                                || otherNodeData->getIdentityChangeTimestamp() > _lastFrameTimestamp
-                                || randFloat() < BILLBOARD_AND_IDENTITY_SEND_PROBABILITY)) {
-                                
-                            QByteArray identityPacket = byteArrayWithPopulatedHeader(PacketTypeAvatarIdentity);
-                            
-                            QByteArray individualData = otherNodeData->getAvatar().identityByteArray();
-                            individualData.replace(0, NUM_BYTES_RFC4122_UUID, otherNode->getUUID().toRfc4122());
-                            identityPacket.append(individualData);
-                            
-                            nodeList->writeDatagram(identityPacket, node);
-                                
-                            ++_sumIdentityPackets;
-                        }
+                    // the avatars of the scripts an agent hosts compete for the listener's budget like any other
+                    QHash<QUuid, AvatarMixerClientData*>::const_iterator hostedAvatar;
+                    for (hostedAvatar = otherNodeData->getHostedAvatars().constBegin();
+                         hostedAvatar != otherNodeData->getHostedAvatars().constEnd(); ++hostedAvatar) {
+                        prioritizeAvatar(otherNode, hostedAvatar.key(), hostedAvatar.value()->getAvatar().getPosition());
                     }
-                
+                    
                     otherNodeData->getMutex().unlock();
                 }
             });
             
+            std::sort(_prioritizedAvatars.begin(), _prioritizedAvatars.end(), hasHigherPriority);
+            
+            // fill this listener's budget in priority order, the top avatar always goes out so a tiny budget can't
+            // starve everyone
+            int bytesSent = 0;
+            
+            for (size_t i = 0; i < _prioritizedAvatars.size(); i++) {
+                const SharedNodePointer& otherNode = _prioritizedAvatars[i].node;
+                const QUuid& avatarUUID = _prioritizedAvatars[i].avatarUUID;
+                
+                if (i > 0 && bytesSent >= listenerBudgetBytes) {
+                    // out of budget, everyone left waits for a later frame
+                    ++_sumStarvedAvatars;
+                    _maxFramesAvatarStarved = std::max(_maxFramesAvatarStarved, _prioritizedAvatars[i].framesSinceSent);
+                    continue;
+                }
+                
+                if (!(otherNodeData = reinterpret_cast<AvatarMixerClientData*>(otherNode->getLinkedData()))->getMutex().tryLock()) {
+                    continue;
+                }
+                
+                AvatarMixerClientData* avatarData = (avatarUUID == otherNode->getUUID())
+                    ? otherNodeData : otherNodeData->getHostedAvatar(avatarUUID);
+                if (!avatarData) {
+                    // the hosted avatar went away since we ranked it
+                    otherNodeData->getMutex().unlock();
+                    continue;
+                }
+                
+                avatarData->encodeAvatarForFrame(avatarUUID, _broadcastFrameNumber, _jointRotationBits);
+                
+                // a listener that doesn't have the avatar's current keyframe gets it first,
+                // followed by this frame's delta against it
+                bool needsKeyframe = !nodeData->hasBeenSentKeyframe(avatarUUID, avatarData->getKeyframeSequence());
+                const QByteArray& deltaByteArray = avatarData->getDeltaByteArray();
+                
+                int avatarBytes = deltaByteArray.size();
+                if (needsKeyframe) {
+                    avatarBytes += avatarData->getKeyframeByteArray().size();
+                }
+                
+                if (avatarBytes + mixedAvatarByteArray.size() > MAX_PACKET_SIZE) {
+                    nodeList->writeDatagram(mixedAvatarByteArray, node);
+                    
+                    // reset the packet
+                    mixedAvatarByteArray.resize(numPacketHeaderBytes);
+                }
+                
+                // copy the avatar into the mixedAvatarByteArray packet
+                if (needsKeyframe) {
+                    mixedAvatarByteArray.append(avatarData->getKeyframeByteArray());
+                    nodeData->setSentKeyframe(avatarUUID, avatarData->getKeyframeSequence());
+                    
+                    ++_sumKeyframes;
+                }
+                mixedAvatarByteArray.append(deltaByteArray);
+                
+                bytesSent += avatarBytes;
+                nodeData->setAvatarSent(avatarUUID, _broadcastFrameNumber);
+                
+                // if the receiving avatar has just connected make sure we send out the mesh and billboard
+                // for this avatar (assuming they exist)
+                bool forceSend = !nodeData->checkAndSetHasReceivedFirstPackets();
+                
+                // we will also force a send of billboard or identity packet
+                // if either has changed in the last frame
+                
+                if (avatarData->getBillboardChangeTimestamp() > 0
+                    && (forceSend
+                        || avatarData->getBillboardChangeTimestamp() > _lastFrameTimestamp
+                        || randFloat() < BILLBOARD_AND_IDENTITY_SEND_PROBABILITY)) {
+                    QByteArray billboardPacket = byteArrayWithPopulatedHeader(PacketTypeAvatarBillboard);
+                    billboardPacket.append(avatarUUID.toRfc4122());
+                    billboardPacket.append(avatarData->getAvatar().getBillboard());
+                    nodeList->writeDatagram(billboardPacket, node);
+                    
+                    ++_sumBillboardPackets;
+                }
+                
+                if (avatarData->getIdentityChangeTimestamp() > 0
+                    && (forceSend
+                        || avatarData->getIdentityChangeTimestamp() > _lastFrameTimestamp
+                        || randFloat() < BILLBOARD_AND_IDENTITY_SEND_PROBABILITY)) {
+                    
+                    QByteArray identityPacket = byteArrayWithPopulatedHeader(PacketTypeAvatarIdentity);
+                    
+                    QByteArray individualData = avatarData->getAvatar().identityByteArray();
+                    individualData.replace(0, NUM_BYTES_RFC4122_UUID, avatarUUID.toRfc4122());
+                    identityPacket.append(individualData);
+                    
+                    nodeList->writeDatagram(identityPacket, node);
+                    
+                    ++_sumIdentityPackets;
+                }
+                
+                otherNodeData->getMutex().unlock();
+            }
+            
+            _sumListenerBytes += bytesSent;
+            
             nodeList->writeDatagram(mixedAvatarByteArray, node);
             
             nodeData->getMutex().unlock();
         }
     });
     
+    nodeList->flushDatagramBatch();
+    
     _lastFrameTimestamp = QDateTime::currentMSecsSinceEpoch();
 }
 
+void AvatarMixer::killAvatar(const QUuid& avatarUUID, const SharedNodePointer& avatarNode) {
+    // send a kill packet for it to our other nodes
+    QByteArray killPacket = byteArrayWithPopulatedHeader(PacketTypeKillAvatar);
+    killPacket += avatarUUID.toRfc4122();
+    
+    NodeList::getInstance()->broadcastToNodes(killPacket,
+                                              NodeSet() << NodeType::Agent);
+    
+    // and the other listeners no longer need to know what they were sent of it
+    NodeList::getInstance()->eachNode([&](const SharedNodePointer& node) {
+        if (node->getLinkedData() && node != avatarNode) {
+            AvatarMixerClientData* nodeData = reinterpret_cast<AvatarMixerClientData*>(node->getLinkedData());
+            QMutexLocker locker(&nodeData->getMutex());
+            nodeData->removeSentAvatar(avatarUUID);
+        }
+    });
+}
+
 void AvatarMixer::nodeKilled(SharedNodePointer killedNode) {
     if (killedNode->getType() == NodeType::Agent
         && killedNode->getLinkedData()) {
-        // this was an avatar we were sending to other people
-        // send a kill packet for it to our other nodes
-        QByteArray killPacket = byteArrayWithPopulatedHeader(PacketTypeKillAvatar);
-        killPacket += killedNode->getUUID().toRfc4122();
+        // this was an avatar we were sending to other people, as were those of the scripts it hosted
+        AvatarMixerClientData* killedNodeData = reinterpret_cast<AvatarMixerClientData*>(killedNode->getLinkedData());
+        QList<QUuid> hostedAvatarUUIDs;
+        {
+            QMutexLocker locker(&killedNodeData->getMutex());
+            hostedAvatarUUIDs = killedNodeData->getHostedAvatars().keys();
+        }
         
-        NodeList::getInstance()->broadcastToNodes(killPacket,
-                                                  NodeSet() << NodeType::Agent);
+        killAvatar(killedNode->getUUID(), killedNode);
+        foreach (const QUuid& hostedAvatarUUID, hostedAvatarUUIDs) {
+            killAvatar(hostedAvatarUUID, killedNode);
+        }
     }
 }
 
@@ -240,6 +373,14 @@ void AvatarMixer::readPendingDatagrams() {
                     nodeList->findNodeAndUpdateWithDataFromPacket(receivedPacket);
                     break;
                 }
+                case PacketTypeHostedAvatarData: {
+                    // only the agents the domain assigned host the avatars of scripts, a client only has its own
+                    SharedNodePointer hostNode = nodeList->sendingNodeForPacket(receivedPacket);
+                    if (hostNode && hostNode->isAssignment()) {
+                        nodeList->updateNodeWithDataFromPacket(hostNode, receivedPacket);
+                    }
+                    break;
+                }
                 case PacketTypeAvatarIdentity: {
                     
                     // check if we have a matching node in our list
@@ -247,12 +388,15 @@ void AvatarMixer::readPendingDatagrams() {
                     
                     if (avatarNode && avatarNode->getLinkedData()) {
                         AvatarMixerClientData* nodeData = reinterpret_cast<AvatarMixerClientData*>(avatarNode->getLinkedData());
-                        AvatarData& avatar = nodeData->getAvatar();
+                        QMutexLocker nodeDataLocker(&nodeData->getMutex());
+                        
+                        // the identity is for the node's own avatar or one of those of the scripts it hosts
+                        AvatarMixerClientData* avatarData = nodeData->getAvatarForIdentityPacket(receivedPacket,
+                                                                                                 avatarNode->getUUID());
                         
                         // parse the identity packet and update the change timestamp if appropriate
-                        if (avatar.hasIdentityChangedAfterParsing(receivedPacket)) {
-                            QMutexLocker nodeDataLocker(&nodeData->getMutex());
-                            nodeData->setIdentityChangeTimestamp(QDateTime::currentMSecsSinceEpoch());
+                        if (avatarData && avatarData->getAvatar().hasIdentityChangedAfterParsing(receivedPacket)) {
+                            avatarData->setIdentityChangeTimestamp(QDateTime::currentMSecsSinceEpoch());
                         }
                     }
                     break;
@@ -276,6 +420,25 @@ void AvatarMixer::readPendingDatagrams() {
                     break;
                 }
                 case PacketTypeKillAvatar: {
+                    // an agent hosting scripts kills the avatar of each of them that stops being one, by its key for it
+                    SharedNodePointer avatarNode = nodeList->sendingNodeForPacket(receivedPacket);
+                    QUuid hostKey = QUuid::fromRfc4122(receivedPacket.mid(numBytesForPacketHeader(receivedPacket),
+                                                                          NUM_BYTES_RFC4122_UUID));
+                    
+                    if (avatarNode && avatarNode->getLinkedData() && !hostKey.isNull()
+                        && hostKey != avatarNode->getUUID()) {
+                        AvatarMixerClientData* nodeData = reinterpret_cast<AvatarMixerClientData*>(avatarNode->getLinkedData());
+                        QUuid avatarUUID;
+                        {
+                            QMutexLocker nodeDataLocker(&nodeData->getMutex());
+                            avatarUUID = nodeData->removeHostedAvatar(hostKey);
+                        }
+                        if (!avatarUUID.isNull()) {
+                            killAvatar(avatarUUID, avatarNode);
+                            break;
+                        }
+                    }
+                    
                     nodeList->processKillNode(receivedPacket);
                     break;
                 }
@@ -294,6 +457,17 @@ void AvatarMixer::sendStatsPacket() {
     
     statsObject["average_billboard_packets_per_frame"] = (float) _sumBillboardPackets / (float) _numStatFrames;
     statsObject["average_identity_packets_per_frame"] = (float) _sumIdentityPackets / (float) _numStatFrames;
+    statsObject["average_keyframes_per_frame"] = (float) _sumKeyframes / (float) _numStatFrames;
+    
+    statsObject["listener_budget_bytes_per_frame"] = (1.0f - _performanceThrottlingRatio) * _listenerBytesPerFrame;
+    if (_sumListeners > 0) {
+        statsObject["average_listener_bytes_per_frame"] = (float) _sumListenerBytes / (float) _sumListeners;
+        statsObject["average_starved_avatars_per_listener"] = (float) _sumStarvedAvatars / (float) _sumListeners;
+    } else {
+        statsObject["average_listener_bytes_per_frame"] = 0.0;
+        statsObject["average_starved_avatars_per_listener"] = 0.0;
+    }
+    statsObject["max_frames_avatar_starved"] = (double) _maxFramesAvatarStarved;
     
     statsObject["trailing_sleep_percentage"] = _trailingSleepRatio * 100;
     statsObject["performance_throttling_ratio"] = _performanceThrottlingRatio;
@@ -303,9 +477,39 @@ void AvatarMixer::sendStatsPacket() {
     _sumListeners = 0;
     _sumBillboardPackets = 0;
     _sumIdentityPackets = 0;
+    _sumKeyframes = 0;
+    _sumListenerBytes = 0;
+    _sumStarvedAvatars = 0;
+    _maxFramesAvatarStarved = 0;
     _numStatFrames = 0;
 }
 
+void AvatarMixer::parseSettingsObject(const QJsonObject& settingsObject) {
+    if (settingsObject.contains(AVATAR_MIXER_SETTINGS_KEY)) {
+        QJsonObject avatarMixerGroupObject = settingsObject[AVATAR_MIXER_SETTINGS_KEY].toObject();
+        
+        const QString JOINT_ROTATION_BITS = "joint_rotation_bits";
+        if (avatarMixerGroupObject[JOINT_ROTATION_BITS].isString()) {
+            bool ok = false;
+            int jointRotationBits = avatarMixerGroupObject[JOINT_ROTATION_BITS].toString().toInt(&ok);
+            if (ok && jointRotationBits >= MIN_JOINT_ROTATION_BITS && jointRotationBits <= MAX_JOINT_ROTATION_BITS) {
+                _jointRotationBits = jointRotationBits;
+                qDebug() << "Joint rotations will be sent with" << _jointRotationBits << "bits per component";
+            }
+        }
+        
+        const QString LISTENER_KBPS = "listener_kbps";
+        if (avatarMixerGroupObject[LISTENER_KBPS].isString()) {
+            bool ok = false;
+            int listenerKbps = avatarMixerGroupObject[LISTENER_KBPS].toString().toInt(&ok);
+            if (ok && listenerKbps > 0) {
+                _listenerBytesPerFrame = listenerKbps * AVATAR_DATA_SEND_INTERVAL_MSECS / CHAR_BIT;
+                qDebug() << "Each listener can be sent" << _listenerBytesPerFrame << "bytes of avatar data per frame";
+            }
+        }
+    }
+}
+
 void AvatarMixer::run() {
     ThreadedAssignment::commonInit(AVATAR_MIXER_LOGGING_NAME, NodeType::AvatarMixer);
     
@@ -314,6 +518,26 @@ void AvatarMixer::run() {
     
     nodeList->linkedDataCreateCallback = attachAvatarDataToNode;
     
+    // wait until we have the domain-server settings, otherwise we bail
+    DomainHandler& domainHandler = nodeList->getDomainHandler();
+    
+    qDebug() << "Waiting for domain settings from domain-server.";
+    
+    // block until we get the settingsRequestComplete signal
+    QEventLoop loop;
+    connect(&domainHandler, &DomainHandler::settingsReceived, &loop, &QEventLoop::quit);
+    connect(&domainHandler, &DomainHandler::settingsReceiveFail, &loop, &QEventLoop::quit);
+    domainHandler.requestDomainSettings();
+    loop.exec();
+    
+    if (domainHandler.getSettingsObject().isEmpty()) {
+        qDebug() << "Failed to retreive settings object from domain-server. Bailing on assignment.";
+        setFinished(true);
+        return;
+    }
+    
+    parseSettingsObject(domainHandler.getSettingsObject());
+    
     // setup the timer that will be fired on the broadcast thread
     QTimer* broadcastTimer = new QTimer();
     broadcastTimer->setInterval(AVATAR_DATA_SEND_INTERVAL_MSECS);
@@ -15,8 +15,17 @@
 #ifndef hifi_AvatarMixer_h
 #define hifi_AvatarMixer_h
 
+#include <vector>
+
 #include <ThreadedAssignment.h>
 
+struct PrioritizedAvatar {
+    SharedNodePointer node;
+    QUuid avatarUUID; // the node's own UUID, or that of one of the avatars of the scripts it hosts
+    float priority;
+    quint64 framesSinceSent;
+};
+
 /// Handles assignments of type AvatarMixer - distribution of avatar data to various clients
 class AvatarMixer : public ThreadedAssignment {
 public:
@@ -36,6 +45,11 @@ public slots:
 private:
     void broadcastAvatarData();
     
+    /// tells every listener that an avatar is gone, and forgets what they were sent of it
+    void killAvatar(const QUuid& avatarUUID, const SharedNodePointer& avatarNode);
+    
+    void parseSettingsObject(const QJsonObject& settingsObject);
+    
     QThread _broadcastThread;
     
     quint64 _lastFrameTimestamp;
@@ -45,8 +59,18 @@ private:
     
     int _sumListeners;
     int _numStatFrames;
+    quint64 _broadcastFrameNumber;
     int _sumBillboardPackets;
     int _sumIdentityPackets;
+    int _sumKeyframes;
+    qint64 _sumListenerBytes;
+    int _sumStarvedAvatars;
+    quint64 _maxFramesAvatarStarved;
+    
+    int _jointRotationBits;
+    int _listenerBytesPerFrame;
+    
+    std::vector<PrioritizedAvatar> _prioritizedAvatars; // reused for each listener on the broadcast thread
 };
 
 #endif // hifi_AvatarMixer_h
@@ -9,27 +9,123 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <QtCore/QDataStream>
+
 #include <PacketHeaders.h>
+#include <UUID.h>
 
 #include "AvatarMixerClientData.h"
 
+// a keyframe a second means a listener that lost one only has stale joints for up to a second
+const quint64 KEYFRAME_INTERVAL_FRAMES = 60;
+
 AvatarMixerClientData::AvatarMixerClientData() :
     NodeData(),
     _hasReceivedFirstPackets(false),
     _billboardChangeTimestamp(0),
-    _identityChangeTimestamp(0)
+    _identityChangeTimestamp(0),
+    _keyframe(),
+    _keyframeFrame(0),
+    _keyframeByteArray(),
+    _deltaByteArray(),
+    _encodedFrame(0),
+    _sentKeyframeSequences(),
+    _lastSentFrames(),
+    _hostedAvatars(),
+    _hostedAvatarUUIDs()
 {
     
 }
 
+AvatarMixerClientData::~AvatarMixerClientData() {
+    qDeleteAll(_hostedAvatars);
+}
+
 int AvatarMixerClientData::parseData(const QByteArray& packet) {
     // compute the offset to the data payload
     int offset = numBytesForPacketHeader(packet);
+    
+    if (packetTypeForPacket(packet) == PacketTypeHostedAvatarData) {
+        if (packet.size() < offset + NUM_BYTES_RFC4122_UUID) {
+            return packet.size();
+        }
+        QUuid hostKey = QUuid::fromRfc4122(packet.mid(offset, NUM_BYTES_RFC4122_UUID));
+        offset += NUM_BYTES_RFC4122_UUID;
+        
+        QUuid avatarUUID = _hostedAvatarUUIDs.value(hostKey);
+        if (avatarUUID.isNull()) {
+            if (_hostedAvatars.size() >= MAX_HOSTED_AVATARS_PER_NODE) {
+                return packet.size();
+            }
+            // a UUID of our own making can't be that of any other node or avatar
+            avatarUUID = QUuid::createUuid();
+            _hostedAvatarUUIDs.insert(hostKey, avatarUUID);
+            _hostedAvatars.insert(avatarUUID, new AvatarMixerClientData());
+        }
+        return NUM_BYTES_RFC4122_UUID + _hostedAvatars.value(avatarUUID)->getAvatar().parseDataAtOffset(packet, offset);
+    }
+    
     return _avatar.parseDataAtOffset(packet, offset);
 }
 
+QUuid AvatarMixerClientData::removeHostedAvatar(const QUuid& hostKey) {
+    QUuid avatarUUID = _hostedAvatarUUIDs.take(hostKey);
+    if (!avatarUUID.isNull()) {
+        delete _hostedAvatars.take(avatarUUID);
+    }
+    return avatarUUID;
+}
+
+AvatarMixerClientData* AvatarMixerClientData::getAvatarForIdentityPacket(const QByteArray& packet,
+                                                                         const QUuid& nodeUUID) {
+    QDataStream packetStream(packet);
+    packetStream.skipRawData(numBytesForPacketHeader(packet));
+    
+    QUuid hostKey;
+    packetStream >> hostKey;
+    
+    if (hostKey.isNull() || hostKey == nodeUUID) {
+        return this;
+    }
+    return getHostedAvatar(_hostedAvatarUUIDs.value(hostKey));
+}
+
 bool AvatarMixerClientData::checkAndSetHasReceivedFirstPackets() {
     bool oldValue = _hasReceivedFirstPackets;
     _hasReceivedFirstPackets = true;
     return oldValue;
 }
+
+void AvatarMixerClientData::encodeAvatarForFrame(const QUuid& nodeUUID, quint64 frameNumber, int jointRotationBits) {
+    if (_encodedFrame == frameNumber) {
+        return;
+    }
+    _encodedFrame = frameNumber;
+    
+    _deltaByteArray.clear();
+    
+    if (_keyframe.isValid && _keyframe.jointRotationBits == jointRotationBits
+        && frameNumber - _keyframeFrame < KEYFRAME_INTERVAL_FRAMES) {
+        QByteArray delta = _avatar.toDeltaByteArray(_keyframe);
+        
+        if (!delta.isEmpty()) {
+            _deltaByteArray = nodeUUID.toRfc4122();
+            _deltaByteArray.append(delta);
+            return;
+        }
+    }
+    
+    _keyframeByteArray = nodeUUID.toRfc4122();
+    _keyframeByteArray.append(_avatar.toKeyframeByteArray(_keyframe, _keyframe.sequence + 1, jointRotationBits));
+    _keyframeFrame = frameNumber;
+}
+
+bool AvatarMixerClientData::hasBeenSentKeyframe(const QUuid& avatarUUID, quint16 sequence) const {
+    QHash<QUuid, quint16>::const_iterator sentSequence = _sentKeyframeSequences.constFind(avatarUUID);
+    return sentSequence != _sentKeyframeSequences.constEnd() && sentSequence.value() == sequence;
+}
+
+void AvatarMixerClientData::removeSentAvatar(const QUuid& avatarUUID) {
+    _sentKeyframeSequences.remove(avatarUUID);
+    _lastSentFrames.remove(avatarUUID);
+}
@@ -12,19 +12,39 @@
 #ifndef hifi_AvatarMixerClientData_h
 #define hifi_AvatarMixerClientData_h
 
+#include <QtCore/QHash>
 #include <QtCore/QUrl>
+#include <QtCore/QUuid>
 
 #include <AvatarData.h>
 #include <NodeData.h>
 
+// the most avatars one agent may host, past which the avatars of any more of its scripts are ignored
+const int MAX_HOSTED_AVATARS_PER_NODE = 256;
+
 class AvatarMixerClientData : public NodeData {
     Q_OBJECT
 public:
     AvatarMixerClientData();
+    ~AvatarMixerClientData();
 
+    /// parses the node's own avatar data, or that of one of the scripts it hosts, which is added on its first packet
     int parseData(const QByteArray& packet);
     AvatarData& getAvatar() { return _avatar; }
     
+    /// The avatars of the scripts an agent hosts, by the UUIDs we gave them. The agent names its avatars by keys of its
+    /// own, which go no further than us, so that nobody can pass their avatar off as someone else's. Each is sent to
+    /// listeners like the avatar of a separate node, and is guarded by the mutex of the hosting node's data.
+    const QHash<QUuid, AvatarMixerClientData*>& getHostedAvatars() const { return _hostedAvatars; }
+    AvatarMixerClientData* getHostedAvatar(const QUuid& avatarUUID) const { return _hostedAvatars.value(avatarUUID); }
+    
+    /// forgets the hosted avatar the agent knows by the key, returning the UUID it was sent to listeners with, or a null
+    /// UUID if the agent hosts no such avatar
+    QUuid removeHostedAvatar(const QUuid& hostKey);
+    
+    /// the data of the avatar an identity packet from this node is for, NULL for a hosted avatar we don't have yet
+    AvatarMixerClientData* getAvatarForIdentityPacket(const QByteArray& packet, const QUuid& nodeUUID);
+    
     bool checkAndSetHasReceivedFirstPackets();
     
     quint64 getBillboardChangeTimestamp() const { return _billboardChangeTimestamp; }
@@ -33,11 +53,46 @@ public:
     quint64 getIdentityChangeTimestamp() const { return _identityChangeTimestamp; }
     void setIdentityChangeTimestamp(quint64 identityChangeTimestamp) { _identityChangeTimestamp = identityChangeTimestamp; }
     
+    /// encodes the avatar for a broadcast frame, at most once per frame since every listener shares the result - a new
+    /// keyframe is started when the current one is due or the avatar can no longer be expressed as a delta against it
+    void encodeAvatarForFrame(const QUuid& nodeUUID, quint64 frameNumber, int jointRotationBits);
+    
+    /// the node UUID and the avatar's current keyframe as they are packed into bulk avatar packets
+    quint16 getKeyframeSequence() const { return _keyframe.sequence; }
+    const QByteArray& getKeyframeByteArray() const { return _keyframeByteArray; }
+    
+    /// the node UUID and this frame's delta against the keyframe, empty on the frame the keyframe itself was encoded
+    const QByteArray& getDeltaByteArray() const { return _deltaByteArray; }
+    
+    /// tracks which keyframe of each other avatar this listener has been sent
+    bool hasBeenSentKeyframe(const QUuid& avatarUUID, quint16 sequence) const;
+    void setSentKeyframe(const QUuid& avatarUUID, quint16 sequence) { _sentKeyframeSequences.insert(avatarUUID, sequence); }
+    
+    /// tracks when each other avatar was last sent to this listener, one that never was has waited since frame 0
+    quint64 getFramesSinceAvatarSent(const QUuid& avatarUUID, quint64 frameNumber) const
+        { return frameNumber - _lastSentFrames.value(avatarUUID, 0); }
+    void setAvatarSent(const QUuid& avatarUUID, quint64 frameNumber) { _lastSentFrames.insert(avatarUUID, frameNumber); }
+    
+    /// forgets what this listener was sent of an avatar that has gone away
+    void removeSentAvatar(const QUuid& avatarUUID);
+    
 private:
     AvatarData _avatar;
     bool _hasReceivedFirstPackets;
     quint64 _billboardChangeTimestamp;
     quint64 _identityChangeTimestamp;
+    
+    AvatarDataKeyframe _keyframe;
+    quint64 _keyframeFrame;
+    QByteArray _keyframeByteArray;
+    QByteArray _deltaByteArray;
+    quint64 _encodedFrame;
+    
+    QHash<QUuid, quint16> _sentKeyframeSequences;
+    QHash<QUuid, quint64> _lastSentFrames;
+    
+    QHash<QUuid, AvatarMixerClientData*> _hostedAvatars;
+    QHash<QUuid, QUuid> _hostedAvatarUUIDs; // the UUIDs we gave the hosted avatars, by the agent's keys for them
 };
 
 #endif // hifi_AvatarMixerClientData_h
@@ -0,0 +1,48 @@
+//
+//  EntityPhysicsThread.cpp
+//  assignment-client/src/entities
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <EntityTree.h>
+#include <PhysicsEngine.h>
+#include <SharedUtil.h>
+
+#include "EntityPhysicsThread.h"
+
+// one step of the engine's fixed substep, a step we're late for is taken right away
+const quint64 USECS_PER_PHYSICS_STEP = USECS_PER_SECOND / 60;
+
+EntityPhysicsThread::EntityPhysicsThread(PhysicsEngine* physicsEngine, EntityTree* tree) :
+    _physicsEngine(physicsEngine),
+    _tree(tree),
+    _nextStepUsecs(0)
+{
+
+}
+
+bool EntityPhysicsThread::process() {
+#ifdef USE_BULLET_PHYSICS
+    quint64 now = usecTimestampNow();
+    if (now < _nextStepUsecs) {
+        usleep(_nextStepUsecs - now);
+    } else if (now - _nextStepUsecs > USECS_PER_PHYSICS_STEP) {
+        // we've fallen more than a step behind (or this is the first step), the engine takes care of catching up
+        // so start counting from here rather than stepping back to back
+        _nextStepUsecs = now;
+    }
+    _nextStepUsecs += USECS_PER_PHYSICS_STEP;
+
+    _physicsEngine->stepSimulation();
+
+    // copy what needs to be sent out of the engine and into the tree, where it goes out to our clients
+    _tree->update();
+#endif // USE_BULLET_PHYSICS
+
+    return isStillRunning();
+}
@@ -0,0 +1,36 @@
+//
+//  EntityPhysicsThread.h
+//  assignment-client/src/entities
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_EntityPhysicsThread_h
+#define hifi_EntityPhysicsThread_h
+
+#include <GenericThread.h>
+
+class EntityTree;
+class PhysicsEngine;
+
+/// Steps the entity server's PhysicsEngine at the engine's fixed rate, and sends what it changes on to the tree.
+class EntityPhysicsThread : public GenericThread {
+    Q_OBJECT
+public:
+    EntityPhysicsThread(PhysicsEngine* physicsEngine, EntityTree* tree);
+
+protected:
+    /// Implements generic processing behavior for this thread.
+    virtual bool process();
+
+private:
+    PhysicsEngine* _physicsEngine;
+    EntityTree* _tree;
+    quint64 _nextStepUsecs;
+};
+
+#endif // hifi_EntityPhysicsThread_h
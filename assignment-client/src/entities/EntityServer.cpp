@@ -11,6 +11,7 @@
 
 #include <QTimer>
 #include <EntityTree.h>
+#include <PhysicsEngine.h>
 #include <SimpleEntitySimulation.h>
 
 #include "EntityServer.h"
@@ -22,11 +23,12 @@ const char* MODEL_SERVER_LOGGING_TARGET_NAME = "entity-server";
 const char* LOCAL_MODELS_PERSIST_FILE = "resources/models.svo";
 
 EntityServer::EntityServer(const QByteArray& packet) 
-    :   OctreeServer(packet), _entitySimulation(NULL) {
+    :   OctreeServer(packet), _entitySimulation(NULL), _wantPhysicsSimulation(false), _physicsThread(NULL) {
     // nothing special to do here...
 }
 
 EntityServer::~EntityServer() {
+    delete _physicsThread;
     EntityTree* tree = (EntityTree*)_tree;
     tree->removeNewlyCreatedHook(this);
 }
@@ -47,7 +49,48 @@ Octree* EntityServer::createTree() {
     return tree;
 }
 
+void EntityServer::readAdditionalConfiguration(const QJsonObject& settingsSectionObject) {
+    // when set we run the physics for our entities, instead of each of our clients running it for themselves
+    readOptionBool(QString("physicsSimulation"), settingsSectionObject, _wantPhysicsSimulation);
+    qDebug("physicsSimulation=%s", debug::valueOf(_wantPhysicsSimulation));
+}
+
+void EntityServer::installPhysicsSimulation() {
+#ifdef USE_BULLET_PHYSICS
+    // our tree hasn't been loaded yet, so the simple simulation has no entities to hand over
+    EntityTree* tree = static_cast<EntityTree*>(_tree);
+    PhysicsEngine* physicsEngine = new PhysicsEngine(glm::vec3(0.0f));
+    physicsEngine->setEntityTree(tree);
+
+    tree->lockForWrite();
+    tree->setSimulation(physicsEngine);
+    tree->unlock();
+
+    delete _entitySimulation;
+    _entitySimulation = physicsEngine;
+
+    // without a packet sender the engine is the authority on its entities
+    physicsEngine->init(NULL);
+
+    _physicsThread = new EntityPhysicsThread(physicsEngine, tree);
+    _physicsThread->initialize(true);
+#else
+    qDebug() << "physicsSimulation is set but this entity server was built without physics, using the simple simulation.";
+#endif // USE_BULLET_PHYSICS
+}
+
+void EntityServer::aboutToFinish() {
+    if (_physicsThread) {
+        _physicsThread->terminate();
+    }
+    OctreeServer::aboutToFinish();
+}
+
 void EntityServer::beforeRun() {
+    if (_wantPhysicsSimulation) {
+        installPhysicsSimulation();
+    }
+
     QTimer* pruneDeletedEntitiesTimer = new QTimer(this);
     connect(pruneDeletedEntitiesTimer, SIGNAL(timeout()), this, SLOT(pruneDeletedEntities()));
     const int PRUNE_DELETED_MODELS_INTERVAL_MSECS = 1 * 1000; // once every second
@@ -108,6 +151,9 @@ int EntityServer::sendSpecialPacket(const SharedNodePointer& node, OctreeQueryNo
         EntityTree* tree = static_cast<EntityTree*>(_tree);
         bool hasMoreToSend = true;
 
+        // an entity the client is told is gone is one it no longer has
+        tree->removeEntitiesDeletedSince(deletedEntitiesSentAt, queryNode->sentItems);
+
         // TODO: is it possible to send too many of these packets? what if you deleted 1,000,000 entities?
         packetsSent = 0;
         while (hasMoreToSend) {
@@ -15,6 +15,7 @@
 #include "../octree/OctreeServer.h"
 
 #include "EntityItem.h"
+#include "EntityPhysicsThread.h"
 #include "EntityServerConsts.h"
 #include "EntityTree.h"
 
@@ -42,14 +43,21 @@ public:
 
     virtual void entityCreated(const EntityItem& newEntity, const SharedNodePointer& senderNode);
 
+    virtual void aboutToFinish();
+
 public slots:
     void pruneDeletedEntities();
 
 protected:
     virtual Octree* createTree();
+    virtual void readAdditionalConfiguration(const QJsonObject& settingsSectionObject);
 
 private:
+    void installPhysicsSimulation();
+
     EntitySimulation* _entitySimulation;
+    bool _wantPhysicsSimulation;
+    EntityPhysicsThread* _physicsThread;
 };
 
 #endif // hifi_EntityServer_h
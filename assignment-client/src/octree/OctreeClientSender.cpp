@@ -1,5 +1,5 @@
 //
-//  OctreeSendThread.cpp
+//  OctreeClientSender.cpp
 //  assignment-client/src/octree
 //
 //  Created by Brad Hefta-Gaub on 8/21/13.
@@ -11,114 +11,48 @@
 
 #include <NodeList.h>
 #include <PacketHeaders.h>
-#include <PerfStat.h>
 #include <SharedUtil.h>
 
-#include "OctreeSendThread.h"
+#include "OctreeClientSender.h"
 #include "OctreeServer.h"
 #include "OctreeServerConsts.h"
 
-quint64 startSceneSleepTime = 0;
-quint64 endSceneSleepTime = 0;
-
-OctreeSendThread::OctreeSendThread(const SharedAssignmentPointer& myAssignment, const SharedNodePointer& node) :
-    _myAssignment(myAssignment),
-    _myServer(static_cast<OctreeServer*>(myAssignment.data())),
-    _node(node),
-    _nodeUUID(node->getUUID()),
-    _packetData(),
-    _nodeMissingCount(0),
-    _isShuttingDown(false)
+OctreeClientSender::OctreeClientSender(OctreeServer* myServer) :
+    _myServer(myServer),
+    _safeServerName(myServer->getMyServerName()),
+    _packetData()
 {
-    QString safeServerName("Octree");
-    if (_myServer) {
-        safeServerName = _myServer->getMyServerName();
-    }
-    qDebug() << qPrintable(safeServerName)  << "server [" << _myServer << "]: client connected "
-                                            "- starting sending thread [" << this << "]";
+    qDebug() << qPrintable(_safeServerName)  << "server [" << _myServer << "]: client connected "
+                                            "- created client sender [" << this << "]";
 
     OctreeServer::clientConnected();
 }
 
-OctreeSendThread::~OctreeSendThread() {
-    QString safeServerName("Octree");
-    if (_myServer) {
-        safeServerName = _myServer->getMyServerName();
-    }
-    
-    qDebug() << qPrintable(safeServerName)  << "server [" << _myServer << "]: client disconnected "
-                                            "- ending sending thread [" << this << "]";
+OctreeClientSender::~OctreeClientSender() {
+    // the node data that owns us can outlive the server, so don't call back into it here
+    qDebug() << qPrintable(_safeServerName)  << "server: client disconnected "
+                                            "- deleting client sender [" << this << "]";
 
     OctreeServer::clientDisconnected();
     OctreeServer::stopTrackingThread(this);
-
-    _node.clear();
-    _myAssignment.clear();
-}
-
-void OctreeSendThread::setIsShuttingDown() {
-    _isShuttingDown = true;
 }
 
-
-bool OctreeSendThread::process() {
-    if (_isShuttingDown) {
-        return false; // exit early if we're shutting down
-    }
-
-    // check that our server and assignment is still valid
-    if (!_myServer || !_myAssignment) {
-        return false; // exit early if it's not, it means the server is shutting down
-    }
-
+void OctreeClientSender::sendPacketsForInterval(const SharedNodePointer& node, OctreeQueryNode* nodeData) {
     OctreeServer::didProcess(this);
 
-    quint64  start = usecTimestampNow();
-
     // don't do any send processing until the initial load of the octree is complete...
-    if (_myServer->isInitialLoadComplete()) {
-        if (_node) {
-            _nodeMissingCount = 0;
-            OctreeQueryNode* nodeData = static_cast<OctreeQueryNode*>(_node->getLinkedData());
-
-            // Sometimes the node data has not yet been linked, in which case we can't really do anything
-            if (nodeData && !nodeData->isShuttingDown()) {
-                bool viewFrustumChanged = nodeData->updateCurrentViewFrustum();
-                packetDistributor(nodeData, viewFrustumChanged);
-            }
-        }
-    }
-
-    if (_isShuttingDown) {
-        return false; // exit early if we're shutting down
-    }
-
-    // Only sleep if we're still running and we got the lock last time we tried, otherwise try to get the lock asap
-    if (isStillRunning()) {
-        // dynamically sleep until we need to fire off the next set of octree elements
-        int elapsed = (usecTimestampNow() - start);
-        int usecToSleep =  OCTREE_SEND_INTERVAL_USECS - elapsed;
-
-        if (usecToSleep > 0) {
-            PerformanceWarning warn(false,"OctreeSendThread... usleep()",false,&_usleepTime,&_usleepCalls);
-            usleep(usecToSleep);
-        } else {
-            const int MIN_USEC_TO_SLEEP = 1;
-            usleep(MIN_USEC_TO_SLEEP);
-        }
+    if (_myServer->isInitialLoadComplete() && !nodeData->isShuttingDown()) {
+        bool viewFrustumChanged = nodeData->updateCurrentViewFrustum();
+        packetDistributor(node, nodeData, viewFrustumChanged);
     }
-
-    return isStillRunning();  // keep running till they terminate us
 }
 
-quint64 OctreeSendThread::_usleepTime = 0;
-quint64 OctreeSendThread::_usleepCalls = 0;
-
-quint64 OctreeSendThread::_totalBytes = 0;
-quint64 OctreeSendThread::_totalWastedBytes = 0;
-quint64 OctreeSendThread::_totalPackets = 0;
+quint64 OctreeClientSender::_totalBytes = 0;
+quint64 OctreeClientSender::_totalWastedBytes = 0;
+quint64 OctreeClientSender::_totalPackets = 0;
 
-int OctreeSendThread::handlePacketSend(OctreeQueryNode* nodeData, int& trueBytesSent, int& truePacketsSent) {
+int OctreeClientSender::handlePacketSend(const SharedNodePointer& node, OctreeQueryNode* nodeData,
+                                         int& trueBytesSent, int& truePacketsSent) {
     OctreeServer::didHandlePacketSend(this);
                  
     // if we're shutting down, then exit early       
@@ -179,12 +113,12 @@ int OctreeSendThread::handlePacketSend(OctreeQueryNode* nodeData, int& trueBytes
 
             // actually send it
             OctreeServer::didCallWriteDatagram(this);
-            NodeList::getInstance()->writeDatagram((char*) statsMessage, statsMessageLength, _node);
+            NodeList::getInstance()->writeDatagram((char*) statsMessage, statsMessageLength, node);
             packetSent = true;
         } else {
             // not enough room in the packet, send two packets
             OctreeServer::didCallWriteDatagram(this);
-            NodeList::getInstance()->writeDatagram((char*) statsMessage, statsMessageLength, _node);
+            NodeList::getInstance()->writeDatagram((char*) statsMessage, statsMessageLength, node);
 
             // since a stats message is only included on end of scene, don't consider any of these bytes "wasted", since
             // there was nothing else to send.
@@ -213,7 +147,7 @@ int OctreeSendThread::handlePacketSend(OctreeQueryNode* nodeData, int& trueBytes
             packetsSent++;
 
             OctreeServer::didCallWriteDatagram(this);
-            NodeList::getInstance()->writeDatagram((char*)nodeData->getPacket(), nodeData->getPacketLength(), _node);
+            NodeList::getInstance()->writeDatagram((char*)nodeData->getPacket(), nodeData->getPacketLength(), node);
             packetSent = true;
 
             thisWastedBytes = MAX_PACKET_SIZE - nodeData->getPacketLength();
@@ -242,7 +176,7 @@ int OctreeSendThread::handlePacketSend(OctreeQueryNode* nodeData, int& trueBytes
         if (nodeData->isPacketWaiting() && !nodeData->isShuttingDown()) {
             // just send the octree packet
             OctreeServer::didCallWriteDatagram(this);
-            NodeList::getInstance()->writeDatagram((char*)nodeData->getPacket(), nodeData->getPacketLength(), _node);
+            NodeList::getInstance()->writeDatagram((char*)nodeData->getPacket(), nodeData->getPacketLength(), node);
             packetSent = true;
 
             int thisWastedBytes = MAX_PACKET_SIZE - nodeData->getPacketLength();
@@ -280,7 +214,8 @@ int OctreeSendThread::handlePacketSend(OctreeQueryNode* nodeData, int& trueBytes
 }
 
 /// Version of octree element distributor that sends the deepest LOD level at once
-int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrustumChanged) {
+int OctreeClientSender::packetDistributor(const SharedNodePointer& node, OctreeQueryNode* nodeData,
+                                          bool viewFrustumChanged) {
         
     OctreeServer::didPacketDistributor(this);
 
@@ -315,7 +250,7 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
     // then let's just send that waiting packet.
     if (!nodeData->getCurrentPacketFormatMatches()) {
         if (nodeData->isPacketWaiting()) {
-            packetsSentThisInterval += handlePacketSend(nodeData, trueBytesSent, truePacketsSent);
+            packetsSentThisInterval += handlePacketSend(node, nodeData, trueBytesSent, truePacketsSent);
         } else {
             nodeData->resetOctreePacket();
         }
@@ -357,7 +292,7 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
         //unsigned long encodeTime = nodeData->stats.getTotalEncodeTime();
         //unsigned long elapsedTime = nodeData->stats.getElapsedTime();
 
-        int packetsJustSent = handlePacketSend(nodeData, trueBytesSent, truePacketsSent);
+        int packetsJustSent = handlePacketSend(node, nodeData, trueBytesSent, truePacketsSent);
         packetsSentThisInterval += packetsJustSent;
 
         // If we're starting a full scene, then definitely we want to empty the elementBag
@@ -395,7 +330,6 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
         bool completedScene = false;
         
         while (somethingToSend && packetsSentThisInterval < maxPacketsPerInterval && !nodeData->isShuttingDown()) {
-            float lockWaitElapsedUsec = OctreeServer::SKIP_TIME;
             float encodeElapsedUsec = OctreeServer::SKIP_TIME;
             float compressAndWriteElapsedUsec = OctreeServer::SKIP_TIME;
             float packetSendingElapsedUsec = OctreeServer::SKIP_TIME;
@@ -404,11 +338,6 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
 
             bool lastNodeDidntFit = false; // assume each node fits
             if (!nodeData->elementBag.isEmpty()) {
-                
-                quint64 lockWaitStart = usecTimestampNow();
-                _myServer->getOctree()->lockForRead();
-                quint64 lockWaitEnd = usecTimestampNow();
-                lockWaitElapsedUsec = (float)(lockWaitEnd - lockWaitStart);
                 quint64 encodeStart = usecTimestampNow();
 
                 OctreeElement* subTree = nodeData->elementBag.extract();
@@ -449,10 +378,9 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
                                              nodeData->getLastTimeBagEmpty(),
                                              isFullScene, &nodeData->stats, _myServer->getJurisdiction(),
                                              &nodeData->extraEncodeData);
+                params.encodeCache = _myServer->getEncodeCache();
+                params.sentItems = &nodeData->sentItems;
 
-                // TODO: should this include the lock time or not? This stat is sent down to the client,
-                // it seems like it may be a good idea to include the lock time as part of the encode time
-                // are reported to client. Since you can encode without the lock
                 nodeData->stats.encodeStarted();
 
                 bytesWritten = _myServer->getOctree()->encodeTreeBitstream(subTree, &_packetData, nodeData->elementBag, params);
@@ -482,7 +410,6 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
                 }
 
                 nodeData->stats.encodeStopped();
-                _myServer->getOctree()->unlock();
             } else {
                 // If the bag was empty then we didn't even attempt to encode, and so we know the bytesWritten were 0
                 bytesWritten = 0;
@@ -508,7 +435,7 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
                             + (nodeData->getCurrentPacketIsCompressed() ? sizeof(OCTREE_PACKET_INTERNAL_SECTION_SIZE) : 0);
 
                     if (writtenSize > nodeData->getAvailable()) {
-                        packetsSentThisInterval += handlePacketSend(nodeData, trueBytesSent, truePacketsSent);
+                        packetsSentThisInterval += handlePacketSend(node, nodeData, trueBytesSent, truePacketsSent);
                     }
 
                     nodeData->writeToPacket(_packetData.getFinalizedData(), _packetData.getFinalizedSize());
@@ -530,7 +457,7 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
                 int targetSize = MAX_OCTREE_PACKET_DATA_SIZE;
                 if (sendNow) {
                     quint64 packetSendingStart = usecTimestampNow();
-                    packetsSentThisInterval += handlePacketSend(nodeData, trueBytesSent, truePacketsSent);
+                    packetsSentThisInterval += handlePacketSend(node, nodeData, trueBytesSent, truePacketsSent);
                     quint64 packetSendingEnd = usecTimestampNow();
                     packetSendingElapsedUsec = (float)(packetSendingEnd - packetSendingStart);
 
@@ -549,7 +476,6 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
                 _packetData.changeSettings(nodeData->getWantCompression(), targetSize); // will do reset
 
             }
-            OctreeServer::trackTreeWaitTime(lockWaitElapsedUsec);
             OctreeServer::trackEncodeTime(encodeElapsedUsec);
             OctreeServer::trackCompressAndWriteTime(compressAndWriteElapsedUsec);
             OctreeServer::trackPacketSendingTime(packetSendingElapsedUsec);
@@ -563,9 +489,9 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
         // Here's where we can/should allow the server to send other data...
         // send the environment packet
         // TODO: should we turn this into a while loop to better handle sending multiple special packets
-        if (_myServer->hasSpecialPacketToSend(_node) && !nodeData->isShuttingDown()) {
+        if (_myServer->hasSpecialPacketToSend(node) && !nodeData->isShuttingDown()) {
             int specialPacketsSent;
-            trueBytesSent += _myServer->sendSpecialPacket(_node, nodeData, specialPacketsSent);
+            trueBytesSent += _myServer->sendSpecialPacket(node, nodeData, specialPacketsSent);
             nodeData->resetOctreePacket();   // because nodeData's _sequenceNumber has changed
             truePacketsSent += specialPacketsSent;
             packetsSentThisInterval += specialPacketsSent;
@@ -575,7 +501,7 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
         while (nodeData->hasNextNackedPacket() && packetsSentThisInterval < maxPacketsPerInterval) {
             const QByteArray* packet = nodeData->getNextNackedPacket();
             if (packet) {
-                NodeList::getInstance()->writeDatagram(*packet, _node);
+                NodeList::getInstance()->writeDatagram(*packet, node);
                 truePacketsSent++;
                 packetsSentThisInterval++;
 
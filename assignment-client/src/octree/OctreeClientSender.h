@@ -0,0 +1,51 @@
+//
+//  OctreeClientSender.h
+//  assignment-client/src/octree
+//
+//  Created by Brad Hefta-Gaub on 8/21/13.
+//  Copyright 2013 High Fidelity, Inc.
+//
+//  Per client state for sending octree data packets, driven by the server's OctreeSendWorkerPool
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreeClientSender_h
+#define hifi_OctreeClientSender_h
+
+#include <NetworkPacket.h>
+#include <OctreeElementBag.h>
+
+#include "OctreeQueryNode.h"
+
+class OctreeServer;
+
+/// Encodes and sends octree packets to a single client. Owned by the client's OctreeQueryNode, and called by whichever
+/// send worker picks the client up when its send interval comes due.
+class OctreeClientSender {
+public:
+    OctreeClientSender(OctreeServer* myServer);
+    ~OctreeClientSender();
+
+    /// sends the client its packets for this interval, the caller must hold the read lock of the server's octree
+    void sendPacketsForInterval(const SharedNodePointer& node, OctreeQueryNode* nodeData);
+
+    static quint64 _totalBytes;
+    static quint64 _totalWastedBytes;
+    static quint64 _totalPackets;
+
+private:
+    OctreeClientSender(const OctreeClientSender&);
+    OctreeClientSender& operator= (const OctreeClientSender&);
+
+    int handlePacketSend(const SharedNodePointer& node, OctreeQueryNode* nodeData, int& trueBytesSent, int& truePacketsSent);
+    int packetDistributor(const SharedNodePointer& node, OctreeQueryNode* nodeData, bool viewFrustumChanged);
+
+    OctreeServer* _myServer;
+    QString _safeServerName;
+
+    OctreePacketData _packetData;
+};
+
+#endif // hifi_OctreeClientSender_h
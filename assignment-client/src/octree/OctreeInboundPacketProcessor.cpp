@@ -9,6 +9,7 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <algorithm>
 #include <limits>
 #include <PacketHeaders.h>
 #include <PerfStat.h>
@@ -20,6 +21,9 @@
 static QUuid DEFAULT_NODE_ID_REF;
 const quint64 TOO_LONG_SINCE_LAST_NACK = 1 * USECS_PER_SECOND;
 
+// the most edit packets applied under one write lock, so that the send threads aren't kept from reading for long
+const int MAX_EDIT_PACKETS_PER_BATCH = 64;
+
 OctreeInboundPacketProcessor::OctreeInboundPacketProcessor(OctreeServer* myServer) :
     _myServer(myServer),
     _receivedPacketCount(0),
@@ -28,6 +32,11 @@ OctreeInboundPacketProcessor::OctreeInboundPacketProcessor(OctreeServer* myServe
     _totalLockWaitTime(0),
     _totalElementsInPacket(0),
     _totalPackets(0),
+    _totalBatches(0),
+    _totalBatchPackets(0),
+    _totalBatchLockWaitTime(0),
+    _totalBatchLockHoldTime(0),
+    _batchLockWaitTimePerPacket(0),
     _lastNackTime(usecTimestampNow()),
     _shuttingDown(false)
 {
@@ -39,6 +48,10 @@ void OctreeInboundPacketProcessor::resetStats() {
     _totalLockWaitTime = 0;
     _totalElementsInPacket = 0;
     _totalPackets = 0;
+    _totalBatches = 0;
+    _totalBatchPackets = 0;
+    _totalBatchLockWaitTime = 0;
+    _totalBatchLockHoldTime = 0;
     _lastNackTime = usecTimestampNow();
 
     _singleSenderStats.clear();
@@ -72,12 +85,39 @@ void OctreeInboundPacketProcessor::midProcess() {
     }
 }
 
-void OctreeInboundPacketProcessor::processPacket(const SharedNodePointer& sendingNode, const QByteArray& packet) {
+void OctreeInboundPacketProcessor::processPackets(const QVector<NetworkPacket>& packets) {
     if (_shuttingDown) {
-        qDebug() << "OctreeInboundPacketProcessor::processPacket() while shutting down... ignoring incoming packet";
+        qDebug() << "OctreeInboundPacketProcessor::processPackets() while shutting down... ignoring incoming packets";
         return;
     }
 
+    Octree* octree = _myServer->getOctree();
+    for (int batchStart = 0; batchStart < packets.size(); batchStart += MAX_EDIT_PACKETS_PER_BATCH) {
+        int batchEnd = std::min(batchStart + MAX_EDIT_PACKETS_PER_BATCH, packets.size());
+
+        quint64 startLock = usecTimestampNow();
+        octree->lockForWrite();
+        quint64 startProcess = usecTimestampNow();
+        _batchLockWaitTimePerPacket = (startProcess - startLock) / (batchEnd - batchStart);
+
+        octree->beginEditBatch();
+        for (int i = batchStart; i < batchEnd; i++) {
+            processPacket(packets.at(i).getNode(), packets.at(i).getByteArray());
+        }
+        octree->endEditBatch();
+
+        octree->unlock();
+        quint64 endProcess = usecTimestampNow();
+
+        trackBatch(batchEnd - batchStart, startProcess - startLock, endProcess - startProcess);
+    }
+
+    // only once all of the packets are tracked, so that none of them are nacked as missing
+    midProcess();
+}
+
+void OctreeInboundPacketProcessor::processPacket(const SharedNodePointer& sendingNode, const QByteArray& packet) {
+
     bool debugProcessPacket = _myServer->wantsVerboseDebug();
 
     if (debugProcessPacket) {
@@ -108,7 +148,7 @@ void OctreeInboundPacketProcessor::processPacket(const SharedNodePointer& sendin
         quint64 transitTime = arrivedAt - sentAt;
         int editsInPacket = 0;
         quint64 processTime = 0;
-        quint64 lockWaitTime = 0;
+        quint64 lockWaitTime = _batchLockWaitTimePerPacket;
 
         if (debugProcessPacket || _myServer->wantsDebugReceiving()) {
             qDebug() << "PROCESSING THREAD: got '" << packetType << "' packet - " << _receivedPacketCount << " command from client";
@@ -152,8 +192,6 @@ void OctreeInboundPacketProcessor::processPacket(const SharedNodePointer& sendin
                         packetType, packetData, packet.size(), editData, atByte, maxSize);
             }
 
-            quint64 startLock = usecTimestampNow();
-            _myServer->getOctree()->lockForWrite();
             quint64 startProcess = usecTimestampNow();
             int editDataBytesRead = _myServer->getOctree()->processEditPacketData(packetType,
                                                                                   reinterpret_cast<const unsigned char*>(packet.data()),
@@ -165,14 +203,10 @@ void OctreeInboundPacketProcessor::processPacket(const SharedNodePointer& sendin
                                 << "editDataBytesRead=" << editDataBytesRead;
             }
 
-            _myServer->getOctree()->unlock();
             quint64 endProcess = usecTimestampNow();
 
             editsInPacket++;
-            quint64 thisProcessTime = endProcess - startProcess;
-            quint64 thisLockWaitTime = startProcess - startLock;
-            processTime += thisProcessTime;
-            lockWaitTime += thisLockWaitTime;
+            processTime += endProcess - startProcess;
 
             // skip to next edit record in the packet
             editData += editDataBytesRead;
@@ -232,6 +266,13 @@ void OctreeInboundPacketProcessor::trackInboundPacket(const QUuid& nodeUUID, uns
     }
 }
 
+void OctreeInboundPacketProcessor::trackBatch(int packetsInBatch, quint64 lockWaitTime, quint64 lockHoldTime) {
+    _totalBatches++;
+    _totalBatchPackets += packetsInBatch;
+    _totalBatchLockWaitTime += lockWaitTime;
+    _totalBatchLockHoldTime += lockHoldTime;
+}
+
 int OctreeInboundPacketProcessor::sendNackPackets() {
     int packetsSent = 0;
 
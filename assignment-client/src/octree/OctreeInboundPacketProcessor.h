@@ -70,6 +70,11 @@ public:
     quint64 getAverageLockWaitTimePerElement() const 
                 { return _totalElementsInPacket == 0 ? 0 : _totalLockWaitTime / _totalElementsInPacket; }
 
+    quint64 getTotalBatchesProcessed() const { return _totalBatches; }
+    float getAveragePacketsPerBatch() const { return _totalBatches == 0 ? 0 : (float)_totalBatchPackets / _totalBatches; }
+    quint64 getAverageLockWaitTimePerBatch() const { return _totalBatches == 0 ? 0 : _totalBatchLockWaitTime / _totalBatches; }
+    quint64 getAverageLockHoldTimePerBatch() const { return _totalBatches == 0 ? 0 : _totalBatchLockHoldTime / _totalBatches; }
+
     void resetStats();
 
     NodeToSenderStatsMap& getSingleSenderStats() { return _singleSenderStats; }
@@ -78,6 +83,10 @@ public:
 
 protected:
 
+    /// Applies the edits in the packets in batches, each under a single write lock on the octree
+    virtual void processPackets(const QVector<NetworkPacket>& packets);
+
+    /// Applies the edits in one packet - called with the octree locked for writing, within an edit batch
     virtual void processPacket(const SharedNodePointer& sendingNode, const QByteArray& packet);
 
     virtual unsigned long getMaxWait() const;
@@ -90,6 +99,7 @@ private:
 private:
     void trackInboundPacket(const QUuid& nodeUUID, unsigned short int sequence, quint64 transitTime, 
             int elementsInPacket, quint64 processTime, quint64 lockWaitTime);
+    void trackBatch(int packetsInBatch, quint64 lockWaitTime, quint64 lockHoldTime);
 
     OctreeServer* _myServer;
     int _receivedPacketCount;
@@ -99,6 +109,12 @@ private:
     quint64 _totalLockWaitTime;
     quint64 _totalElementsInPacket;
     quint64 _totalPackets;
+
+    quint64 _totalBatches;
+    quint64 _totalBatchPackets;
+    quint64 _totalBatchLockWaitTime;
+    quint64 _totalBatchLockHoldTime;
+    quint64 _batchLockWaitTimePerPacket; // the current batch's lock wait, shared among its packets' stats
     
     NodeToSenderStatsMap _singleSenderStats;
 
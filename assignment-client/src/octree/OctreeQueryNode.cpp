@@ -14,7 +14,7 @@
 #include "OctreeQueryNode.h"
 #include <cstring>
 #include <cstdio>
-#include "OctreeSendThread.h"
+#include "OctreeClientSender.h"
 
 OctreeQueryNode::OctreeQueryNode() :
     _viewSent(false),
@@ -33,7 +33,7 @@ OctreeQueryNode::OctreeQueryNode() :
     _viewFrustumJustStoppedChanging(true),
     _currentPacketIsColor(true),
     _currentPacketIsCompressed(false),
-    _octreeSendThread(NULL),
+    _octreeClientSender(NULL),
     _lastClientBoundaryLevelAdjust(0),
     _lastClientOctreeSizeScale(DEFAULT_OCTREE_SIZE_SCALE),
     _lodChanged(false),
@@ -48,10 +48,11 @@ OctreeQueryNode::OctreeQueryNode() :
 
 OctreeQueryNode::~OctreeQueryNode() {
     _isShuttingDown = true;
-    if (_octreeSendThread) {
-        forceNodeShutdown();
-    }
-    
+
+    // the send workers hold a reference to our node while they use the sender, so nothing can still be sending with it
+    delete _octreeClientSender;
+    _octreeClientSender = NULL;
+
     delete[] _octreePacket;
     delete[] _lastOctreePacket;
 }
@@ -59,44 +60,17 @@ OctreeQueryNode::~OctreeQueryNode() {
 void OctreeQueryNode::nodeKilled() {
     _isShuttingDown = true;
     elementBag.unhookNotifications(); // if our node is shutting down, then we no longer need octree element notifications
-    if (_octreeSendThread) {
-        // just tell our thread we want to shutdown, this is asynchronous, and fast, we don't need or want it to block
-        // while the thread actually shuts down
-        _octreeSendThread->setIsShuttingDown();
-    }
+    // the send workers drop us from their schedule the next time we come due
 }
 
 void OctreeQueryNode::forceNodeShutdown() {
     _isShuttingDown = true;
     elementBag.unhookNotifications(); // if our node is shutting down, then we no longer need octree element notifications
-    if (_octreeSendThread) {
-        // we really need to force our thread to shutdown, this is synchronous, we will block while the thread actually 
-        // shuts down because we really need it to shutdown, and it's ok if we wait for it to complete
-        OctreeSendThread* sendThread = _octreeSendThread;
-        _octreeSendThread = NULL;
-        sendThread->setIsShuttingDown();
-        sendThread->terminate();
-        delete sendThread;
-    }
+    // the server stops its send workers after forcing its nodes to shut down, which releases their references to us
 }
 
-void OctreeQueryNode::sendThreadFinished() {
-    // We've been notified by our thread that it is shutting down. So we can clean up our reference to it, and
-    // delete the actual thread object. Cleaning up our thread will correctly unroll all refereces to shared
-    // pointers to our node as well as the octree server assignment
-    if (_octreeSendThread) {
-        OctreeSendThread* sendThread = _octreeSendThread;
-        _octreeSendThread = NULL;
-        delete sendThread;
-    }
-}
-
-void OctreeQueryNode::initializeOctreeSendThread(const SharedAssignmentPointer& myAssignment, const SharedNodePointer& node) {
-    _octreeSendThread = new OctreeSendThread(myAssignment, node);
-    
-    // we want to be notified when the thread finishes
-    connect(_octreeSendThread, &GenericThread::finished, this, &OctreeQueryNode::sendThreadFinished);
-    _octreeSendThread->initialize(true);
+void OctreeQueryNode::initializeOctreeClientSender(OctreeServer* myServer) {
+    _octreeClientSender = new OctreeClientSender(myServer);
 }
 
 bool OctreeQueryNode::packetIsDuplicate() const {
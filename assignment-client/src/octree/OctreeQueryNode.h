@@ -26,7 +26,8 @@
 #include "SentPacketHistory.h"
 #include <qqueue.h>
 
-class OctreeSendThread;
+class OctreeClientSender;
+class OctreeServer;
 
 class OctreeQueryNode : public OctreeQuery {
     Q_OBJECT
@@ -59,6 +60,7 @@ public:
     OctreeElementBag elementBag;
     CoverageMap map;
     OctreeElementExtraEncodeData extraEncodeData;
+    OctreeSentItems sentItems;
 
     ViewFrustum& getCurrentViewFrustum() { return _currentViewFrustum; }
     ViewFrustum& getLastKnownViewFrustum() { return _lastKnownViewFrustum; }
@@ -89,8 +91,9 @@ public:
     
     OctreeSceneStats stats;
     
-    void initializeOctreeSendThread(const SharedAssignmentPointer& myAssignment, const SharedNodePointer& node);
-    bool isOctreeSendThreadInitalized() { return _octreeSendThread; }
+    void initializeOctreeClientSender(OctreeServer* myServer);
+    bool isOctreeClientSenderInitialized() const { return _octreeClientSender; }
+    OctreeClientSender* getOctreeClientSender() { return _octreeClientSender; }
     
     void dumpOutOfView();
     
@@ -113,9 +116,6 @@ public:
     bool hasNextNackedPacket() const;
     const QByteArray* getNextNackedPacket();
 
-private slots:
-    void sendThreadFinished();
-    
 private:
     OctreeQueryNode(const OctreeQueryNode &);
     OctreeQueryNode& operator= (const OctreeQueryNode&);
@@ -141,7 +141,7 @@ private:
     bool _currentPacketIsColor;
     bool _currentPacketIsCompressed;
 
-    OctreeSendThread* _octreeSendThread;
+    OctreeClientSender* _octreeClientSender;
 
     // watch for LOD changes
     int _lastClientBoundaryLevelAdjust;
@@ -0,0 +1,169 @@
+//
+//  OctreeSendWorkerPool.cpp
+//  assignment-client/src/octree
+//
+//  Created on 3/9/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+
+#include <QtCore/QDebug>
+
+#include <NodeList.h>
+#include <SharedUtil.h>
+
+#include "OctreeClientSender.h"
+#include "OctreeServer.h"
+#include "OctreeServerConsts.h"
+
+#include "OctreeSendWorkerPool.h"
+
+OctreeSendWorkerThread::OctreeSendWorkerThread(OctreeSendWorkerPool& pool) :
+    _pool(pool)
+{
+
+}
+
+void OctreeSendWorkerThread::run() {
+    std::vector<OctreeSendWorkerPool::ScheduledClient> batch;
+    batch.reserve(MAX_CLIENTS_PER_SEND_BATCH);
+
+    while (_pool.takeDueClients(batch)) {
+        _pool.sendToClients(batch);
+        _pool.rescheduleClients(batch);
+
+        // clients that were dropped release their nodes here, outside of the schedule lock
+        batch.clear();
+    }
+}
+
+OctreeSendWorkerPool::OctreeSendWorkerPool(OctreeServer* server, int numWorkers) :
+    _server(server),
+    _threads(),
+    _schedule(),
+    _isStopping(false)
+{
+    if (numWorkers < 1) {
+        numWorkers = std::max(1, QThread::idealThreadCount());
+    }
+
+    qDebug() << "Sending to octree clients on" << numWorkers << "worker threads.";
+
+    for (int i = 0; i < numWorkers; i++) {
+        OctreeSendWorkerThread* thread = new OctreeSendWorkerThread(*this);
+        thread->start();
+        _threads.append(thread);
+    }
+}
+
+OctreeSendWorkerPool::~OctreeSendWorkerPool() {
+    {
+        QMutexLocker locker(&_scheduleMutex);
+        _isStopping = true;
+        _clientsChanged.wakeAll();
+    }
+
+    foreach(OctreeSendWorkerThread* thread, _threads) {
+        thread->wait();
+        delete thread;
+    }
+
+    _schedule.clear();
+}
+
+void OctreeSendWorkerPool::addClient(const SharedNodePointer& node) {
+    ScheduledClient client = { node, usecTimestampNow() };
+
+    QMutexLocker locker(&_scheduleMutex);
+    _schedule.push_back(client);
+    std::push_heap(_schedule.begin(), _schedule.end(), hasLaterDeadline);
+    _clientsChanged.wakeOne();
+}
+
+bool OctreeSendWorkerPool::takeDueClients(std::vector<ScheduledClient>& batch) {
+    QMutexLocker locker(&_scheduleMutex);
+
+    while (!_isStopping) {
+        if (_schedule.empty()) {
+            _clientsChanged.wait(&_scheduleMutex);
+            continue;
+        }
+
+        quint64 now = usecTimestampNow();
+        quint64 earliestDeadline = _schedule.front().deadline;
+        if (earliestDeadline > now) {
+            // round up so that we don't wake just short of the deadline and spin
+            unsigned long msecsToWait = (earliestDeadline - now + USECS_PER_MSEC - 1) / USECS_PER_MSEC;
+            _clientsChanged.wait(&_scheduleMutex, msecsToWait);
+            continue;
+        }
+
+        while (!_schedule.empty() && _schedule.front().deadline <= now
+               && (int)batch.size() < MAX_CLIENTS_PER_SEND_BATCH) {
+            std::pop_heap(_schedule.begin(), _schedule.end(), hasLaterDeadline);
+            batch.push_back(_schedule.back());
+            _schedule.pop_back();
+        }
+
+        // hand off to another worker in case there are more clients due than fit in our batch
+        if (!_schedule.empty()) {
+            _clientsChanged.wakeOne();
+        }
+        return true;
+    }
+
+    return false;
+}
+
+void OctreeSendWorkerPool::sendToClients(std::vector<ScheduledClient>& batch) {
+    Octree* tree = _server->getOctree();
+
+    quint64 lockWaitStart = usecTimestampNow();
+    tree->lockForRead();
+    OctreeServer::trackTreeWaitTime((float)(usecTimestampNow() - lockWaitStart));
+
+    // the packets for the whole batch of clients go out together
+    NodeList* nodeList = NodeList::getInstance();
+    nodeList->beginDatagramBatch();
+
+    for (size_t i = 0; i < batch.size(); i++) {
+        OctreeQueryNode* nodeData = static_cast<OctreeQueryNode*>(batch[i].node->getLinkedData());
+        if (nodeData && !nodeData->isShuttingDown()) {
+            nodeData->getOctreeClientSender()->sendPacketsForInterval(batch[i].node, nodeData);
+        }
+    }
+
+    tree->unlock();
+
+    nodeList->flushDatagramBatch();
+}
+
+void OctreeSendWorkerPool::rescheduleClients(std::vector<ScheduledClient>& batch) {
+    quint64 now = usecTimestampNow();
+
+    QMutexLocker locker(&_scheduleMutex);
+
+    for (size_t i = 0; i < batch.size(); i++) {
+        OctreeQueryNode* nodeData = static_cast<OctreeQueryNode*>(batch[i].node->getLinkedData());
+        if (!nodeData || nodeData->isShuttingDown()) {
+            continue;
+        }
+
+        ScheduledClient client = batch[i];
+        client.deadline += OCTREE_SEND_INTERVAL_USECS;
+
+        // a client that fell a whole interval behind goes to the back of the due clients instead of bursting to catch up
+        if (client.deadline < now) {
+            client.deadline = now;
+        }
+
+        _schedule.push_back(client);
+        std::push_heap(_schedule.begin(), _schedule.end(), hasLaterDeadline);
+    }
+
+    _clientsChanged.wakeOne();
+}
@@ -0,0 +1,79 @@
+//
+//  OctreeSendWorkerPool.h
+//  assignment-client/src/octree
+//
+//  Created on 3/9/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreeSendWorkerPool_h
+#define hifi_OctreeSendWorkerPool_h
+
+#include <vector>
+
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+#include <QtCore/QVector>
+#include <QtCore/QWaitCondition>
+
+#include <LimitedNodeList.h>
+
+class OctreeSendWorkerPool;
+class OctreeServer;
+
+// the most clients a worker sends to under a single read lock of the octree, so that edits aren't held off for long
+const int MAX_CLIENTS_PER_SEND_BATCH = 8;
+
+class OctreeSendWorkerThread : public QThread {
+public:
+    OctreeSendWorkerThread(OctreeSendWorkerPool& pool);
+
+protected:
+    void run();
+
+private:
+    OctreeSendWorkerPool& _pool;
+};
+
+/// Sends octree packets to every client of the server from a fixed set of worker threads. Each client is due once per
+/// send interval; workers always take the clients with the earliest deadlines, and send to a batch of them under one
+/// read lock of the octree.
+class OctreeSendWorkerPool {
+public:
+    OctreeSendWorkerPool(OctreeServer* server, int numWorkers);
+    ~OctreeSendWorkerPool();
+
+    /// schedules a client whose node data has an initialized client sender, the client is dropped once it shuts down
+    void addClient(const SharedNodePointer& node);
+
+    int getNumWorkers() const { return _threads.size(); }
+
+private:
+    friend class OctreeSendWorkerThread;
+
+    struct ScheduledClient {
+        SharedNodePointer node;
+        quint64 deadline;
+    };
+
+    static bool hasLaterDeadline(const ScheduledClient& a, const ScheduledClient& b) { return a.deadline > b.deadline; }
+
+    /// blocks until at least one client is due, returns false if the pool is stopping
+    bool takeDueClients(std::vector<ScheduledClient>& batch);
+    void sendToClients(std::vector<ScheduledClient>& batch);
+    void rescheduleClients(std::vector<ScheduledClient>& batch);
+
+    OctreeServer* _server;
+
+    QVector<OctreeSendWorkerThread*> _threads;
+
+    QMutex _scheduleMutex;
+    QWaitCondition _clientsChanged;
+    std::vector<ScheduledClient> _schedule; // heap with the earliest deadline at the front
+    bool _isStopping;
+};
+
+#endif // hifi_OctreeSendWorkerPool_h
@@ -22,7 +22,6 @@
 #include <LogHandler.h>
 #include <UUID.h>
 
-#include "../AssignmentClient.h"
 
 #include "OctreeServer.h"
 #include "OctreeServerConsts.h"
@@ -123,6 +122,10 @@ void OctreeServer::resetSendingStats() {
     _longProcessWait = 0;
     _shortProcessWait = 0;
     _noProcessWait = 0;
+
+    if (_encodeCache) {
+        _encodeCache->resetStats();
+    }
 }
 
 void OctreeServer::trackEncodeTime(float time) { 
@@ -237,6 +240,10 @@ OctreeServer::OctreeServer(const QByteArray& packet) :
     _jurisdictionSender(NULL),
     _octreeInboundPacketProcessor(NULL),
     _persistThread(NULL),
+    _sendWorkerPool(NULL),
+    _numSendWorkers(0),
+    _encodeCache(NULL),
+    _encodeCacheMegabytes(DEFAULT_ENCODE_CACHE_MEGABYTES),
     _started(time(0)),
     _startedUSecs(usecTimestampNow())
 {
@@ -279,6 +286,12 @@ OctreeServer::~OctreeServer() {
         _persistThread->deleteLater();
     }
 
+    delete _sendWorkerPool;
+    _sendWorkerPool = NULL;
+
+    delete _encodeCache;
+    _encodeCache = NULL;
+
     delete _jurisdiction;
     _jurisdiction = NULL;
     
@@ -414,15 +427,18 @@ bool OctreeServer::handleHTTPRequest(HTTPConnection* connection, const QUrl& url
         statsString += QString("<b>%1 Outbound Packet Statistics... "
                                 "<a href='/resetStats'>[RESET]</a></b>\r\n").arg(getMyServerName());
 
-        quint64 totalOutboundPackets = OctreeSendThread::_totalPackets;
-        quint64 totalOutboundBytes = OctreeSendThread::_totalBytes;
-        quint64 totalWastedBytes = OctreeSendThread::_totalWastedBytes;
+        quint64 totalOutboundPackets = OctreeClientSender::_totalPackets;
+        quint64 totalOutboundBytes = OctreeClientSender::_totalBytes;
+        quint64 totalWastedBytes = OctreeClientSender::_totalWastedBytes;
         quint64 totalBytesOfOctalCodes = OctreePacketData::getTotalBytesOfOctalCodes();
         quint64 totalBytesOfBitMasks = OctreePacketData::getTotalBytesOfBitMasks();
         quint64 totalBytesOfColor = OctreePacketData::getTotalBytesOfColor();
 
         statsString += QString("          Total Clients Connected: %1 clients\r\n")
             .arg(locale.toString((uint)getCurrentClientCount()).rightJustified(COLUMN_WIDTH, ' '));
+        statsString += QString("              Send Worker Threads: %1 threads\r\n")
+            .arg(locale.toString((uint)(_sendWorkerPool ? _sendWorkerPool->getNumWorkers() : 0))
+                 .rightJustified(COLUMN_WIDTH, ' '));
 
         quint64 oneSecondAgo = usecTimestampNow() - USECS_PER_SECOND;
         
@@ -539,6 +555,23 @@ bool OctreeServer::handleHTTPRequest(HTTPConnection* connection, const QUrl& url
                                          _averageExtraLongEncodeTime.getAverage(), 
                                          extraLongVsTotalEncode * AS_PERCENT, _extraLongEncode);
 
+        // encoded subtree cache
+        if (_encodeCache) {
+            quint64 cacheLookups = _encodeCache->getHits() + _encodeCache->getMisses();
+            statsString += QString().sprintf("     Encoded subtree cache hit rate:               (%6.2f%%) samples: %12llu \r\n",
+                                             _encodeCache->getHitRate() * AS_PERCENT, cacheLookups);
+            statsString += QString("               Subtree cache hits: %1 subtrees\r\n")
+                .arg(locale.toString((uint)_encodeCache->getHits()).rightJustified(COLUMN_WIDTH, ' '));
+            statsString += QString("             Subtree bytes served: %1 bytes\r\n")
+                .arg(locale.toString((uint)_encodeCache->getBytesServed()).rightJustified(COLUMN_WIDTH, ' '));
+            statsString += QString("                 Subtrees cached: %1 subtrees\r\n")
+                .arg(locale.toString((uint)_encodeCache->getCachedSubtrees()).rightJustified(COLUMN_WIDTH, ' '));
+            statsString += QString("              Subtree cache size: %1 bytes\r\n\r\n")
+                .arg(locale.toString((uint)_encodeCache->getCachedBytes()).rightJustified(COLUMN_WIDTH, ' '));
+        } else {
+            statsString += "     Encoded subtree cache: DISABLED\r\n\r\n";
+        }
+
 
         float averageCompressAndWriteTime = getAverageCompressAndWriteTime();
         statsString += QString().sprintf("     Average compress and write time:    %9.2f usecs\r\n", 
@@ -653,6 +686,20 @@ bool OctreeServer::handleHTTPRequest(HTTPConnection* connection, const QUrl& url
         statsString += QString("  Average Wait Lock Time/Element: %1 usecs\r\n")
             .arg(locale.toString((uint)averageLockWaitTimePerElement).rightJustified(COLUMN_WIDTH, ' '));
 
+        // edits are applied in batches, each under one write lock
+        quint64 totalBatchesProcessed = _octreeInboundPacketProcessor->getTotalBatchesProcessed();
+        float averagePacketsPerBatch = _octreeInboundPacketProcessor->getAveragePacketsPerBatch();
+        quint64 averageLockWaitTimePerBatch = _octreeInboundPacketProcessor->getAverageLockWaitTimePerBatch();
+        quint64 averageLockHoldTimePerBatch = _octreeInboundPacketProcessor->getAverageLockHoldTimePerBatch();
+
+        statsString += QString("           Total Inbound Batches: %1 batches\r\n")
+            .arg(locale.toString((uint)totalBatchesProcessed).rightJustified(COLUMN_WIDTH, ' '));
+        statsString += QString().sprintf("  Average Inbound Packets/Batch: %f packets/batch\r\n", averagePacketsPerBatch);
+        statsString += QString("    Average Wait Lock Time/Batch: %1 usecs\r\n")
+            .arg(locale.toString((uint)averageLockWaitTimePerBatch).rightJustified(COLUMN_WIDTH, ' '));
+        statsString += QString("    Average Hold Lock Time/Batch: %1 usecs\r\n")
+            .arg(locale.toString((uint)averageLockHoldTimePerBatch).rightJustified(COLUMN_WIDTH, ' '));
+
 
         int senderNumber = 0;
         NodeToSenderStatsMap& allSenderStats = _octreeInboundPacketProcessor->getSingleSenderStats();
@@ -841,14 +888,9 @@ void OctreeServer::readPendingDatagram(const QByteArray& receivedPacket, const H
             if (matchingNode) {
                 nodeList->updateNodeWithDataFromPacket(matchingNode, receivedPacket);
                 OctreeQueryNode* nodeData = (OctreeQueryNode*)matchingNode->getLinkedData();
-                if (nodeData && !nodeData->isOctreeSendThreadInitalized()) {
-                    
-                    // NOTE: this is an important aspect of the proper ref counting. The send threads/node data need to 
-                    // know that the OctreeServer/Assignment will not get deleted on it while it's still active. The 
-                    // solution is to get the shared pointer for the current assignment. We need to make sure this is the 
-                    // same SharedAssignmentPointer that was ref counted by the assignment client.                    
-                    SharedAssignmentPointer sharedAssignment = AssignmentClient::getCurrentAssignment();
-                    nodeData->initializeOctreeSendThread(sharedAssignment, matchingNode);
+                if (nodeData && !nodeData->isOctreeClientSenderInitialized() && _sendWorkerPool) {
+                    nodeData->initializeOctreeClientSender(this);
+                    _sendWorkerPool->addClient(matchingNode);
                 }
             }
         } else if (packetType == PacketTypeOctreeDataNack) {
@@ -1080,6 +1122,22 @@ void OctreeServer::readConfiguration() {
     }
     qDebug("packetsPerSecondTotalMax=%d _packetsTotalPerInterval=%d", 
                     packetsPerSecondTotalMax, _packetsTotalPerInterval);
+
+    // the clients are shared between a fixed number of send workers, by default one per core
+    if (readOptionInt(QString("sendThreads"), settingsSectionObject, _numSendWorkers)) {
+        qDebug("sendThreads=%d", _numSendWorkers);
+    }
+
+    // subtrees that every client would encode the same way are shared between clients, 0 turns this off
+    if (readOptionInt(QString("encodeCacheMegabytes"), settingsSectionObject, _encodeCacheMegabytes)) {
+        qDebug("encodeCacheMegabytes=%d", _encodeCacheMegabytes);
+    }
+
+    // keeping all of an element's children in one block trades some memory for faster walks of large trees
+    bool linearChildren = false;
+    readOptionBool(QString("linearChildren"), settingsSectionObject, linearChildren);
+    OctreeElement::setLinearChildren(linearChildren);
+    qDebug("linearChildren=%s", debug::valueOf(linearChildren));
                     
                     
     readAdditionalConfiguration(settingsSectionObject);
@@ -1149,6 +1207,13 @@ void OctreeServer::run() {
     _octreeInboundPacketProcessor = new OctreeInboundPacketProcessor(this);
     _octreeInboundPacketProcessor->initialize(true);
 
+    // and the workers that send the octree to our clients
+    if (_encodeCacheMegabytes > 0) {
+        const int BYTES_PER_MEGABYTE = 1024 * 1024;
+        _encodeCache = new OctreeEncodeCache(_encodeCacheMegabytes * BYTES_PER_MEGABYTE);
+    }
+    _sendWorkerPool = new OctreeSendWorkerPool(this, _numSendWorkers);
+
     // Convert now to tm struct for local timezone
     tm* localtm = localtime(&_started);
     const int MAX_TIME_LENGTH = 128;
@@ -1216,6 +1281,11 @@ void OctreeServer::aboutToFinish() {
         qDebug() << qPrintable(_safeServerName) << "server about to finish while node still connected node:" << *node;
         forceNodeShutdown(node);
     });
+
+    // stopping the send workers releases their references to our nodes
+    qDebug() << qPrintable(_safeServerName) << "server stopping send workers...";
+    delete _sendWorkerPool;
+    _sendWorkerPool = NULL;
     
     if (_persistThread) {
         _persistThread->aboutToFinish();
@@ -1360,9 +1430,9 @@ void OctreeServer::sendStatsPacket() {
 
     static QJsonObject statsObject2;
 
-    statsObject2[baseName + QString(".2.outbound.data.totalPackets")] = (double)OctreeSendThread::_totalPackets;
-    statsObject2[baseName + QString(".2.outbound.data.totalBytes")] = (double)OctreeSendThread::_totalBytes;
-    statsObject2[baseName + QString(".2.outbound.data.totalBytesWasted")] = (double)OctreeSendThread::_totalWastedBytes;
+    statsObject2[baseName + QString(".2.outbound.data.totalPackets")] = (double)OctreeClientSender::_totalPackets;
+    statsObject2[baseName + QString(".2.outbound.data.totalBytes")] = (double)OctreeClientSender::_totalBytes;
+    statsObject2[baseName + QString(".2.outbound.data.totalBytesWasted")] = (double)OctreeClientSender::_totalWastedBytes;
     statsObject2[baseName + QString(".2.outbound.data.totalBytesOctalCodes")] = 
         (double)OctreePacketData::getTotalBytesOfOctalCodes();
     statsObject2[baseName + QString(".2.outbound.data.totalBytesBitMasks")] = 
@@ -1395,14 +1465,18 @@ void OctreeServer::sendStatsPacket() {
         (double)_octreeInboundPacketProcessor->getAverageProcessTimePerElement();
     statsObject3[baseName + QString(".3.inbound.timing.5.avgLockWaitTimePerElement")] = 
         (double)_octreeInboundPacketProcessor->getAverageLockWaitTimePerElement();
+    statsObject3[baseName + QString(".3.inbound.timing.6.avgLockWaitTimePerBatch")] = 
+        (double)_octreeInboundPacketProcessor->getAverageLockWaitTimePerBatch();
+    statsObject3[baseName + QString(".3.inbound.timing.7.avgLockHoldTimePerBatch")] = 
+        (double)_octreeInboundPacketProcessor->getAverageLockHoldTimePerBatch();
 
     NodeList::getInstance()->sendStatsToDomainServer(statsObject3);
 }
 
-QMap<OctreeSendThread*, quint64> OctreeServer::_threadsDidProcess;
-QMap<OctreeSendThread*, quint64> OctreeServer::_threadsDidPacketDistributor;
-QMap<OctreeSendThread*, quint64> OctreeServer::_threadsDidHandlePacketSend;
-QMap<OctreeSendThread*, quint64> OctreeServer::_threadsDidCallWriteDatagram;
+QMap<OctreeClientSender*, quint64> OctreeServer::_threadsDidProcess;
+QMap<OctreeClientSender*, quint64> OctreeServer::_threadsDidPacketDistributor;
+QMap<OctreeClientSender*, quint64> OctreeServer::_threadsDidHandlePacketSend;
+QMap<OctreeClientSender*, quint64> OctreeServer::_threadsDidCallWriteDatagram;
 
 QMutex OctreeServer::_threadsDidProcessMutex;
 QMutex OctreeServer::_threadsDidPacketDistributorMutex;
@@ -1410,28 +1484,28 @@ QMutex OctreeServer::_threadsDidHandlePacketSendMutex;
 QMutex OctreeServer::_threadsDidCallWriteDatagramMutex;
 
 
-void OctreeServer::didProcess(OctreeSendThread* thread) {
+void OctreeServer::didProcess(OctreeClientSender* thread) {
     QMutexLocker locker(&_threadsDidProcessMutex);
     _threadsDidProcess[thread] = usecTimestampNow();
 }
 
-void OctreeServer::didPacketDistributor(OctreeSendThread* thread) {
+void OctreeServer::didPacketDistributor(OctreeClientSender* thread) {
     QMutexLocker locker(&_threadsDidPacketDistributorMutex);
     _threadsDidPacketDistributor[thread] = usecTimestampNow();
 }
 
-void OctreeServer::didHandlePacketSend(OctreeSendThread* thread) {
+void OctreeServer::didHandlePacketSend(OctreeClientSender* thread) {
     QMutexLocker locker(&_threadsDidHandlePacketSendMutex);
     _threadsDidHandlePacketSend[thread] = usecTimestampNow();
 }
 
-void OctreeServer::didCallWriteDatagram(OctreeSendThread* thread) {
+void OctreeServer::didCallWriteDatagram(OctreeClientSender* thread) {
     QMutexLocker locker(&_threadsDidCallWriteDatagramMutex);
     _threadsDidCallWriteDatagram[thread] = usecTimestampNow();
 }
 
 
-void OctreeServer::stopTrackingThread(OctreeSendThread* thread) {
+void OctreeServer::stopTrackingThread(OctreeClientSender* thread) {
     QMutexLocker lockerA(&_threadsDidProcessMutex);
     QMutexLocker lockerB(&_threadsDidPacketDistributorMutex);
     QMutexLocker lockerC(&_threadsDidHandlePacketSendMutex);
@@ -1443,13 +1517,13 @@ void OctreeServer::stopTrackingThread(OctreeSendThread* thread) {
     _threadsDidCallWriteDatagram.remove(thread);
 }
 
-int howManyThreadsDidSomething(QMutex& mutex, QMap<OctreeSendThread*, quint64>& something, quint64 since) {
+int howManyThreadsDidSomething(QMutex& mutex, QMap<OctreeClientSender*, quint64>& something, quint64 since) {
     int count = 0;
     if (mutex.tryLock()) {
         if (since == 0) {
             count = something.size();
         } else {
-            QMap<OctreeSendThread*, quint64>::const_iterator i = something.constBegin();
+            QMap<OctreeClientSender*, quint64>::const_iterator i = something.constBegin();
             while (i != something.constEnd()) {
                 if (i.value() > since) {
                     count++;
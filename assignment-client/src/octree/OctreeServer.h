@@ -20,9 +20,11 @@
 
 #include <ThreadedAssignment.h>
 #include <EnvironmentData.h>
+#include <OctreeEncodeCache.h>
 
 #include "OctreePersistThread.h"
-#include "OctreeSendThread.h"
+#include "OctreeClientSender.h"
+#include "OctreeSendWorkerPool.h"
 #include "OctreeServerConsts.h"
 #include "OctreeInboundPacketProcessor.h"
 
@@ -43,6 +45,7 @@ public:
     bool wantsVerboseDebug() const { return _verboseDebug; }
 
     Octree* getOctree() { return _tree; }
+    OctreeEncodeCache* getEncodeCache() { return _encodeCache; }
     JurisdictionMap* getJurisdiction() { return _jurisdiction; }
 
     int getPacketsPerClientPerInterval() const { return std::min(_packetsPerClientPerInterval, 
@@ -104,11 +107,11 @@ public:
     static float getAverageProcessWaitTime() { return _averageProcessWaitTime.getAverage(); }
     
     // these methods allow us to track which threads got to various states
-    static void didProcess(OctreeSendThread* thread);
-    static void didPacketDistributor(OctreeSendThread* thread);
-    static void didHandlePacketSend(OctreeSendThread* thread);
-    static void didCallWriteDatagram(OctreeSendThread* thread);
-    static void stopTrackingThread(OctreeSendThread* thread);
+    static void didProcess(OctreeClientSender* thread);
+    static void didPacketDistributor(OctreeClientSender* thread);
+    static void didHandlePacketSend(OctreeClientSender* thread);
+    static void didCallWriteDatagram(OctreeClientSender* thread);
+    static void stopTrackingThread(OctreeClientSender* thread);
 
     static int howManyThreadsDidProcess(quint64 since = 0);
     static int howManyThreadsDidPacketDistributor(quint64 since = 0);
@@ -169,6 +172,10 @@ protected:
     JurisdictionSender* _jurisdictionSender;
     OctreeInboundPacketProcessor* _octreeInboundPacketProcessor;
     OctreePersistThread* _persistThread;
+    OctreeSendWorkerPool* _sendWorkerPool;
+    int _numSendWorkers;
+    OctreeEncodeCache* _encodeCache;
+    int _encodeCacheMegabytes;
     
     int _persistInterval;
     bool _wantBackup;
@@ -228,10 +235,10 @@ protected:
     static int _shortProcessWait;
     static int _noProcessWait;
 
-    static QMap<OctreeSendThread*, quint64> _threadsDidProcess;
-    static QMap<OctreeSendThread*, quint64> _threadsDidPacketDistributor;
-    static QMap<OctreeSendThread*, quint64> _threadsDidHandlePacketSend;
-    static QMap<OctreeSendThread*, quint64> _threadsDidCallWriteDatagram;
+    static QMap<OctreeClientSender*, quint64> _threadsDidProcess;
+    static QMap<OctreeClientSender*, quint64> _threadsDidPacketDistributor;
+    static QMap<OctreeClientSender*, quint64> _threadsDidHandlePacketSend;
+    static QMap<OctreeClientSender*, quint64> _threadsDidCallWriteDatagram;
 
     static QMutex _threadsDidProcessMutex;
     static QMutex _threadsDidPacketDistributorMutex;
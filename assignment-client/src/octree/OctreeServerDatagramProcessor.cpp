@@ -20,7 +20,8 @@
 
 OctreeServerDatagramProcessor::OctreeServerDatagramProcessor(QUdpSocket& nodeSocket, QThread* previousNodeSocketThread) :
     _nodeSocket(nodeSocket),
-    _previousNodeSocketThread(previousNodeSocketThread)
+    _previousNodeSocketThread(previousNodeSocketThread),
+    _receiveBatch()
 {
     
 }
@@ -32,24 +33,20 @@ OctreeServerDatagramProcessor::~OctreeServerDatagramProcessor() {
 
 void OctreeServerDatagramProcessor::readPendingDatagrams() {
     
-    HifiSockAddr senderSockAddr;
-    static QByteArray incomingPacket;
-    
-    // read everything that is available
-    while (_nodeSocket.hasPendingDatagrams()) {
-        incomingPacket.resize(_nodeSocket.pendingDatagramSize());
-        
-        // just get this packet off the stack
-        _nodeSocket.readDatagram(incomingPacket.data(), incomingPacket.size(),
-                                  senderSockAddr.getAddressPointer(), senderSockAddr.getPortPointer());
-                                  
-        PacketType packetType = packetTypeForPacket(incomingPacket);
-        if (packetType == PacketTypePing) {
-            NodeList::getInstance()->processNodeData(senderSockAddr, incomingPacket);
-            return; // don't emit
+    // read everything that is available, a batch at a time
+    while (_receiveBatch.readPendingDatagrams(_nodeSocket) > 0) {
+        for (int i = 0; i < _receiveBatch.size(); i++) {
+            const QByteArray& incomingPacket = _receiveBatch.getDatagram(i);
+            const HifiSockAddr& senderSockAddr = _receiveBatch.getSenderSockAddr(i);
+            
+            PacketType packetType = packetTypeForPacket(incomingPacket);
+            if (packetType == PacketTypePing) {
+                NodeList::getInstance()->processNodeData(senderSockAddr, incomingPacket);
+                continue; // don't emit, but keep going with the rest of the batch
+            }
+            
+            // emit the signal to tell the OctreeServer it needs to process a packet
+            emit packetRequiresProcessing(incomingPacket, senderSockAddr);
         }
-        
-        // emit the signal to tell AudioMixer it needs to process a packet
-        emit packetRequiresProcessing(incomingPacket, senderSockAddr);
     }
 }
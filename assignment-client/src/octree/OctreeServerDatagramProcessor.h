@@ -15,6 +15,8 @@
 #include <qobject.h>
 #include <qudpsocket.h>
 
+#include <DatagramBatch.h>
+
 class OctreeServerDatagramProcessor : public QObject {
     Q_OBJECT
 public:
@@ -27,6 +29,7 @@ signals:
 private:
     QUdpSocket& _nodeSocket;
     QThread* _previousNodeSocketThread;
+    DatagramReceiveBatch _receiveBatch;
 };
 
 #endif // hifi_OctreeServerDatagramProcessor_h
\ No newline at end of file
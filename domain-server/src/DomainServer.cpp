@@ -48,6 +48,7 @@ DomainServer::DomainServer(int argc, char* argv[]) :
     _unfulfilledAssignments(),
     _pendingAssignedNodes(),
     _isUsingDTLS(false),
+    _packetAuthenticator(PacketAuthenticator::SipHash),
     _oauthProviderURL(),
     _oauthClientID(),
     _hostname(),
@@ -229,6 +230,13 @@ void DomainServer::setupNodeListAndAssignments(const QUuid& sessionUUID) {
         }
     }
 
+    // the nodes we tell about each other authenticate their packets to each other with the MAC picked here
+    const QString PACKET_AUTHENTICATOR_OPTION = "security.packet_authenticator";
+    const QString MD5_PACKET_AUTHENTICATOR_VALUE = "md5";
+    QVariant packetAuthenticatorValue = _settingsManager.valueOrDefaultValueForKeyPath(PACKET_AUTHENTICATOR_OPTION);
+    _packetAuthenticator = (packetAuthenticatorValue.toString() == MD5_PACKET_AUTHENTICATOR_VALUE)
+        ? PacketAuthenticator::MD5 : PacketAuthenticator::SipHash;
+
     QSet<Assignment::Type> parsedTypes;
     parseAssignmentConfigs(parsedTypes);
 
@@ -481,6 +489,7 @@ void DomainServer::populateStaticScriptedAssignmentsFromSettings() {
             const QString PERSISTENT_SCRIPT_URL_KEY = "url";
             const QString PERSISTENT_SCRIPT_NUM_INSTANCES_KEY = "num_instances";
             const QString PERSISTENT_SCRIPT_POOL_KEY = "pool";
+            const QString PERSISTENT_SCRIPT_INSTANCES_PER_PROCESS_KEY = "instances_per_process";
             
             if (persistentScript.contains(PERSISTENT_SCRIPT_URL_KEY)) {
                 // check how many instances of this script to add
@@ -490,14 +499,23 @@ void DomainServer::populateStaticScriptedAssignmentsFromSettings() {
                 
                 QString scriptPool = persistentScript.value(PERSISTENT_SCRIPT_POOL_KEY).toString();
                 
-                qDebug() << "Adding" << numInstances << "of persistent script at URL" << scriptURL << "- pool" << scriptPool;
+                // instances can be hosted together, the agent runs as many as its payload is prefixed with
+                int instancesPerProcess = qMax(persistentScript.value(PERSISTENT_SCRIPT_INSTANCES_PER_PROCESS_KEY).toInt(), 1);
+                
+                qDebug() << "Adding" << numInstances << "of persistent script at URL" << scriptURL << "- pool" << scriptPool
+                    << "-" << instancesPerProcess << "per assignment";
                 
-                for (int i = 0; i < numInstances; ++i) {
-                    // add a scripted assignment to the queue for this instance
+                for (int i = 0; i < numInstances; i += instancesPerProcess) {
+                    // add a scripted assignment to the queue for these instances
                     Assignment* scriptAssignment = new Assignment(Assignment::CreateCommand,
                                                                   Assignment::AgentType,
                                                                   scriptPool);
-                    scriptAssignment->setPayload(scriptURL.toUtf8());
+                    int numAssignmentInstances = qMin(instancesPerProcess, numInstances - i);
+                    if (numAssignmentInstances > 1) {
+                        scriptAssignment->setPayload(QString("%1 %2").arg(numAssignmentInstances).arg(scriptURL).toUtf8());
+                    } else {
+                        scriptAssignment->setPayload(scriptURL.toUtf8());
+                    }
                     
                     // add it to static hash so we know we have to keep giving it back out
                     addStaticAssignmentToAssignmentHash(scriptAssignment);
@@ -832,15 +850,7 @@ NodeSet DomainServer::nodeInterestListFromPacket(const QByteArray& packet, int n
 }
 
 void DomainServer::sendDomainListToNode(const SharedNodePointer& node, const HifiSockAddr &senderSockAddr,
-                                        const NodeSet& nodeInterestList) {
-
-    QByteArray broadcastPacket = byteArrayWithPopulatedHeader(PacketTypeDomainList);
-
-    // always send the node their own UUID back
-    QDataStream broadcastDataStream(&broadcastPacket, QIODevice::Append);
-    broadcastDataStream << node->getUUID();
-
-    int numBroadcastPacketLeadBytes = broadcastDataStream.device()->pos();
+                                        const NodeSet& nodeInterestList, quint32 acknowledgedListVersion) {
 
     DomainServerNodeData* nodeData = reinterpret_cast<DomainServerNodeData*>(node->getLinkedData());
 
@@ -854,22 +864,38 @@ void DomainServer::sendDomainListToNode(const SharedNodePointer& node, const Hif
     }
 
     if (nodeInterestList.size() > 0) {
+        
+        // if the node has everything we last sent it we only need to tell it what changed since then,
+        // otherwise it gets the full list (a base version of 0) and we start over from that
+        ListedNodeHash& previouslyListedNodes = nodeData->getListedNodes();
+        bool isDelta = acknowledgedListVersion != 0 && acknowledgedListVersion == nodeData->getDomainListVersion();
+        quint32 baseListVersion = isDelta ? acknowledgedListVersion : 0;
+        
+        ListedNodeHash listedNodes;
+        int numStillListed = 0;
+        QByteArray entriesByteArray;
+        QList<QByteArray> packetEntries;
 
 //        DTLSServerSession* dtlsSession = _isUsingDTLS ? _dtlsSessions[senderSockAddr] : NULL;
-        int dataMTU = MAX_PACKET_SIZE;
+        // leave room for our own UUID and the list versions and packet numbering that lead each packet
+        int dataMTU = MAX_PACKET_SIZE - numBytesForPacketHeaderGivenPacketType(PacketTypeDomainList) - NUM_BYTES_RFC4122_UUID
+            - 2 * sizeof(quint32) - 2 * sizeof(quint16);
+        
+        auto appendEntry = [&](const QByteArray& entryByteArray) {
+            if (entriesByteArray.size() + entryByteArray.size() > dataMTU) {
+                // we need to break here and start a new packet
+                packetEntries.append(entriesByteArray);
+                entriesByteArray.clear();
+            }
+            
+            entriesByteArray.append(entryByteArray);
+        };
 
         if (nodeData->isAuthenticated()) {
             // if this authenticated node has any interest types, send back those nodes as well
             nodeList->eachNode([&](const SharedNodePointer& otherNode){
-                // reset our nodeByteArray and nodeDataStream
-                QByteArray nodeByteArray;
-                QDataStream nodeDataStream(&nodeByteArray, QIODevice::Append);
-                
                 if (otherNode->getUUID() != node->getUUID() && nodeInterestList.contains(otherNode->getType())) {
                     
-                    // don't send avatar nodes to other avatars, that will come from avatar mixer
-                    nodeDataStream << *otherNode.data();
-                    
                     // pack the secret that these two nodes will use to communicate with each other
                     QUuid secretUUID = nodeData->getSessionSecretHash().value(otherNode->getUUID());
                     if (secretUUID.isNull()) {
@@ -885,27 +911,85 @@ void DomainServer::sendDomainListToNode(const SharedNodePointer& node, const Hif
                         
                     }
                     
-                    nodeDataStream << secretUUID;
+                    ListedNodeState listedState = { otherNode->getPublicSocket(), otherNode->getLocalSocket(), secretUUID };
+                    listedNodes.insert(otherNode->getUUID(), listedState);
                     
-                    if (broadcastPacket.size() +  nodeByteArray.size() > dataMTU) {
-                        // we need to break here and start a new packet
-                        // so send the current one
+                    if (isDelta) {
+                        ListedNodeHash::const_iterator previousState = previouslyListedNodes.constFind(otherNode->getUUID());
                         
-                        nodeList->writeDatagram(broadcastPacket, node, senderSockAddr);
-                        
-                        // reset the broadcastPacket structure
-                        broadcastPacket.resize(numBroadcastPacketLeadBytes);
-                        broadcastDataStream.device()->seek(numBroadcastPacketLeadBytes);
+                        if (previousState != previouslyListedNodes.constEnd()) {
+                            ++numStillListed;
+                            
+                            if (previousState->publicSocket == listedState.publicSocket
+                                && previousState->localSocket == listedState.localSocket
+                                && previousState->connectionSecret == listedState.connectionSecret) {
+                                // the node already knows about this node as it is now
+                                return;
+                            }
+                        }
                     }
                     
-                    // append the nodeByteArray to the current state of broadcastDataStream
-                    broadcastPacket.append(nodeByteArray);
+                    QByteArray nodeByteArray;
+                    QDataStream nodeDataStream(&nodeByteArray, QIODevice::Append);
+                    
+                    // don't send avatar nodes to other avatars, that will come from avatar mixer
+                    nodeDataStream << DomainListEntryType::AddOrUpdate << *otherNode.data();
+                    
+                    // and how they will authenticate their packets with it, and whether it's one of our assignments,
+                    // which other assignments may trust with more than a client
+                    DomainServerNodeData* otherNodeData = reinterpret_cast<DomainServerNodeData*>(otherNode->getLinkedData());
+                    nodeDataStream << secretUUID << _packetAuthenticator << !otherNodeData->getAssignmentUUID().isNull();
+                    
+                    appendEntry(nodeByteArray);
                 }
             });
         }
-
-        // always write the last broadcastPacket
-        nodeList->writeDatagram(broadcastPacket, node, senderSockAddr);
+        
+        bool hasChanges = !isDelta || !entriesByteArray.isEmpty() || !packetEntries.isEmpty();
+        
+        if (isDelta && numStillListed < previouslyListedNodes.size()) {
+            // tell the node about anything it was sent that is gone now
+            ListedNodeHash::const_iterator previousState = previouslyListedNodes.constBegin();
+            while (previousState != previouslyListedNodes.constEnd()) {
+                if (!listedNodes.contains(previousState.key())) {
+                    QByteArray nodeByteArray;
+                    QDataStream nodeDataStream(&nodeByteArray, QIODevice::Append);
+                    nodeDataStream << DomainListEntryType::Remove << previousState.key();
+                    
+                    appendEntry(nodeByteArray);
+                    hasChanges = true;
+                }
+                
+                ++previousState;
+            }
+        }
+        
+        // always write the last packet, even an empty one lets the node know we heard its check-in
+        packetEntries.append(entriesByteArray);
+        
+        quint32 listVersion = nodeData->getDomainListVersion();
+        if (hasChanges) {
+            // zero is reserved to mean that the node doesn't have a list
+            if (++listVersion == 0) {
+                ++listVersion;
+            }
+            
+            nodeData->setDomainListVersion(listVersion);
+            previouslyListedNodes.swap(listedNodes);
+        }
+        
+        quint16 numPackets = packetEntries.size();
+        for (quint16 packetIndex = 0; packetIndex < numPackets; packetIndex++) {
+            QByteArray broadcastPacket = byteArrayWithPopulatedHeader(PacketTypeDomainList);
+            
+            // always send the node their own UUID back, followed by which list this is and what it builds on
+            QDataStream broadcastDataStream(&broadcastPacket, QIODevice::Append);
+            broadcastDataStream << node->getUUID() << baseListVersion << listVersion << packetIndex << numPackets;
+            
+            broadcastPacket.append(packetEntries[packetIndex]);
+            
+            nodeList->writeDatagram(broadcastPacket, node, senderSockAddr);
+        }
     }
 }
 
@@ -1289,9 +1373,10 @@ void DomainServer::processDatagram(const QByteArray& receivedPacket, const HifiS
                     checkInNode->setLastHeardMicrostamp(timeNow);
                     
                     QList<NodeType_t> nodeInterestList;
-                    packetStream >> nodeInterestList;
+                    quint32 acknowledgedListVersion;
+                    packetStream >> nodeInterestList >> acknowledgedListVersion;
                     
-                    sendDomainListToNode(checkInNode, senderSockAddr, nodeInterestList.toSet());
+                    sendDomainListToNode(checkInNode, senderSockAddr, nodeInterestList.toSet(), acknowledgedListVersion);
                 }
                 
                 break;
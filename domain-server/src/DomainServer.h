@@ -96,7 +96,7 @@ private:
                                    const HifiSockAddr& senderSockAddr);
     NodeSet nodeInterestListFromPacket(const QByteArray& packet, int numPreceedingBytes);
     void sendDomainListToNode(const SharedNodePointer& node, const HifiSockAddr& senderSockAddr,
-                              const NodeSet& nodeInterestList);
+                              const NodeSet& nodeInterestList, quint32 acknowledgedListVersion = 0);
     
     void parseAssignmentConfigs(QSet<Assignment::Type>& excludedTypes);
     void addStaticAssignmentToAssignmentHash(Assignment* newAssignment);
@@ -134,6 +134,7 @@ private:
     TransactionHash _pendingAssignmentCredits;
     
     bool _isUsingDTLS;
+    PacketAuthenticator_t _packetAuthenticator;
     
     QUrl _oauthProviderURL;
     QString _oauthClientID;
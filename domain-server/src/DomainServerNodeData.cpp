@@ -25,7 +25,9 @@ DomainServerNodeData::DomainServerNodeData() :
     _paymentIntervalTimer(),
     _statsJSONObject(),
     _sendingSockAddr(),
-    _isAuthenticated(true)
+    _isAuthenticated(true),
+    _domainListVersion(0),
+    _listedNodes()
 {
     _paymentIntervalTimer.start();
 }
@@ -20,6 +20,15 @@
 #include <HifiSockAddr.h>
 #include <NodeData.h>
 
+/// what a node was last told about one of the other nodes in its domain list
+struct ListedNodeState {
+    HifiSockAddr publicSocket;
+    HifiSockAddr localSocket;
+    QUuid connectionSecret;
+};
+
+typedef QHash<QUuid, ListedNodeState> ListedNodeHash;
+
 class DomainServerNodeData : public NodeData {
 public:
     DomainServerNodeData();
@@ -47,6 +56,12 @@ public:
     bool isAuthenticated() const { return _isAuthenticated; }
     
     QHash<QUuid, QUuid>& getSessionSecretHash() { return _sessionSecretHash; }
+    
+    void setDomainListVersion(quint32 domainListVersion) { _domainListVersion = domainListVersion; }
+    quint32 getDomainListVersion() const { return _domainListVersion; }
+    
+    /// the nodes in the domain list this node was last sent, as of getDomainListVersion()
+    ListedNodeHash& getListedNodes() { return _listedNodes; }
 private:
     QJsonObject mergeJSONStatsFromNewObject(const QJsonObject& newObject, QJsonObject destinationObject);
     
@@ -58,6 +73,8 @@ private:
     QJsonObject _statsJSONObject;
     HifiSockAddr _sendingSockAddr;
     bool _isAuthenticated;
+    quint32 _domainListVersion;
+    ListedNodeHash _listedNodes;
 };
 
 #endif // hifi_DomainServerNodeData_h
@@ -0,0 +1,268 @@
+//
+//  AudioMixKernels.cpp
+//  libraries/audio/src
+//
+//  Created on 3/4/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <math.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HIFI_AUDIO_MIX_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "AudioConstants.h"
+
+#include "AudioMixKernels.h"
+
+const float MIN_SAMPLE_FLOAT = (float)AudioConstants::MIN_SAMPLE_VALUE;
+const float MAX_SAMPLE_FLOAT = (float)AudioConstants::MAX_SAMPLE_VALUE;
+
+void AudioMixKernels::Scalar::addMonoToStereo(float* mix, const int16_t* source, int numFrames,
+                                              float leftGain, float rightGain, int delaySamples, bool rightIsDelayed) {
+    // the delayed channel starts reading in the history, the other one at the start of the frame
+    const int16_t* leftSource = rightIsDelayed ? source + delaySamples : source;
+    const int16_t* rightSource = rightIsDelayed ? source : source + delaySamples;
+
+    for (int i = 0; i < numFrames; i++) {
+        mix[2 * i] += leftSource[i] * leftGain;
+        mix[2 * i + 1] += rightSource[i] * rightGain;
+    }
+}
+
+void AudioMixKernels::Scalar::addStereo(float* mix, const int16_t* source, int numSamples, float gain) {
+    for (int i = 0; i < numSamples; i++) {
+        mix[i] += source[i] * gain;
+    }
+}
+
+void AudioMixKernels::Scalar::addSamples(float* mix, const int16_t* source, int numSamples) {
+    for (int i = 0; i < numSamples; i++) {
+        mix[i] += source[i];
+    }
+}
+
+void AudioMixKernels::Scalar::saturateToInt16(int16_t* destination, const float* mix, int numSamples) {
+    for (int i = 0; i < numSamples; i++) {
+        float sample = mix[i];
+        if (sample < MIN_SAMPLE_FLOAT) {
+            sample = MIN_SAMPLE_FLOAT;
+        } else if (sample > MAX_SAMPLE_FLOAT) {
+            sample = MAX_SAMPLE_FLOAT;
+        }
+        destination[i] = (int16_t)lrintf(sample);
+    }
+}
+
+#if defined(__AVX2__)
+
+// loads 8 int16 samples and widens them to floats
+static inline __m256 loadSamples(const int16_t* source) {
+    return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source))));
+}
+
+void AudioMixKernels::addMonoToStereo(float* mix, const int16_t* source, int numFrames,
+                                      float leftGain, float rightGain, int delaySamples, bool rightIsDelayed) {
+    const int16_t* leftSource = rightIsDelayed ? source + delaySamples : source;
+    const int16_t* rightSource = rightIsDelayed ? source : source + delaySamples;
+
+    __m256 leftGains = _mm256_set1_ps(leftGain);
+    __m256 rightGains = _mm256_set1_ps(rightGain);
+
+    const int FRAMES_PER_STEP = 8;
+    int i = 0;
+    for (; i + FRAMES_PER_STEP <= numFrames; i += FRAMES_PER_STEP) {
+        __m256 left = _mm256_mul_ps(loadSamples(leftSource + i), leftGains);
+        __m256 right = _mm256_mul_ps(loadSamples(rightSource + i), rightGains);
+
+        // unpack interleaves within each 128-bit lane, so swap the middle halves back into order
+        __m256 low = _mm256_unpacklo_ps(left, right);
+        __m256 high = _mm256_unpackhi_ps(left, right);
+        __m256 first = _mm256_permute2f128_ps(low, high, 0x20);
+        __m256 second = _mm256_permute2f128_ps(low, high, 0x31);
+
+        float* mixAt = mix + 2 * i;
+        _mm256_storeu_ps(mixAt, _mm256_add_ps(_mm256_loadu_ps(mixAt), first));
+        _mm256_storeu_ps(mixAt + 8, _mm256_add_ps(_mm256_loadu_ps(mixAt + 8), second));
+    }
+
+    if (i < numFrames) {
+        Scalar::addMonoToStereo(mix + 2 * i, source + i, numFrames - i, leftGain, rightGain, delaySamples, rightIsDelayed);
+    }
+}
+
+void AudioMixKernels::addStereo(float* mix, const int16_t* source, int numSamples, float gain) {
+    __m256 gains = _mm256_set1_ps(gain);
+
+    const int SAMPLES_PER_STEP = 8;
+    int i = 0;
+    for (; i + SAMPLES_PER_STEP <= numSamples; i += SAMPLES_PER_STEP) {
+        __m256 samples = _mm256_mul_ps(loadSamples(source + i), gains);
+        _mm256_storeu_ps(mix + i, _mm256_add_ps(_mm256_loadu_ps(mix + i), samples));
+    }
+
+    if (i < numSamples) {
+        Scalar::addStereo(mix + i, source + i, numSamples - i, gain);
+    }
+}
+
+void AudioMixKernels::addSamples(float* mix, const int16_t* source, int numSamples) {
+    const int SAMPLES_PER_STEP = 8;
+    int i = 0;
+    for (; i + SAMPLES_PER_STEP <= numSamples; i += SAMPLES_PER_STEP) {
+        _mm256_storeu_ps(mix + i, _mm256_add_ps(_mm256_loadu_ps(mix + i), loadSamples(source + i)));
+    }
+
+    if (i < numSamples) {
+        Scalar::addSamples(mix + i, source + i, numSamples - i);
+    }
+}
+
+void AudioMixKernels::saturateToInt16(int16_t* destination, const float* mix, int numSamples) {
+    const int SAMPLES_PER_STEP = 16;
+    int i = 0;
+    for (; i + SAMPLES_PER_STEP <= numSamples; i += SAMPLES_PER_STEP) {
+        __m256i low = _mm256_cvtps_epi32(_mm256_loadu_ps(mix + i));
+        __m256i high = _mm256_cvtps_epi32(_mm256_loadu_ps(mix + i + 8));
+
+        // packs saturates to int16 but works per 128-bit lane, so put the 64-bit quarters back in order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(low, high), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), packed);
+    }
+
+    if (i < numSamples) {
+        Scalar::saturateToInt16(destination + i, mix + i, numSamples - i);
+    }
+}
+
+const char* AudioMixKernels::getInstructionSetName() {
+    return "AVX2";
+}
+
+#elif defined(HIFI_AUDIO_MIX_SSE2)
+
+// widens the low and high four int16 samples of a register to floats
+static inline __m128 lowSamples(__m128i samples) {
+    return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16));
+}
+
+static inline __m128 highSamples(__m128i samples) {
+    return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16));
+}
+
+static inline void addToMix(float* mixAt, __m128 samples) {
+    _mm_storeu_ps(mixAt, _mm_add_ps(_mm_loadu_ps(mixAt), samples));
+}
+
+void AudioMixKernels::addMonoToStereo(float* mix, const int16_t* source, int numFrames,
+                                      float leftGain, float rightGain, int delaySamples, bool rightIsDelayed) {
+    const int16_t* leftSource = rightIsDelayed ? source + delaySamples : source;
+    const int16_t* rightSource = rightIsDelayed ? source : source + delaySamples;
+
+    __m128 leftGains = _mm_set1_ps(leftGain);
+    __m128 rightGains = _mm_set1_ps(rightGain);
+
+    const int FRAMES_PER_STEP = 8;
+    int i = 0;
+    for (; i + FRAMES_PER_STEP <= numFrames; i += FRAMES_PER_STEP) {
+        __m128i leftInput = _mm_loadu_si128(reinterpret_cast<const __m128i*>(leftSource + i));
+        __m128i rightInput = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rightSource + i));
+
+        __m128 left = _mm_mul_ps(lowSamples(leftInput), leftGains);
+        __m128 right = _mm_mul_ps(lowSamples(rightInput), rightGains);
+
+        float* mixAt = mix + 2 * i;
+        addToMix(mixAt, _mm_unpacklo_ps(left, right));
+        addToMix(mixAt + 4, _mm_unpackhi_ps(left, right));
+
+        left = _mm_mul_ps(highSamples(leftInput), leftGains);
+        right = _mm_mul_ps(highSamples(rightInput), rightGains);
+
+        addToMix(mixAt + 8, _mm_unpacklo_ps(left, right));
+        addToMix(mixAt + 12, _mm_unpackhi_ps(left, right));
+    }
+
+    if (i < numFrames) {
+        Scalar::addMonoToStereo(mix + 2 * i, source + i, numFrames - i, leftGain, rightGain, delaySamples, rightIsDelayed);
+    }
+}
+
+void AudioMixKernels::addStereo(float* mix, const int16_t* source, int numSamples, float gain) {
+    __m128 gains = _mm_set1_ps(gain);
+
+    const int SAMPLES_PER_STEP = 8;
+    int i = 0;
+    for (; i + SAMPLES_PER_STEP <= numSamples; i += SAMPLES_PER_STEP) {
+        __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        addToMix(mix + i, _mm_mul_ps(lowSamples(input), gains));
+        addToMix(mix + i + 4, _mm_mul_ps(highSamples(input), gains));
+    }
+
+    if (i < numSamples) {
+        Scalar::addStereo(mix + i, source + i, numSamples - i, gain);
+    }
+}
+
+void AudioMixKernels::addSamples(float* mix, const int16_t* source, int numSamples) {
+    const int SAMPLES_PER_STEP = 8;
+    int i = 0;
+    for (; i + SAMPLES_PER_STEP <= numSamples; i += SAMPLES_PER_STEP) {
+        __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        addToMix(mix + i, lowSamples(input));
+        addToMix(mix + i + 4, highSamples(input));
+    }
+
+    if (i < numSamples) {
+        Scalar::addSamples(mix + i, source + i, numSamples - i);
+    }
+}
+
+void AudioMixKernels::saturateToInt16(int16_t* destination, const float* mix, int numSamples) {
+    const int SAMPLES_PER_STEP = 8;
+    int i = 0;
+    for (; i + SAMPLES_PER_STEP <= numSamples; i += SAMPLES_PER_STEP) {
+        __m128i low = _mm_cvtps_epi32(_mm_loadu_ps(mix + i));
+        __m128i high = _mm_cvtps_epi32(_mm_loadu_ps(mix + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_packs_epi32(low, high));
+    }
+
+    if (i < numSamples) {
+        Scalar::saturateToInt16(destination + i, mix + i, numSamples - i);
+    }
+}
+
+const char* AudioMixKernels::getInstructionSetName() {
+    return "SSE2";
+}
+
+#else
+
+void AudioMixKernels::addMonoToStereo(float* mix, const int16_t* source, int numFrames,
+                                      float leftGain, float rightGain, int delaySamples, bool rightIsDelayed) {
+    Scalar::addMonoToStereo(mix, source, numFrames, leftGain, rightGain, delaySamples, rightIsDelayed);
+}
+
+void AudioMixKernels::addStereo(float* mix, const int16_t* source, int numSamples, float gain) {
+    Scalar::addStereo(mix, source, numSamples, gain);
+}
+
+void AudioMixKernels::addSamples(float* mix, const int16_t* source, int numSamples) {
+    Scalar::addSamples(mix, source, numSamples);
+}
+
+void AudioMixKernels::saturateToInt16(int16_t* destination, const float* mix, int numSamples) {
+    Scalar::saturateToInt16(destination, mix, numSamples);
+}
+
+const char* AudioMixKernels::getInstructionSetName() {
+    return "scalar";
+}
+
+#endif
@@ -0,0 +1,49 @@
+//
+//  AudioMixKernels.h
+//  libraries/audio/src
+//
+//  Created on 3/4/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioMixKernels_h
+#define hifi_AudioMixKernels_h
+
+#include <stdint.h>
+
+/// Inner loops for the audio mixer. Every kernel accumulates into a float buffer of interleaved stereo samples so that
+/// sources can be summed without clamping, and the mix is only saturated back to int16 once it is complete.
+/// The SSE2 (and AVX2, when compiled for it) paths are picked at compile time, with a scalar fallback everywhere else.
+namespace AudioMixKernels {
+
+    /// spreads a mono source to stereo, one of the two channels is weakened and delayed by delaySamples.
+    /// source holds delaySamples of history followed by the numFrames samples of the frame itself
+    void addMonoToStereo(float* mix, const int16_t* source, int numFrames,
+                         float leftGain, float rightGain, int delaySamples, bool rightIsDelayed);
+
+    /// adds an interleaved stereo source with the same gain on both channels
+    void addStereo(float* mix, const int16_t* source, int numSamples, float gain);
+
+    /// adds an int16 buffer (a filtered pre-mix, for example) as is
+    void addSamples(float* mix, const int16_t* source, int numSamples);
+
+    /// rounds and saturates the accumulated mix to int16
+    void saturateToInt16(int16_t* destination, const float* mix, int numSamples);
+
+    /// scalar versions of the kernels above, always compiled so the vectorized paths can be checked against them
+    namespace Scalar {
+        void addMonoToStereo(float* mix, const int16_t* source, int numFrames,
+                             float leftGain, float rightGain, int delaySamples, bool rightIsDelayed);
+        void addStereo(float* mix, const int16_t* source, int numSamples, float gain);
+        void addSamples(float* mix, const int16_t* source, int numSamples);
+        void saturateToInt16(int16_t* destination, const float* mix, int numSamples);
+    }
+
+    /// name of the instruction set the kernels were compiled for ("AVX2", "SSE2" or "scalar")
+    const char* getInstructionSetName();
+}
+
+#endif // hifi_AudioMixKernels_h
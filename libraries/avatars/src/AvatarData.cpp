@@ -146,6 +146,8 @@ QByteArray AvatarData::toByteArray() {
     unsigned char* destinationBuffer = reinterpret_cast<unsigned char*>(avatarDataByteArray.data());
     unsigned char* startPosition = destinationBuffer;
     
+    *destinationBuffer++ = AVATAR_DATA_FULL;
+    
     memcpy(destinationBuffer, &_position, sizeof(_position));
     destinationBuffer += sizeof(_position);
     
@@ -255,6 +257,193 @@ QByteArray AvatarData::toByteArray() {
     return avatarDataByteArray.left(destinationBuffer - startPosition);
 }
 
+// deltas carry the position as an offset from the keyframe's in 16 bit fixed point, 1mm precision out to 32m
+const int DELTA_POSITION_RADIX = 10;
+const float MAX_DELTA_POSITION_OFFSET = 31.0f;
+
+// the look at position is sent relative to the avatar in 16 bit fixed point, 1.5cm precision out to 500m
+const int LOOK_AT_OFFSET_RADIX = 6;
+const float MAX_LOOK_AT_OFFSET = 500.0f;
+
+const quint64 INVALID_JOINT_CODE = ~0ULL;
+
+static quint64 packJointCode(const JointData& joint, int jointRotationBits) {
+    return joint.valid ? packOrientationQuatSmallestThree(joint.rotation, jointRotationBits) : INVALID_JOINT_CODE;
+}
+
+// the compact joint data is a bit stream, filled most significant bit first - the buffer must start out zeroed
+static void writeBits(unsigned char* buffer, int& bitPosition, quint64 value, int numBits) {
+    for (int i = numBits - 1; i >= 0; i--) {
+        if (value & (1ULL << i)) {
+            buffer[bitPosition / BITS_IN_BYTE] |= 1 << (BITS_IN_BYTE - 1 - (bitPosition % BITS_IN_BYTE));
+        }
+        ++bitPosition;
+    }
+}
+
+static quint64 readBits(const unsigned char* buffer, int& bitPosition, int numBits) {
+    quint64 value = 0;
+    for (int i = 0; i < numBits; i++) {
+        bool bit = buffer[bitPosition / BITS_IN_BYTE] & (1 << (BITS_IN_BYTE - 1 - (bitPosition % BITS_IN_BYTE)));
+        value = (value << 1) | (bit ? 1 : 0);
+        ++bitPosition;
+    }
+    return value;
+}
+
+QByteArray AvatarData::toKeyframeByteArray(AvatarDataKeyframe& keyframe, quint16 sequence, int jointRotationBits) {
+    keyframe.sequence = sequence;
+    keyframe.isValid = true;
+    keyframe.jointRotationBits = glm::clamp(jointRotationBits, MIN_JOINT_ROTATION_BITS, MAX_JOINT_ROTATION_BITS);
+    keyframe.position = _position;
+    
+    keyframe.jointCodes.resize(_jointData.size());
+    for (int i = 0; i < _jointData.size(); i++) {
+        keyframe.jointCodes[i] = packJointCode(_jointData[i], keyframe.jointRotationBits);
+    }
+    
+    return toCompactByteArray(AVATAR_DATA_KEYFRAME, keyframe);
+}
+
+QByteArray AvatarData::toDeltaByteArray(const AvatarDataKeyframe& keyframe) {
+    glm::vec3 positionOffset = glm::abs(_position - keyframe.position);
+    if (!keyframe.isValid || keyframe.jointCodes.size() != _jointData.size()
+        || glm::max(positionOffset.x, glm::max(positionOffset.y, positionOffset.z)) > MAX_DELTA_POSITION_OFFSET) {
+        return QByteArray();
+    }
+    
+    return toCompactByteArray(AVATAR_DATA_DELTA, keyframe);
+}
+
+QByteArray AvatarData::toCompactByteArray(AvatarDataFormat format, const AvatarDataKeyframe& keyframe) {
+    // lazily allocate memory for HeadData in case we're not an Avatar instance
+    if (!_headData) {
+        _headData = new HeadData(this);
+    }
+    
+    // the joint bit stream relies on the buffer starting out zeroed
+    QByteArray avatarDataByteArray(MAX_PACKET_SIZE, 0);
+    
+    unsigned char* destinationBuffer = reinterpret_cast<unsigned char*>(avatarDataByteArray.data());
+    unsigned char* startPosition = destinationBuffer;
+    
+    *destinationBuffer++ = format;
+    
+    // the keyframe this record belongs to and the precision of its joints
+    memcpy(destinationBuffer, &keyframe.sequence, sizeof(keyframe.sequence));
+    destinationBuffer += sizeof(keyframe.sequence);
+    *destinationBuffer++ = keyframe.jointRotationBits;
+    
+    if (format == AVATAR_DATA_KEYFRAME) {
+        memcpy(destinationBuffer, &_position, sizeof(_position));
+        destinationBuffer += sizeof(_position);
+    } else {
+        destinationBuffer += packFloatVec3ToSignedTwoByteFixed(destinationBuffer, _position - keyframe.position,
+                                                               DELTA_POSITION_RADIX);
+    }
+    
+    // Body rotation and scale
+    destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _bodyYaw);
+    destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _bodyPitch);
+    destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _bodyRoll);
+    destinationBuffer += packFloatRatioToTwoByte(destinationBuffer, _targetScale);
+    
+    // Head rotation
+    destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _headData->getFinalPitch());
+    destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _headData->getFinalYaw());
+    destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _headData->getFinalRoll());
+    
+    // Lookat Position, relative to the avatar
+    glm::vec3 lookAtOffset = _headData->_lookAtPosition - _position;
+    float lookAtDistance = glm::length(lookAtOffset);
+    if (lookAtDistance > MAX_LOOK_AT_OFFSET) {
+        lookAtOffset *= MAX_LOOK_AT_OFFSET / lookAtDistance;
+    }
+    destinationBuffer += packFloatVec3ToSignedTwoByteFixed(destinationBuffer, lookAtOffset, LOOK_AT_OFFSET_RADIX);
+    
+    // Instantaneous audio loudness (used to drive facial animation)
+    memcpy(destinationBuffer, &_headData->_audioLoudness, sizeof(float));
+    destinationBuffer += sizeof(float);
+    
+    // bitMask of less than byte wide items, laid out as in the full format
+    unsigned char bitItems = 0;
+    setSemiNibbleAt(bitItems, KEY_STATE_START_BIT, _keyState);
+    setSemiNibbleAt(bitItems, HAND_STATE_START_BIT, _handState & ~IS_FINGER_POINTING_FLAG);
+    if (_handState & IS_FINGER_POINTING_FLAG) {
+        setAtBit(bitItems, HAND_STATE_FINGER_POINTING_BIT);
+    }
+    if (_headData->_isFaceshiftConnected) {
+        setAtBit(bitItems, IS_FACESHIFT_CONNECTED);
+    }
+    if (_isChatCirclingEnabled) {
+        setAtBit(bitItems, IS_CHAT_CIRCLING_ENABLED);
+    }
+    if (_referential != NULL && _referential->isValid()) {
+        setAtBit(bitItems, HAS_REFERENTIAL);
+    }
+    *destinationBuffer++ = bitItems;
+    
+    if (_referential != NULL && _referential->isValid()) {
+        destinationBuffer += _referential->packReferential(destinationBuffer);
+    }
+    
+    if (_headData->_isFaceshiftConnected) {
+        memcpy(destinationBuffer, &_headData->_leftEyeBlink, sizeof(float));
+        destinationBuffer += sizeof(float);
+        
+        memcpy(destinationBuffer, &_headData->_rightEyeBlink, sizeof(float));
+        destinationBuffer += sizeof(float);
+        
+        memcpy(destinationBuffer, &_headData->_averageLoudness, sizeof(float));
+        destinationBuffer += sizeof(float);
+        
+        memcpy(destinationBuffer, &_headData->_browAudioLift, sizeof(float));
+        destinationBuffer += sizeof(float);
+        
+        // blendshape coefficients are between 0 and 1, a byte each is plenty
+        *destinationBuffer++ = _headData->_blendshapeCoefficients.size();
+        foreach (float coefficient, _headData->_blendshapeCoefficients) {
+            destinationBuffer += packFloatToByte(destinationBuffer, glm::clamp(coefficient, 0.0f, 1.0f), 1.0f);
+        }
+    }
+    
+    // pupil dilation
+    destinationBuffer += packFloatToByte(destinationBuffer, _headData->_pupilDilation, 1.0f);
+    
+    // joint data - a keyframe has every joint, a delta has a bit per joint saying whether it changed since the keyframe.
+    // each joint present then has a validity bit followed by its packed rotation if it is valid.
+    *destinationBuffer++ = _jointData.size();
+    
+    unsigned char* jointBytesAt = destinationBuffer;
+    destinationBuffer += sizeof(quint16);
+    
+    int packedJointBits = 2 + 3 * keyframe.jointRotationBits;
+    int bitPosition = 0;
+    for (int i = 0; i < _jointData.size(); i++) {
+        quint64 jointCode = keyframe.jointCodes[i];
+        if (format == AVATAR_DATA_DELTA) {
+            jointCode = packJointCode(_jointData[i], keyframe.jointRotationBits);
+            
+            bool hasChanged = (jointCode != keyframe.jointCodes[i]);
+            writeBits(destinationBuffer, bitPosition, hasChanged ? 1 : 0, 1);
+            if (!hasChanged) {
+                continue;
+            }
+        }
+        
+        writeBits(destinationBuffer, bitPosition, jointCode != INVALID_JOINT_CODE ? 1 : 0, 1);
+        if (jointCode != INVALID_JOINT_CODE) {
+            writeBits(destinationBuffer, bitPosition, jointCode, packedJointBits);
+        }
+    }
+    
+    quint16 jointBytes = (bitPosition + BITS_IN_BYTE - 1) / BITS_IN_BYTE;
+    memcpy(jointBytesAt, &jointBytes, sizeof(jointBytes));
+    destinationBuffer += jointBytes;
+    
+    return avatarDataByteArray.left(destinationBuffer - startPosition);
+}
+
 bool AvatarData::shouldLogError(const quint64& now) {
     if (now > _errorLogExpiry) {
         _errorLogExpiry = now + DEFAULT_FILTERED_LOG_EXPIRY;
@@ -279,6 +468,29 @@ int AvatarData::parseDataAtOffset(const QByteArray& packet, int offset) {
         _handData = new HandData(this);
     }
     
+    if (offset >= packet.size()) {
+        return 0;
+    }
+    
+    // the first byte says which format the rest of the record is in
+    AvatarDataFormat format = (AvatarDataFormat) packet.at(offset);
+    switch (format) {
+        case AVATAR_DATA_FULL:
+            return 1 + parseFullDataAtOffset(packet, offset + 1);
+        case AVATAR_DATA_KEYFRAME:
+        case AVATAR_DATA_DELTA:
+            return 1 + parseCompactDataAtOffset(packet, offset + 1, format);
+        default:
+            quint64 now = usecTimestampNow();
+            if (shouldLogError(now)) {
+                qDebug() << "Unknown AvatarData format" << format << "; displayName = '" << _displayName << "'";
+            }
+            // we can't tell where this record ends, so we report all bytes as consumed
+            return packet.size() - offset;
+    }
+}
+
+int AvatarData::parseFullDataAtOffset(const QByteArray& packet, int offset) {
     const unsigned char* startPosition = reinterpret_cast<const unsigned char*>(packet.data()) + offset;
     const unsigned char* sourceBuffer = startPosition;
     quint64 now = usecTimestampNow();
@@ -554,6 +766,287 @@ int AvatarData::parseDataAtOffset(const QByteArray& packet, int offset) {
     return sourceBuffer - startPosition;
 }
 
+int AvatarData::parseCompactDataAtOffset(const QByteArray& packet, int offset, AvatarDataFormat format) {
+    const unsigned char* startPosition = reinterpret_cast<const unsigned char*>(packet.data()) + offset;
+    const unsigned char* sourceBuffer = startPosition;
+    quint64 now = usecTimestampNow();
+    
+    // The absolute minimum size of a compact record is as follows:
+    //     keyframe sequence   =  2 bytes
+    //     joint rotation bits =  1
+    //     position            = 12 for a keyframe, 6 (fixed point offset) for a delta
+    //     body rotation       =  6 (compressed floats)
+    //     targetScale         =  2 (compressed float)
+    //     head rotation       =  6 (compressed floats)
+    //     lookAt offset       =  6 (fixed point)
+    //     audioLoudness       =  4
+    //     bitItems            =  1
+    //     pupilSize           =  1
+    //     numJoints           =  1
+    //     joint data bytes    =  2
+    // = 44 bytes for a keyframe, 38 for a delta
+    int minPossibleSize = (format == AVATAR_DATA_KEYFRAME) ? 44 : 38;
+    
+    int maxAvailableSize = packet.size() - offset;
+    if (minPossibleSize > maxAvailableSize) {
+        if (shouldLogError(now)) {
+            qDebug() << "Malformed compact AvatarData packet at the start; "
+                << " displayName = '" << _displayName << "'"
+                << " minPossibleSize = " << minPossibleSize
+                << " maxAvailableSize = " << maxAvailableSize;
+        }
+        return maxAvailableSize;
+    }
+    
+    quint16 sequence;
+    memcpy(&sequence, sourceBuffer, sizeof(sequence));
+    sourceBuffer += sizeof(sequence);
+    
+    int jointRotationBits = *sourceBuffer++;
+    if (jointRotationBits < MIN_JOINT_ROTATION_BITS || jointRotationBits > MAX_JOINT_ROTATION_BITS) {
+        if (shouldLogError(now)) {
+            qDebug() << "Discard AvatarData with" << jointRotationBits << "bit joint rotations; displayName = '"
+                << _displayName << "'";
+        }
+        return maxAvailableSize;
+    }
+    
+    // a delta can only be fully applied on top of the keyframe it was encoded against - if we missed that keyframe
+    // we still take everything that is sent whole and catch up on the rest with the next keyframe
+    bool hasKeyframe = (format == AVATAR_DATA_KEYFRAME)
+        || (_receivedKeyframe.isValid && _receivedKeyframe.sequence == sequence);
+    
+    { // Body world position
+        glm::vec3 position;
+        if (format == AVATAR_DATA_KEYFRAME) {
+            memcpy(&position, sourceBuffer, sizeof(position));
+            sourceBuffer += sizeof(position);
+        } else {
+            glm::vec3 positionOffset;
+            sourceBuffer += unpackFloatVec3FromSignedTwoByteFixed(sourceBuffer, positionOffset, DELTA_POSITION_RADIX);
+            position = _receivedKeyframe.position + positionOffset;
+        }
+        
+        if (glm::isnan(position.x) || glm::isnan(position.y) || glm::isnan(position.z)) {
+            if (shouldLogError(now)) {
+                qDebug() << "Discard nan AvatarData::position; displayName = '" << _displayName << "'";
+            }
+            return maxAvailableSize;
+        }
+        
+        if (format == AVATAR_DATA_KEYFRAME) {
+            _receivedKeyframe.sequence = sequence;
+            _receivedKeyframe.isValid = true;
+            _receivedKeyframe.jointRotationBits = jointRotationBits;
+            _receivedKeyframe.position = position;
+        }
+        
+        if (hasKeyframe) {
+            setPosition(position);
+        }
+    }
+    
+    { // Body rotation, scale and head rotation
+        float yaw, pitch, roll, scale;
+        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &yaw);
+        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &pitch);
+        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &roll);
+        sourceBuffer += unpackFloatRatioFromTwoByte(sourceBuffer, scale);
+        
+        float headYaw, headPitch, headRoll;
+        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &headPitch);
+        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &headYaw);
+        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &headRoll);
+        
+        if (glm::isnan(yaw) || glm::isnan(pitch) || glm::isnan(roll) || glm::isnan(scale)
+            || glm::isnan(headYaw) || glm::isnan(headPitch) || glm::isnan(headRoll)) {
+            if (shouldLogError(now)) {
+                qDebug() << "Discard nan AvatarData::orientation,scale; displayName = '" << _displayName << "'";
+            }
+            return maxAvailableSize;
+        }
+        _bodyYaw = yaw;
+        _bodyPitch = pitch;
+        _bodyRoll = roll;
+        _targetScale = scale;
+        
+        _headData->setBasePitch(headPitch);
+        _headData->setBaseYaw(headYaw);
+        _headData->setBaseRoll(headRoll);
+    }
+    
+    { // Lookat Position, relative to the avatar
+        glm::vec3 lookAtOffset;
+        sourceBuffer += unpackFloatVec3FromSignedTwoByteFixed(sourceBuffer, lookAtOffset, LOOK_AT_OFFSET_RADIX);
+        _headData->_lookAtPosition = _position + lookAtOffset;
+    }
+    
+    { // AudioLoudness
+        float audioLoudness;
+        memcpy(&audioLoudness, sourceBuffer, sizeof(float));
+        sourceBuffer += sizeof(float);
+        if (glm::isnan(audioLoudness)) {
+            if (shouldLogError(now)) {
+                qDebug() << "Discard nan AvatarData::audioLoudness; displayName = '" << _displayName << "'";
+            }
+            return maxAvailableSize;
+        }
+        _headData->_audioLoudness = audioLoudness;
+    }
+    
+    { // bitFlags and face data, see parseFullDataAtOffset for the layout of the bit items
+        unsigned char bitItems = *sourceBuffer++;
+        
+        _keyState = (KeyState)getSemiNibbleAt(bitItems, KEY_STATE_START_BIT);
+        _handState = getSemiNibbleAt(bitItems, HAND_STATE_START_BIT)
+            + (oneAtBit(bitItems, HAND_STATE_FINGER_POINTING_BIT) ? IS_FINGER_POINTING_FLAG : 0);
+        
+        _headData->_isFaceshiftConnected = oneAtBit(bitItems, IS_FACESHIFT_CONNECTED);
+        _isChatCirclingEnabled = oneAtBit(bitItems, IS_CHAT_CIRCLING_ENABLED);
+        bool hasReferential = oneAtBit(bitItems, HAS_REFERENTIAL);
+        
+        if (hasReferential) {
+            Referential* ref = new Referential(sourceBuffer, this);
+            if (_referential == NULL ||
+                ref->version() != _referential->version()) {
+                changeReferential(ref);
+            } else {
+                delete ref;
+            }
+            _referential->update();
+        } else if (_referential != NULL) {
+            changeReferential(NULL);
+        }
+        
+        if (_headData->_isFaceshiftConnected) {
+            float leftEyeBlink, rightEyeBlink, averageLoudness, browAudioLift;
+            minPossibleSize += sizeof(leftEyeBlink) + sizeof(rightEyeBlink) + sizeof(averageLoudness) + sizeof(browAudioLift);
+            minPossibleSize++; // one byte for the number of blendshapes
+            if (minPossibleSize > maxAvailableSize) {
+                if (shouldLogError(now)) {
+                    qDebug() << "Malformed compact AvatarData packet after BitItems;"
+                        << " displayName = '" << _displayName << "'"
+                        << " minPossibleSize = " << minPossibleSize
+                        << " maxAvailableSize = " << maxAvailableSize;
+                }
+                return maxAvailableSize;
+            }
+            
+            memcpy(&leftEyeBlink, sourceBuffer, sizeof(float));
+            sourceBuffer += sizeof(float);
+            
+            memcpy(&rightEyeBlink, sourceBuffer, sizeof(float));
+            sourceBuffer += sizeof(float);
+            
+            memcpy(&averageLoudness, sourceBuffer, sizeof(float));
+            sourceBuffer += sizeof(float);
+            
+            memcpy(&browAudioLift, sourceBuffer, sizeof(float));
+            sourceBuffer += sizeof(float);
+            
+            if (glm::isnan(leftEyeBlink) || glm::isnan(rightEyeBlink)
+                    || glm::isnan(averageLoudness) || glm::isnan(browAudioLift)) {
+                if (shouldLogError(now)) {
+                    qDebug() << "Discard nan AvatarData::faceData; displayName = '" << _displayName << "'";
+                }
+                return maxAvailableSize;
+            }
+            _headData->_leftEyeBlink = leftEyeBlink;
+            _headData->_rightEyeBlink = rightEyeBlink;
+            _headData->_averageLoudness = averageLoudness;
+            _headData->_browAudioLift = browAudioLift;
+            
+            int numCoefficients = (int)(*sourceBuffer++);
+            minPossibleSize += numCoefficients;
+            if (minPossibleSize > maxAvailableSize) {
+                if (shouldLogError(now)) {
+                    qDebug() << "Malformed compact AvatarData packet after Blendshapes;"
+                        << " displayName = '" << _displayName << "'"
+                        << " minPossibleSize = " << minPossibleSize
+                        << " maxAvailableSize = " << maxAvailableSize;
+                }
+                return maxAvailableSize;
+            }
+            
+            _headData->_blendshapeCoefficients.resize(numCoefficients);
+            for (int i = 0; i < numCoefficients; i++) {
+                sourceBuffer += unpackFloatFromByte(sourceBuffer, _headData->_blendshapeCoefficients[i], 1.0f);
+            }
+        }
+    }
+    
+    { // pupil dilation
+        sourceBuffer += unpackFloatFromByte(sourceBuffer, _headData->_pupilDilation, 1.0f);
+    }
+    
+    // joint data
+    int numJoints = *sourceBuffer++;
+    
+    quint16 jointBytes;
+    memcpy(&jointBytes, sourceBuffer, sizeof(jointBytes));
+    sourceBuffer += sizeof(jointBytes);
+    
+    minPossibleSize += jointBytes;
+    if (minPossibleSize > maxAvailableSize) {
+        if (shouldLogError(now)) {
+            qDebug() << "Malformed compact AvatarData packet after JointBytes;"
+                << " displayName = '" << _displayName << "'"
+                << " minPossibleSize = " << minPossibleSize
+                << " maxAvailableSize = " << maxAvailableSize;
+        }
+        return maxAvailableSize;
+    }
+    
+    if (format == AVATAR_DATA_KEYFRAME) {
+        _receivedKeyframe.jointCodes.resize(numJoints);
+    }
+    _jointData.resize(numJoints);
+    
+    int packedJointBits = 2 + 3 * jointRotationBits;
+    int bitPosition = 0;
+    int numJointBits = jointBytes * BITS_IN_BYTE;
+    for (int i = 0; i < numJoints; i++) {
+        // every joint needs at least its changed or validity bit, and a valid one its packed rotation on top of that
+        if (bitPosition + 1 > numJointBits) {
+            break;
+        }
+        
+        bool isPresent = (format == AVATAR_DATA_KEYFRAME) || readBits(sourceBuffer, bitPosition, 1);
+        quint64 jointCode = INVALID_JOINT_CODE;
+        
+        if (isPresent) {
+            if (bitPosition + 1 > numJointBits) {
+                break;
+            }
+            if (readBits(sourceBuffer, bitPosition, 1)) {
+                if (bitPosition + packedJointBits > numJointBits) {
+                    break;
+                }
+                jointCode = readBits(sourceBuffer, bitPosition, packedJointBits);
+            }
+        } else if (hasKeyframe && i < _receivedKeyframe.jointCodes.size()) {
+            jointCode = _receivedKeyframe.jointCodes[i];
+        } else {
+            // without the keyframe we don't know what this joint was, so leave it as it is until the next one
+            continue;
+        }
+        
+        if (format == AVATAR_DATA_KEYFRAME) {
+            _receivedKeyframe.jointCodes[i] = jointCode;
+        }
+        
+        JointData& data = _jointData[i];
+        data.valid = (jointCode != INVALID_JOINT_CODE);
+        if (data.valid) {
+            _hasNewJointRotations = true;
+            data.rotation = unpackOrientationQuatSmallestThree(jointCode, jointRotationBits);
+        }
+    }
+    sourceBuffer += jointBytes;
+    
+    return sourceBuffer - startPosition;
+}
+
 bool AvatarData::hasReferential() {
     return _referential != NULL;
 }
@@ -896,7 +1389,8 @@ QByteArray AvatarData::identityByteArray() {
     QByteArray identityData;
     QDataStream identityStream(&identityData, QIODevice::Append);
 
-    identityStream << QUuid() << _faceModelURL << _skeletonModelURL << _attachmentData << _displayName;
+    // the avatar mixer tells the avatars of the scripts an agent hosts apart by their session UUIDs
+    identityStream << _sessionUUID << _faceModelURL << _skeletonModelURL << _attachmentData << _displayName;
     
     return identityData;
 }
@@ -116,6 +116,32 @@ enum KeyState {
     DELETE_KEY_DOWN
 };
 
+// Every avatar data record starts with a byte saying how the rest of it is encoded. Agents send the full format up to
+// the avatar-mixer, which sends compact keyframes and deltas against them back down to everyone else.
+enum AvatarDataFormat {
+    AVATAR_DATA_FULL = 0,  // float positions, look at and blendshapes plus every joint as four 16 bit components
+    AVATAR_DATA_KEYFRAME,  // compact state with quantized blendshapes and every joint as a smallest three quat
+    AVATAR_DATA_DELTA      // compact state relative to a keyframe, only carrying the joints that changed since it
+};
+
+// bits used for each of the three components of the compact smallest three joint rotations
+const int DEFAULT_JOINT_ROTATION_BITS = 12;
+const int MIN_JOINT_ROTATION_BITS = 6;
+const int MAX_JOINT_ROTATION_BITS = 20;
+
+/// The state compact deltas are encoded against - captured by the sender when it encodes a keyframe and by the receiver
+/// when it parses one, joints are kept in their packed form so unchanged ones can be found by comparing codes
+class AvatarDataKeyframe {
+public:
+    AvatarDataKeyframe() : sequence(0), isValid(false), jointRotationBits(DEFAULT_JOINT_ROTATION_BITS), position(0.0f) { }
+    
+    quint16 sequence;
+    bool isValid;
+    int jointRotationBits;
+    glm::vec3 position;
+    QVector<quint64> jointCodes;
+};
+
 class QDataStream;
 
 class AttachmentData;
@@ -165,6 +191,13 @@ public:
 
     virtual QByteArray toByteArray();
 
+    /// encodes a compact keyframe, capturing the state later deltas are encoded against in keyframe
+    QByteArray toKeyframeByteArray(AvatarDataKeyframe& keyframe, quint16 sequence, int jointRotationBits);
+    
+    /// encodes the current state as a delta against keyframe
+    /// \return an empty array if the avatar has moved too far or changed skeletons since the keyframe
+    QByteArray toDeltaByteArray(const AvatarDataKeyframe& keyframe);
+
     /// \return true if an error should be logged
     bool shouldLogError(const quint64& now);
 
@@ -379,9 +412,15 @@ protected:
     
     PlayerPointer _player;
     
+    AvatarDataKeyframe _receivedKeyframe; ///< the last keyframe parsed, compact deltas are decoded against it
+    
     /// Loads the joint indices, names from the FST file (if any)
     virtual void updateJointMappings();
     void changeReferential(Referential* ref);
+    
+    QByteArray toCompactByteArray(AvatarDataFormat format, const AvatarDataKeyframe& keyframe);
+    int parseFullDataAtOffset(const QByteArray& packet, int offset);
+    int parseCompactDataAtOffset(const QByteArray& packet, int offset, AvatarDataFormat format);
 
 private:
     // privatize the copy constructor and assignment operator so they cannot be called
@@ -333,7 +333,8 @@ void EntityTreeRenderer::render(RenderArgs::RenderMode renderMode, RenderArgs::R
         RenderArgs args = { this, _viewFrustum, getSizeScale(), getBoundaryLevelAdjust(), renderMode, renderSide,
                                             0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
         _tree->lockForRead();
-        _tree->recurseTreeWithOperation(renderOperation, &args);
+        OctreeElement* root = _tree->getRoot();
+        renderSubtree(root, root->inFrustum(*_viewFrustum), root->furthestDistanceToCamera(*_viewFrustum), &args);
 
         Model::RenderMode modelRenderMode = renderMode == RenderArgs::SHADOW_RENDER_MODE
                                             ? Model::SHADOW_RENDER_MODE : Model::DEFAULT_RENDER_MODE;
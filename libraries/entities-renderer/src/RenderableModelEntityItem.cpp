@@ -159,7 +159,10 @@ void RenderableModelEntityItem::render(RenderArgs* args) {
                         PerformanceTimer perfTimer("_model->simulate");
                         _model->simulate(0.0f);
                     }
-                    _needsInitialSimulation = false;
+                    if (_needsInitialSimulation) {
+                        _needsInitialSimulation = false;
+                        _dirtyFlags |= EntityItem::DIRTY_UPDATEABLE;
+                    }
                 }
 
                 if (_model->isActive()) {
@@ -26,7 +26,6 @@ public:
     virtual EntityItemProperties getProperties() const;
     virtual bool setProperties(const EntityItemProperties& properties);
 
-    // TODO: eventually only include properties changed since the params.lastViewFrustumSent time
     virtual EntityPropertyFlags getEntityProperties(EncodeBitstreamParams& params) const;
 
     virtual void appendSubclassData(OctreePacketData* packetData, EncodeBitstreamParams& params, 
@@ -0,0 +1,178 @@
+//
+//  EntityCollisionGrid.cpp
+//  libraries/entities/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include "EntityItem.h"
+#include "EntityCollisionGrid.h"
+
+// entities that overlap more cells than this are kept out of the cells and checked against everything instead
+const int MAX_CELLS_PER_BINNED_ENTITY = 64;
+
+const int CELL_COORDINATE_BITS = 21;
+const quint64 CELL_COORDINATE_MASK = (1 << CELL_COORDINATE_BITS) - 1;
+
+static quint64 cellKey(int x, int y, int z) {
+    return (((quint64)x & CELL_COORDINATE_MASK) << (2 * CELL_COORDINATE_BITS)) |
+        (((quint64)y & CELL_COORDINATE_MASK) << CELL_COORDINATE_BITS) | ((quint64)z & CELL_COORDINATE_MASK);
+}
+
+bool EntityCollisionGrid::CellRange::operator==(const CellRange& other) const {
+    return minX == other.minX && minY == other.minY && minZ == other.minZ &&
+        maxX == other.maxX && maxY == other.maxY && maxZ == other.maxZ;
+}
+
+qint64 EntityCollisionGrid::CellRange::getNumCells() const {
+    return (qint64)(maxX - minX + 1) * (qint64)(maxY - minY + 1) * (qint64)(maxZ - minZ + 1);
+}
+
+EntityCollisionGrid::EntityCollisionGrid(float cellSize) :
+    _cellSize(cellSize),
+    _cells(),
+    _entityCells(),
+    _largeEntities()
+{
+}
+
+void EntityCollisionGrid::updateEntity(EntityItem* entity) {
+    if (entity->getIgnoreForCollisions()) {
+        removeEntity(entity);
+        return;
+    }
+
+    CellRange newRange = computeCellRange(entity);
+    QHash<EntityItem*, CellRange>::iterator entityCells = _entityCells.find(entity);
+    if (entityCells != _entityCells.end()) {
+        if (entityCells.value() == newRange) {
+            // most updates are for entities that haven't left their cells
+            return;
+        }
+        removeFromCells(entity, entityCells.value());
+        entityCells.value() = newRange;
+    } else {
+        _entityCells.insert(entity, newRange);
+    }
+    addToCells(entity, newRange);
+}
+
+void EntityCollisionGrid::removeEntity(EntityItem* entity) {
+    QHash<EntityItem*, CellRange>::iterator entityCells = _entityCells.find(entity);
+    if (entityCells != _entityCells.end()) {
+        removeFromCells(entity, entityCells.value());
+        _entityCells.erase(entityCells);
+    }
+}
+
+void EntityCollisionGrid::clear() {
+    _cells.clear();
+    _entityCells.clear();
+    _largeEntities.clear();
+}
+
+void EntityCollisionGrid::findNearbyEntities(EntityItem* entity, QVector<EntityItem*>& nearbyEntities) const {
+    int firstNearbyEntity = nearbyEntities.size();
+
+    QHash<EntityItem*, CellRange>::const_iterator entityCells = _entityCells.find(entity);
+    CellRange range = (entityCells != _entityCells.end()) ? entityCells.value() : computeCellRange(entity);
+
+    if (range.getNumCells() > MAX_CELLS_PER_BINNED_ENTITY) {
+        // a large entity is near everything, and walking its cells would cost more than just listing everything
+        foreach (EntityItem* otherEntity, _entityCells.keys()) {
+            if (otherEntity != entity) {
+                nearbyEntities.append(otherEntity);
+            }
+        }
+        return;
+    }
+
+    for (int x = range.minX; x <= range.maxX; x++) {
+        for (int y = range.minY; y <= range.maxY; y++) {
+            for (int z = range.minZ; z <= range.maxZ; z++) {
+                QHash<quint64, QVector<EntityItem*> >::const_iterator cell = _cells.find(cellKey(x, y, z));
+                if (cell != _cells.end()) {
+                    foreach (EntityItem* otherEntity, cell.value()) {
+                        if (otherEntity != entity) {
+                            nearbyEntities.append(otherEntity);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    foreach (EntityItem* largeEntity, _largeEntities) {
+        if (largeEntity != entity) {
+            nearbyEntities.append(largeEntity);
+        }
+    }
+
+    // an entity spanning several of the cells we looked at was listed once for each of them
+    std::sort(nearbyEntities.begin() + firstNearbyEntity, nearbyEntities.end());
+    nearbyEntities.erase(std::unique(nearbyEntities.begin() + firstNearbyEntity, nearbyEntities.end()),
+                         nearbyEntities.end());
+}
+
+EntityCollisionGrid::CellRange EntityCollisionGrid::computeCellRange(EntityItem* entity) const {
+    const Shape& shape = entity->getCollisionShapeInMeters();
+    glm::vec3 minimum = (shape.getTranslation() - glm::vec3(shape.getBoundingRadius())) / _cellSize;
+    glm::vec3 maximum = (shape.getTranslation() + glm::vec3(shape.getBoundingRadius())) / _cellSize;
+
+    CellRange range;
+    range.minX = (int)glm::floor(minimum.x);
+    range.minY = (int)glm::floor(minimum.y);
+    range.minZ = (int)glm::floor(minimum.z);
+    range.maxX = (int)glm::floor(maximum.x);
+    range.maxY = (int)glm::floor(maximum.y);
+    range.maxZ = (int)glm::floor(maximum.z);
+    return range;
+}
+
+void EntityCollisionGrid::addToCells(EntityItem* entity, const CellRange& range) {
+    if (range.getNumCells() > MAX_CELLS_PER_BINNED_ENTITY) {
+        _largeEntities.insert(entity);
+        return;
+    }
+    for (int x = range.minX; x <= range.maxX; x++) {
+        for (int y = range.minY; y <= range.maxY; y++) {
+            for (int z = range.minZ; z <= range.maxZ; z++) {
+                _cells[cellKey(x, y, z)].append(entity);
+            }
+        }
+    }
+}
+
+void EntityCollisionGrid::removeFromCells(EntityItem* entity, const CellRange& range) {
+    if (range.getNumCells() > MAX_CELLS_PER_BINNED_ENTITY) {
+        _largeEntities.remove(entity);
+        return;
+    }
+    for (int x = range.minX; x <= range.maxX; x++) {
+        for (int y = range.minY; y <= range.maxY; y++) {
+            for (int z = range.minZ; z <= range.maxZ; z++) {
+                QHash<quint64, QVector<EntityItem*> >::iterator cell = _cells.find(cellKey(x, y, z));
+                if (cell == _cells.end()) {
+                    continue;
+                }
+                QVector<EntityItem*>& cellEntities = cell.value();
+                int index = cellEntities.indexOf(entity);
+                if (index != -1) {
+                    // order within a cell doesn't matter, so fill the hole with the last entry
+                    cellEntities[index] = cellEntities.last();
+                    cellEntities.removeLast();
+                }
+                if (cellEntities.isEmpty()) {
+                    _cells.erase(cell);
+                }
+            }
+        }
+    }
+}
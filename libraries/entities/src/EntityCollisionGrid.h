@@ -0,0 +1,62 @@
+//
+//  EntityCollisionGrid.h
+//  libraries/entities/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_EntityCollisionGrid_h
+#define hifi_EntityCollisionGrid_h
+
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+#include <QtCore/QVector>
+
+class EntityItem;
+
+const float DEFAULT_ENTITY_COLLISION_GRID_CELL_SIZE = 4.0f; // meters
+
+/// A uniform grid broadphase for entity collisions. Each collidable entity is binned into the cells its collision
+/// shape's bounding sphere overlaps, and is only re-binned when an update finds it has moved into different cells.
+class EntityCollisionGrid {
+public:
+    EntityCollisionGrid(float cellSize = DEFAULT_ENTITY_COLLISION_GRID_CELL_SIZE);
+
+    /// adds the entity to the grid, or moves it to the cells it now overlaps - entities that are ignored for
+    /// collisions are removed instead
+    void updateEntity(EntityItem* entity);
+    void removeEntity(EntityItem* entity);
+    void clear();
+
+    bool contains(EntityItem* entity) const { return _entityCells.contains(entity); }
+    int size() const { return _entityCells.size(); }
+
+    /// \param[out] nearbyEntities the entities that share a cell with this one, each listed once, not including itself
+    void findNearbyEntities(EntityItem* entity, QVector<EntityItem*>& nearbyEntities) const;
+
+private:
+    class CellRange {
+    public:
+        bool operator==(const CellRange& other) const;
+        bool operator!=(const CellRange& other) const { return !(*this == other); }
+        qint64 getNumCells() const;
+
+        int minX, minY, minZ;
+        int maxX, maxY, maxZ;
+    };
+
+    CellRange computeCellRange(EntityItem* entity) const;
+    void addToCells(EntityItem* entity, const CellRange& range);
+    void removeFromCells(EntityItem* entity, const CellRange& range);
+
+    float _cellSize;
+    QHash<quint64, QVector<EntityItem*> > _cells;
+    QHash<EntityItem*, CellRange> _entityCells;
+    QSet<EntityItem*> _largeEntities; // entities spanning too many cells to bin, every query looks at these
+};
+
+#endif // hifi_EntityCollisionGrid_h
@@ -16,6 +16,7 @@
 #include <HeadData.h>
 #include <HandData.h>
 #include <PerfStat.h>
+#include <ShapeCollider.h>
 #include <SphereShape.h>
 
 #include "EntityCollisionSystem.h"
@@ -49,156 +50,219 @@ void EntityCollisionSystem::updateCollisions() {
     assert(_entityTree);
     // update all Entities
     if (_entityTree->tryLockForWrite()) {
+        lock();
+        {
+            PerformanceTimer perfTimer("broadphase");
+            // only the entities we simulate can have moved into other cells since the last pass,
+            // external edits re-bin the entities they touch as they arrive
+            foreach (EntityItem* entity, _movingEntities) {
+                _collisionGrid.updateEntity(entity);
+            }
+            findEntityContacts();
+        }
+
+        foreach (const EntityContact& contact, _contacts) {
+            resolveEntityContact(contact);
+        }
+        _contacts.clear();
+
         foreach (EntityItem* entity, _movingEntities) {
-            checkEntity(entity);
+            updateCollisionWithAvatars(entity);
         }
+
+        sendCollidedEntities();
+        unlock();
+
+        // NOTE: Do this after updating the entities so that the callback can delete the entities if they want to
+        foreach (const EntityCollisionEvent& event, _collisionEvents) {
+            emit entityCollisionWithEntity(event.idA, event.idB, event.collision);
+        }
+        _collisionEvents.clear();
+
         _entityTree->unlock();
     }
 }
 
-
-void EntityCollisionSystem::checkEntity(EntityItem* entity) {
-    updateCollisionWithEntities(entity);
-    updateCollisionWithAvatars(entity);
+void EntityCollisionSystem::addEntityInternal(EntityItem* entity) {
+    SimpleEntitySimulation::addEntityInternal(entity);
+    _collisionGrid.updateEntity(entity);
 }
 
-void EntityCollisionSystem::emitGlobalEntityCollisionWithEntity(EntityItem* entityA, 
-                                            EntityItem* entityB, const Collision& collision) {
-                                            
-    EntityItemID idA = entityA->getEntityItemID();
-    EntityItemID idB = entityB->getEntityItemID();
-    emit entityCollisionWithEntity(idA, idB, collision);
+void EntityCollisionSystem::removeEntityInternal(EntityItem* entity) {
+    SimpleEntitySimulation::removeEntityInternal(entity);
+    _collisionGrid.removeEntity(entity);
+    _collidedEntities.remove(entity);
 }
 
-void EntityCollisionSystem::updateCollisionWithEntities(EntityItem* entityA) {
+const int COLLISION_GRID_DIRTY_FLAGS = EntityItem::DIRTY_POSITION | EntityItem::DIRTY_SHAPE |
+    EntityItem::DIRTY_COLLISION_GROUP;
 
-    if (entityA->getIgnoreForCollisions()) {
-        return; // bail early if this entity is to be ignored...
+void EntityCollisionSystem::entityChangedInternal(EntityItem* entity) {
+    // the base class clears the dirty flags
+    int dirtyFlags = entity->getDirtyFlags();
+    SimpleEntitySimulation::entityChangedInternal(entity);
+    if (dirtyFlags & COLLISION_GRID_DIRTY_FLAGS) {
+        _collisionGrid.updateEntity(entity);
     }
+}
 
-    // don't collide entities with unknown IDs,
-    if (!entityA->isKnownID()) {
-        return;
-    }
+void EntityCollisionSystem::clearEntitiesInternal() {
+    SimpleEntitySimulation::clearEntitiesInternal();
+    _collisionGrid.clear();
+    _collidedEntities.clear();
+}
 
-    glm::vec3 penetration;
-    EntityItem* entityB = NULL;
-    
+void EntityCollisionSystem::findEntityContacts() {
     const int MAX_COLLISIONS_PER_ENTITY = 32;
     CollisionList collisions(MAX_COLLISIONS_PER_ENTITY);
-    bool shapeCollisionsAccurate = false;
-    
-    bool shapeCollisions = _entityTree->findShapeCollisions(&entityA->getCollisionShapeInMeters(), 
-                                            collisions, Octree::NoLock, &shapeCollisionsAccurate);
-
-    if (shapeCollisions) {
-        for(int i = 0; i < collisions.size(); i++) {
-
-            CollisionInfo* collision = collisions[i];
-            penetration = collision->_penetration;
-            entityB = static_cast<EntityItem*>(collision->_extraData);
-            
-            // The collision _extraData should be a valid entity, but if for some reason
-            // it's NULL then continue with a warning.
-            if (!entityB) {
-                qDebug() << "UNEXPECTED - we have a collision with missing _extraData. Something went wrong down below!";
-                continue; // skip this loop pass if the entity is NULL
-            }
-            
+    QVector<EntityItem*> nearbyEntities;
+
+    foreach (EntityItem* entityA, _movingEntities) {
+        if (entityA->getIgnoreForCollisions()) {
+            continue; // skip this entity if it is to be ignored...
+        }
+
+        // don't collide entities with unknown IDs,
+        if (!entityA->isKnownID()) {
+            continue;
+        }
+
+        const Shape* shapeA = &entityA->getCollisionShapeInMeters();
+        collisions.clear();
+        nearbyEntities.clear();
+        _collisionGrid.findNearbyEntities(entityA, nearbyEntities);
+
+        foreach (EntityItem* entityB, nearbyEntities) {
             // don't collide entities with unknown IDs,
             if (!entityB->isKnownID()) {
                 continue; // skip this loop pass if the entity has an unknown ID
             }
-            
-            // NOTE: 'penetration' is the depth that 'entityA' overlaps 'entityB'.  It points from A into B.
-            glm::vec3 penetrationInTreeUnits = penetration / (float)(TREE_SCALE);
-
-            // Even if the Entities overlap... when the Entities are already moving appart
-            // we don't want to count this as a collision.
-            glm::vec3 relativeVelocity = entityA->getVelocity() - entityB->getVelocity();
-            
-            bool fullyEnclosedCollision = glm::length(penetrationInTreeUnits) > entityA->getLargestDimension();
-
-            bool wantToMoveA = entityA->getCollisionsWillMove();
-            bool wantToMoveB = entityB->getCollisionsWillMove();
-            bool movingTowardEachOther = glm::dot(relativeVelocity, penetrationInTreeUnits) > 0.0f;
-
-            // only do collisions if the entities are moving toward each other and one or the other
-            // of the entities are movable from collisions
-            bool doCollisions = !fullyEnclosedCollision && movingTowardEachOther && (wantToMoveA || wantToMoveB); 
-
-            if (doCollisions) {
-
-                quint64 now = usecTimestampNow();
-        
-                glm::vec3 axis = glm::normalize(penetration);
-                glm::vec3 axialVelocity = glm::dot(relativeVelocity, axis) * axis;
-
-                float massA = entityA->getMass();
-                float massB = entityB->getMass();
-                float totalMass = massA + massB;
-                float massRatioA = (2.0f * massB / totalMass);
-                float massRatioB = (2.0f * massA / totalMass);
-
-                // in the event that one of our entities is non-moving, then fix up these ratios
-                if (wantToMoveA && !wantToMoveB) {
-                    massRatioA = 2.0f;
-                    massRatioB = 0.0f;
-                }
 
-                if (!wantToMoveA && wantToMoveB) {
-                    massRatioA = 0.0f;
-                    massRatioB = 2.0f;
-                }
-            
-                // unless the entity is configured to not be moved by collision, calculate it's new position
-                // and velocity and apply it
-                if (wantToMoveA) {
-                    // handle Entity A
-                    glm::vec3 newVelocityA = entityA->getVelocity() - axialVelocity * massRatioA;
-                    glm::vec3 newPositionA = entityA->getPosition() - 0.5f * penetrationInTreeUnits;
-
-                    EntityItemProperties propertiesA = entityA->getProperties();
-                    EntityItemID idA(entityA->getID());
-                    propertiesA.setVelocity(newVelocityA * (float)TREE_SCALE);
-                    propertiesA.setPosition(newPositionA * (float)TREE_SCALE);
-                    propertiesA.setLastEdited(now);
-
-                    // NOTE: EntityTree::updateEntity() will cause the entity to get sorted correctly in the EntitySimulation,
-                    // thereby waking up static non-moving entities.
-                    _entityTree->updateEntity(entityA, propertiesA);
-                    _packetSender->queueEditEntityMessage(PacketTypeEntityAddOrEdit, idA, propertiesA);
-                }            
-
-                // unless the entity is configured to not be moved by collision, calculate it's new position
-                // and velocity and apply it
-                if (wantToMoveB) {
-                    glm::vec3 newVelocityB = entityB->getVelocity() + axialVelocity * massRatioB;
-                    glm::vec3 newPositionB = entityB->getPosition() + 0.5f * penetrationInTreeUnits;
-
-                    EntityItemProperties propertiesB = entityB->getProperties();
-
-                    EntityItemID idB(entityB->getID());
-                    propertiesB.setVelocity(newVelocityB * (float)TREE_SCALE);
-                    propertiesB.setPosition(newPositionB * (float)TREE_SCALE);
-                    propertiesB.setLastEdited(now);
-
-                    // NOTE: EntityTree::updateEntity() will cause the entity to get sorted correctly in the EntitySimulation,
-                    // thereby waking up static non-moving entities.
-                    _entityTree->updateEntity(entityB, propertiesB);
-                    _packetSender->queueEditEntityMessage(PacketTypeEntityAddOrEdit, idB, propertiesB);
-                }
+            // when both entities are moving the pair is only checked from the side of the lower pointer
+            if (entityB < entityA && _movingEntities.contains(entityB)) {
+                continue;
+            }
 
-                // NOTE: Do this after updating the entities so that the callback can delete the entities if they want to
-                Collision collision;
-                collision.penetration = penetration;
-                collision.contactPoint = (0.5f * (float)TREE_SCALE) * (entityA->getPosition() + entityB->getPosition());
-                emitGlobalEntityCollisionWithEntity(entityA, entityB, collision);
+            if (ShapeCollider::collideShapes(shapeA, &entityB->getCollisionShapeInMeters(), collisions)) {
+                CollisionInfo* collision = collisions.getLastCollision();
+                if (collision) {
+                    EntityContact contact = { entityA, entityB, collision->_penetration };
+                    _contacts.append(contact);
+                }
+            }
+            if (collisions.isFull()) {
+                break;
             }
         }
     }
 }
 
+void EntityCollisionSystem::resolveEntityContact(const EntityContact& contact) {
+    EntityItem* entityA = contact.entityA;
+    EntityItem* entityB = contact.entityB;
+    glm::vec3 penetration = contact.penetration;
+
+    // NOTE: 'penetration' is the depth that 'entityA' overlaps 'entityB'.  It points from A into B.
+    glm::vec3 penetrationInTreeUnits = penetration / (float)(TREE_SCALE);
+
+    // Even if the Entities overlap... when the Entities are already moving appart
+    // we don't want to count this as a collision.
+    glm::vec3 relativeVelocity = entityA->getVelocity() - entityB->getVelocity();
+
+    bool fullyEnclosedCollision = glm::length(penetrationInTreeUnits) > entityA->getLargestDimension();
+
+    bool wantToMoveA = entityA->getCollisionsWillMove();
+    bool wantToMoveB = entityB->getCollisionsWillMove();
+    bool movingTowardEachOther = glm::dot(relativeVelocity, penetrationInTreeUnits) > 0.0f;
+
+    // only do collisions if the entities are moving toward each other and one or the other
+    // of the entities are movable from collisions
+    bool doCollisions = !fullyEnclosedCollision && movingTowardEachOther && (wantToMoveA || wantToMoveB);
+    if (!doCollisions) {
+        return;
+    }
+
+    glm::vec3 axis = glm::normalize(penetration);
+    glm::vec3 axialVelocity = glm::dot(relativeVelocity, axis) * axis;
+
+    float massA = entityA->getMass();
+    float massB = entityB->getMass();
+    float totalMass = massA + massB;
+    float massRatioA = (2.0f * massB / totalMass);
+    float massRatioB = (2.0f * massA / totalMass);
+
+    // in the event that one of our entities is non-moving, then fix up these ratios
+    if (wantToMoveA && !wantToMoveB) {
+        massRatioA = 2.0f;
+        massRatioB = 0.0f;
+    }
+
+    if (!wantToMoveA && wantToMoveB) {
+        massRatioA = 0.0f;
+        massRatioB = 2.0f;
+    }
+
+    // unless the entity is configured to not be moved by collision, calculate it's new position
+    // and velocity and apply it
+    if (wantToMoveA) {
+        glm::vec3 newVelocityA = entityA->getVelocity() - axialVelocity * massRatioA;
+        glm::vec3 newPositionA = entityA->getPosition() - 0.5f * penetrationInTreeUnits;
+        moveEntity(entityA, newPositionA, newVelocityA);
+    }
+
+    if (wantToMoveB) {
+        glm::vec3 newVelocityB = entityB->getVelocity() + axialVelocity * massRatioB;
+        glm::vec3 newPositionB = entityB->getPosition() + 0.5f * penetrationInTreeUnits;
+        moveEntity(entityB, newPositionB, newVelocityB);
+    }
+
+    EntityCollisionEvent event;
+    event.idA = entityA->getEntityItemID();
+    event.idB = entityB->getEntityItemID();
+    event.collision.penetration = penetration;
+    event.collision.contactPoint = (0.5f * (float)TREE_SCALE) * (entityA->getPosition() + entityB->getPosition());
+    _collisionEvents.append(event);
+}
+
+void EntityCollisionSystem::moveEntity(EntityItem* entity, const glm::vec3& position, const glm::vec3& velocity) {
+    if (entity->getLocked() || entity->getSimulatedByServer()) {
+        // the tree wouldn't take an edit of a locked entity either, and the entity server moves the ones it simulates
+        return;
+    }
+    entity->setPosition(position);
+    entity->setVelocity(velocity);
+    _collidedEntities.insert(entity);
+}
+
+void EntityCollisionSystem::sendCollidedEntities() {
+    if (_collidedEntities.isEmpty()) {
+        return;
+    }
+    quint64 now = usecTimestampNow();
+    foreach (EntityItem* entity, _collidedEntities) {
+        entity->setLastEdited(now);
+
+        // wake up static non-moving entities that were hit
+        if (entity->isMoving()) {
+            _movingEntities.insert(entity);
+            _movableButStoppedEntities.remove(entity);
+        }
+        _collisionGrid.updateEntity(entity);
+
+        // the other properties didn't change, so the edit carries just these
+        EntityItemProperties properties;
+        properties.setPosition(entity->getPosition() * (float)TREE_SCALE);
+        properties.setVelocity(entity->getVelocity() * (float)TREE_SCALE);
+        properties.setLastEdited(now);
+        _packetSender->queueEditEntityMessage(PacketTypeEntityAddOrEdit, entity->getEntityItemID(), properties);
+    }
+
+    // re-sort all of the collided entities in the tree with a single pass
+    _entitiesToBeSorted.unite(_collidedEntities);
+    _collidedEntities.clear();
+    sortEntitiesThatMoved();
+}
+
 void EntityCollisionSystem::updateCollisionWithAvatars(EntityItem* entity) {
     
     // Entities that are in hand, don't collide with avatars
@@ -290,13 +354,5 @@ void EntityCollisionSystem::applyHardCollision(EntityItem* entity, const Collisi
         }
     }
 
-    EntityItemProperties properties = entity->getProperties();
-    EntityItemID entityItemID(entity->getID());
-
-    properties.setPosition(position * (float)TREE_SCALE);
-    properties.setVelocity(velocity * (float)TREE_SCALE);
-    properties.setLastEdited(usecTimestampNow());
-
-    _entityTree->updateEntity(entity, properties);
-    _packetSender->queueEditEntityMessage(PacketTypeEntityAddOrEdit, entityItemID, properties);
+    moveEntity(entity, position, velocity);
 }
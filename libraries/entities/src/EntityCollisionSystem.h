@@ -23,6 +23,7 @@
 #include <OctreePacketData.h>
 #include <SharedUtil.h>
 
+#include "EntityCollisionGrid.h"
 #include "EntityItem.h"
 #include "SimpleEntitySimulation.h"
 
@@ -42,24 +43,49 @@ public:
 
     void updateCollisions();
 
-    void checkEntity(EntityItem* Entity);
-    void updateCollisionWithEntities(EntityItem* Entity);
     void updateCollisionWithAvatars(EntityItem* Entity);
-    void queueEntityPropertiesUpdate(EntityItem* Entity);
 
 signals:
     void entityCollisionWithEntity(const EntityItemID& idA, const EntityItemID& idB, const Collision& collision);
 
+protected:
+    virtual void addEntityInternal(EntityItem* entity);
+    virtual void removeEntityInternal(EntityItem* entity);
+    virtual void entityChangedInternal(EntityItem* entity);
+    virtual void clearEntitiesInternal();
+
 private:
-    void applyHardCollision(EntityItem* entity, const CollisionInfo& collisionInfo);
+    /// two entities found to overlap, where penetration is the depth that entityA overlaps entityB
+    class EntityContact {
+    public:
+        EntityItem* entityA;
+        EntityItem* entityB;
+        glm::vec3 penetration;
+    };
 
-    static bool updateOperation(OctreeElement* element, void* extraData);
-    void emitGlobalEntityCollisionWithEntity(EntityItem* entityA, EntityItem* entityB, const Collision& penetration);
+    /// a collision to report once the tree is unlocked
+    class EntityCollisionEvent {
+    public:
+        EntityItemID idA;
+        EntityItemID idB;
+        Collision collision;
+    };
+
+    void findEntityContacts();
+    void resolveEntityContact(const EntityContact& contact);
+    void applyHardCollision(EntityItem* entity, const CollisionInfo& collisionInfo);
+    void moveEntity(EntityItem* entity, const glm::vec3& position, const glm::vec3& velocity);
+    void sendCollidedEntities();
 
     EntityEditPacketSender* _packetSender;
     AbstractAudioInterface* _audio;
     AvatarHashMap* _avatars;
     CollisionList _collisions;
+
+    EntityCollisionGrid _collisionGrid;
+    QVector<EntityContact> _contacts;
+    QSet<EntityItem*> _collidedEntities; // entities moved by collisions this pass, sent once the pass is done
+    QVector<EntityCollisionEvent> _collisionEvents;
 };
 
 #endif // hifi_EntityCollisionSystem_h
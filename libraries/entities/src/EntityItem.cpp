@@ -9,6 +9,8 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <algorithm>
+
 #include <QtCore/QObject>
 
 #include <ByteCountCoding.h>
@@ -34,6 +36,7 @@ void EntityItem::initFromEntityItemID(const EntityItemID& entityItemID) {
     _lastEditedFromRemoteInRemoteTime = 0;
     _created = UNKNOWN_CREATED_TIME;
     _changedOnServer = 0;
+    std::fill(_propertiesChangedOnServer, _propertiesChangedOnServer + PROP_LAST_ITEM + 1, 0);
 
     _position = ENTITY_ITEM_ZERO_VEC3;
     _dimensions = ENTITY_ITEM_DEFAULT_DIMENSIONS;
@@ -54,6 +57,7 @@ void EntityItem::initFromEntityItemID(const EntityItemID& entityItemID) {
     _collisionsWillMove = ENTITY_ITEM_DEFAULT_COLLISIONS_WILL_MOVE;
     _locked = ENTITY_ITEM_DEFAULT_LOCKED;
     _userData = ENTITY_ITEM_DEFAULT_USER_DATA;
+    _simulatedByServer = ENTITY_ITEM_DEFAULT_SIMULATED_BY_SERVER;
     
     recalculateCollisionShape();
 }
@@ -117,10 +121,43 @@ EntityPropertyFlags EntityItem::getEntityProperties(EncodeBitstreamParams& param
     requestedProperties += PROP_COLLISIONS_WILL_MOVE;
     requestedProperties += PROP_LOCKED;
     requestedProperties += PROP_USER_DATA;
+    requestedProperties += PROP_SIMULATED_BY_SERVER;
     
     return requestedProperties;
 }
 
+EntityPropertyFlags EntityItem::getPropertiesToSend(EncodeBitstreamParams& params) const {
+    EntityPropertyFlags propertiesToSend = getEntityProperties(params);
+
+    // full scenes send everything, so that they make up for any earlier packets the client lost
+    if (params.forceSendScene || !params.sentItems || !params.sentItems->contains(getID())) {
+        return propertiesToSend;
+    }
+    for (int i = propertiesToSend.firstFlag(); i <= propertiesToSend.lastFlag() && i <= PROP_LAST_ITEM; i++) {
+        if (_propertiesChangedOnServer[i] < params.lastViewFrustumSent) {
+            propertiesToSend -= (EntityPropertyList)i;
+        }
+    }
+    return propertiesToSend;
+}
+
+void EntityItem::markAsChangedOnServer() {
+    _changedOnServer = usecTimestampNow();
+    std::fill(_propertiesChangedOnServer, _propertiesChangedOnServer + PROP_LAST_ITEM + 1, _changedOnServer);
+}
+
+void EntityItem::markAsChangedOnServer(const EntityPropertyFlags& changedProperties) {
+    if (!changedProperties) {
+        return; // nothing the clients are sent changed
+    }
+    _changedOnServer = glm::max(usecTimestampNow(), _changedOnServer);
+    for (int i = changedProperties.firstFlag(); i <= changedProperties.lastFlag() && i <= PROP_LAST_ITEM; i++) {
+        if (changedProperties.getHasProperty((EntityPropertyList)i)) {
+            _propertiesChangedOnServer[i] = _changedOnServer;
+        }
+    }
+}
+
 OctreeElement::AppendState EntityItem::appendEntityData(OctreePacketData* packetData, EncodeBitstreamParams& params, 
                                             EntityTreeElementExtraEncodeData* entityTreeElementExtraEncodeData) const {
     // ALL this fits...
@@ -144,7 +181,7 @@ OctreeElement::AppendState EntityItem::appendEntityData(OctreePacketData* packet
     ByteCountCoded<quint64> updateDeltaCoder = updateDelta;
     QByteArray encodedUpdateDelta = updateDeltaCoder;
     EntityPropertyFlags propertyFlags(PROP_LAST_ITEM);
-    EntityPropertyFlags requestedProperties = getEntityProperties(params);
+    EntityPropertyFlags requestedProperties = getPropertiesToSend(params);
     EntityPropertyFlags propertiesDidntFit = requestedProperties;
 
     // If we are being called for a subsequent pass at appendEntityData() that failed to completely encode this item,
@@ -233,6 +270,7 @@ OctreeElement::AppendState EntityItem::appendEntityData(OctreePacketData* packet
         APPEND_ENTITY_PROPERTY(PROP_COLLISIONS_WILL_MOVE, appendValue, getCollisionsWillMove());
         APPEND_ENTITY_PROPERTY(PROP_LOCKED, appendValue, getLocked());
         APPEND_ENTITY_PROPERTY(PROP_USER_DATA, appendValue, getUserData());
+        APPEND_ENTITY_PROPERTY(PROP_SIMULATED_BY_SERVER, appendValue, getSimulatedByServer());
 
         appendSubclassData(packetData, params, entityTreeElementExtraEncodeData,
                                 requestedProperties,
@@ -509,6 +547,7 @@ int EntityItem::readEntityDataFromBuffer(const unsigned char* data, int bytesLef
         READ_ENTITY_PROPERTY_SETTER(PROP_COLLISIONS_WILL_MOVE, bool, updateCollisionsWillMove);
         READ_ENTITY_PROPERTY(PROP_LOCKED, bool, _locked);
         READ_ENTITY_PROPERTY_STRING(PROP_USER_DATA,setUserData);
+        READ_ENTITY_PROPERTY_SETTER(PROP_SIMULATED_BY_SERVER, bool, updateSimulatedByServer);
 
         if (wantDebug) {
             qDebug() << "    readEntityDataFromBuffer() _registrationPoint:" << _registrationPoint;
@@ -787,6 +826,7 @@ EntityItemProperties EntityItem::getProperties() const {
     COPY_ENTITY_PROPERTY_TO_PROPERTIES(collisionsWillMove, getCollisionsWillMove);
     COPY_ENTITY_PROPERTY_TO_PROPERTIES(locked, getLocked);
     COPY_ENTITY_PROPERTY_TO_PROPERTIES(userData, getUserData);
+    COPY_ENTITY_PROPERTY_TO_PROPERTIES(simulatedByServer, getSimulatedByServer);
 
     properties._defaultSettings = false;
     
@@ -1127,6 +1167,13 @@ void EntityItem::updateCollisionsWillMove(bool value) {
     }
 }
 
+void EntityItem::updateSimulatedByServer(bool value) {
+    if (_simulatedByServer != value) {
+        _simulatedByServer = value;
+        _dirtyFlags |= EntityItem::DIRTY_MOTION_TYPE;
+    }
+}
+
 void EntityItem::updateLifetime(float value) {
     if (_lifetime != value) {
         _lifetime = value;
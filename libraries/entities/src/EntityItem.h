@@ -90,11 +90,18 @@ public:
     float getEditedAgo() const /// Elapsed seconds since this entity was last edited
         { return (float)(usecTimestampNow() - getLastEdited()) / (float)USECS_PER_SECOND; }
 
-    void markAsChangedOnServer() {  _changedOnServer = usecTimestampNow();  }
+    /// records that every property changed, as they do when the entity is created
+    void markAsChangedOnServer();
+
+    /// records which properties changed, so that clients that have the entity are sent only those
+    void markAsChangedOnServer(const EntityPropertyFlags& changedProperties);
     quint64 getLastChangedOnServer() const { return _changedOnServer; }
 
-    // TODO: eventually only include properties changed since the params.lastViewFrustumSent time
     virtual EntityPropertyFlags getEntityProperties(EncodeBitstreamParams& params) const;
+
+    /// The properties of getEntityProperties() that the client needs: those that changed since the client's last scene
+    /// if it has the entity already, otherwise all of them.
+    EntityPropertyFlags getPropertiesToSend(EncodeBitstreamParams& params) const;
         
     virtual OctreeElement::AppendState appendEntityData(OctreePacketData* packetData, EncodeBitstreamParams& params,
                                                 EntityTreeElementExtraEncodeData* entityTreeElementExtraEncodeData) const;
@@ -245,6 +252,10 @@ public:
     
     const QString& getUserData() const { return _userData; }
     void setUserData(const QString& value) { _userData = value; }
+
+    /// true when the entity server runs the physics of this entity, so that clients don't simulate or edit it
+    bool getSimulatedByServer() const { return _simulatedByServer; }
+    void setSimulatedByServer(bool value) { _simulatedByServer = value; }
     
     // TODO: We need to get rid of these users of getRadius()... 
     float getRadius() const;
@@ -270,6 +281,7 @@ public:
     void updateAngularDamping(float value);
     void updateIgnoreForCollisions(bool value);
     void updateCollisionsWillMove(bool value);
+    void updateSimulatedByServer(bool value);
     void updateLifetime(float value);
 
     uint32_t getDirtyFlags() const { return _dirtyFlags; }
@@ -297,6 +309,7 @@ protected:
     quint64 _lastEditedFromRemoteInRemoteTime; // last time we received and edit from the server (in server-time-frame)
     quint64 _created;
     quint64 _changedOnServer;
+    quint64 _propertiesChangedOnServer[PROP_LAST_ITEM + 1]; // when each property last changed, by EntityPropertyList
 
     glm::vec3 _position;
     glm::vec3 _dimensions;
@@ -317,6 +330,7 @@ protected:
     bool _collisionsWillMove;
     bool _locked;
     QString _userData;
+    bool _simulatedByServer;
 
     // NOTE: Damping is applied like this:  v *= pow(1 - damping, dt)
     //
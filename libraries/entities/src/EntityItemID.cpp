@@ -18,7 +18,8 @@
 
 // for locally created models
 QHash<uint32_t, QUuid> EntityItemID::_tokenIDsToIDs;
-uint32_t EntityItemID::_nextCreatorTokenID = 0;
+QReadWriteLock EntityItemID::_tokenIDsToIDsLock;
+QAtomicInt EntityItemID::_nextCreatorTokenID(0);
 
 EntityItemID::EntityItemID() :
     id(NEW_ENTITY), 
@@ -50,16 +51,16 @@ EntityItemID::EntityItemID(const QUuid& id) :
 };
 
 EntityItemID EntityItemID::getIDfromCreatorTokenID(uint32_t creatorTokenID) {
-    if (_tokenIDsToIDs.find(creatorTokenID) != _tokenIDsToIDs.end()) {
-        return EntityItemID(_tokenIDsToIDs[creatorTokenID], creatorTokenID, true);
+    QReadLocker locker(&_tokenIDsToIDsLock);
+    QHash<uint32_t, QUuid>::const_iterator found = _tokenIDsToIDs.constFind(creatorTokenID);
+    if (found != _tokenIDsToIDs.constEnd()) {
+        return EntityItemID(found.value(), creatorTokenID, true);
     }
     return EntityItemID(UNKNOWN_ENTITY_ID);
 }
 
 uint32_t EntityItemID::getNextCreatorTokenID() {
-    uint32_t creatorTokenID = _nextCreatorTokenID;
-    _nextCreatorTokenID++;
-    return creatorTokenID;
+    return (uint32_t)_nextCreatorTokenID.fetchAndAddOrdered(1);
 }
 
 EntityItemID EntityItemID::assignActualIDForToken() const {
@@ -121,6 +122,7 @@ void EntityItemID::handleAddEntityResponse(const QByteArray& packet) {
     dataAt += NUM_BYTES_RFC4122_UUID;
 
     // add our token to id mapping
+    QWriteLocker locker(&_tokenIDsToIDsLock);
     _tokenIDsToIDs[creatorTokenID] = entityID;
 }
 
@@ -15,8 +15,10 @@
 #include <stdint.h>
 
 
+#include <QAtomicInt>
 #include <QObject>
 #include <QHash>
+#include <QReadWriteLock>
 #include <QScriptEngine>
 #include <QUuid>
 
@@ -64,8 +66,10 @@ private:
     friend class EntityTree;
     EntityItemID assignActualIDForToken() const; // only called by EntityTree
 
-    static uint32_t _nextCreatorTokenID; /// used by the static interfaces for creator token ids
+    // script engines on many threads create entities, so the token counter is atomic and the mapping is locked
+    static QAtomicInt _nextCreatorTokenID; /// used by the static interfaces for creator token ids
     static QHash<uint32_t, QUuid> _tokenIDsToIDs;
+    static QReadWriteLock _tokenIDsToIDsLock;
 };
 
 inline bool operator<(const EntityItemID& a, const EntityItemID& b) {
@@ -60,6 +60,7 @@ EntityItemProperties::EntityItemProperties() :
     CONSTRUCT_PROPERTY(textures, ""),
     CONSTRUCT_PROPERTY(animationSettings, ""),
     CONSTRUCT_PROPERTY(userData, ENTITY_ITEM_DEFAULT_USER_DATA),
+    CONSTRUCT_PROPERTY(simulatedByServer, ENTITY_ITEM_DEFAULT_SIMULATED_BY_SERVER),
     CONSTRUCT_PROPERTY(text, TextEntityItem::DEFAULT_TEXT),
     CONSTRUCT_PROPERTY(lineHeight, TextEntityItem::DEFAULT_LINE_HEIGHT),
     CONSTRUCT_PROPERTY(textColor, TextEntityItem::DEFAULT_TEXT_COLOR),
@@ -206,6 +207,7 @@ EntityPropertyFlags EntityItemProperties::getChangedProperties() const {
     CHECK_PROPERTY_CHANGE(PROP_LOCKED, locked);
     CHECK_PROPERTY_CHANGE(PROP_TEXTURES, textures);
     CHECK_PROPERTY_CHANGE(PROP_USER_DATA, userData);
+    CHECK_PROPERTY_CHANGE(PROP_SIMULATED_BY_SERVER, simulatedByServer);
     CHECK_PROPERTY_CHANGE(PROP_TEXT, text);
     CHECK_PROPERTY_CHANGE(PROP_LINE_HEIGHT, lineHeight);
     CHECK_PROPERTY_CHANGE(PROP_TEXT_COLOR, textColor);
@@ -214,6 +216,51 @@ EntityPropertyFlags EntityItemProperties::getChangedProperties() const {
     return changedProperties;
 }
 
+void EntityItemProperties::merge(const EntityItemProperties& other) {
+    MERGE_PROPERTY(dimensions);
+    MERGE_PROPERTY(position);
+    MERGE_PROPERTY(rotation);
+    MERGE_PROPERTY(mass);
+    MERGE_PROPERTY(velocity);
+    MERGE_PROPERTY(gravity);
+    MERGE_PROPERTY(damping);
+    MERGE_PROPERTY(lifetime);
+    MERGE_PROPERTY(script);
+    MERGE_PROPERTY(color);
+    MERGE_PROPERTY(modelURL);
+    MERGE_PROPERTY(animationURL);
+    MERGE_PROPERTY(animationIsPlaying);
+    MERGE_PROPERTY(animationFrameIndex);
+    MERGE_PROPERTY(animationFPS);
+    MERGE_PROPERTY(animationSettings);
+    MERGE_PROPERTY(visible);
+    MERGE_PROPERTY(registrationPoint);
+    MERGE_PROPERTY(angularVelocity);
+    MERGE_PROPERTY(angularDamping);
+    MERGE_PROPERTY(ignoreForCollisions);
+    MERGE_PROPERTY(collisionsWillMove);
+    MERGE_PROPERTY(isSpotlight);
+    MERGE_PROPERTY(diffuseColor);
+    MERGE_PROPERTY(ambientColor);
+    MERGE_PROPERTY(specularColor);
+    MERGE_PROPERTY(constantAttenuation);
+    MERGE_PROPERTY(linearAttenuation);
+    MERGE_PROPERTY(quadraticAttenuation);
+    MERGE_PROPERTY(exponent);
+    MERGE_PROPERTY(cutoff);
+    MERGE_PROPERTY(locked);
+    MERGE_PROPERTY(textures);
+    MERGE_PROPERTY(userData);
+    MERGE_PROPERTY(text);
+    MERGE_PROPERTY(lineHeight);
+    MERGE_PROPERTY(textColor);
+    MERGE_PROPERTY(backgroundColor);
+    MERGE_PROPERTY(glowLevel);
+    MERGE_PROPERTY(localRenderAlpha);
+
+    setLastEdited(qMax(_lastEdited, other._lastEdited));
+}
+
 QScriptValue EntityItemProperties::copyToScriptValue(QScriptEngine* engine) const {
     QScriptValue properties = engine->newObject();
 
@@ -262,6 +309,7 @@ QScriptValue EntityItemProperties::copyToScriptValue(QScriptEngine* engine) cons
     COPY_PROPERTY_TO_QSCRIPTVALUE(exponent);
     COPY_PROPERTY_TO_QSCRIPTVALUE(cutoff);
     COPY_PROPERTY_TO_QSCRIPTVALUE(locked);
+    COPY_PROPERTY_TO_QSCRIPTVALUE(simulatedByServer); // gettable, but not settable
     COPY_PROPERTY_TO_QSCRIPTVALUE(textures);
     COPY_PROPERTY_TO_QSCRIPTVALUE(userData);
     COPY_PROPERTY_TO_QSCRIPTVALUE(text);
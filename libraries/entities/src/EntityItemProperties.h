@@ -83,7 +83,10 @@ enum EntityPropertyList {
     PROP_ANIMATION_SETTINGS,
     PROP_USER_DATA,
 
-    PROP_LAST_ITEM = PROP_USER_DATA,
+    // available to all entities, set by the entity server only
+    PROP_SIMULATED_BY_SERVER,
+
+    PROP_LAST_ITEM = PROP_SIMULATED_BY_SERVER,
 
     // These properties of TextEntity piggy back off of properties of ModelEntities, the type doesn't matter
     // since the derived class knows how to interpret it's own properties and knows the types it expects
@@ -175,6 +178,7 @@ public:
     DEFINE_PROPERTY_REF(PROP_TEXTURES, Textures, textures, QString);
     DEFINE_PROPERTY_REF_WITH_SETTER_AND_GETTER(PROP_ANIMATION_SETTINGS, AnimationSettings, animationSettings, QString);
     DEFINE_PROPERTY_REF(PROP_USER_DATA, UserData, userData, QString);
+    DEFINE_PROPERTY(PROP_SIMULATED_BY_SERVER, SimulatedByServer, simulatedByServer, bool);
     DEFINE_PROPERTY_REF(PROP_TEXT, Text, text, QString);
     DEFINE_PROPERTY(PROP_LINE_HEIGHT, LineHeight, lineHeight, float);
     DEFINE_PROPERTY_REF(PROP_TEXT_COLOR, TextColor, textColor, xColor);
@@ -213,6 +217,9 @@ public:
     void clearID() { _id = UNKNOWN_ENTITY_ID; _idSet = false; }
     void markAllChanged();
 
+    /// Takes on the properties changed in other, as though other were a later edit applied on top of this one.
+    void merge(const EntityItemProperties& other);
+
     void setSittingPoints(const QVector<SittingPoint>& sittingPoints);
 
     const glm::vec3& getNaturalDimensions() const { return _naturalDimensions; }
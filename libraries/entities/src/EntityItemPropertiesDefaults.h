@@ -23,6 +23,7 @@ const glm::vec3 ENTITY_ITEM_ZERO_VEC3(0.0f);
 const glm::vec3 REGULAR_GRAVITY = glm::vec3(0, -9.8f / (float)TREE_SCALE, 0);
 
 const bool ENTITY_ITEM_DEFAULT_LOCKED = false;
+const bool ENTITY_ITEM_DEFAULT_SIMULATED_BY_SERVER = false;
 const QString ENTITY_ITEM_DEFAULT_USER_DATA = QString("");
 
 const float ENTITY_ITEM_DEFAULT_LOCAL_RENDER_ALPHA = 1.0f;
@@ -157,6 +157,12 @@
         changedProperties += P;    \
     }
 
+#define MERGE_PROPERTY(M)                \
+    if (other._##M##Changed) {           \
+        _##M = other._##M;               \
+        _##M##Changed = true;            \
+    }
+
 
 #define COPY_PROPERTY_TO_QSCRIPTVALUE_VEC3(P) \
     QScriptValue P = vec3toScriptValue(engine, _##P); \
@@ -9,15 +9,20 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <algorithm>
+#include <functional>
+
 #include <AACube.h>
 
 #include "EntitySimulation.h"
 #include "MovingEntitiesOperator.h"
 
+// the expiry queue is rebuilt once removed and rescheduled entities have left it this much larger than needed
+const int EXPIRY_QUEUE_STALE_ENTRY_SLACK = 1024;
+
 void EntitySimulation::setEntityTree(EntityTree* tree) {
     if (_entityTree && _entityTree != tree) {
-        _mortalEntities.clear();
-        _nextExpiry = quint64(-1);
+        clearMortalEntities();
         _updateableEntities.clear();
         _entitiesToBeSorted.clear();
     }
@@ -40,27 +45,29 @@ void EntitySimulation::updateEntities(QSet<EntityItem*>& entitiesToDelete) {
 
 // private
 void EntitySimulation::expireMortalEntities(const quint64& now) {
-    if (now > _nextExpiry) {
-        // only search for expired entities if we expect to find one
-        _nextExpiry = quint64(-1);
-        QSet<EntityItem*>::iterator itemItr = _mortalEntities.begin();
-        while (itemItr != _mortalEntities.end()) {
-            EntityItem* entity = *itemItr;
-            quint64 expiry = entity->getExpiry();
-            if (expiry < now) {
-                _entitiesToDelete.insert(entity);
-                itemItr = _mortalEntities.erase(itemItr);
-                _updateableEntities.remove(entity);
-                _entitiesToBeSorted.remove(entity);
-                removeEntityInternal(entity);
-            } else {
-                if (expiry < _nextExpiry) {
-                    // remeber the smallest _nextExpiry so we know when to start the next search
-                    _nextExpiry = expiry;
-                }
-                ++itemItr;
-            }
+    // only look at the entities whose time is up, soonest first
+    while (!_expiryQueue.isEmpty() && _expiryQueue.first().first < now) {
+        EntityExpiry nextExpiry = _expiryQueue.first();
+        std::pop_heap(_expiryQueue.begin(), _expiryQueue.end(), std::greater<EntityExpiry>());
+        _expiryQueue.removeLast();
+
+        EntityItem* entity = nextExpiry.second;
+        if (!_mortalEntities.contains(entity)) {
+            // this entity was removed or made immortal after its expiry was queued
+            continue;
         }
+
+        if (entity->getExpiry() >= now) {
+            // the entity's lifetime changed after this expiry was queued, make sure it is queued for the new one
+            queueExpiry(entity);
+            continue;
+        }
+
+        _entitiesToDelete.insert(entity);
+        _mortalEntities.remove(entity);
+        _updateableEntities.remove(entity);
+        _entitiesToBeSorted.remove(entity);
+        removeEntityInternal(entity);
     }
 }
 
@@ -70,17 +77,53 @@ void EntitySimulation::callUpdateOnEntitiesThatNeedIt(const quint64& now) {
     QSet<EntityItem*>::iterator itemItr = _updateableEntities.begin();
     while (itemItr != _updateableEntities.end()) {
         EntityItem* entity = *itemItr;
-        // TODO: catch transition from needing update to not as a "change" 
-        // so we don't have to scan for it here.
-        if (!entity->needsToCallUpdate()) {
-            itemItr = _updateableEntities.erase(itemItr);
-        } else {
-            entity->update(now);
-            ++itemItr;
+        entity->update(now);
+
+        // an entity flags DIRTY_UPDATEABLE when it may have stopped needing update(), so we only ask the ones that did
+        if (entity->getDirtyFlags() & EntityItem::DIRTY_UPDATEABLE) {
+            entity->clearDirtyFlags(EntityItem::DIRTY_UPDATEABLE);
+            if (!entity->needsToCallUpdate()) {
+                itemItr = _updateableEntities.erase(itemItr);
+                continue;
+            }
         }
+        ++itemItr;
     }
 }
 
+// private
+void EntitySimulation::addMortalEntity(EntityItem* entity) {
+    _mortalEntities.insert(entity);
+    queueExpiry(entity);
+}
+
+// private
+void EntitySimulation::queueExpiry(EntityItem* entity) {
+    // entries for entities that are no longer mortal, or whose expiry changed, are left in the queue and skipped
+    // when they come up - once there are too many of them we rebuild the queue from the entities that are still mortal
+    if (_expiryQueue.size() > 2 * _mortalEntities.size() + EXPIRY_QUEUE_STALE_ENTRY_SLACK) {
+        _expiryQueue.clear();
+        foreach (EntityItem* mortalEntity, _mortalEntities) {
+            _expiryQueue.append(EntityExpiry(mortalEntity->getExpiry(), mortalEntity));
+        }
+        std::make_heap(_expiryQueue.begin(), _expiryQueue.end(), std::greater<EntityExpiry>());
+
+        if (_mortalEntities.contains(entity)) {
+            // the rebuilt queue already has this entity at its current expiry
+            return;
+        }
+    }
+
+    _expiryQueue.append(EntityExpiry(entity->getExpiry(), entity));
+    std::push_heap(_expiryQueue.begin(), _expiryQueue.end(), std::greater<EntityExpiry>());
+}
+
+// private
+void EntitySimulation::clearMortalEntities() {
+    _mortalEntities.clear();
+    _expiryQueue.clear();
+}
+
 // private
 void EntitySimulation::sortEntitiesThatMoved() {
     // NOTE: this is only for entities that have been moved by THIS EntitySimulation.
@@ -116,17 +159,18 @@ void EntitySimulation::sortEntitiesThatMoved() {
 void EntitySimulation::addEntity(EntityItem* entity) {
     assert(entity);
     if (entity->isMortal()) {
-        _mortalEntities.insert(entity);
-        quint64 expiry = entity->getExpiry();
-        if (expiry < _nextExpiry) {
-            _nextExpiry = expiry;
-        }
+        addMortalEntity(entity);
     }
     if (entity->needsToCallUpdate()) {
         _updateableEntities.insert(entity);
     }
     addEntityInternal(entity);
 
+    if (_entityTree && _entityTree->getIsServer()) {
+        // tell the clients whether to run the physics of this entity themselves
+        entity->setSimulatedByServer(isAuthoritative());
+    }
+
     // DirtyFlags are used to signal changes to entities that have already been added, 
     // so we can clear them for this entity which has just been added.
     entity->clearDirtyFlags();
@@ -164,11 +208,7 @@ void EntitySimulation::entityChanged(EntityItem* entity) {
     if (!wasRemoved) {
         if (dirtyFlags & EntityItem::DIRTY_LIFETIME) {
             if (entity->isMortal()) {
-                _mortalEntities.insert(entity);
-                quint64 expiry = entity->getExpiry();
-                if (expiry < _nextExpiry) {
-                    _nextExpiry = expiry;
-                }
+                addMortalEntity(entity);
             } else {
                 _mortalEntities.remove(entity);
             }
@@ -184,8 +224,7 @@ void EntitySimulation::entityChanged(EntityItem* entity) {
 }
 
 void EntitySimulation::clearEntities() {
-    _mortalEntities.clear();
-    _nextExpiry = quint64(-1);
+    clearMortalEntities();
     _updateableEntities.clear();
     _entitiesToBeSorted.clear();
     clearEntitiesInternal();
@@ -12,7 +12,9 @@
 #ifndef hifi_EntitySimulation_h
 #define hifi_EntitySimulation_h
 
+#include <QPair>
 #include <QSet>
+#include <QVector>
 
 #include <PerfStat.h>
 
@@ -31,6 +33,9 @@ const int DIRTY_SIMULATION_FLAGS =
         EntityItem::DIRTY_LIFETIME |
         EntityItem::DIRTY_UPDATEABLE;
 
+// when a mortal entity expires, and which entity it is
+typedef QPair<quint64, EntityItem*> EntityExpiry;
+
 class EntitySimulation {
 public:
     EntitySimulation() : _mutex(QMutex::Recursive), _entityTree(NULL) { }
@@ -61,6 +66,9 @@ public:
 
     EntityTree* getEntityTree() { return _entityTree; }
 
+    /// \return true when this simulation runs the physics of its entities for every client, which then leave them alone
+    virtual bool isAuthoritative() const { return false; }
+
 protected:
 
     // These pure virtual methods are protected because they are not to be called will-nilly. The base class
@@ -83,6 +91,10 @@ protected:
     void callUpdateOnEntitiesThatNeedIt(const quint64& now);
     void sortEntitiesThatMoved();
 
+    void addMortalEntity(EntityItem* entity);
+    void queueExpiry(EntityItem* entity);
+    void clearMortalEntities();
+
     QMutex _mutex;
 
     // back pointer to EntityTree structure
@@ -91,8 +103,8 @@ protected:
     // We maintain multiple lists, each for its distinct purpose.
     // An entity may be in more than one list.
     QSet<EntityItem*> _mortalEntities; // entities that have an expiry
-    quint64 _nextExpiry;
-    QSet<EntityItem*> _updateableEntities; // entities that need update() called
+    QVector<EntityExpiry> _expiryQueue; // min-heap of when _mortalEntities expire, may hold stale entries
+    QSet<EntityItem*> _updateableEntities; // entities that need update() called, until they flag DIRTY_UPDATEABLE
     QSet<EntityItem*> _entitiesToBeSorted; // entities that were moved by THIS simulation and might need to be resorted in the tree
     QSet<EntityItem*> _entitiesToDelete;
 };
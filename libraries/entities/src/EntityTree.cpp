@@ -21,7 +21,8 @@
 EntityTree::EntityTree(bool shouldReaverage) : 
     Octree(shouldReaverage), 
     _fbxService(NULL),
-    _simulation(NULL)
+    _simulation(NULL),
+    _isBatchingEdits(false)
 {
     _rootElement = createNewElement();
 }
@@ -47,6 +48,7 @@ void EntityTree::eraseAllOctreeElements(bool createNewRoot) {
         element->cleanupEntities();
     }
     _entityToElementMap.clear();
+    _batchedEdits.clear();
     Octree::eraseAllOctreeElements(createNewRoot);
 }
 
@@ -528,8 +530,12 @@ int EntityTree::processEditPacketData(PacketType packetType, const unsigned char
     // we handle these types of "edit" packets
     switch (packetType) {
         case PacketTypeEntityErase: {
+            // the erased entities may have edits waiting
+            applyBatchedEdits();
+
             QByteArray dataByteArray((const char*)editData, maxLength);
             processedBytes = processEraseMessageDetails(dataByteArray, senderNode);
+            journalEdit(packetType, editData, processedBytes);
             break;
         }
         
@@ -548,12 +554,34 @@ int EntityTree::processEditPacketData(PacketType packetType, const unsigned char
                     // search for the entity by EntityItemID
                     EntityItem* existingEntity = findEntityByEntityItemID(entityItemID);
                     
-                    // if the EntityItem exists, then update it
+                    // if the EntityItem exists, then update it - at the end of the batch if we're in one, unless the
+                    // edit (un)locks the entity, which changes whether the edits around it are allowed
                     if (existingEntity) {
+                        if (_isBatchingEdits && !properties.lockedChanged()) {
+                            QHash<EntityItemID, EntityItemProperties>::iterator batchedEdit =
+                                _batchedEdits.find(entityItemID);
+                            if (batchedEdit == _batchedEdits.end()) {
+                                _batchedEdits.insert(entityItemID, properties);
+                            } else {
+                                batchedEdit->merge(properties);
+                            }
+                        } else {
+                            applyBatchedEdits();
+                            updateEntity(entityItemID, properties);
+                            existingEntity->markAsChangedOnServer(properties.getChangedProperties());
+                        }
+                        journalEdit(packetType, editData, processedBytes);
+                    } else if (!isReplayingJournal()) {
+                        qDebug() << "User attempted to edit an unknown entity. ID:" << entityItemID;
+                    }
+                } else if (isReplayingJournal()) {
+                    // this entity was created before we restarted, give it back the ID we assigned it then - unless
+                    // our last snapshot already has it, in which case the edit is just replayed on top of it
+                    entityItemID = EntityItemID(getReplayAssignedID());
+                    if (findEntityByEntityItemID(entityItemID)) {
                         updateEntity(entityItemID, properties);
-                        existingEntity->markAsChangedOnServer();
                     } else {
-                        qDebug() << "User attempted to edit an unknown entity. ID:" << entityItemID;
+                        addEntity(entityItemID, properties);
                     }
                 } else {
                     // this is a new entity... assign a new entityID
@@ -561,6 +589,7 @@ int EntityTree::processEditPacketData(PacketType packetType, const unsigned char
                     EntityItem* newEntity = addEntity(entityItemID, properties);
                     if (newEntity) {
                         newEntity->markAsChangedOnServer();
+                        journalEdit(packetType, editData, processedBytes, entityItemID.id);
                         notifyNewlyCreatedEntity(*newEntity, senderNode);
                     }
                 }
@@ -576,6 +605,27 @@ int EntityTree::processEditPacketData(PacketType packetType, const unsigned char
 }
 
 
+void EntityTree::beginEditBatch() {
+    _isBatchingEdits = true;
+}
+
+void EntityTree::endEditBatch() {
+    applyBatchedEdits();
+    _isBatchingEdits = false;
+}
+
+void EntityTree::applyBatchedEdits() {
+    for (QHash<EntityItemID, EntityItemProperties>::const_iterator edit = _batchedEdits.constBegin();
+            edit != _batchedEdits.constEnd(); edit++) {
+        EntityItem* entity = findEntityByEntityItemID(edit.key());
+        if (entity) {
+            updateEntity(entity, edit.value());
+            entity->markAsChangedOnServer(edit.value().getChangedProperties());
+        }
+    }
+    _batchedEdits.clear();
+}
+
 void EntityTree::notifyNewlyCreatedEntity(const EntityItem& newEntity, const SharedNodePointer& senderNode) {
     _newlyCreatedHooksLock.lockForRead();
     for (int i = 0; i < _newlyCreatedHooks.size(); i++) {
@@ -603,10 +653,7 @@ void EntityTree::removeNewlyCreatedHook(NewlyCreatedEntityHook* hook) {
 
 
 void EntityTree::releaseSceneEncodeData(OctreeElementExtraEncodeData* extraEncodeData) const {
-    foreach(void* extraData, *extraEncodeData) {
-        EntityTreeElementExtraEncodeData* thisExtraEncodeData = static_cast<EntityTreeElementExtraEncodeData*>(extraData);
-        delete thisExtraEncodeData;
-    }
+    // the element data is all in the arena, which is kept for the client's next scene
     extraEncodeData->clear();
 }
 
@@ -736,6 +783,16 @@ bool EntityTree::encodeEntitiesDeletedSince(OCTREE_PACKET_SEQUENCE sequenceNumbe
     return hasMoreToSend;
 }
 
+void EntityTree::removeEntitiesDeletedSince(quint64 sinceTime, OctreeSentItems& sentItems) {
+    if (sentItems.isEmpty()) {
+        return;
+    }
+    QReadLocker locker(&_recentlyDeletedEntitiesLock);
+    QMultiMap<quint64, QUuid>::const_iterator iterator = _recentlyDeletedEntityItemIDs.upperBound(sinceTime);
+    for (; iterator != _recentlyDeletedEntityItemIDs.constEnd(); ++iterator) {
+        sentItems.remove(iterator.value());
+    }
+}
 
 // called by the server when it knows all nodes have been sent deleted packets
 void EntityTree::forgetEntitiesDeletedBefore(quint64 sinceTime) {
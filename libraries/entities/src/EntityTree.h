@@ -65,6 +65,10 @@ public:
     virtual int processEditPacketData(PacketType packetType, const unsigned char* packetData, int packetLength,
                     const unsigned char* editData, int maxLength, const SharedNodePointer& senderNode);
 
+    // edits to an entity that arrive in the same batch are merged, and applied to the entity once
+    virtual void beginEditBatch();
+    virtual void endEditBatch();
+
     virtual bool rootElementHasData() const { return true; }
     
     // the root at least needs to store the number of entities in the packet/buffer
@@ -123,6 +127,10 @@ public:
                                     unsigned char* packetData, size_t maxLength, size_t& outputLength);
     void forgetEntitiesDeletedBefore(quint64 sinceTime);
 
+    /// removes the entities deleted since the time from the ones a client was sent, so that the set doesn't grow
+    /// with every entity the client ever saw
+    void removeEntitiesDeletedSince(quint64 sinceTime, OctreeSentItems& sentItems);
+
     int processEraseMessage(const QByteArray& dataByteArray, const SharedNodePointer& sourceNode);
     int processEraseMessageDetails(const QByteArray& dataByteArray, const SharedNodePointer& sourceNode);
     void handleAddEntityResponse(const QByteArray& packet);
@@ -168,6 +176,7 @@ private:
     static bool sendEntitiesOperation(OctreeElement* element, void* extraData);
 
     void notifyNewlyCreatedEntity(const EntityItem& newEntity, const SharedNodePointer& senderNode);
+    void applyBatchedEdits();
 
     QReadWriteLock _newlyCreatedHooksLock;
     QVector<NewlyCreatedEntityHook*> _newlyCreatedHooks;
@@ -179,6 +188,9 @@ private:
     QHash<EntityItemID, EntityTreeElement*> _entityToElementMap;
 
     EntitySimulation* _simulation;
+
+    bool _isBatchingEdits;
+    QHash<EntityItemID, EntityItemProperties> _batchedEdits;
 };
 
 #endif // hifi_EntityTree_h
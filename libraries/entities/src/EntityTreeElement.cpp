@@ -11,6 +11,8 @@
 
 #include <glm/gtx/transform.hpp>
 
+#include <QtCore/QThreadStorage>
+
 #include <AACubeShape.h>
 #include <ShapeCollider.h>
 
@@ -20,6 +22,80 @@
 #include "EntityTree.h"
 #include "EntityTreeElement.h"
 
+// the pending properties of an entity are kept as a mask, which every property has to fit in
+Q_STATIC_ASSERT(PROP_LAST_ITEM < 64);
+
+const int INITIAL_PENDING_ENTITIES = 4;
+
+// the arenas of the encode passes that have no scene to keep track of, one per thread so that each pass reuses the
+// chunks of the last rather than allocating its own
+static QThreadStorage<OctreeElementExtraEncodeData*> passEncodeDatas;
+
+static OctreeElementExtraEncodeData& getPassEncodeData() {
+    if (!passEncodeDatas.hasLocalData()) {
+        passEncodeDatas.setLocalData(new OctreeElementExtraEncodeData());
+    }
+    OctreeElementExtraEncodeData& passEncodeData = *passEncodeDatas.localData();
+    passEncodeData.clear();
+    return passEncodeData;
+}
+
+EntityPropertyFlags EntityTreeElementPendingEntities::value(const EntityItemID& entityItemID) const {
+    EntityPropertyFlags properties;
+    int index = indexOf(entityItemID);
+    if (index != -1) {
+        for (int i = 0; i <= PROP_LAST_ITEM; i++) {
+            if (_entities[index].properties & (1ULL << i)) {
+                properties += (EntityPropertyList)i;
+            }
+        }
+    }
+    return properties;
+}
+
+void EntityTreeElementPendingEntities::insert(const EntityItemID& entityItemID, const EntityPropertyFlags& properties) {
+    quint64 mask = 0;
+    for (int i = 0; i <= PROP_LAST_ITEM; i++) {
+        if (properties.getHasProperty((EntityPropertyList)i)) {
+            mask |= (1ULL << i);
+        }
+    }
+
+    int index = indexOf(entityItemID);
+    if (index == -1) {
+        // out of room, so move to a bigger array - the old one goes back to the arena when the scene's done
+        if (_size == _capacity) {
+            int capacity = qMax(INITIAL_PENDING_ENTITIES, _capacity * 2);
+            Entry* entities = static_cast<Entry*>(_arena->allocate(sizeof(Entry) * capacity));
+            for (int i = 0; i < _size; i++) {
+                new (entities + i) Entry(_entities[i]);
+            }
+            _entities = entities;
+            _capacity = capacity;
+        }
+        index = _size++;
+        new (_entities + index) Entry();
+        _entities[index].entityItemID = entityItemID;
+    }
+    _entities[index].properties = mask;
+}
+
+void EntityTreeElementPendingEntities::remove(const EntityItemID& entityItemID) {
+    int index = indexOf(entityItemID);
+    if (index != -1) {
+        _entities[index] = _entities[--_size];
+    }
+}
+
+int EntityTreeElementPendingEntities::indexOf(const EntityItemID& entityItemID) const {
+    for (int i = 0; i < _size; i++) {
+        if (_entities[i].entityItemID == entityItemID) {
+            return i;
+        }
+    }
+    return -1;
+}
+
 EntityTreeElement::EntityTreeElement(unsigned char* octalCode) : OctreeElement(), _entityItems(NULL) {
     init(octalCode);
 };
@@ -72,7 +148,8 @@ void EntityTreeElement::initializeExtraEncodeData(EncodeBitstreamParams& params)
     assert(extraEncodeData); // EntityTrees always require extra encode data on their encoding passes
     // Check to see if this element yet has encode data... if it doesn't create it
     if (!extraEncodeData->contains(this)) {
-        EntityTreeElementExtraEncodeData* entityTreeElementExtraEncodeData = new EntityTreeElementExtraEncodeData();
+        EntityTreeElementExtraEncodeData* entityTreeElementExtraEncodeData =
+                extraEncodeData->create<EntityTreeElementExtraEncodeData>(extraEncodeData);
         entityTreeElementExtraEncodeData->elementCompleted = (_entityItems->size() == 0);
         for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
             EntityTreeElement* child = getChildAtIndex(i);
@@ -88,7 +165,7 @@ void EntityTreeElement::initializeExtraEncodeData(EncodeBitstreamParams& params)
         }
         for (uint16_t i = 0; i < _entityItems->size(); i++) {
             EntityItem* entity = (*_entityItems)[i];
-            entityTreeElementExtraEncodeData->entities.insert(entity->getEntityItemID(), entity->getEntityProperties(params));
+            entityTreeElementExtraEncodeData->entities.insert(entity->getEntityItemID(), entity->getPropertiesToSend(params));
         }
         
         // TODO: some of these inserts might be redundant!!!
@@ -140,6 +217,65 @@ bool EntityTreeElement::alreadyFullyEncoded(EncodeBitstreamParams& params) const
     return false;
 }
 
+bool EntityTreeElement::canEncodeSubtreeFromCache(EncodeBitstreamParams& params) const {
+    OctreeElementExtraEncodeData* extraEncodeData = params.extraEncodeData;
+    assert(extraEncodeData); // EntityTrees always require extra encode data on their encoding passes
+
+    // our own encode data may exist because our parent just sent our entities, but none of our children may have been
+    // sent yet this scene - any deeper encode data would mean one of our children had been encoded first
+    if (extraEncodeData->contains(this)) {
+        EntityTreeElementExtraEncodeData* entityTreeElementExtraEncodeData
+                        = static_cast<EntityTreeElementExtraEncodeData*>(extraEncodeData->value(this));
+        if (entityTreeElementExtraEncodeData->subtreeCompleted) {
+            return false;
+        }
+        for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+            EntityTreeElement* child = getChildAtIndex(i);
+            bool completedBeforeEncoding = !child || !child->hasEntities();
+            if (entityTreeElementExtraEncodeData->childCompleted[i] != completedBeforeEncoding) {
+                return false;
+            }
+        }
+    }
+
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        EntityTreeElement* child = getChildAtIndex(i);
+        if (child && extraEncodeData->contains(child)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void EntityTreeElement::subtreeEncodedFromCache(EncodeBitstreamParams& params) const {
+    // leave our encode data the way a complete encode of our subtree would have, so that it isn't sent again this scene
+    initializeExtraEncodeData(params);
+
+    // and the client now has every entity of the subtree in full, as the encode would have recorded
+    if (params.sentItems) {
+        addSubtreeEntitiesToSentItems(*params.sentItems);
+    }
+
+    EntityTreeElementExtraEncodeData* entityTreeElementExtraEncodeData
+                    = static_cast<EntityTreeElementExtraEncodeData*>(params.extraEncodeData->value(this));
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        entityTreeElementExtraEncodeData->childCompleted[i] = true;
+    }
+    entityTreeElementExtraEncodeData->subtreeCompleted = true;
+}
+
+void EntityTreeElement::addSubtreeEntitiesToSentItems(OctreeSentItems& sentItems) const {
+    for (uint16_t i = 0; i < _entityItems->size(); i++) {
+        sentItems.insert((*_entityItems)[i]->getID());
+    }
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        EntityTreeElement* child = getChildAtIndex(i);
+        if (child) {
+            child->addSubtreeEntitiesToSentItems(sentItems);
+        }
+    }
+}
+
 void EntityTreeElement::updateEncodedData(int childIndex, AppendState childAppendState, EncodeBitstreamParams& params) const {
     OctreeElementExtraEncodeData* extraEncodeData = params.extraEncodeData;
     assert(extraEncodeData); // EntityTrees always require extra encode data on their encoding passes
@@ -244,12 +380,16 @@ OctreeElement::AppendState EntityTreeElement::appendElementData(OctreePacketData
     OctreeElementExtraEncodeData* extraEncodeData = params.extraEncodeData;
     EntityTreeElementExtraEncodeData* entityTreeElementExtraEncodeData = NULL;
     bool hadElementExtraData = false;
+
+    // without a scene to keep track of, what this pass needs is kept just for the pass
+    OctreeElementExtraEncodeData* arena = extraEncodeData ? extraEncodeData : &getPassEncodeData();
+
     if (extraEncodeData && extraEncodeData->contains(this)) {
         entityTreeElementExtraEncodeData = static_cast<EntityTreeElementExtraEncodeData*>(extraEncodeData->value(this));
         hadElementExtraData = true;
     } else {
         // if there wasn't one already, then create one
-        entityTreeElementExtraEncodeData = new EntityTreeElementExtraEncodeData();
+        entityTreeElementExtraEncodeData = arena->create<EntityTreeElementExtraEncodeData>(arena);
         entityTreeElementExtraEncodeData->elementCompleted = (_entityItems->size() == 0);
 
         for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
@@ -266,7 +406,7 @@ OctreeElement::AppendState EntityTreeElement::appendElementData(OctreePacketData
         }
         for (uint16_t i = 0; i < _entityItems->size(); i++) {
             EntityItem* entity = (*_entityItems)[i];
-            entityTreeElementExtraEncodeData->entities.insert(entity->getEntityItemID(), entity->getEntityProperties(params));
+            entityTreeElementExtraEncodeData->entities.insert(entity->getEntityItemID(), entity->getPropertiesToSend(params));
         }
     }
 
@@ -297,6 +437,11 @@ OctreeElement::AppendState EntityTreeElement::appendElementData(OctreePacketData
                 includeThisEntity = includeThisEntity && 
                                         entityTreeElementExtraEncodeData->entities.contains(entity->getEntityItemID());
             }
+
+            // a client that has the entity is only sent what changed, which may be nothing it's sent
+            if (includeThisEntity && !entityTreeElementExtraEncodeData->entities.value(entity->getEntityItemID())) {
+                includeThisEntity = false;
+            }
         
             if (includeThisEntity && params.viewFrustum) {
             
@@ -342,6 +487,11 @@ OctreeElement::AppendState EntityTreeElement::appendElementData(OctreePacketData
             // If the entity item got completely appended, then we can remove it from the extra encode data
             if (appendEntityState == OctreeElement::COMPLETED) {
                 entityTreeElementExtraEncodeData->entities.remove(entity->getEntityItemID());
+
+                // and from here on the client can be sent just the properties that change
+                if (params.sentItems) {
+                    params.sentItems->insert(entity->getID());
+                }
             }
 
             // If any part of the entity items didn't fit, then the element is considered partial
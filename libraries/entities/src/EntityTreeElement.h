@@ -36,18 +36,50 @@ public:
     int _movingItems;
 };
 
+/// The entities of an element still to be sent in a scene, with the properties each still needs. Lives in the arena of
+/// the client's OctreeElementExtraEncodeData, so it's a flat array from the arena with the properties as a mask - an
+/// element holds few enough entities that looking one up is a short scan.
+class EntityTreeElementPendingEntities {
+public:
+    EntityTreeElementPendingEntities(OctreeElementExtraEncodeData* arena) :
+        _arena(arena),
+        _entities(NULL),
+        _size(0),
+        _capacity(0) { }
+
+    bool contains(const EntityItemID& entityItemID) const { return indexOf(entityItemID) != -1; }
+    EntityPropertyFlags value(const EntityItemID& entityItemID) const;
+    void insert(const EntityItemID& entityItemID, const EntityPropertyFlags& properties);
+    void remove(const EntityItemID& entityItemID);
+    int size() const { return _size; }
+
+private:
+    class Entry {
+    public:
+        EntityItemID entityItemID;
+        quint64 properties;
+    };
+
+    int indexOf(const EntityItemID& entityItemID) const;
+
+    OctreeElementExtraEncodeData* _arena;
+    Entry* _entities;
+    int _size;
+    int _capacity;
+};
+
 class EntityTreeElementExtraEncodeData {
 public:
-    EntityTreeElementExtraEncodeData() : 
+    EntityTreeElementExtraEncodeData(OctreeElementExtraEncodeData* arena) : 
         elementCompleted(false), 
         subtreeCompleted(false),
-        entities() {
+        entities(arena) {
             memset(childCompleted, 0, sizeof(childCompleted));
         }
     bool elementCompleted;
     bool subtreeCompleted;
     bool childCompleted[NUMBER_OF_CHILDREN];
-    QMap<EntityItemID, EntityPropertyFlags> entities;
+    EntityTreeElementPendingEntities entities;
 };
 
 inline QDebug operator<<(QDebug debug, const EntityTreeElementExtraEncodeData* data) {
@@ -116,6 +148,8 @@ public:
     virtual bool shouldRecurseChildTree(int childIndex, EncodeBitstreamParams& params) const;
     virtual void updateEncodedData(int childIndex, AppendState childAppendState, EncodeBitstreamParams& params) const;
     virtual void elementEncodeComplete(EncodeBitstreamParams& params, OctreeElementBag* bag) const;
+    virtual bool canEncodeSubtreeFromCache(EncodeBitstreamParams& params) const;
+    virtual void subtreeEncodedFromCache(EncodeBitstreamParams& params) const;
 
     bool alreadyFullyEncoded(EncodeBitstreamParams& params) const;
 
@@ -200,6 +234,8 @@ public:
 
 protected:
     virtual void init(unsigned char * octalCode);
+    void addSubtreeEntitiesToSentItems(OctreeSentItems& sentItems) const;
+
     EntityTree* _myTree;
     QList<EntityItem*>* _entityItems;
 };
@@ -378,6 +378,11 @@ void ModelEntityItem::update(const quint64& now) {
         float deltaTime = (float)(now - _lastAnimated) / (float)USECS_PER_SECOND;
         _lastAnimated = now;
         _animationLoop.simulate(deltaTime);
+
+        if (!getAnimationIsPlaying()) {
+            // the animation ran to its end, let the simulation know we may not need update() anymore
+            _dirtyFlags |= EntityItem::DIRTY_UPDATEABLE;
+        }
     } else {
         _lastAnimated = now;
     }
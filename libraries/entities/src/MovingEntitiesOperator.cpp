@@ -100,6 +100,8 @@ void MovingEntitiesOperator::addEntityToMoveList(EntityItem* entity, const AACub
         if (_wantDebug) {
             qDebug() << "    oldContainingElement->bestFitBounds(newCubeClamped) IS BEST FIT... NOTHING TO DO";
         }
+        // the entity stays where it is, but what's encoded for the subtrees it's in has still changed
+        _tree->markPathToElementChanged(oldContainingElement);
     }
 
     if (_wantDebug) {
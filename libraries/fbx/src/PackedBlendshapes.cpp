@@ -0,0 +1,202 @@
+//
+//  PackedBlendshapes.cpp
+//  libraries/fbx/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+#include <string.h>
+
+#include <SharedUtil.h>
+
+#include "FBXReader.h"
+#include "PackedBlendshapes.h"
+
+// the vertex x, y, z and normal x, y, z arrays
+const int NUM_PACKED_COMPONENTS = 6;
+const int NUM_VERTEX_COMPONENTS = 3;
+
+const float NORMAL_COEFFICIENT_SCALE = 0.01f;
+
+PackedBlendshapes::PackedBlendshapes() {
+}
+
+PackedBlendshapes::PackedBlendshapes(const FBXMesh& mesh) {
+    int numVertices = mesh.vertices.size();
+
+    // pack every vertex any blendshape moves, keeping them in mesh order
+    QVector<int> packedIndices(numVertices, -1);
+    foreach (const FBXBlendshape& blendshape, mesh.blendshapes) {
+        foreach (int index, blendshape.indices) {
+            if (index >= 0 && index < numVertices) {
+                packedIndices[index] = 0;
+            }
+        }
+    }
+    for (int i = 0; i < numVertices; i++) {
+        if (packedIndices.at(i) != -1) {
+            packedIndices[i] = _vertexIndices.size();
+            _vertexIndices.append(i);
+        }
+    }
+
+    int numPacked = _vertexIndices.size();
+    _base.resize(NUM_PACKED_COMPONENTS * numPacked);
+    for (int i = 0; i < numPacked; i++) {
+        int index = _vertexIndices.at(i);
+        glm::vec3 normal = (index < mesh.normals.size()) ? mesh.normals.at(index) : glm::vec3();
+        for (int j = 0; j < NUM_VERTEX_COMPONENTS; j++) {
+            _base[j * numPacked + i] = mesh.vertices.at(index)[j];
+            _base[(NUM_VERTEX_COMPONENTS + j) * numPacked + i] = normal[j];
+        }
+    }
+
+    _blendshapes.resize(mesh.blendshapes.size());
+    for (int i = 0; i < mesh.blendshapes.size(); i++) {
+        const FBXBlendshape& blendshape = mesh.blendshapes.at(i);
+        Blendshape& packedBlendshape = _blendshapes[i];
+
+        int first = numPacked;
+        int last = -1;
+        foreach (int index, blendshape.indices) {
+            if (index >= 0 && index < numVertices) {
+                first = qMin(first, packedIndices.at(index));
+                last = qMax(last, packedIndices.at(index));
+            }
+        }
+        packedBlendshape.first = qMin(first, last + 1);
+        packedBlendshape.count = last + 1 - packedBlendshape.first;
+
+        // the vertices this blendshape spans but doesn't move get zero offsets, and repeated ones sum as they did
+        int count = packedBlendshape.count;
+        packedBlendshape.offsets.fill(0.0f, NUM_PACKED_COMPONENTS * count);
+        for (int j = 0; j < blendshape.indices.size(); j++) {
+            int index = blendshape.indices.at(j);
+            if (index < 0 || index >= numVertices) {
+                continue;
+            }
+            int offset = packedIndices.at(index) - packedBlendshape.first;
+            glm::vec3 normal = (j < blendshape.normals.size()) ? blendshape.normals.at(j) : glm::vec3();
+            for (int k = 0; k < NUM_VERTEX_COMPONENTS; k++) {
+                packedBlendshape.offsets[k * count + offset] += blendshape.vertices.at(j)[k];
+                packedBlendshape.offsets[(NUM_VERTEX_COMPONENTS + k) * count + offset] += normal[k];
+            }
+        }
+    }
+}
+
+static QVector<QPair<int, int> > mergeRanges(QVector<QPair<int, int> > ranges) {
+    std::sort(ranges.begin(), ranges.end());
+    QVector<QPair<int, int> > merged;
+    foreach (const QPair<int, int>& range, ranges) {
+        if (!merged.isEmpty() && range.first <= merged.last().second) {
+            merged.last().second = qMax(merged.last().second, range.second);
+        } else {
+            merged.append(range);
+        }
+    }
+    return merged;
+}
+
+// kept free of anything that would stop the compiler from vectorizing it
+static void addScaled(float* destination, const float* source, float scale, int count) {
+    for (int i = 0; i < count; i++) {
+        destination[i] += source[i] * scale;
+    }
+}
+
+BlendedMesh::BlendedMesh() :
+    _firstChangedVertex(0),
+    _changedVertexEnd(0) {
+}
+
+void BlendedMesh::reset(const FBXMesh& mesh) {
+    _vertices = mesh.vertices;
+    _normals = mesh.normals;
+    _accumulators.clear();
+    _lastBlendedRanges.clear();
+    clearChanges();
+}
+
+void BlendedMesh::blend(const PackedBlendshapes& blendshapes, const QVector<float>& coefficients) {
+    int numPacked = blendshapes.getNumPackedVertices();
+    if (_accumulators.size() != NUM_PACKED_COMPONENTS * numPacked) {
+        _accumulators.resize(NUM_PACKED_COMPONENTS * numPacked);
+    }
+
+    QVector<PackedRange> blendedRanges;
+    int numBlendshapes = qMin(coefficients.size(), blendshapes._blendshapes.size());
+    for (int i = 0; i < numBlendshapes; i++) {
+        const PackedBlendshapes::Blendshape& blendshape = blendshapes._blendshapes.at(i);
+        if (coefficients.at(i) >= EPSILON && blendshape.count > 0) {
+            blendedRanges.append(PackedRange(blendshape.first, blendshape.first + blendshape.count));
+        }
+    }
+
+    // what the last blend moved has to be put back even if nothing moves it now
+    QVector<PackedRange> changedRanges = mergeRanges(blendedRanges + _lastBlendedRanges);
+    _lastBlendedRanges = mergeRanges(blendedRanges);
+
+    float* accumulators = _accumulators.data();
+    const float* base = blendshapes._base.constData();
+    foreach (const PackedRange& range, changedRanges) {
+        for (int i = 0; i < NUM_PACKED_COMPONENTS; i++) {
+            memcpy(accumulators + i * numPacked + range.first, base + i * numPacked + range.first,
+                (range.second - range.first) * sizeof(float));
+        }
+    }
+
+    for (int i = 0; i < numBlendshapes; i++) {
+        float vertexCoefficient = coefficients.at(i);
+        const PackedBlendshapes::Blendshape& blendshape = blendshapes._blendshapes.at(i);
+        if (vertexCoefficient < EPSILON || blendshape.count == 0) {
+            continue;
+        }
+        float normalCoefficient = vertexCoefficient * NORMAL_COEFFICIENT_SCALE;
+        const float* offsets = blendshape.offsets.constData();
+        for (int j = 0; j < NUM_PACKED_COMPONENTS; j++) {
+            addScaled(accumulators + j * numPacked + blendshape.first, offsets + j * blendshape.count,
+                (j < NUM_VERTEX_COMPONENTS) ? vertexCoefficient : normalCoefficient, blendshape.count);
+        }
+    }
+
+    const float* vertexX = accumulators;
+    const float* vertexY = vertexX + numPacked;
+    const float* vertexZ = vertexY + numPacked;
+    const float* normalX = vertexZ + numPacked;
+    const float* normalY = normalX + numPacked;
+    const float* normalZ = normalY + numPacked;
+    foreach (const PackedRange& range, changedRanges) {
+        for (int i = range.first; i < range.second; i++) {
+            int index = blendshapes._vertexIndices.at(i);
+            _vertices[index] = glm::vec3(vertexX[i], vertexY[i], vertexZ[i]);
+            if (index < _normals.size()) {
+                _normals[index] = glm::vec3(normalX[i], normalY[i], normalZ[i]);
+            }
+        }
+        addChangedRange(blendshapes, range);
+    }
+}
+
+void BlendedMesh::clearChanges() {
+    _firstChangedVertex = 0;
+    _changedVertexEnd = 0;
+}
+
+void BlendedMesh::addChangedRange(const PackedBlendshapes& blendshapes, const PackedRange& range) {
+    // packed vertices are in mesh order, so the ends of the range are the ends of the vertices it covers
+    int first = blendshapes._vertexIndices.at(range.first);
+    int end = blendshapes._vertexIndices.at(range.second - 1) + 1;
+    if (getNumChangedVertices() == 0) {
+        _firstChangedVertex = first;
+        _changedVertexEnd = end;
+    } else {
+        _firstChangedVertex = qMin(_firstChangedVertex, first);
+        _changedVertexEnd = qMax(_changedVertexEnd, end);
+    }
+}
@@ -0,0 +1,81 @@
+//
+//  PackedBlendshapes.h
+//  libraries/fbx/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_PackedBlendshapes_h
+#define hifi_PackedBlendshapes_h
+
+#include <QtCore/QPair>
+#include <QtCore/QVector>
+
+#include <glm/glm.hpp>
+
+class FBXMesh;
+
+/// A mesh's blendshapes laid out for blending. The vertices that any blendshape moves are gathered, in mesh order, into
+/// a packed range, and each blendshape keeps dense offsets over the part of that range it spans, with x, y and z in
+/// separate arrays, so that applying one is a run of multiply-adds the compiler can vectorize.
+class PackedBlendshapes {
+public:
+    PackedBlendshapes();
+    PackedBlendshapes(const FBXMesh& mesh);
+
+    bool isEmpty() const { return _vertexIndices.isEmpty(); }
+    int getNumBlendshapes() const { return _blendshapes.size(); }
+    int getNumPackedVertices() const { return _vertexIndices.size(); }
+
+private:
+    friend class BlendedMesh;
+
+    class Blendshape {
+    public:
+        int first; // the first packed vertex spanned
+        int count;
+        QVector<float> offsets; // the vertex x, y and z offsets, then the normal x, y and z offsets, each count long
+    };
+
+    QVector<int> _vertexIndices; // the mesh vertex of each packed vertex
+    QVector<float> _base; // the unblended vertex x, y, z and normal x, y, z of the packed vertices, as in the offsets
+    QVector<Blendshape> _blendshapes;
+};
+
+/// The blended vertices and normals of one mesh, kept between blends so that each only rewrites the vertices moved by
+/// the blendshapes that it or the previous blend applied.
+class BlendedMesh {
+public:
+    BlendedMesh();
+
+    /// Starts over from the mesh's unblended vertices and normals.
+    void reset(const FBXMesh& mesh);
+
+    void blend(const PackedBlendshapes& blendshapes, const QVector<float>& coefficients);
+
+    const QVector<glm::vec3>& getVertices() const { return _vertices; }
+    const QVector<glm::vec3>& getNormals() const { return _normals; }
+
+    /// Returns the range of vertices that changed since the last call to clearChanges, empty if none did.
+    int getFirstChangedVertex() const { return _firstChangedVertex; }
+    int getNumChangedVertices() const { return qMax(_changedVertexEnd - _firstChangedVertex, 0); }
+    void clearChanges();
+
+private:
+    typedef QPair<int, int> PackedRange;
+
+    void addChangedRange(const PackedBlendshapes& blendshapes, const PackedRange& range);
+
+    QVector<glm::vec3> _vertices;
+    QVector<glm::vec3> _normals;
+    QVector<float> _accumulators; // laid out like PackedBlendshapes::_base
+    QVector<PackedRange> _lastBlendedRanges; // the packed vertices the last blend moved, which may need restoring
+    int _firstChangedVertex;
+    int _changedVertexEnd;
+};
+
+#endif // hifi_PackedBlendshapes_h
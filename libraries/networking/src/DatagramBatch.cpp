@@ -0,0 +1,195 @@
+//
+//  DatagramBatch.cpp
+//  libraries/networking/src
+//
+//  Created on 3/12/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <QtCore/QDebug>
+
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#endif
+
+#include "DatagramBatch.h"
+
+const int MAX_DATAGRAM_BYTES = 65536;
+
+DatagramSendBatch::DatagramSendBatch() :
+    _datagrams()
+{
+    _datagrams.reserve(MAX_DATAGRAMS_PER_BATCH);
+}
+
+void DatagramSendBatch::queue(const QByteArray& datagram, const HifiSockAddr& destinationSockAddr) {
+    QueuedDatagram queuedDatagram = { datagram, destinationSockAddr.getAddress(), destinationSockAddr.getPort() };
+    _datagrams.append(queuedDatagram);
+}
+
+qint64 DatagramSendBatch::flush(QUdpSocket& socket) {
+    qint64 bytesSent = 0;
+    int numSent = 0;
+
+#ifdef Q_OS_LINUX
+    int socketDescriptor = socket.socketDescriptor();
+
+    while (numSent < _datagrams.size()) {
+        struct mmsghdr messages[MAX_DATAGRAMS_PER_BATCH];
+        struct iovec iovecs[MAX_DATAGRAMS_PER_BATCH];
+        struct sockaddr_in destinations[MAX_DATAGRAMS_PER_BATCH];
+
+        // batch up IPv4 datagrams until we hit one we leave to the socket
+        int numMessages = 0;
+        while (numSent + numMessages < _datagrams.size() && numMessages < MAX_DATAGRAMS_PER_BATCH
+               && _datagrams[numSent + numMessages].address.protocol() == QAbstractSocket::IPv4Protocol) {
+            const QueuedDatagram& queuedDatagram = _datagrams[numSent + numMessages];
+
+            memset(&destinations[numMessages], 0, sizeof(sockaddr_in));
+            destinations[numMessages].sin_family = AF_INET;
+            destinations[numMessages].sin_addr.s_addr = htonl(queuedDatagram.address.toIPv4Address());
+            destinations[numMessages].sin_port = htons(queuedDatagram.port);
+
+            iovecs[numMessages].iov_base = const_cast<char*>(queuedDatagram.datagram.constData());
+            iovecs[numMessages].iov_len = queuedDatagram.datagram.size();
+
+            memset(&messages[numMessages], 0, sizeof(mmsghdr));
+            messages[numMessages].msg_hdr.msg_name = &destinations[numMessages];
+            messages[numMessages].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            messages[numMessages].msg_hdr.msg_iov = &iovecs[numMessages];
+            messages[numMessages].msg_hdr.msg_iovlen = 1;
+
+            ++numMessages;
+        }
+
+        int numMessagesSent = 0;
+        if (numMessages > 0) {
+            numMessagesSent = sendmmsg(socketDescriptor, messages, numMessages, 0);
+            if (numMessagesSent < 0) {
+                qDebug() << "ERROR in sendmmsg:" << strerror(errno) << "- writing datagrams one at a time.";
+                break;
+            }
+
+            for (int i = 0; i < numMessagesSent; i++) {
+                bytesSent += messages[i].msg_len;
+            }
+            numSent += numMessagesSent;
+        }
+
+        if (numMessagesSent == 0) {
+            // the next datagram isn't IPv4, or the kernel took none of them - let the socket write it
+            break;
+        }
+    }
+#endif
+
+    // whatever we couldn't batch is written one datagram at a time
+    for (int i = numSent; i < _datagrams.size(); i++) {
+        const QueuedDatagram& queuedDatagram = _datagrams[i];
+        qint64 bytesWritten = socket.writeDatagram(queuedDatagram.datagram, queuedDatagram.address, queuedDatagram.port);
+
+        if (bytesWritten < 0) {
+            qDebug() << "ERROR in writeDatagram:" << socket.error() << "-" << socket.errorString();
+        } else {
+            bytesSent += bytesWritten;
+        }
+    }
+
+    _datagrams.clear();
+    return bytesSent;
+}
+
+DatagramReceiveBatch::DatagramReceiveBatch() :
+    _datagrams(MAX_DATAGRAMS_PER_RECEIVE_BATCH),
+    _senderSockAddrs(MAX_DATAGRAMS_PER_RECEIVE_BATCH),
+    _receiveBuffers(),
+    _numDatagrams(0)
+{
+#ifdef Q_OS_LINUX
+    _receiveBuffers.resize(MAX_DATAGRAMS_PER_RECEIVE_BATCH);
+    for (int i = 0; i < _receiveBuffers.size(); i++) {
+        _receiveBuffers[i].resize(MAX_DATAGRAM_BYTES);
+    }
+#endif
+}
+
+int DatagramReceiveBatch::readPendingDatagrams(QUdpSocket& socket) {
+    _numDatagrams = 0;
+
+    // The first datagram always goes through the socket. An unbuffered QUdpSocket stops watching for datagrams when it
+    // signals that there are some, until one is read through it - this keeps readyRead coming for what we don't get to.
+    if (!socket.hasPendingDatagrams()) {
+        return 0;
+    }
+
+    _datagrams[0].resize(socket.pendingDatagramSize());
+    if (socket.readDatagram(_datagrams[0].data(), _datagrams[0].size(),
+                            _senderSockAddrs[0].getAddressPointer(), _senderSockAddrs[0].getPortPointer()) < 0) {
+        return 0;
+    }
+    _numDatagrams = 1;
+
+#ifdef Q_OS_LINUX
+    _numDatagrams += readDatagramsFromDescriptor(socket, _numDatagrams);
+#else
+    while (_numDatagrams < MAX_DATAGRAMS_PER_RECEIVE_BATCH && socket.hasPendingDatagrams()) {
+        QByteArray& datagram = _datagrams[_numDatagrams];
+        HifiSockAddr& senderSockAddr = _senderSockAddrs[_numDatagrams];
+
+        datagram.resize(socket.pendingDatagramSize());
+        if (socket.readDatagram(datagram.data(), datagram.size(),
+                                senderSockAddr.getAddressPointer(), senderSockAddr.getPortPointer()) < 0) {
+            break;
+        }
+        ++_numDatagrams;
+    }
+#endif
+
+    return _numDatagrams;
+}
+
+int DatagramReceiveBatch::readDatagramsFromDescriptor(QUdpSocket& socket, int firstIndex) {
+#ifdef Q_OS_LINUX
+    int numMessages = MAX_DATAGRAMS_PER_RECEIVE_BATCH - firstIndex;
+    if (numMessages <= 0) {
+        return 0;
+    }
+
+    struct mmsghdr messages[MAX_DATAGRAMS_PER_RECEIVE_BATCH];
+    struct iovec iovecs[MAX_DATAGRAMS_PER_RECEIVE_BATCH];
+    struct sockaddr_storage senders[MAX_DATAGRAMS_PER_RECEIVE_BATCH];
+
+    memset(messages, 0, sizeof(mmsghdr) * numMessages);
+    for (int i = 0; i < numMessages; i++) {
+        iovecs[i].iov_base = _receiveBuffers[i].data();
+        iovecs[i].iov_len = _receiveBuffers[i].size();
+
+        messages[i].msg_hdr.msg_name = &senders[i];
+        messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+        messages[i].msg_hdr.msg_iov = &iovecs[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int numMessagesRead = recvmmsg(socket.socketDescriptor(), messages, numMessages, MSG_DONTWAIT, NULL);
+    if (numMessagesRead < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            qDebug() << "ERROR in recvmmsg:" << strerror(errno);
+        }
+        return 0;
+    }
+
+    for (int i = 0; i < numMessagesRead; i++) {
+        // copied out of the receive buffer, since whoever processes the datagram may hold on to it
+        _datagrams[firstIndex + i] = QByteArray(_receiveBuffers[i].constData(), messages[i].msg_len);
+        _senderSockAddrs[firstIndex + i] = HifiSockAddr(reinterpret_cast<const sockaddr*>(&senders[i]));
+    }
+    return numMessagesRead;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,75 @@
+//
+//  DatagramBatch.h
+//  libraries/networking/src
+//
+//  Created on 3/12/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_DatagramBatch_h
+#define hifi_DatagramBatch_h
+
+#include <QtCore/QVector>
+#include <QtNetwork/QHostAddress>
+#include <QtNetwork/QUdpSocket>
+
+#include "HifiSockAddr.h"
+
+// the most datagrams handed to the socket in a single system call
+const int MAX_DATAGRAMS_PER_BATCH = 64;
+
+// a receive batch is smaller than a send batch since each datagram read needs a buffer big enough for any datagram
+const int MAX_DATAGRAMS_PER_RECEIVE_BATCH = 16;
+
+/// Datagrams queued for sending together. On Linux a flush is a single sendmmsg() per MAX_DATAGRAMS_PER_BATCH
+/// datagrams, elsewhere the datagrams are written one at a time.
+class DatagramSendBatch {
+public:
+    DatagramSendBatch();
+
+    void queue(const QByteArray& datagram, const HifiSockAddr& destinationSockAddr);
+
+    bool isEmpty() const { return _datagrams.isEmpty(); }
+    bool isFull() const { return _datagrams.size() >= MAX_DATAGRAMS_PER_BATCH; }
+
+    /// sends every queued datagram on the socket and empties the batch
+    /// \return the number of bytes sent
+    qint64 flush(QUdpSocket& socket);
+
+private:
+    struct QueuedDatagram {
+        QByteArray datagram;
+        QHostAddress address;
+        quint16 port;
+    };
+
+    QVector<QueuedDatagram> _datagrams;
+};
+
+/// Reads the datagrams pending on a socket in batches. On Linux everything after the first datagram of a batch is read
+/// with a single recvmmsg(), elsewhere the datagrams are read one at a time.
+class DatagramReceiveBatch {
+public:
+    DatagramReceiveBatch();
+
+    /// reads up to MAX_DATAGRAMS_PER_RECEIVE_BATCH of the datagrams pending on the socket, replacing the last batch read
+    /// \return the number of datagrams read
+    int readPendingDatagrams(QUdpSocket& socket);
+
+    int size() const { return _numDatagrams; }
+    const QByteArray& getDatagram(int index) const { return _datagrams[index]; }
+    const HifiSockAddr& getSenderSockAddr(int index) const { return _senderSockAddrs[index]; }
+
+private:
+    int readDatagramsFromDescriptor(QUdpSocket& socket, int firstIndex);
+
+    QVector<QByteArray> _datagrams;
+    QVector<HifiSockAddr> _senderSockAddrs;
+    QVector<QByteArray> _receiveBuffers;
+    int _numDatagrams;
+};
+
+#endif // hifi_DatagramBatch_h
@@ -77,7 +77,8 @@ LimitedNodeList::LimitedNodeList(unsigned short socketListenPort, unsigned short
     _stunSockAddr(STUN_SERVER_HOSTNAME, STUN_SERVER_PORT),
     _numCollectedPackets(0),
     _numCollectedBytes(0),
-    _packetStatTimer()
+    _packetStatTimer(),
+    _datagramBatches()
 {
     _nodeSocket.bind(QHostAddress::AnyIPv4, socketListenPort);
     qDebug() << "NodeList socket is listening on" << _nodeSocket.localPort();
@@ -200,7 +201,8 @@ bool LimitedNodeList::packetVersionAndHashMatch(const QByteArray& packet) {
         SharedNodePointer sendingNode = sendingNodeForPacket(packet);
         if (sendingNode) {
             // check if the md5 hash in the header matches the hash we would expect
-            if (hashFromPacketHeader(packet) == hashForPacketAndConnectionUUID(packet, sendingNode->getConnectionSecret())) {
+            if (packetHashMatchesConnectionUUID(packet, sendingNode->getConnectionSecret(),
+                                                sendingNode->getPacketAuthenticator())) {
                 return true;
             } else {
                 static QMultiMap<QUuid, PacketType> hashDebugSuppressMap;
@@ -228,18 +230,32 @@ bool LimitedNodeList::packetVersionAndHashMatch(const QByteArray& packet) {
 }
 
 qint64 LimitedNodeList::writeDatagram(const QByteArray& datagram, const HifiSockAddr& destinationSockAddr,
-                                      const QUuid& connectionSecret) {
+                                      const QUuid& connectionSecret, PacketAuthenticator_t packetAuthenticator) {
     QByteArray datagramCopy = datagram;
     
     if (!connectionSecret.isNull()) {
-        // setup the MD5 hash for source verification in the header
-        replaceHashInPacketGivenConnectionUUID(datagramCopy, connectionSecret);
+        // setup the hash for source verification in the header
+        replaceHashInPacketGivenConnectionUUID(datagramCopy, connectionSecret, packetAuthenticator);
     }
     
-    // stat collection for packets
-    ++_numCollectedPackets;
-    _numCollectedBytes += datagram.size();
+    // stat collection for packets, datagrams are written from many threads
+    _numCollectedPackets.fetchAndAddRelaxed(1);
+    _numCollectedBytes.fetchAndAddRelaxed(datagram.size());
     
+    if (_datagramBatches.hasLocalData()) {
+        // this thread is batching its datagrams, send them once the batch is full or flushed
+        DatagramSendBatch* datagramBatch = _datagramBatches.localData();
+        datagramBatch->queue(datagramCopy, destinationSockAddr);
+        
+        if (datagramBatch->isFull()) {
+            QMutexLocker locker(&_nodeSocketWriteMutex);
+            datagramBatch->flush(_nodeSocket);
+        }
+        
+        return datagram.size();
+    }
+    
+    QMutexLocker locker(&_nodeSocketWriteMutex);
     qint64 bytesWritten = _nodeSocket.writeDatagram(datagramCopy,
                                                     destinationSockAddr.getAddress(), destinationSockAddr.getPort());
     
@@ -250,6 +266,24 @@ qint64 LimitedNodeList::writeDatagram(const QByteArray& datagram, const HifiSock
     return bytesWritten;
 }
 
+void LimitedNodeList::beginDatagramBatch() {
+    if (!_datagramBatches.hasLocalData()) {
+        _datagramBatches.setLocalData(new DatagramSendBatch());
+    }
+}
+
+void LimitedNodeList::flushDatagramBatch() {
+    if (_datagramBatches.hasLocalData()) {
+        {
+            QMutexLocker locker(&_nodeSocketWriteMutex);
+            _datagramBatches.localData()->flush(_nodeSocket);
+        }
+        
+        // the batch is deleted here, later datagrams from this thread are sent right away again
+        _datagramBatches.setLocalData(NULL);
+    }
+}
+
 qint64 LimitedNodeList::writeDatagram(const QByteArray& datagram, const SharedNodePointer& destinationNode,
                                const HifiSockAddr& overridenSockAddr) {
     if (destinationNode) {
@@ -265,7 +299,8 @@ qint64 LimitedNodeList::writeDatagram(const QByteArray& datagram, const SharedNo
             }
         }
         
-        return writeDatagram(datagram, *destinationSockAddr, destinationNode->getConnectionSecret());
+        return writeDatagram(datagram, *destinationSockAddr, destinationNode->getConnectionSecret(),
+                             destinationNode->getPacketAuthenticator());
     }
     
     // didn't have a destinationNode to send to, return 0
@@ -488,17 +523,17 @@ SharedNodePointer LimitedNodeList::soloNodeOfType(char nodeType) {
 }
 
 void LimitedNodeList::getPacketStats(float& packetsPerSecond, float& bytesPerSecond) {
-    packetsPerSecond = (float) _numCollectedPackets / ((float) _packetStatTimer.elapsed() / 1000.0f);
-    bytesPerSecond = (float) _numCollectedBytes / ((float) _packetStatTimer.elapsed() / 1000.0f);
+    packetsPerSecond = (float) _numCollectedPackets.load() / ((float) _packetStatTimer.elapsed() / 1000.0f);
+    bytesPerSecond = (float) _numCollectedBytes.load() / ((float) _packetStatTimer.elapsed() / 1000.0f);
 }
 
 void LimitedNodeList::resetPacketStats() {
-    _numCollectedPackets = 0;
-    _numCollectedBytes = 0;
+    _numCollectedPackets.store(0);
+    _numCollectedBytes.store(0);
     _packetStatTimer.restart();
 }
 
-void LimitedNodeList::removeSilentNodes() {
+int LimitedNodeList::removeSilentNodes() {
     QSet<SharedNodePointer> killedNodes;
     
     eachNodeHashIterator([&](NodeHash::iterator& it){
@@ -521,6 +556,8 @@ void LimitedNodeList::removeSilentNodes() {
     foreach(const SharedNodePointer& killedNode, killedNodes) {
         handleNodeKill(killedNode);
     }
+    
+    return killedNodes.size();
 }
 
 const uint32_t RFC_5389_MAGIC_COOKIE = 0x2112A442;
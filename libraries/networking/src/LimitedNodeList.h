@@ -21,14 +21,17 @@
 #endif
 
 #include <qelapsedtimer.h>
+#include <qmutex.h>
 #include <qreadwritelock.h>
 #include <qset.h>
 #include <qsharedpointer.h>
+#include <qthreadstorage.h>
 #include <QtNetwork/qudpsocket.h>
 #include <QtNetwork/qhostaddress.h>
 
 #include <tbb/concurrent_unordered_map.h>
 
+#include "DatagramBatch.h"
 #include "DomainHandler.h"
 #include "Node.h"
 #include "UUIDHasher.h"
@@ -67,6 +70,13 @@ namespace PingType {
     const PingType_t Symmetric = 3;
 }
 
+// each node in a domain list is preceded by whether it is being added (or updated) or removed
+typedef quint8 DomainListEntryType_t;
+namespace DomainListEntryType {
+    const DomainListEntryType_t AddOrUpdate = 0;
+    const DomainListEntryType_t Remove = 1;
+}
+
 class LimitedNodeList : public QObject {
     Q_OBJECT
 public:
@@ -95,6 +105,10 @@ public:
     qint64 writeUnverifiedDatagram(const char* data, qint64 size, const SharedNodePointer& destinationNode,
                          const HifiSockAddr& overridenSockAddr = HifiSockAddr());
 
+    /// datagrams written from the calling thread are queued from here on, and sent together by flushDatagramBatch()
+    void beginDatagramBatch();
+    void flushDatagramBatch();
+
     void(*linkedDataCreateCallback)(Node *);
     
     int size() const { return _nodeHash.size(); }
@@ -167,7 +181,8 @@ public slots:
     void reset();
     void eraseAllNodes();
     
-    void removeSilentNodes();
+    /// \return the number of nodes removed
+    virtual int removeSilentNodes();
     
     void updateLocalSockAddr();
     
@@ -187,7 +202,8 @@ protected:
     void operator=(LimitedNodeList const&); // Don't implement, needed to avoid copies of singleton
     
     qint64 writeDatagram(const QByteArray& datagram, const HifiSockAddr& destinationSockAddr,
-                         const QUuid& connectionSecret);
+                         const QUuid& connectionSecret,
+                         PacketAuthenticator_t packetAuthenticator = PacketAuthenticator::MD5);
     
     void changeSocketBufferSizes(int numBytes);
     
@@ -201,9 +217,11 @@ protected:
     HifiSockAddr _localSockAddr;
     HifiSockAddr _publicSockAddr;
     HifiSockAddr _stunSockAddr;
-    int _numCollectedPackets;
-    int _numCollectedBytes;
+    QAtomicInt _numCollectedPackets;
+    QAtomicInt _numCollectedBytes;
     QElapsedTimer _packetStatTimer;
+    QThreadStorage<DatagramSendBatch*> _datagramBatches;
+    QMutex _nodeSocketWriteMutex; // datagrams are written from many threads, one thread's batch at a time
     
     template<typename IteratorLambda>
     void eachNodeHashIterator(IteratorLambda functor) {
@@ -47,9 +47,11 @@ Node::Node(const QUuid& uuid, NodeType_t type, const HifiSockAddr& publicSocket,
     _activeSocket(NULL),
     _symmetricSocket(),
     _connectionSecret(),
+    _packetAuthenticator(PacketAuthenticator::MD5),
     _bytesReceivedMovingAverage(NULL),
     _linkedData(NULL),
     _isAlive(true),
+    _isAssignment(false),
     _pingMs(-1),  // "Uninitialized"
     _clockSkewUsec(0),
     _mutex(),
@@ -23,6 +23,7 @@
 #include "HifiSockAddr.h"
 #include "NetworkPeer.h"
 #include "NodeData.h"
+#include "PacketHeaders.h"
 #include "SimpleMovingAverage.h"
 #include "MovingPercentile.h"
 
@@ -57,12 +58,19 @@ public:
     const QUuid& getConnectionSecret() const { return _connectionSecret; }
     void setConnectionSecret(const QUuid& connectionSecret) { _connectionSecret = connectionSecret; }
 
+    PacketAuthenticator_t getPacketAuthenticator() const { return _packetAuthenticator; }
+    void setPacketAuthenticator(PacketAuthenticator_t packetAuthenticator) { _packetAuthenticator = packetAuthenticator; }
+
     NodeData* getLinkedData() const { return _linkedData; }
     void setLinkedData(NodeData* linkedData) { _linkedData = linkedData; }
 
     bool isAlive() const { return _isAlive; }
     void setAlive(bool isAlive) { _isAlive = isAlive; }
 
+    /// whether the domain-server gave the node an assignment, as opposed to it being a client that connected itself
+    bool isAssignment() const { return _isAssignment; }
+    void setIsAssignment(bool isAssignment) { _isAssignment = isAssignment; }
+
     void  recordBytesReceived(int bytesReceived);
     float getAverageKilobitsPerSecond();
     float getAveragePacketsPerSecond();
@@ -99,9 +107,11 @@ private:
     HifiSockAddr _symmetricSocket;
     
     QUuid _connectionSecret;
+    PacketAuthenticator_t _packetAuthenticator;
     SimpleMovingAverage* _bytesReceivedMovingAverage;
     NodeData* _linkedData;
     bool _isAlive;
+    bool _isAssignment;
     int _pingMs;
     int _clockSkewUsec;
     QMutex _mutex;
@@ -59,6 +59,9 @@ NodeList::NodeList(char newOwnerType, unsigned short socketListenPort, unsigned
     _nodeTypesOfInterest(),
     _domainHandler(this),
     _numNoReplyDomainCheckIns(0),
+    _domainListVersion(0),
+    _pendingDomainListVersion(0),
+    _receivedDomainListPackets(),
     _assignmentServerSocket(),
     _hasCompletedInitialSTUNFailure(false),
     _stunRequestsSinceSuccess(0)
@@ -212,6 +215,11 @@ void NodeList::reset() {
     LimitedNodeList::reset();
     
     _numNoReplyDomainCheckIns = 0;
+    
+    // we no longer have a domain list, the next one we get will be a full list
+    _domainListVersion = 0;
+    _pendingDomainListVersion = 0;
+    _receivedDomainListPackets.clear();
 
     // refresh the owner UUID to the NULL UUID
     setSessionUUID(QUuid());
@@ -319,6 +327,7 @@ void NodeList::sendDomainServerCheckIn() {
         
         
         // if this is a connect request, and we can present a username signature, send it along
+        // otherwise let the domain-server know which domain list we have so it only has to send us what changed
         if (!_domainHandler.isConnected()) {
             DataServerAccountInfo& accountInfo = AccountManager::getInstance().getAccountInfo();
             packetStream << accountInfo.getUsername();
@@ -329,6 +338,8 @@ void NodeList::sendDomainServerCheckIn() {
                 qDebug() << "Including username signature in domain connect request.";
                 packetStream << usernameSignature;
             }
+        } else {
+            packetStream << _domainListVersion;
         }
         
         if (!isUsingDTLS) {
@@ -394,6 +405,7 @@ int NodeList::processDomainServerList(const QByteArray& packet) {
     qint8 nodeType;
     
     QUuid nodeUUID, connectionUUID;
+    PacketAuthenticator_t packetAuthenticator;
 
     HifiSockAddr nodePublicSocket;
     HifiSockAddr nodeLocalSocket;
@@ -406,8 +418,29 @@ int NodeList::processDomainServerList(const QByteArray& packet) {
     packetStream >> newUUID;
     setSessionUUID(newUUID);
     
+    // then which list this packet is part of, and which list it changes (zero for a full list)
+    quint32 baseListVersion, listVersion;
+    quint16 packetIndex, numPackets;
+    packetStream >> baseListVersion >> listVersion >> packetIndex >> numPackets;
+    
+    if (baseListVersion != 0 && baseListVersion != _domainListVersion) {
+        // these are changes to a list we don't have, our next check-in will get us the full list
+        pingInactiveNodes();
+        return readNodes;
+    }
+    
+    DomainListEntryType_t entryType;
+    
     // pull each node in the packet
     while(packetStream.device()->pos() < packet.size()) {
+        packetStream >> entryType;
+        
+        if (entryType == DomainListEntryType::Remove) {
+            packetStream >> nodeUUID;
+            killNodeWithUUID(nodeUUID);
+            continue;
+        }
+        
         packetStream >> nodeType >> nodeUUID >> nodePublicSocket >> nodeLocalSocket;
 
         // if the public socket address is 0 then it's reachable at the same IP
@@ -418,8 +451,24 @@ int NodeList::processDomainServerList(const QByteArray& packet) {
 
         SharedNodePointer node = addOrUpdateNode(nodeUUID, nodeType, nodePublicSocket, nodeLocalSocket);
         
-        packetStream >> connectionUUID;
+        bool isAssignment;
+        packetStream >> connectionUUID >> packetAuthenticator >> isAssignment;
         node->setConnectionSecret(connectionUUID);
+        node->setPacketAuthenticator(packetAuthenticator);
+        node->setIsAssignment(isAssignment);
+        
+        readNodes++;
+    }
+    
+    // once we have every packet of a list we have that list, and can tell the domain-server so on our next check-in
+    if (listVersion != _pendingDomainListVersion) {
+        _pendingDomainListVersion = listVersion;
+        _receivedDomainListPackets.clear();
+    }
+    
+    _receivedDomainListPackets.insert(packetIndex);
+    if (_receivedDomainListPackets.size() == numPackets) {
+        _domainListVersion = listVersion;
     }
     
     // ping inactive nodes in conjunction with receipt of list from domain-server
@@ -429,6 +478,20 @@ int NodeList::processDomainServerList(const QByteArray& packet) {
     return readNodes;
 }
 
+int NodeList::removeSilentNodes() {
+    int numRemoved = LimitedNodeList::removeSilentNodes();
+    
+    if (numRemoved > 0) {
+        // the domain-server may still have the nodes we gave up on, and won't send them again as changes to the list we
+        // have - so we forget our list, and our next check-in gets us the full one
+        _domainListVersion = 0;
+        _pendingDomainListVersion = 0;
+        _receivedDomainListPackets.clear();
+    }
+    
+    return numRemoved;
+}
+
 void NodeList::sendAssignment(Assignment& assignment) {
     
     PacketType assignmentPacketType = assignment.getCommand() == Assignment::CreateCommand
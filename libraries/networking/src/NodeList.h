@@ -65,6 +65,7 @@ public:
     void pingPunchForInactiveNode(const SharedNodePointer& node);
 public slots:
     void reset();
+    int removeSilentNodes();
     void sendDomainServerCheckIn();
     void pingInactiveNodes();
 signals:
@@ -88,6 +89,9 @@ private:
     NodeSet _nodeTypesOfInterest;
     DomainHandler _domainHandler;
     int _numNoReplyDomainCheckIns;
+    quint32 _domainListVersion;
+    quint32 _pendingDomainListVersion;
+    QSet<quint16> _receivedDomainListPackets;
     HifiSockAddr _assignmentServerSocket;
     bool _hasCompletedInitialSTUNFailure;
     unsigned int _stunRequestsSinceSuccess;
@@ -14,6 +14,7 @@
 #include <QtCore/QDebug>
 
 #include "NodeList.h"
+#include "SipHash.h"
 
 #include "PacketHeaders.h"
 
@@ -57,14 +58,18 @@ PacketVersion versionForPacketType(PacketType type) {
         case PacketTypeInjectAudio:
             return 1;
         case PacketTypeAvatarData:
-            return 5;
+        case PacketTypeHostedAvatarData:
+            return 6;
+        case PacketTypeBulkAvatarData:
+            return 1;
         case PacketTypeAvatarIdentity:
             return 1;
         case PacketTypeEnvironmentData:
             return 2;
         case PacketTypeDomainList:
+            return 6;
         case PacketTypeDomainListRequest:
-            return 3;
+            return 4;
         case PacketTypeCreateAssignment:
         case PacketTypeRequestAssignment:
             return 2;
@@ -72,7 +77,7 @@ PacketVersion versionForPacketType(PacketType type) {
             return 1;
         case PacketTypeEntityAddOrEdit:
         case PacketTypeEntityData:
-            return VERSION_ENTITIES_HAVE_USER_DATA;
+            return VERSION_ENTITIES_HAVE_SIMULATED_BY_SERVER;
         case PacketTypeEntityErase:
             return 2;
         case PacketTypeAudioStreamStats:
@@ -95,6 +100,7 @@ QString nameForPacketType(PacketType type) {
         PACKET_TYPE_NAME_LOOKUP(PacketTypePingReply);
         PACKET_TYPE_NAME_LOOKUP(PacketTypeKillAvatar);
         PACKET_TYPE_NAME_LOOKUP(PacketTypeAvatarData);
+        PACKET_TYPE_NAME_LOOKUP(PacketTypeHostedAvatarData);
         PACKET_TYPE_NAME_LOOKUP(PacketTypeInjectAudio);
         PACKET_TYPE_NAME_LOOKUP(PacketTypeMixedAudio);
         PACKET_TYPE_NAME_LOOKUP(PacketTypeMicrophoneAudioNoEcho);
@@ -208,14 +214,63 @@ QByteArray hashFromPacketHeader(const QByteArray& packet) {
     return packet.mid(numBytesForPacketHeader(packet) - NUM_BYTES_MD5_HASH, NUM_BYTES_MD5_HASH);
 }
 
-QByteArray hashForPacketAndConnectionUUID(const QByteArray& packet, const QUuid& connectionUUID) {
-    return QCryptographicHash::hash(packet.mid(numBytesForPacketHeader(packet)) + connectionUUID.toRfc4122(),
-                                    QCryptographicHash::Md5);
+// the same bytes as QUuid::toRfc4122(), without allocating a QByteArray for them
+static void packRfc4122(const QUuid& uuid, unsigned char* rfc4122) {
+    for (int i = 0; i < 4; i++) {
+        rfc4122[i] = (unsigned char)(uuid.data1 >> (8 * (3 - i)));
+    }
+    rfc4122[4] = (unsigned char)(uuid.data2 >> 8);
+    rfc4122[5] = (unsigned char)uuid.data2;
+    rfc4122[6] = (unsigned char)(uuid.data3 >> 8);
+    rfc4122[7] = (unsigned char)uuid.data3;
+    memcpy(rfc4122 + 8, uuid.data4, sizeof(uuid.data4));
 }
 
-void replaceHashInPacketGivenConnectionUUID(QByteArray& packet, const QUuid& connectionUUID) {
-    packet.replace(numBytesForPacketHeader(packet) - NUM_BYTES_MD5_HASH, NUM_BYTES_MD5_HASH,
-                   hashForPacketAndConnectionUUID(packet, connectionUUID));
+// hashes the data of the packet where it is, rather than a copy of it with the connection secret appended
+static void hashPacketData(const QByteArray& packet, int numHeaderBytes, const QUuid& connectionUUID,
+                           PacketAuthenticator_t authenticator, unsigned char* hash) {
+    const unsigned char* packetData = reinterpret_cast<const unsigned char*>(packet.constData()) + numHeaderBytes;
+    int packetDataSize = packet.size() - numHeaderBytes;
+
+    unsigned char secret[NUM_BYTES_RFC4122_UUID];
+    packRfc4122(connectionUUID, secret);
+
+    if (authenticator == PacketAuthenticator::SipHash) {
+        sipHash128(secret, packetData, packetDataSize, hash);
+    } else {
+        QCryptographicHash md5(QCryptographicHash::Md5);
+        md5.addData(reinterpret_cast<const char*>(packetData), packetDataSize);
+        md5.addData(reinterpret_cast<const char*>(secret), NUM_BYTES_RFC4122_UUID);
+        memcpy(hash, md5.result().constData(), NUM_BYTES_MD5_HASH);
+    }
+}
+
+QByteArray hashForPacketAndConnectionUUID(const QByteArray& packet, const QUuid& connectionUUID,
+                                          PacketAuthenticator_t authenticator) {
+    QByteArray hash(NUM_BYTES_MD5_HASH, 0);
+    hashPacketData(packet, numBytesForPacketHeader(packet), connectionUUID, authenticator,
+                   reinterpret_cast<unsigned char*>(hash.data()));
+    return hash;
+}
+
+void replaceHashInPacketGivenConnectionUUID(QByteArray& packet, const QUuid& connectionUUID,
+                                            PacketAuthenticator_t authenticator) {
+    int numHeaderBytes = numBytesForPacketHeader(packet);
+    unsigned char hash[NUM_BYTES_MD5_HASH];
+    hashPacketData(packet, numHeaderBytes, connectionUUID, authenticator, hash);
+    memcpy(packet.data() + numHeaderBytes - NUM_BYTES_MD5_HASH, hash, NUM_BYTES_MD5_HASH);
+}
+
+bool packetHashMatchesConnectionUUID(const QByteArray& packet, const QUuid& connectionUUID,
+                                     PacketAuthenticator_t authenticator) {
+    int numHeaderBytes = numBytesForPacketHeader(packet);
+    if (packet.size() < numHeaderBytes) {
+        return false;
+    }
+
+    unsigned char hash[NUM_BYTES_MD5_HASH];
+    hashPacketData(packet, numHeaderBytes, connectionUUID, authenticator, hash);
+    return memcmp(packet.constData() + numHeaderBytes - NUM_BYTES_MD5_HASH, hash, NUM_BYTES_MD5_HASH) == 0;
 }
 
 PacketType packetTypeForPacket(const QByteArray& packet) {
@@ -42,7 +42,7 @@ enum PacketType {
     PacketTypeMuteEnvironment,
     PacketTypeAudioStreamStats,
     PacketTypeDataServerConfirm, // 20
-    UNUSED_5,
+    PacketTypeHostedAvatarData,
     UNUSED_6,
     UNUSED_7,
     UNUSED_8,
@@ -88,7 +88,14 @@ const QSet<PacketType> NON_VERIFIED_PACKETS = QSet<PacketType>()
     << PacketTypeIceServerHeartbeat << PacketTypeIceServerHeartbeatResponse
     << PacketTypeUnverifiedPing << PacketTypeUnverifiedPingReply;
 
-const int NUM_BYTES_MD5_HASH = 16;
+// how the hash in the header of a verified packet is computed, both nodes are told which one to use by the domain-server
+typedef quint8 PacketAuthenticator_t;
+namespace PacketAuthenticator {
+    const PacketAuthenticator_t MD5 = 0; // MD5 of the packet data followed by the connection secret
+    const PacketAuthenticator_t SipHash = 1; // SipHash-2-4-128 of the packet data, keyed with the connection secret
+}
+
+const int NUM_BYTES_MD5_HASH = 16; // the size of the hash in the header of a verified packet, whatever the authenticator
 const int NUM_STATIC_HEADER_BYTES = sizeof(PacketVersion) + NUM_BYTES_RFC4122_UUID;
 const int MAX_PACKET_HEADER_BYTES = sizeof(PacketType) + NUM_BYTES_MD5_HASH + NUM_STATIC_HEADER_BYTES;
 
@@ -110,8 +117,14 @@ int numBytesForPacketHeaderGivenPacketType(PacketType type);
 QUuid uuidFromPacketHeader(const QByteArray& packet);
 
 QByteArray hashFromPacketHeader(const QByteArray& packet);
-QByteArray hashForPacketAndConnectionUUID(const QByteArray& packet, const QUuid& connectionUUID);
-void replaceHashInPacketGivenConnectionUUID(QByteArray& packet, const QUuid& connectionUUID);
+QByteArray hashForPacketAndConnectionUUID(const QByteArray& packet, const QUuid& connectionUUID,
+                                          PacketAuthenticator_t authenticator = PacketAuthenticator::MD5);
+void replaceHashInPacketGivenConnectionUUID(QByteArray& packet, const QUuid& connectionUUID,
+                                            PacketAuthenticator_t authenticator = PacketAuthenticator::MD5);
+
+/// checks the hash in the header of the packet, in place
+bool packetHashMatchesConnectionUUID(const QByteArray& packet, const QUuid& connectionUUID,
+                                     PacketAuthenticator_t authenticator = PacketAuthenticator::MD5);
 
 PacketType packetTypeForPacket(const QByteArray& packet);
 PacketType packetTypeForPacket(const char* packet);
@@ -126,6 +139,7 @@ const PacketVersion VERSION_ENTITIES_HAS_FILE_BREAKS = VERSION_ENTITIES_SUPPORT_
 const PacketVersion VERSION_ENTITIES_SUPPORT_DIMENSIONS = 4;
 const PacketVersion VERSION_ENTITIES_MODELS_HAVE_ANIMATION_SETTINGS = 5;
 const PacketVersion VERSION_ENTITIES_HAVE_USER_DATA = 6;
+const PacketVersion VERSION_ENTITIES_HAVE_SIMULATED_BY_SERVER = 7;
 const PacketVersion VERSION_OCTREE_HAS_FILE_BREAKS = 1;
 
 #endif // hifi_PacketHeaders_h
@@ -40,21 +40,29 @@ bool ReceivedPacketProcessor::process() {
     }
     preProcess();
     while (_packets.size() > 0) {
-        lock(); // lock to make sure nothing changes on us
-        NetworkPacket& packet = _packets.front(); // get the oldest packet
-        NetworkPacket temporary = packet; // make a copy of the packet in case the vector is resized on us
-        _packets.erase(_packets.begin()); // remove the oldest packet
-        if (!temporary.getNode().isNull()) {
-            _nodePacketCounts[temporary.getNode()->getUUID()]--;
+        // take all of the waiting packets at once, so that the receiving thread only waits on us once for them
+        QVector<NetworkPacket> currentPackets;
+        lock();
+        currentPackets.swap(_packets);
+        foreach (const NetworkPacket& packet, currentPackets) {
+            if (!packet.getNode().isNull()) {
+                _nodePacketCounts[packet.getNode()->getUUID()]--;
+            }
         }
         unlock(); // let others add to the packets
-        processPacket(temporary.getNode(), temporary.getByteArray()); // process our temporary copy
-        midProcess();
+        processPackets(currentPackets);
     }
     postProcess();
     return isStillRunning();  // keep running till they terminate us
 }
 
+void ReceivedPacketProcessor::processPackets(const QVector<NetworkPacket>& packets) {
+    foreach (const NetworkPacket& packet, packets) {
+        processPacket(packet.getNode(), packet.getByteArray());
+        midProcess();
+    }
+}
+
 void ReceivedPacketProcessor::nodeKilled(SharedNodePointer node) {
     lock();
     _nodePacketCounts.remove(node->getUUID());
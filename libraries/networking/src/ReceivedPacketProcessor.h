@@ -56,6 +56,10 @@ protected:
     /// \param QByteArray& the packet to be processed
     virtual void processPacket(const SharedNodePointer& sendingNode, const QByteArray& packet) = 0;
 
+    /// Processes all of the packets that were waiting when the processing thread last looked. Default processes each with
+    /// processPacket() followed by midProcess(), override to handle the packets together.
+    virtual void processPackets(const QVector<NetworkPacket>& packets);
+
     /// Implements generic processing behavior for this thread.
     virtual bool process();
 
@@ -65,7 +69,8 @@ protected:
     /// Override to do work before the packets processing loop. Default does nothing.
     virtual void preProcess() { }
 
-    /// Override to do work inside the packet processing loop after a packet is processed. Default does nothing.
+    /// Override to do work inside the packet processing loop after a packet (or a batch of them, if processPackets() is
+    /// overridden) is processed. Default does nothing.
     virtual void midProcess() { }
 
     /// Override to do work after the packets processing loop.  Default does nothing.
@@ -0,0 +1,90 @@
+//
+//  SipHash.cpp
+//  libraries/networking/src
+//
+//  Created on 3/12/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "SipHash.h"
+
+static inline quint64 rotateLeft(quint64 value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// SipHash reads its key and message as little endian words, whatever the platform
+static inline quint64 readLittleEndian(const unsigned char* bytes, int numBytes) {
+    quint64 value = 0;
+    for (int i = 0; i < numBytes; i++) {
+        value |= (quint64)bytes[i] << (8 * i);
+    }
+    return value;
+}
+
+static inline void writeLittleEndian(quint64 value, unsigned char* bytes) {
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+class SipHashState {
+public:
+    SipHashState(const unsigned char* key) {
+        quint64 k0 = readLittleEndian(key, 8);
+        quint64 k1 = readLittleEndian(key + 8, 8);
+
+        v0 = 0x736f6d6570736575ULL ^ k0;
+        v1 = 0x646f72616e646f6dULL ^ k1;
+        v2 = 0x6c7967656e657261ULL ^ k0;
+        v3 = 0x7465646279746573ULL ^ k1;
+    }
+
+    void round() {
+        v0 += v1; v1 = rotateLeft(v1, 13); v1 ^= v0; v0 = rotateLeft(v0, 32);
+        v2 += v3; v3 = rotateLeft(v3, 16); v3 ^= v2;
+        v0 += v3; v3 = rotateLeft(v3, 21); v3 ^= v0;
+        v2 += v1; v1 = rotateLeft(v1, 17); v1 ^= v2; v2 = rotateLeft(v2, 32);
+    }
+
+    void compress(quint64 word) {
+        v3 ^= word;
+        round();
+        round();
+        v0 ^= word;
+    }
+
+    quint64 finalize() {
+        round();
+        round();
+        round();
+        round();
+        return v0 ^ v1 ^ v2 ^ v3;
+    }
+
+    quint64 v0, v1, v2, v3;
+};
+
+void sipHash128(const unsigned char* key, const unsigned char* data, int length, unsigned char* output) {
+    SipHashState state(key);
+
+    // the 128 bit variant is domain separated from the 64 bit one
+    state.v1 ^= 0xee;
+
+    int numWholeWords = length / 8;
+    for (int i = 0; i < numWholeWords; i++) {
+        state.compress(readLittleEndian(data + 8 * i, 8));
+    }
+
+    // the last word holds the leftover bytes and the low byte of the length
+    quint64 lastWord = ((quint64)length << 56) | readLittleEndian(data + 8 * numWholeWords, length % 8);
+    state.compress(lastWord);
+
+    state.v2 ^= 0xee;
+    writeLittleEndian(state.finalize(), output);
+
+    state.v1 ^= 0xdd;
+    writeLittleEndian(state.finalize(), output + 8);
+}
@@ -0,0 +1,24 @@
+//
+//  SipHash.h
+//  libraries/networking/src
+//
+//  Created on 3/12/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_SipHash_h
+#define hifi_SipHash_h
+
+#include <QtCore/QtGlobal>
+
+const int NUM_BYTES_SIPHASH_KEY = 16;
+const int NUM_BYTES_SIPHASH_128 = 16;
+
+/// SipHash-2-4 with a 128 bit output (https://131002.net/siphash/), a keyed MAC that is much cheaper than a
+/// cryptographic hash for the short messages we authenticate packets with
+void sipHash128(const unsigned char* key, const unsigned char* data, int length, unsigned char* output);
+
+#endif // hifi_SipHash_h
@@ -31,7 +31,9 @@
 
 #include "CoverageMap.h"
 #include "OctreeConstants.h"
+#include "OctreeEditJournal.h"
 #include "OctreeElementBag.h"
+#include "OctreeEncodeCache.h"
 #include "Octree.h"
 #include "ViewFrustum.h"
 
@@ -46,7 +48,9 @@ Octree::Octree(bool shouldReaverage) :
     _stopImport(false),
     _lock(QReadWriteLock::Recursive),
     _isViewing(false),
-    _isServer(false)
+    _isServer(false),
+    _editJournal(NULL),
+    _isReplayingJournal(false)
 {
 }
 
@@ -193,6 +197,20 @@ bool Octree::recurseElementWithOperator(OctreeElement* element, RecurseOctreeOpe
 }
 
 
+void Octree::markPathToElementChanged(OctreeElement* element) {
+    const unsigned char* elementCode = element->getOctalCode();
+    int elementSections = numberOfThreeBitSectionsInCode(elementCode);
+
+    OctreeElement* pathElement = _rootElement;
+    while (pathElement) {
+        pathElement->markSubtreeChanged();
+        if (pathElement == element || numberOfThreeBitSectionsInCode(pathElement->getOctalCode()) >= elementSections) {
+            break;
+        }
+        pathElement = pathElement->getChildAtIndex(branchIndexWithDescendant(pathElement->getOctalCode(), elementCode));
+    }
+}
+
 OctreeElement* Octree::nodeForOctalCode(OctreeElement* ancestorElement,
                                        const unsigned char* needleCode, OctreeElement** parentOfFoundElement) const {
     // special case for NULL octcode
@@ -1133,6 +1151,46 @@ int Octree::encodeTreeBitstream(OctreeElement* element,
     return bytesWritten;
 }
 
+int Octree::encodeChildTreeBitstream(OctreeElement* childElement,
+                                     OctreePacketData* packetData, OctreeElementBag& bag,
+                                     EncodeBitstreamParams& params, int& currentEncodeLevel,
+                                     const ViewFrustum::location& parentLocationThisView) const {
+
+    OctreeEncodeCache* encodeCache = params.encodeCache;
+    bool useCache = encodeCache && encodeCache->canUseSubtree(childElement, params, parentLocationThisView)
+                        && childElement->canEncodeSubtreeFromCache(params);
+
+    if (useCache) {
+        int cachedBytes = encodeCache->appendSubtree(childElement, packetData, params);
+        if (cachedBytes > 0) {
+            childElement->subtreeEncodedFromCache(params);
+            if (params.stats) {
+                params.stats->subtreeSentFromCache(childElement, params.includeExistsBits);
+            }
+            return cachedBytes;
+        }
+    }
+
+    // track whether this subtree alone didn't fit, without losing what our earlier siblings reported
+    EncodeBitstreamParams::reason previousStopReason = params.stopReason;
+    params.stopReason = EncodeBitstreamParams::UNKNOWN;
+
+    int subtreeStart = packetData->getUncompressedByteOffset();
+    int bytesWritten = encodeTreeBitstreamRecursion(childElement, packetData, bag, params,
+                                                    currentEncodeLevel, parentLocationThisView);
+
+    // only a subtree that was sent in full is the same for every client
+    if (useCache && bytesWritten > 0 && params.stopReason != EncodeBitstreamParams::DIDNT_FIT
+            && packetData->getUncompressedByteOffset() - subtreeStart == bytesWritten) {
+        encodeCache->cacheSubtree(childElement, params, packetData->getUncompressedData(subtreeStart), bytesWritten);
+    }
+
+    if (params.stopReason == EncodeBitstreamParams::UNKNOWN) {
+        params.stopReason = previousStopReason;
+    }
+    return bytesWritten;
+}
+
 int Octree::encodeTreeBitstreamRecursion(OctreeElement* element,
                                             OctreePacketData* packetData, OctreeElementBag& bag,
                                             EncodeBitstreamParams& params, int& currentEncodeLevel,
@@ -1331,6 +1389,20 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* element,
     int indexOfChildren[NUMBER_OF_CHILDREN] = { 0, 0, 0, 0, 0, 0, 0, 0 };
     int currentCount = 0;
 
+    // where the children are in the view, and how far, all found at once rather than child by child - the furthest
+    // distances are what the LOD check goes by, so they're needed even when the children are all in view
+    AACube elementCube = element->getAACube();
+    elementCube.scale(TREE_SCALE);
+    ViewFrustum::location childLocations[NUMBER_OF_CHILDREN];
+    float childDistances[NUMBER_OF_CHILDREN];
+    float childFurthestDistances[NUMBER_OF_CHILDREN];
+    if (params.viewFrustum && !element->isLeaf()) {
+        params.viewFrustum->childCubesInFrustum(elementCube, childLocations, childDistances, childFurthestDistances);
+    }
+    ViewFrustum::location lastChildLocations[NUMBER_OF_CHILDREN];
+    float lastChildDistances[NUMBER_OF_CHILDREN];
+    bool haveLastChildLocations = false;
+
     for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
         OctreeElement* childElement = element->getChildAtIndex(i);
 
@@ -1350,7 +1422,7 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* element,
 
         if (params.wantOcclusionCulling) {
             if (childElement) {
-                float distance = params.viewFrustum ? childElement->distanceToCamera(*params.viewFrustum) : 0;
+                float distance = params.viewFrustum ? childDistances[i] : 0;
 
                 currentCount = insertIntoSortedArrays((void*)childElement, distance, i,
                                                       (void**)&sortedChildren, (float*)&distancesToChildren,
@@ -1380,7 +1452,7 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* element,
                 ( !params.viewFrustum || // no view frustum was given, everything is assumed in view
                   (nodeLocationThisView == ViewFrustum::INSIDE) || // parent was fully in view, we can assume ALL children are
                   (nodeLocationThisView == ViewFrustum::INTERSECT && 
-                        childElement->isInView(*params.viewFrustum)) // the parent intersects and the child is in view
+                        childLocations[originalIndex] != ViewFrustum::OUTSIDE) // the parent intersects and the child is in view
                 ));
 
         if (!childIsInView) {
@@ -1446,7 +1518,7 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* element,
 
                 bool shouldRender = !params.viewFrustum
                                     ? true
-                                    : childElement->calculateShouldRender(params.viewFrustum,
+                                    : childElement->calculateShouldRender(childFurthestDistances[originalIndex],
                                                     params.octreeElementSizeScale, params.boundaryLevelAdjust);
 
                 // track some stats
@@ -1466,7 +1538,11 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* element,
                     bool childWasInView = false;
 
                     if (childElement && params.deltaViewFrustum && params.lastViewFrustum) {
-                        ViewFrustum::location location = childElement->inFrustum(*params.lastViewFrustum);
+                        if (!haveLastChildLocations) {
+                            params.lastViewFrustum->childCubesInFrustum(elementCube, lastChildLocations, lastChildDistances);
+                            haveLastChildLocations = true;
+                        }
+                        ViewFrustum::location location = lastChildLocations[originalIndex];
 
                         // If we're a leaf, then either intersect or inside is considered "formerly in view"
                         if (childElement->isLeaf()) {
@@ -1698,8 +1774,8 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* element,
                     // Allow the datatype a chance to determine if it really wants to recurse this tree. Usually this
                     // will be true. But if the tree has already been encoded, we will skip this.
                     if (element->shouldRecurseChildTree(originalIndex, params)) {
-                        childTreeBytesOut = encodeTreeBitstreamRecursion(childElement, packetData, bag, params,
-                                                                                thisLevel, nodeLocationThisView);
+                        childTreeBytesOut = encodeChildTreeBitstream(childElement, packetData, bag, params,
+                                                                     thisLevel, nodeLocationThisView);
                     } else {
                         childTreeBytesOut = 0;
                     }
@@ -2043,86 +2119,104 @@ bool Octree::readFromSVOFile(const char* fileName) {
     return fileOk;
 }
 
-void Octree::writeToSVOFile(const char* fileName, OctreeElement* element) {
-    std::ofstream file(fileName, std::ios::out|std::ios::binary);
+void Octree::writeToSVOBuffer(QByteArray& buffer, OctreeElement* element) {
+    PacketType expectedType = expectedDataPacketType();
+    PacketVersion expectedVersion = versionForPacketType(expectedType);
+    bool hasBufferBreaks = versionHasSVOfileBreaks(expectedVersion);
 
-    if(file.is_open()) {
-        qDebug("Saving to file %s...", fileName);
+    // before reading the file, check to see if this version of the Octree supports file versions
+    if (getWantSVOfileVersions()) {
+        // if so, read the first byte of the file and see if it matches the expected version code
+        buffer.append(reinterpret_cast<const char*>(&expectedType), sizeof(expectedType));
+        buffer.append(reinterpret_cast<const char*>(&expectedVersion), sizeof(expectedVersion));
+        qDebug() << "SVO file type: " << nameForPacketType(expectedType) << " version: " << (int)expectedVersion;
 
-        PacketType expectedType = expectedDataPacketType();
-        PacketVersion expectedVersion = versionForPacketType(expectedType);
-        bool hasBufferBreaks = versionHasSVOfileBreaks(expectedVersion);
-
-        // before reading the file, check to see if this version of the Octree supports file versions
-        if (getWantSVOfileVersions()) {
-            // if so, read the first byte of the file and see if it matches the expected version code
-            file.write(reinterpret_cast<char*>(&expectedType), sizeof(expectedType));
-            file.write(&expectedVersion, sizeof(expectedVersion));
-            qDebug() << "SVO file type: " << nameForPacketType(expectedType) << " version: " << (int)expectedVersion;
+        hasBufferBreaks = versionHasSVOfileBreaks(expectedVersion);
+    }
+    if (hasBufferBreaks) {
+        qDebug() << "    this version includes buffer breaks";
+    } else {
+        qDebug() << "    this version does not include buffer breaks";
+    }
+    
 
-            hasBufferBreaks = versionHasSVOfileBreaks(expectedVersion);
-        }
-        if (hasBufferBreaks) {
-            qDebug() << "    this version includes buffer breaks";
-        } else {
-            qDebug() << "    this version does not include buffer breaks";
-        }
-        
+    OctreeElementBag elementBag;
+    OctreeElementExtraEncodeData extraEncodeData;
+    // If we were given a specific element, start from there, otherwise start from root
+    if (element) {
+        elementBag.insert(element);
+    } else {
+        elementBag.insert(_rootElement);
+    }
 
-        OctreeElementBag elementBag;
-        OctreeElementExtraEncodeData extraEncodeData;
-        // If we were given a specific element, start from there, otherwise start from root
-        if (element) {
-            elementBag.insert(element);
-        } else {
-            elementBag.insert(_rootElement);
-        }
+    OctreePacketData packetData;
+    int bytesWritten = 0;
+    bool lastPacketWritten = false;
 
-        OctreePacketData packetData;
-        int bytesWritten = 0;
-        bool lastPacketWritten = false;
+    while (!elementBag.isEmpty()) {
+        OctreeElement* subTree = elementBag.extract();
+        
+        lockForRead(); // do tree locking down here so that we have shorter slices and less thread contention
+        EncodeBitstreamParams params(INT_MAX, IGNORE_VIEW_FRUSTUM, WANT_COLOR, NO_EXISTS_BITS);
+        params.extraEncodeData = &extraEncodeData;
+        bytesWritten = encodeTreeBitstream(subTree, &packetData, elementBag, params);
+        unlock();
 
-        while (!elementBag.isEmpty()) {
-            OctreeElement* subTree = elementBag.extract();
-            
-            lockForRead(); // do tree locking down here so that we have shorter slices and less thread contention
-            EncodeBitstreamParams params(INT_MAX, IGNORE_VIEW_FRUSTUM, WANT_COLOR, NO_EXISTS_BITS);
-            params.extraEncodeData = &extraEncodeData;
-            bytesWritten = encodeTreeBitstream(subTree, &packetData, elementBag, params);
-            unlock();
-
-            // if the subTree couldn't fit, and so we should reset the packet and reinsert the element in our bag and try again
-            if (bytesWritten == 0 && (params.stopReason == EncodeBitstreamParams::DIDNT_FIT)) {
-                if (packetData.hasContent()) {
-                    // if this type of SVO file should have buffer breaks, then we will write a buffer size before each
-                    // buffer to allow the reader to read this file in chunks.
-                    if (hasBufferBreaks) {
-                        quint16 bufferSize = packetData.getFinalizedSize();
-                        file.write((const char*)&bufferSize, sizeof(bufferSize));
-                    }
-                    file.write((const char*)packetData.getFinalizedData(), packetData.getFinalizedSize());
-                    lastPacketWritten = true;
+        // if the subTree couldn't fit, and so we should reset the packet and reinsert the element in our bag and try again
+        if (bytesWritten == 0 && (params.stopReason == EncodeBitstreamParams::DIDNT_FIT)) {
+            if (packetData.hasContent()) {
+                // if this type of SVO file should have buffer breaks, then we will write a buffer size before each
+                // buffer to allow the reader to read this file in chunks.
+                if (hasBufferBreaks) {
+                    quint16 bufferSize = packetData.getFinalizedSize();
+                    buffer.append((const char*)&bufferSize, sizeof(bufferSize));
                 }
-                packetData.reset(); // is there a better way to do this? could we fit more?
-                elementBag.insert(subTree);
-            } else {
-                lastPacketWritten = false;
+                buffer.append((const char*)packetData.getFinalizedData(), packetData.getFinalizedSize());
+                lastPacketWritten = true;
             }
+            packetData.reset(); // is there a better way to do this? could we fit more?
+            elementBag.insert(subTree);
+        } else {
+            lastPacketWritten = false;
         }
+    }
 
-        if (!lastPacketWritten) {
-            // if this type of SVO file should have buffer breaks, then we will write a buffer size before each
-            // buffer to allow the reader to read this file in chunks.
-            if (hasBufferBreaks) {
-                quint16 bufferSize = packetData.getFinalizedSize();
-                file.write((const char*)&bufferSize, sizeof(bufferSize));
-            }
-            file.write((const char*)packetData.getFinalizedData(), packetData.getFinalizedSize());
+    if (!lastPacketWritten) {
+        // if this type of SVO file should have buffer breaks, then we will write a buffer size before each
+        // buffer to allow the reader to read this file in chunks.
+        if (hasBufferBreaks) {
+            quint16 bufferSize = packetData.getFinalizedSize();
+            buffer.append((const char*)&bufferSize, sizeof(bufferSize));
         }
-        
-        releaseSceneEncodeData(&extraEncodeData);
+        buffer.append((const char*)packetData.getFinalizedData(), packetData.getFinalizedSize());
     }
+    
+    releaseSceneEncodeData(&extraEncodeData);
+}
+
+bool Octree::writeToSVOFile(const char* fileName, OctreeElement* element) {
+    QByteArray buffer;
+    writeToSVOBuffer(buffer, element);
+    return writeSVOBufferToFile(fileName, buffer);
+}
+
+bool Octree::writeSVOBufferToFile(const char* fileName, const QByteArray& buffer) {
+    std::ofstream file(fileName, std::ios::out|std::ios::binary);
+    if (!file.is_open()) {
+        qDebug("ERROR opening %s to save to", fileName);
+        return false;
+    }
+
+    qDebug("Saving to file %s...", fileName);
+    file.write(buffer.constData(), buffer.size());
     file.close();
+
+    // the stream's state covers the write and the flush on close
+    if (!file) {
+        qDebug("ERROR writing to %s", fileName);
+        return false;
+    }
+    return true;
 }
 
 unsigned long Octree::getOctreeElementsCount() {
@@ -2192,3 +2286,22 @@ void Octree::cancelImport() {
     _stopImport = true;
 }
 
+void Octree::journalEdit(PacketType packetType, const unsigned char* editData, int length, const QUuid& assignedID) {
+    // edits being replayed are already in the journal
+    if (_editJournal && !_isReplayingJournal) {
+        _editJournal->append(packetType, editData, length, assignedID);
+    }
+}
+
+int Octree::replayJournaledEdit(PacketType packetType, const unsigned char* editData, int length, const QUuid& assignedID) {
+    _isReplayingJournal = true;
+    _replayAssignedID = assignedID;
+
+    // the edit is replayed as if it were the only edit in a packet from no one in particular
+    int bytesRead = processEditPacketData(packetType, editData, length, editData, length, SharedNodePointer());
+
+    _isReplayingJournal = false;
+    _replayAssignedID = QUuid();
+    return bytesRead;
+}
+
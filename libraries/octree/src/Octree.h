@@ -19,7 +19,9 @@ class CoverageMap;
 class ReadBitstreamToTreeParams;
 class Octree;
 class OctreeElement;
+class OctreeEditJournal;
 class OctreeElementBag;
+class OctreeEncodeCache;
 class OctreePacketData;
 class Shape;
 
@@ -86,6 +88,8 @@ public:
     CoverageMap* map;
     JurisdictionMap* jurisdictionMap;
     OctreeElementExtraEncodeData* extraEncodeData;
+    OctreeEncodeCache* encodeCache; // if set, subtrees that every client would encode the same way come from here
+    OctreeSentItems* sentItems; // if set, the items the client has, kept up to date by the encode
 
     // output hints from the encode process
     typedef enum {
@@ -136,6 +140,8 @@ public:
             map(map),
             jurisdictionMap(jurisdictionMap),
             extraEncodeData(extraEncodeData),
+            encodeCache(NULL),
+            sentItems(NULL),
             stopReason(UNKNOWN)
     {}
 
@@ -230,6 +236,20 @@ public:
     virtual bool handlesEditPacketType(PacketType packetType) const { return false; }
     virtual int processEditPacketData(PacketType packetType, const unsigned char* packetData, int packetLength,
                     const unsigned char* editData, int maxLength, const SharedNodePointer& sourceNode) { return 0; }
+
+    // The OctreeServer processes inbound edits in batches under a single write lock, calling these around each batch. A
+    // tree may hold back the edits it's given until endEditBatch() so that repeated edits to the same item apply once.
+    virtual void beginEditBatch() { }
+    virtual void endEditBatch() { }
+
+    // Edit journaling, trees that process edits record each one they apply with journalEdit() so that a persisted tree
+    // can replay its edits since the last snapshot. assignedID is the ID the tree gave whatever the edit created.
+    void setEditJournal(OctreeEditJournal* editJournal) { _editJournal = editJournal; }
+    OctreeEditJournal* getEditJournal() const { return _editJournal; }
+    void journalEdit(PacketType packetType, const unsigned char* editData, int length, const QUuid& assignedID = QUuid());
+    int replayJournaledEdit(PacketType packetType, const unsigned char* editData, int length, const QUuid& assignedID);
+    bool isReplayingJournal() const { return _isReplayingJournal; }
+    const QUuid& getReplayAssignedID() const { return _replayAssignedID; }
                     
     virtual bool recurseChildrenWithData() const { return true; }
     virtual bool rootElementHasData() const { return false; }
@@ -267,6 +287,10 @@ public:
     OctreeElement* getOrCreateChildElementAt(float x, float y, float z, float s);
     OctreeElement* getOrCreateChildElementContaining(const AACube& box);
 
+    /// marks the subtrees of element and every element above it as changed, for changes made to element's contents without
+    /// an operator walking down to it
+    void markPathToElementChanged(OctreeElement* element);
+
     void recurseTreeWithOperation(RecurseOctreeOperation operation, void* extraData = NULL);
     void recurseTreeWithPostOperation(RecurseOctreeOperation operation, void* extraData = NULL);
 
@@ -320,7 +344,12 @@ public:
     void loadOctreeFile(const char* fileName, bool wantColorRandomizer);
 
     // these will read/write files that match the wireformat, excluding the 'V' leading
-    void writeToSVOFile(const char* filename, OctreeElement* element = NULL);
+    /// \return false if the file couldn't be opened or written in full
+    bool writeToSVOFile(const char* filename, OctreeElement* element = NULL);
+
+    /// encodes what writeToSVOFile would write into buffer, so that it can be written without holding the tree's lock
+    void writeToSVOBuffer(QByteArray& buffer, OctreeElement* element = NULL);
+    static bool writeSVOBufferToFile(const char* filename, const QByteArray& buffer);
     bool readFromSVOFile(const char* filename);
     
 
@@ -372,6 +401,12 @@ protected:
                                      EncodeBitstreamParams& params, int& currentEncodeLevel,
                                      const ViewFrustum::location& parentLocationThisView) const;
 
+    /// encodes the subtree below a child element, from the params' encode cache when it has a usable copy of it
+    int encodeChildTreeBitstream(OctreeElement* childElement,
+                                 OctreePacketData* packetData, OctreeElementBag& bag,
+                                 EncodeBitstreamParams& params, int& currentEncodeLevel,
+                                 const ViewFrustum::location& parentLocationThisView) const;
+
     static bool countOctreeElementsOperation(OctreeElement* element, void* extraData);
 
     OctreeElement* nodeForOctalCode(OctreeElement* ancestorElement, const unsigned char* needleCode, OctreeElement** parentOfFoundElement) const;
@@ -389,6 +424,10 @@ protected:
     
     bool _isViewing; 
     bool _isServer;
+
+    OctreeEditJournal* _editJournal;
+    bool _isReplayingJournal;
+    QUuid _replayAssignedID;
 };
 
 float boundaryDistanceForRenderLevel(unsigned int renderLevel, float voxelSizeScale);
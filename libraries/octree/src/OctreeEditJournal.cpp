@@ -0,0 +1,187 @@
+//
+//  OctreeEditJournal.cpp
+//  libraries/octree/src
+//
+//  Created on 3/11/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <limits>
+
+#include <QtCore/QDebug>
+#include <QtCore/QSaveFile>
+
+#include "Octree.h"
+
+#include "OctreeEditJournal.h"
+
+// each record is the edit's packet type and version, the length of the edit, the assigned ID and then the edit itself
+const int JOURNAL_RECORD_HEADER_BYTES = sizeof(quint8) + sizeof(PacketVersion) + sizeof(quint16) + NUM_BYTES_RFC4122_UUID;
+
+OctreeEditJournal::OctreeEditJournal(const QString& filename) :
+    _filename(filename),
+    _file(filename),
+    _recordsAppended(0)
+{
+
+}
+
+OctreeEditJournal::~OctreeEditJournal() {
+    close();
+}
+
+int OctreeEditJournal::replay(Octree* tree) {
+    QFile file(_filename);
+    if (!file.exists()) {
+        return 0;
+    }
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "ERROR: could not open octree edit journal" << _filename << "for replay:" << file.errorString();
+        return 0;
+    }
+
+    QByteArray journal = file.readAll();
+    file.close();
+
+    const unsigned char* dataAt = reinterpret_cast<const unsigned char*>(journal.constData());
+    int bytesLeft = journal.size();
+    int editsReplayed = 0;
+    int editsSkipped = 0;
+
+    while (bytesLeft >= JOURNAL_RECORD_HEADER_BYTES) {
+        PacketType packetType = (PacketType)dataAt[0];
+        PacketVersion packetVersion = (PacketVersion)dataAt[sizeof(quint8)];
+
+        quint16 length;
+        memcpy(&length, dataAt + sizeof(quint8) + sizeof(PacketVersion), sizeof(length));
+
+        if (bytesLeft < JOURNAL_RECORD_HEADER_BYTES + length) {
+            // we crashed while this record was being written, so it never made it to the tree either
+            qDebug() << "Octree edit journal" << _filename << "ends in a partial record, ignoring it.";
+            break;
+        }
+
+        const char* encodedID = reinterpret_cast<const char*>(dataAt + JOURNAL_RECORD_HEADER_BYTES - NUM_BYTES_RFC4122_UUID);
+        QUuid assignedID = QUuid::fromRfc4122(QByteArray::fromRawData(encodedID, NUM_BYTES_RFC4122_UUID));
+        const unsigned char* editData = dataAt + JOURNAL_RECORD_HEADER_BYTES;
+
+        if (packetVersion == versionForPacketType(packetType) && tree->handlesEditPacketType(packetType)) {
+            tree->replayJournaledEdit(packetType, editData, length, assignedID);
+            editsReplayed++;
+        } else {
+            editsSkipped++;
+        }
+
+        dataAt += JOURNAL_RECORD_HEADER_BYTES + length;
+        bytesLeft -= JOURNAL_RECORD_HEADER_BYTES + length;
+    }
+
+    if (editsSkipped > 0) {
+        qDebug() << "Octree edit journal" << _filename << "skipped" << editsSkipped << "edits of an unsupported version.";
+    }
+    return editsReplayed;
+}
+
+bool OctreeEditJournal::open() {
+    QMutexLocker locker(&_mutex);
+    if (_file.isOpen()) {
+        return true;
+    }
+
+    if (!_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qDebug() << "ERROR: could not open octree edit journal" << _filename << ":" << _file.errorString();
+        return false;
+    }
+    return true;
+}
+
+void OctreeEditJournal::close() {
+    QMutexLocker locker(&_mutex);
+    if (_file.isOpen()) {
+        _file.close();
+    }
+}
+
+void OctreeEditJournal::append(PacketType packetType, const unsigned char* editData, int length,
+                               const QUuid& assignedID) {
+    if (length <= 0 || length > std::numeric_limits<quint16>::max()) {
+        return;
+    }
+
+    QByteArray record;
+    record.reserve(JOURNAL_RECORD_HEADER_BYTES + length);
+    record.append((char)(quint8)packetType);
+    record.append(versionForPacketType(packetType));
+
+    quint16 editLength = length;
+    record.append(reinterpret_cast<const char*>(&editLength), sizeof(editLength));
+    record.append(assignedID.toRfc4122());
+    record.append(reinterpret_cast<const char*>(editData), length);
+
+    QMutexLocker locker(&_mutex);
+    if (!_file.isOpen()) {
+        return;
+    }
+
+    // flush each record so that an edit is in the journal once the server has applied it, even if we crash right after
+    if (_file.write(record) != record.size() || !_file.flush()) {
+        qDebug() << "ERROR: could not write to octree edit journal" << _filename << ":" << _file.errorString();
+        return;
+    }
+    _recordsAppended++;
+}
+
+void OctreeEditJournal::truncate() {
+    QMutexLocker locker(&_mutex);
+    if (_file.isOpen()) {
+        _file.resize(0);
+    } else {
+        QFile::resize(_filename, 0);
+    }
+}
+
+bool OctreeEditJournal::discardFirstBytes(qint64 size) {
+    QMutexLocker locker(&_mutex);
+    qint64 journalSize = _file.isOpen() ? _file.size() : QFile(_filename).size();
+    if (size >= journalSize) {
+        // nothing was appended since, which is the usual case
+        if (_file.isOpen()) {
+            return _file.resize(0);
+        }
+        return QFile::resize(_filename, 0);
+    }
+
+    QFile file(_filename);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(size)) {
+        qDebug() << "ERROR: could not read octree edit journal" << _filename << ":" << file.errorString();
+        return false;
+    }
+    QByteArray laterRecords = file.readAll();
+    file.close();
+
+    // the records that are kept replace the journal in one step, so that a crash leaves either journal whole
+    QSaveFile newJournal(_filename);
+    if (!newJournal.open(QIODevice::WriteOnly) || newJournal.write(laterRecords) != laterRecords.size()
+            || !newJournal.commit()) {
+        qDebug() << "ERROR: could not rewrite octree edit journal" << _filename << ":" << newJournal.errorString();
+        return false;
+    }
+
+    // and we carry on appending to the new file
+    if (_file.isOpen()) {
+        _file.close();
+        if (!_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            qDebug() << "ERROR: could not reopen octree edit journal" << _filename << ":" << _file.errorString();
+        }
+    }
+    return true;
+}
+
+qint64 OctreeEditJournal::getSize() {
+    QMutexLocker locker(&_mutex);
+    return _file.isOpen() ? _file.size() : QFile(_filename).size();
+}
@@ -0,0 +1,64 @@
+//
+//  OctreeEditJournal.h
+//  libraries/octree/src
+//
+//  Created on 3/11/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreeEditJournal_h
+#define hifi_OctreeEditJournal_h
+
+#include <QtCore/QFile>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QUuid>
+
+#include <PacketHeaders.h>
+
+class Octree;
+
+/// Append-only log of the edits applied to a persisted octree since its last snapshot. Each record holds an edit as
+/// the tree read it from an edit packet, plus the ID the tree assigned if the edit created something, so that
+/// replaying the journal on top of the snapshot recreates the same tree. Replayed edits must be idempotent, since a
+/// crash between writing a snapshot and truncating the journal replays edits the snapshot already has.
+class OctreeEditJournal {
+public:
+    OctreeEditJournal(const QString& filename);
+    ~OctreeEditJournal();
+
+    const QString& getFilename() const { return _filename; }
+
+    /// applies the journaled edits to the tree, the caller must hold the tree's write lock
+    /// \return the number of edits replayed
+    int replay(Octree* tree);
+
+    /// opens the journal to append to it, keeping any records already in it
+    bool open();
+    void close();
+
+    /// appends an edit record and flushes it to the file
+    void append(PacketType packetType, const unsigned char* editData, int length, const QUuid& assignedID);
+
+    /// discards all records, call once a snapshot that includes them has been written
+    void truncate();
+
+    /// discards the records in the first size bytes of the journal, for a snapshot that was taken when the journal was
+    /// that size - the records appended since are kept
+    /// \return false if the journal couldn't be rewritten, in which case it is left as it was
+    bool discardFirstBytes(qint64 size);
+
+    quint64 getRecordsAppended() const { return _recordsAppended; }
+    qint64 getSize();
+
+private:
+    QString _filename;
+    QMutex _mutex;
+    QFile _file;
+    quint64 _recordsAppended;
+};
+
+#endif // hifi_OctreeEditJournal_h
@@ -17,6 +17,10 @@
 #include <QtCore/QDebug>
 
 #include <LogHandler.h>
+#include <QMap>
+#include <QMutex>
+#include <QSet>
+
 #include <NodeList.h>
 #include <PerfStat.h>
 #include <AACubeShape.h>
@@ -35,6 +39,9 @@ quint64 OctreeElement::_externalChildrenMemoryUsage = 0;
 quint64 OctreeElement::_voxelNodeCount = 0;
 quint64 OctreeElement::_voxelNodeLeafCount = 0;
 
+// octal codes are at most 255 sections deep, so no subtree is this tall
+const unsigned char UNKNOWN_SUBTREE_HEIGHT = 255;
+
 void OctreeElement::resetPopulationStatistics() {
     _voxelNodeCount = 0;
     _voxelNodeLeafCount = 0;
@@ -69,6 +76,8 @@ void OctreeElement::init(unsigned char * octalCode) {
     // set up the _children union
     _childBitmask = 0;
     _childrenExternal = false;
+    _childrenLinear = _linearChildren;
+    _subtreeHeight = UNKNOWN_SUBTREE_HEIGHT;
     
     
 #ifdef BLENDED_UNION_CHILDREN
@@ -119,9 +128,37 @@ OctreeElement::~OctreeElement() {
 
 void OctreeElement::markWithChangedTime() {
     _lastChanged = usecTimestampNow();
+    markSubtreeChanged();
     notifyUpdateHooks(); // if the node has changed, notify our hooks
 }
 
+void OctreeElement::markSubtreeChanged() {
+    // this element's stamp is only changed with its tree locked for writing, but the next stamp is taken by other trees
+    // under their own locks
+    _subtreeChangeStamp = ++_nextSubtreeChangeStamp;
+    _subtreeHeight = UNKNOWN_SUBTREE_HEIGHT;
+}
+
+int OctreeElement::getSubtreeHeight() const {
+    // only the children marked changed since they were last asked are walked again. Threads that find the height
+    // unknown at once each work out the same one, so which store lands doesn't matter
+    unsigned char subtreeHeight = _subtreeHeight.load(std::memory_order_relaxed);
+    if (subtreeHeight == UNKNOWN_SUBTREE_HEIGHT) {
+        int height = 0;
+        if (!isLeaf()) {
+            for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+                OctreeElement* child = getChildAtIndex(i);
+                if (child) {
+                    height = qMax(height, child->getSubtreeHeight() + 1);
+                }
+            }
+        }
+        subtreeHeight = height;
+        _subtreeHeight.store(subtreeHeight, std::memory_order_relaxed);
+    }
+    return subtreeHeight;
+}
+
 // This method is called by Octree when the subtree below this node
 // is known to have changed. It's intended to be used as a place to do
 // bookkeeping that a node may need to do when the subtree below it has
@@ -312,12 +349,107 @@ quint64 OctreeElement::_couldNotStoreFourChildrenInternally = 0;
 quint64 OctreeElement::_externalChildrenCount = 0;
 quint64 OctreeElement::_childrenCount[NUMBER_OF_CHILDREN + 1] = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
+bool OctreeElement::_linearChildren = false;
+
+std::atomic<quint64> OctreeElement::_nextSubtreeChangeStamp(0);
+
+#ifdef SIMPLE_EXTERNAL_CHILDREN
+// the blocks of linear children are made this many at a time, side by side
+const int CHILD_BLOCKS_PER_SLAB = 1024;
+
+class ChildBlockSlab {
+public:
+    OctreeElement** blocks;
+    OctreeElement** freeBlocks; // the first slot of a free block points to the next free block of the slab
+    int numFreeBlocks;
+};
+
+static QMutex childBlocksMutex;
+static QMap<OctreeElement**, ChildBlockSlab*> childBlockSlabs; // by the address of their first block
+static QSet<ChildBlockSlab*> childBlockSlabsWithFreeBlocks;
+static ChildBlockSlab* currentChildBlockSlab = NULL; // the slab blocks come from while it has any, to keep them together
+
+OctreeElement** OctreeElement::allocateChildBlock() {
+    QMutexLocker locker(&childBlocksMutex);
+    if (!currentChildBlockSlab) {
+        if (!childBlockSlabsWithFreeBlocks.isEmpty()) {
+            currentChildBlockSlab = *childBlockSlabsWithFreeBlocks.constBegin();
+
+        } else {
+            ChildBlockSlab* slab = new ChildBlockSlab();
+            slab->blocks = new OctreeElement*[CHILD_BLOCKS_PER_SLAB * NUMBER_OF_CHILDREN];
+            slab->freeBlocks = NULL;
+            for (int i = CHILD_BLOCKS_PER_SLAB - 1; i >= 0; i--) {
+                OctreeElement** block = slab->blocks + i * NUMBER_OF_CHILDREN;
+                *reinterpret_cast<OctreeElement***>(block) = slab->freeBlocks;
+                slab->freeBlocks = block;
+            }
+            slab->numFreeBlocks = CHILD_BLOCKS_PER_SLAB;
+            childBlockSlabs.insert(slab->blocks, slab);
+            childBlockSlabsWithFreeBlocks.insert(slab);
+            currentChildBlockSlab = slab;
+        }
+    }
+    ChildBlockSlab* slab = currentChildBlockSlab;
+    OctreeElement** block = slab->freeBlocks;
+    slab->freeBlocks = *reinterpret_cast<OctreeElement***>(block);
+    if (--slab->numFreeBlocks == 0) {
+        childBlockSlabsWithFreeBlocks.remove(slab);
+        currentChildBlockSlab = NULL;
+    }
+    memset(block, 0, sizeof(OctreeElement*) * NUMBER_OF_CHILDREN);
+    _externalChildrenMemoryUsage += NUMBER_OF_CHILDREN * sizeof(OctreeElement*);
+    return block;
+}
+
+void OctreeElement::freeChildBlock(OctreeElement** block) {
+    QMutexLocker locker(&childBlocksMutex);
+
+    // the block's slab is the last to start at or before it
+    QMap<OctreeElement**, ChildBlockSlab*>::iterator slabIterator = childBlockSlabs.upperBound(block);
+    --slabIterator;
+    ChildBlockSlab* slab = slabIterator.value();
+
+    *reinterpret_cast<OctreeElement***>(block) = slab->freeBlocks;
+    slab->freeBlocks = block;
+    if (slab->numFreeBlocks++ == 0) {
+        childBlockSlabsWithFreeBlocks.insert(slab);
+    }
+    _externalChildrenMemoryUsage -= NUMBER_OF_CHILDREN * sizeof(OctreeElement*);
+
+    // a slab nobody uses goes back to the heap, unless it's the only one with room, which keeps a tree that grows and
+    // shrinks around a slab boundary from making and freeing the same slab over and over
+    if (slab->numFreeBlocks == CHILD_BLOCKS_PER_SLAB && childBlockSlabsWithFreeBlocks.size() > 1) {
+        childBlockSlabs.erase(slabIterator);
+        childBlockSlabsWithFreeBlocks.remove(slab);
+        if (currentChildBlockSlab == slab) {
+            currentChildBlockSlab = NULL;
+        }
+        delete[] slab->blocks;
+        delete slab;
+    }
+}
+
+int OctreeElement::getChildBlockSlabCount() {
+    QMutexLocker locker(&childBlocksMutex);
+    return childBlockSlabs.size();
+}
+#else
+int OctreeElement::getChildBlockSlabCount() {
+    return 0;
+}
+#endif // def SIMPLE_EXTERNAL_CHILDREN
+
 OctreeElement* OctreeElement::getChildAtIndex(int childIndex) const {
 #ifdef SIMPLE_CHILD_ARRAY
     return _simpleChildArray[childIndex];
 #endif // SIMPLE_CHILD_ARRAY
 
 #ifdef SIMPLE_EXTERNAL_CHILDREN
+    if (_childrenLinear) {
+        return _children.external ? _children.external[childIndex] : NULL;
+    }
+
     int childCount = getChildCount();
 
     switch (childCount) {
@@ -665,7 +797,15 @@ void OctreeElement::deleteAllChildren() {
     
     if (_childrenExternal) {
         // if the children_t union represents _children.external we need to delete it here
+#ifdef SIMPLE_EXTERNAL_CHILDREN
+        if (_childrenLinear) {
+            freeChildBlock(_children.external);
+        } else {
+            delete[] _children.external;
+        }
+#else
         delete[] _children.external;
+#endif
     }
 
 #ifdef BLENDED_UNION_CHILDREN
@@ -716,6 +856,8 @@ void OctreeElement::deleteAllChildren() {
 }
 
 void OctreeElement::setChildAtIndex(int childIndex, OctreeElement* child) {
+    _subtreeHeight = UNKNOWN_SUBTREE_HEIGHT;
+    
 #ifdef SIMPLE_CHILD_ARRAY
     int previousChildCount = getChildCount();
     if (child) {
@@ -754,7 +896,22 @@ void OctreeElement::setChildAtIndex(int childIndex, OctreeElement* child) {
         _childrenCount[newChildCount]++;
     }
 
-    if ((previousChildCount == 0 || previousChildCount == 1) && newChildCount == 0) {
+    if (_childrenLinear) {
+        // the block is there from the first child to the last
+        if (newChildCount == 0) {
+            if (_children.external) {
+                freeChildBlock(_children.external);
+                _children.external = NULL;
+                _childrenExternal = false;
+            }
+        } else {
+            if (!_children.external) {
+                _children.external = allocateChildBlock();
+                _childrenExternal = true;
+            }
+            _children.external[childIndex] = child;
+        }
+    } else if ((previousChildCount == 0 || previousChildCount == 1) && newChildCount == 0) {
         _children.single = NULL;
     } else if (previousChildCount == 0 && newChildCount == 1) {
         _children.single = child;
@@ -1237,10 +1394,13 @@ ViewFrustum::location OctreeElement::inFrustum(const ViewFrustum& viewFrustum) c
 //    corner. We can use we can use this corner as our "voxel position" to do our distance calculations off of.
 //    By doing this, we don't need to test each child voxel's position vs the LOD boundary
 bool OctreeElement::calculateShouldRender(const ViewFrustum* viewFrustum, float voxelScaleSize, int boundaryLevelAdjust) const {
+    return hasContent() && calculateShouldRender(furthestDistanceToCamera(*viewFrustum), voxelScaleSize, boundaryLevelAdjust);
+}
+
+bool OctreeElement::calculateShouldRender(float furthestDistance, float voxelScaleSize, int boundaryLevelAdjust) const {
     bool shouldRender = false;
     
     if (hasContent()) {
-        float furthestDistance = furthestDistanceToCamera(*viewFrustum);
         float childBoundary = boundaryDistanceForRenderLevel(getLevel() + 1 + boundaryLevelAdjust, voxelScaleSize);
         bool inChildBoundary = (furthestDistance <= childBoundary);
         if (hasDetailedContent() && inChildBoundary) {
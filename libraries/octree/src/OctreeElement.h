@@ -16,6 +16,8 @@
 //#define SIMPLE_CHILD_ARRAY
 #define SIMPLE_EXTERNAL_CHILDREN
 
+#include <atomic>
+
 #include <QReadWriteLock>
 
 #include <OctalCode.h>
@@ -99,6 +101,13 @@ public:
     virtual void updateEncodedData(int childIndex, AppendState childAppendState, EncodeBitstreamParams& params) const { }
     virtual void elementEncodeComplete(EncodeBitstreamParams& params, OctreeElementBag* bag) const { }
 
+    /// Override to return false if an earlier pass of this scene already encoded part of the subtree below this element,
+    /// in which case a cached encoding of the whole subtree can't be used in its place
+    virtual bool canEncodeSubtreeFromCache(EncodeBitstreamParams& params) const { return true; }
+
+    /// Called in place of encoding the subtree below this element when its cached encoding was appended instead
+    virtual void subtreeEncodedFromCache(EncodeBitstreamParams& params) const { }
+
     /// Override to serialize the state of this element. This is used for persistance and for transmission across the network.
     virtual AppendState appendElementData(OctreePacketData* packetData, EncodeBitstreamParams& params) const 
                                 { return COMPLETED; }
@@ -154,6 +163,10 @@ public:
 
     bool calculateShouldRender(const ViewFrustum* viewFrustum, 
                 float voxelSizeScale = DEFAULT_OCTREE_SIZE_SCALE, int boundaryLevelAdjust = 0) const;
+
+    /// as above, for a caller that already has the distance to our furthest point, as childCubesInFrustum() finds it
+    bool calculateShouldRender(float furthestDistance,
+                float voxelSizeScale = DEFAULT_OCTREE_SIZE_SCALE, int boundaryLevelAdjust = 0) const;
     
     // points are assumed to be in Voxel Coordinates (not TREE_SCALE'd)
     float distanceSquareToPoint(const glm::vec3& point) const; // when you don't need the actual distance, use this.
@@ -169,6 +182,14 @@ public:
     void markWithChangedTime();
     quint64 getLastChanged() const { return _lastChanged; }
     void handleSubtreeChanged(Octree* myTree);
+
+    /// A stamp that changes whenever this element or anything below it is marked changed. Changes are marked on the
+    /// whole path from the root down to them, so an unchanged stamp means nothing in the subtree has changed.
+    quint64 getSubtreeChangeStamp() const { return _subtreeChangeStamp; }
+    void markSubtreeChanged();
+
+    /// the number of levels below this element, worked out again only for subtrees marked changed since it was last asked
+    int getSubtreeHeight() const;
     
     // Used by VoxelSystem for rendering in/out of view and LOD
     void setShouldRender(bool shouldRender);
@@ -197,6 +218,9 @@ public:
     static quint64 getExternalChildrenMemoryUsage() { return _externalChildrenMemoryUsage; }
     static quint64 getTotalMemoryUsage() { return _octreeMemoryUsage + _octcodeMemoryUsage + _externalChildrenMemoryUsage; }
 
+    /// the number of slabs the blocks of linear children are kept in, which go back to the heap once they're unused
+    static int getChildBlockSlabCount();
+
     static quint64 getGetChildAtIndexTime() { return _getChildAtIndexTime; }
     static quint64 getGetChildAtIndexCalls() { return _getChildAtIndexCalls; }
     static quint64 getSetChildAtIndexTime() { return _setChildAtIndexTime; }
@@ -214,6 +238,12 @@ public:
 
     static quint64 getExternalChildrenCount() { return _externalChildrenCount; }
     static quint64 getChildrenCount(int childCount) { return _childrenCount[childCount]; }
+
+    /// Whether elements made from now on keep their children linearly: all eight slots in one block from a shared pool
+    /// once there's any child, so that a child is found by its index alone, and the blocks of a subtree built together
+    /// sit together in memory. Otherwise a single child is kept in the element and more in a block of their own.
+    static void setLinearChildren(bool linearChildren) { _linearChildren = linearChildren; }
+    static bool getLinearChildren() { return _linearChildren; }
     
 #ifdef BLENDED_UNION_CHILDREN
 #ifdef HAS_AUDIT_CHILDREN
@@ -281,6 +311,7 @@ protected:
     } _octalCode;  
 
     quint64 _lastChanged; /// Client and server, timestamp this node was last changed, 8 bytes
+    quint64 _subtreeChangeStamp; /// Server, stamp of the last change to this node or below it, 8 bytes
 
     /// Client and server, pointers to child nodes, various encodings
 #ifdef SIMPLE_CHILD_ARRAY
@@ -292,6 +323,9 @@ protected:
       OctreeElement* single;
       OctreeElement** external;
     } _children;
+
+    static OctreeElement** allocateChildBlock();
+    static void freeChildBlock(OctreeElement** block);
 #endif
     
 #ifdef BLENDED_UNION_CHILDREN
@@ -317,13 +351,17 @@ protected:
     static std::map<uint16_t, QString> _mapKeysToSourceUUIDs;
 
     unsigned char _childBitmask;     // 1 byte 
+    /// Server, levels below this node as of the last getSubtreeHeight() or UNKNOWN_SUBTREE_HEIGHT if changed since, 1 byte.
+    /// Atomic, since sending threads fill it in at once while holding only the tree's read lock
+    mutable std::atomic<unsigned char> _subtreeHeight;
 
     bool _falseColored : 1, /// Client only, is this voxel false colored, 1 bit
          _isDirty : 1, /// Client only, has this voxel changed since being rendered, 1 bit
          _shouldRender : 1, /// Client only, should this voxel render at this time, 1 bit
          _octcodePointer : 1, /// Client and Server only, is this voxel's octal code a pointer or buffer, 1 bit
          _unknownBufferIndex : 1,
-         _childrenExternal : 1; /// Client only, is this voxel's VBO buffer the unknown buffer index, 1 bit
+         _childrenExternal : 1, /// Client only, is this voxel's VBO buffer the unknown buffer index, 1 bit
+         _childrenLinear : 1; /// Client and server, are this element's children kept linearly, 1 bit
 
     static QReadWriteLock _deleteHooksLock;
     static std::vector<OctreeElementDeleteHook*> _deleteHooks;
@@ -354,6 +392,10 @@ protected:
 #endif
     static quint64 _externalChildrenCount;
     static quint64 _childrenCount[NUMBER_OF_CHILDREN + 1];
+
+    static bool _linearChildren;
+
+    static std::atomic<quint64> _nextSubtreeChangeStamp; // shared by every tree, each changed under its own lock
 };
 
 #endif // hifi_OctreeElement_h
@@ -16,7 +16,11 @@
 #ifndef hifi_OctreeElementBag_h
 #define hifi_OctreeElementBag_h
 
+#include <QSet>
+#include <QUuid>
+
 #include "OctreeElement.h"
+#include "OctreeElementExtraEncodeData.h"
 
 class OctreeElementBag : public OctreeElementDeleteHook {
 
@@ -41,6 +45,8 @@ private:
     bool _hooked;
 };
 
-typedef QMap<const OctreeElement*,void*> OctreeElementExtraEncodeData;
+// the IDs of the items in a tree's elements (entities, say) that a client has been sent in full, so that it can be sent
+// just the properties of them that change
+typedef QSet<QUuid> OctreeSentItems;
 
 #endif // hifi_OctreeElementBag_h
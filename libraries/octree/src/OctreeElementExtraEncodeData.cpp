@@ -0,0 +1,113 @@
+//
+//  OctreeElementExtraEncodeData.cpp
+//  libraries/octree/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+
+#include <QtCore/QHash>
+
+#include "OctreeElementExtraEncodeData.h"
+
+const int INITIAL_SLOTS = 1024;
+const size_t ARENA_CHUNK_SIZE = 64 * 1024;
+
+// enough for anything the trees keep in the arena
+const size_t ARENA_ALIGNMENT = 16;
+
+// generation 0 marks a slot that has never been used
+const quint32 FIRST_GENERATION = 1;
+
+OctreeElementExtraEncodeData::OctreeElementExtraEncodeData() :
+    _size(0),
+    _generation(FIRST_GENERATION),
+    _currentChunk(0),
+    _chunkOffset(0)
+{
+}
+
+OctreeElementExtraEncodeData::~OctreeElementExtraEncodeData() {
+    foreach (char* chunk, _chunks) {
+        delete[] chunk;
+    }
+}
+
+void* OctreeElementExtraEncodeData::value(const OctreeElement* element) const {
+    if (_size == 0) {
+        return NULL;
+    }
+    const Slot* slot = findSlot(element);
+    return (slot->generation == _generation) ? slot->data : NULL;
+}
+
+void OctreeElementExtraEncodeData::insert(const OctreeElement* element, void* data) {
+    // keep the table at most half full so that the probes stay short
+    if ((_size + 1) * 2 > _slots.size()) {
+        grow();
+    }
+    Slot* slot = findSlot(element);
+    if (slot->generation != _generation) {
+        slot->element = element;
+        slot->generation = _generation;
+        _size++;
+    }
+    slot->data = data;
+}
+
+void OctreeElementExtraEncodeData::clear() {
+    _size = 0;
+    _currentChunk = 0;
+    _chunkOffset = 0;
+
+    if (++_generation == 0) {
+        // the generations wrapped around, so the oldest slots could look current
+        _slots.fill(Slot());
+        _generation = FIRST_GENERATION;
+    }
+}
+
+void* OctreeElementExtraEncodeData::allocate(size_t size) {
+    size = (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+
+    // move on to the first chunk from here with room, making one if there's none
+    while (_currentChunk < _chunks.size() && _chunkOffset + size > _chunkSizes.at(_currentChunk)) {
+        _currentChunk++;
+        _chunkOffset = 0;
+    }
+    if (_currentChunk == _chunks.size()) {
+        size_t chunkSize = std::max(size, ARENA_CHUNK_SIZE);
+        _chunks.append(new char[chunkSize]);
+        _chunkSizes.append(chunkSize);
+        _chunkOffset = 0;
+    }
+    void* allocation = _chunks.at(_currentChunk) + _chunkOffset;
+    _chunkOffset += size;
+    return allocation;
+}
+
+OctreeElementExtraEncodeData::Slot* OctreeElementExtraEncodeData::findSlot(const OctreeElement* element) const {
+    int mask = _slots.size() - 1;
+    Slot* slots = const_cast<Slot*>(_slots.constData());
+    for (int i = qHash(element) & mask;; i = (i + 1) & mask) {
+        if (slots[i].generation != _generation || slots[i].element == element) {
+            return slots + i;
+        }
+    }
+}
+
+void OctreeElementExtraEncodeData::grow() {
+    // the table is only made once there's something to put in it, so that a tree can keep one for a single pass cheaply
+    QVector<Slot> oldSlots = _slots;
+    _slots = QVector<Slot>(oldSlots.isEmpty() ? INITIAL_SLOTS : oldSlots.size() * 2);
+    foreach (const Slot& oldSlot, oldSlots) {
+        if (oldSlot.generation == _generation) {
+            *findSlot(oldSlot.element) = oldSlot;
+        }
+    }
+}
@@ -0,0 +1,75 @@
+//
+//  OctreeElementExtraEncodeData.h
+//  libraries/octree/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreeElementExtraEncodeData_h
+#define hifi_OctreeElementExtraEncodeData_h
+
+#include <new>
+
+#include <QtCore/QVector>
+#include <QtCore/QtGlobal>
+
+class OctreeElement;
+
+/// The state a tree keeps about each element for one client's scene, while the scene takes more than one packet to send.
+/// Kept for the client from scene to scene, so that once it has grown to fit a scene, starting the next one allocates
+/// nothing: the elements are looked up in a flat table that clear() empties by moving on to a new generation, and the
+/// state itself comes from an arena that clear() rewinds. Whatever lives in the arena is never destroyed, so it has to
+/// be plain data - arrays it needs come from the arena too.
+class OctreeElementExtraEncodeData {
+public:
+    OctreeElementExtraEncodeData();
+    ~OctreeElementExtraEncodeData();
+
+    bool contains(const OctreeElement* element) const { return _size > 0 && findSlot(element)->generation == _generation; }
+
+    /// returns the state kept for the element, or NULL if there is none
+    void* value(const OctreeElement* element) const;
+
+    void insert(const OctreeElement* element, void* data);
+    int size() const { return _size; }
+
+    /// forgets the state of every element, and everything allocated for it
+    void clear();
+
+    /// returns size bytes from the arena, aligned for any type, good until the next clear()
+    void* allocate(size_t size);
+
+    /// constructs a T in the arena - T must not need destroying
+    template<typename T> T* create() { return new (allocate(sizeof(T))) T(); }
+    template<typename T, typename Arg> T* create(Arg arg) { return new (allocate(sizeof(T))) T(arg); }
+
+private:
+    Q_DISABLE_COPY(OctreeElementExtraEncodeData)
+
+    class Slot {
+    public:
+        Slot() : element(NULL), data(NULL), generation(0) { }
+
+        const OctreeElement* element;
+        void* data;
+        quint32 generation; // the slot is in use only if this is the table's current generation
+    };
+
+    Slot* findSlot(const OctreeElement* element) const;
+    void grow();
+
+    QVector<Slot> _slots; // a power of two in size once there's anything in it, probed linearly
+    int _size;
+    quint32 _generation;
+
+    QVector<char*> _chunks;
+    QVector<size_t> _chunkSizes;
+    int _currentChunk;
+    size_t _chunkOffset;
+};
+
+#endif // hifi_OctreeElementExtraEncodeData_h
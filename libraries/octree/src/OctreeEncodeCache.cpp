@@ -0,0 +1,144 @@
+//
+//  OctreeEncodeCache.cpp
+//  libraries/octree/src
+//
+//  Created on 3/10/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <climits>
+
+#include "Octree.h"
+#include "OctreePacketData.h"
+
+#include "OctreeEncodeCache.h"
+
+OctreeEncodeCache::OctreeEncodeCache(int maxCachedBytes) :
+    _entries(maxCachedBytes),
+    _hits(0),
+    _misses(0),
+    _bytesServed(0)
+{
+    OctreeElement::addDeleteHook(this);
+    OctreeElement::addUpdateHook(this);
+}
+
+OctreeEncodeCache::~OctreeEncodeCache() {
+    OctreeElement::removeUpdateHook(this);
+    OctreeElement::removeDeleteHook(this);
+}
+
+int OctreeEncodeCache::variantForParams(const EncodeBitstreamParams& params) {
+    return (params.includeColor ? 2 : 0) + (params.includeExistsBits ? 1 : 0);
+}
+
+int OctreeEncodeCache::costOfEntry(const Entry& entry) {
+    int cost = sizeof(Entry);
+    for (int i = 0; i < NUMBER_OF_VARIANTS; i++) {
+        cost += entry.bitstreams[i].size();
+    }
+    return cost;
+}
+
+bool OctreeEncodeCache::canUseSubtree(const OctreeElement* element, const EncodeBitstreamParams& params,
+                                      ViewFrustum::location parentLocation) {
+    // only full scenes are independent of what the client was sent before
+    if (!params.viewFrustum || params.deltaViewFrustum || params.wantOcclusionCulling || !params.forceSendScene
+            || params.maxEncodeLevel != INT_MAX || params.chopLevels) {
+        return false;
+    }
+
+    if (parentLocation != ViewFrustum::INSIDE && element->inFrustum(*params.viewFrustum) != ViewFrustum::INSIDE) {
+        return false;
+    }
+
+    int maxLevel = element->getLevel() + element->getSubtreeHeight();
+
+    // the deepest elements of the subtree are the last to pass the LOD, and their data is only sent when the furthest
+    // corner of their parent is within their boundary - if the furthest corner of the subtree is, then everything is sent
+    float boundaryDistance = boundaryDistanceForRenderLevel(maxLevel + 1 + params.boundaryLevelAdjust,
+                                                            params.octreeElementSizeScale);
+    return element->furthestDistanceToCamera(*params.viewFrustum) <= boundaryDistance;
+}
+
+int OctreeEncodeCache::appendSubtree(const OctreeElement* element, OctreePacketData* packetData,
+                                     const EncodeBitstreamParams& params) {
+    QMutexLocker locker(&_mutex);
+
+    Entry* entry = _entries.object(element);
+    if (!entry || entry->subtreeChangeStamp != element->getSubtreeChangeStamp()) {
+        _misses++;
+        return 0;
+    }
+
+    const QByteArray& bitstream = entry->bitstreams[variantForParams(params)];
+    if (bitstream.isEmpty()) {
+        _misses++;
+        return 0;
+    }
+
+    // if the cached subtree doesn't fit then the caller encodes what it can of it
+    if (!packetData->appendRawData(reinterpret_cast<const unsigned char*>(bitstream.constData()), bitstream.size())) {
+        _misses++;
+        return 0;
+    }
+
+    _hits++;
+    _bytesServed += bitstream.size();
+    return bitstream.size();
+}
+
+void OctreeEncodeCache::cacheSubtree(const OctreeElement* element, const EncodeBitstreamParams& params,
+                                     const unsigned char* bitstream, int length) {
+    if (length <= 0) {
+        return;
+    }
+
+    QMutexLocker locker(&_mutex);
+
+    // take the entry so that it is re-inserted with its new cost
+    Entry* entry = _entries.take(element);
+    if (!entry) {
+        entry = new Entry();
+        entry->subtreeChangeStamp = element->getSubtreeChangeStamp();
+    } else if (entry->subtreeChangeStamp != element->getSubtreeChangeStamp()) {
+        // the other variants were encoded before the subtree last changed
+        for (int i = 0; i < NUMBER_OF_VARIANTS; i++) {
+            entry->bitstreams[i].clear();
+        }
+        entry->subtreeChangeStamp = element->getSubtreeChangeStamp();
+    }
+
+    entry->bitstreams[variantForParams(params)] = QByteArray(reinterpret_cast<const char*>(bitstream), length);
+    _entries.insert(element, entry, costOfEntry(*entry));
+}
+
+void OctreeEncodeCache::elementDeleted(OctreeElement* element) {
+    QMutexLocker locker(&_mutex);
+    _entries.remove(element);
+}
+
+void OctreeEncodeCache::elementUpdated(OctreeElement* element) {
+    QMutexLocker locker(&_mutex);
+    _entries.remove(element);
+}
+
+int OctreeEncodeCache::getCachedSubtrees() {
+    QMutexLocker locker(&_mutex);
+    return _entries.size();
+}
+
+int OctreeEncodeCache::getCachedBytes() {
+    QMutexLocker locker(&_mutex);
+    return _entries.totalCost();
+}
+
+void OctreeEncodeCache::resetStats() {
+    QMutexLocker locker(&_mutex);
+    _hits = 0;
+    _misses = 0;
+    _bytesServed = 0;
+}
@@ -0,0 +1,79 @@
+//
+//  OctreeEncodeCache.h
+//  libraries/octree/src
+//
+//  Created on 3/10/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreeEncodeCache_h
+#define hifi_OctreeEncodeCache_h
+
+#include <QtCore/QByteArray>
+#include <QtCore/QCache>
+#include <QtCore/QMutex>
+
+#include "OctreeElement.h"
+#include "ViewFrustum.h"
+
+class EncodeBitstreamParams;
+class OctreePacketData;
+
+const int DEFAULT_ENCODE_CACHE_MEGABYTES = 32;
+
+/// Cache of the encoded bitstreams of octree subtrees, shared by every client a server encodes for. A subtree is only
+/// cached or served for encodes that are guaranteed to send all of it - full scenes of a subtree that is entirely inside
+/// the client's view, and close enough that its deepest elements are within the client's LOD. Those encodes don't
+/// depend on the client's view at all, so the bytes one client produced can be spliced into another client's packet.
+class OctreeEncodeCache : public OctreeElementDeleteHook, public OctreeElementUpdateHook {
+public:
+    OctreeEncodeCache(int maxCachedBytes);
+    ~OctreeEncodeCache();
+
+    /// returns true if encoding the subtree below element with these params would send every element in it
+    bool canUseSubtree(const OctreeElement* element, const EncodeBitstreamParams& params,
+                       ViewFrustum::location parentLocation);
+
+    /// appends the cached bitstream of the subtree below element to packetData if there is one and it fits
+    /// \return the number of bytes appended, 0 if the subtree needs to be encoded
+    int appendSubtree(const OctreeElement* element, OctreePacketData* packetData, const EncodeBitstreamParams& params);
+
+    /// keeps the bitstream just encoded for the subtree below element for the next client
+    void cacheSubtree(const OctreeElement* element, const EncodeBitstreamParams& params,
+                      const unsigned char* bitstream, int length);
+
+    virtual void elementDeleted(OctreeElement* element);
+    virtual void elementUpdated(OctreeElement* element);
+
+    int getCachedSubtrees();
+    int getCachedBytes();
+    quint64 getHits() const { return _hits; }
+    quint64 getMisses() const { return _misses; }
+    quint64 getBytesServed() const { return _bytesServed; }
+    float getHitRate() const { return (_hits + _misses) > 0 ? (float)_hits / (float)(_hits + _misses) : 0.0f; }
+    void resetStats();
+
+private:
+    // a subtree is encoded differently with and without color and exists bits
+    static const int NUMBER_OF_VARIANTS = 4;
+
+    struct Entry {
+        quint64 subtreeChangeStamp; // the element's subtree change stamp when the bitstreams were encoded
+        QByteArray bitstreams[NUMBER_OF_VARIANTS];
+    };
+
+    static int variantForParams(const EncodeBitstreamParams& params);
+    static int costOfEntry(const Entry& entry);
+
+    QMutex _mutex;
+    QCache<const OctreeElement*, Entry> _entries; // cost is in bytes
+
+    quint64 _hits;
+    quint64 _misses;
+    quint64 _bytesServed;
+};
+
+#endif // hifi_OctreeEncodeCache_h
@@ -18,6 +18,7 @@
 #include <QDir>
 #include <QDirIterator>
 #include <QFile>
+#include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonObject>
 
@@ -28,10 +29,16 @@
 
 const int OctreePersistThread::DEFAULT_PERSIST_INTERVAL = 1000 * 30; // every 30 seconds
 
+// edits are journaled as they are applied, and folded into a new snapshot of the whole file every persist interval
+const QString EDIT_JOURNAL_EXTENSION = ".journal";
+const QString SNAPSHOT_EXTENSION = ".snapshot";
+const QString LOCK_FILE_EXTENSION = ".lock";
+
 OctreePersistThread::OctreePersistThread(Octree* tree, const QString& filename, int persistInterval, 
                                                 bool wantBackup, const QJsonObject& settings, bool debugTimestampNow) :
     _tree(tree),
     _filename(filename),
+    _editJournal(filename + EDIT_JOURNAL_EXTENSION),
     _persistInterval(persistInterval),
     _initialLoadComplete(false),
     _loadTimeUSecs(0),
@@ -99,22 +106,33 @@ bool OctreePersistThread::process() {
         qDebug() << "loading Octrees from file: " << _filename << "...";
 
         bool persistantFileRead;
+        int editsReplayed = 0;
 
         _tree->lockForWrite();
         {
             PerformanceWarning warn(true, "Loading Octree File", true);
             
             // First check to make sure "lock" file doesn't exist. If it does exist, then
-            // our last save crashed during the save, and we want to load our most recent backup.
-            QString lockFileName = _filename + ".lock";
+            // our last save crashed during the save.
+            QString lockFileName = _filename + LOCK_FILE_EXTENSION;
+            QString snapshotFileName = _filename + SNAPSHOT_EXTENSION;
             std::ifstream lockFile(qPrintable(lockFileName), std::ios::in|std::ios::binary|std::ios::ate);
             if(lockFile.is_open()) {
-                qDebug() << "WARNING: Octree lock file detected at startup:" << lockFileName
-                         << "-- Attempting to restore from previous backup file.";
-                         
-                // This is where we should attempt to find the most recent backup and restore from
-                // that file as our persist file.
-                restoreFromMostRecentBackup();
+                qDebug() << "WARNING: Octree lock file detected at startup:" << lockFileName;
+
+                // the persist file is only removed once the snapshot replacing it is written in full, so while it's
+                // there it's what we have and the snapshot may be partial
+                if (QFile::exists(_filename)) {
+                    qDebug() << "Loading Octree... removing the snapshot that was being saved:" << snapshotFileName;
+                    remove(qPrintable(snapshotFileName));
+                } else if (!QFile::exists(snapshotFileName)) {
+                    qDebug() << "Loading Octree... no persist file or snapshot -- Attempting to restore from previous"
+                             << "backup file.";
+
+                    // This is where we should attempt to find the most recent backup and restore from
+                    // that file as our persist file.
+                    restoreFromMostRecentBackup();
+                }
 
                 lockFile.close();
                 qDebug() << "Loading Octree... lock file closed:" << lockFileName;
@@ -122,16 +140,34 @@ bool OctreePersistThread::process() {
                 qDebug() << "Loading Octree... lock file removed:" << lockFileName;
             }
 
+            // if we crashed while replacing the persist file with a new snapshot, the snapshot is the latest we have
+            if (!QFile::exists(_filename) && QFile::exists(snapshotFileName)) {
+                qDebug() << "WARNING: Octree snapshot detected at startup without persist file:" << snapshotFileName
+                         << "-- Using it as our persist file.";
+                QFile::rename(snapshotFileName, _filename);
+            }
+
             persistantFileRead = _tree->readFromSVOFile(_filename.toLocal8Bit().constData());
+
+            // then bring the tree up to date with the edits since that file was saved
+            editsReplayed = _editJournal.replay(_tree);
             _tree->pruneTree();
+
+            // from here on every edit the tree applies goes to the journal
+            _editJournal.open();
+            _tree->setEditJournal(&_editJournal);
         }
         _tree->unlock();
 
         quint64 loadDone = usecTimestampNow();
         _loadTimeUSecs = loadDone - loadStarted;
 
-        _tree->clearDirtyBit(); // the tree is clean since we just loaded it
-        qDebug("DONE loading Octrees from file... fileRead=%s", debug::valueOf(persistantFileRead));
+        // the tree is clean since we just loaded it, unless it has journaled edits that aren't in the file yet
+        if (editsReplayed == 0) {
+            _tree->clearDirtyBit();
+        }
+        qDebug("DONE loading Octrees from file... fileRead=%s editsReplayed=%d",
+               debug::valueOf(persistantFileRead), editsReplayed);
 
         unsigned long nodeCount = OctreeElement::getNodeCount();
         unsigned long internalNodeCount = OctreeElement::getInternalNodeCount();
@@ -200,43 +236,77 @@ bool OctreePersistThread::process() {
 void OctreePersistThread::aboutToFinish() {
     qDebug() << "Persist thread about to finish...";
     persist();
+
+    _tree->lockForWrite();
+    _tree->setEditJournal(NULL);
+    _tree->unlock();
+    _editJournal.close();
     qDebug() << "Persist thread done with about to finish...";
 }
 
 void OctreePersistThread::persist() {
     if (_tree->isDirty()) {
-        _tree->lockForWrite();
+        // NOTE: we don't prune before saving, the entity operators already prune the elements they leave empty, and
+        // pruning needs the write lock which would hold off every client we're sending to
+
+        backup(); // handle backup if requested        
+
+        // The snapshot is encoded under one read lock, noting how much of the journal it includes - clients are still
+        // sent to while we encode, and edits only wait for the encode, not for the disk. The new snapshot is written next
+        // to the persist file and then replaces it, so that a crash while saving leaves the old file and the journal
+        // intact, with the lock file telling the next load that the snapshot may be partial.
+        QByteArray snapshot;
+        qint64 journalSize;
+        _tree->lockForRead();
         {
-            qDebug() << "pruning Octree before saving...";
-            _tree->pruneTree();
-            qDebug() << "DONE pruning Octree before saving...";
+            PerformanceWarning warn(true, "Encoding Octree Snapshot", true);
+            _tree->writeToSVOBuffer(snapshot);
+            journalSize = _editJournal.getSize();
+
+            // edits made while we write mark the tree dirty again
+            _tree->clearDirtyBit();
         }
         _tree->unlock();
 
-        backup(); // handle backup if requested        
+        QString snapshotFileName = _filename + SNAPSHOT_EXTENSION;
+        QString lockFileName = _filename + LOCK_FILE_EXTENSION;
+        {
+            PerformanceWarning warn(true, "Saving Octree Snapshot", true);
 
+            std::ofstream lockFile(qPrintable(lockFileName), std::ios::out|std::ios::binary);
+            lockFile.close();
 
-        // create our "lock" file to indicate we're saving.
-        QString lockFileName = _filename + ".lock";
-        std::ofstream lockFile(qPrintable(lockFileName), std::ios::out|std::ios::binary);
-        if(lockFile.is_open()) {
-            qDebug() << "saving Octree lock file created at:" << lockFileName;
+            qDebug() << "saving Octree to file " << snapshotFileName << "...";
+            if (Octree::writeSVOBufferToFile(qPrintable(snapshotFileName), snapshot)
+                    && replaceWithSnapshot(snapshotFileName)) {
+                // if we crash before this the journal's edits are replayed on top of the snapshot that already has
+                // them, which the trees are able to handle
+                _editJournal.discardFirstBytes(journalSize);
 
-            qDebug() << "saving Octree to file " << _filename << "...";
-            
-            _tree->writeToSVOFile(qPrintable(_filename));
-            time(&_lastPersistTime);
-            _tree->clearDirtyBit(); // tree is clean after saving
-            qDebug() << "DONE saving Octree to file...";
+                time(&_lastPersistTime);
+                qDebug() << "DONE saving Octree to file...";
+            } else {
+                qDebug() << "ERROR saving Octree to file " << snapshotFileName << "... keeping the edit journal.";
+                remove(qPrintable(snapshotFileName));
+                _tree->setDirtyBit(); // so that we try again next time
+            }
 
-            lockFile.close();
-            qDebug() << "saving Octree lock file closed:" << lockFileName;
             remove(qPrintable(lockFileName));
-            qDebug() << "saving Octree lock file removed:" << lockFileName;
         }
     }
 }
 
+bool OctreePersistThread::replaceWithSnapshot(const QString& snapshotFileName) {
+    // rename() can't replace an existing file everywhere, so the old file is removed first - if we crash in between, the
+    // snapshot is picked up as the persist file the next time we load
+    remove(qPrintable(_filename));
+    if (!QFile::rename(snapshotFileName, _filename)) {
+        qDebug() << "ERROR replacing persist file" << _filename << "with snapshot" << snapshotFileName;
+        return false;
+    }
+    return true;
+}
+
 void OctreePersistThread::restoreFromMostRecentBackup() {
     qDebug() << "Restoring from most recent backup...";
     
@@ -17,6 +17,7 @@
 #include <QString>
 #include <GenericThread.h>
 #include "Octree.h"
+#include "OctreeEditJournal.h"
 
 /// Generalized threaded processor for handling received inbound packets.
 class OctreePersistThread : public GenericThread {
@@ -50,6 +51,7 @@ protected:
     virtual bool process();
     
     void persist();
+    bool replaceWithSnapshot(const QString& snapshotFileName);
     void backup();
     void rollOldBackupVersions(const BackupRule& rule);
     void restoreFromMostRecentBackup();
@@ -60,6 +62,7 @@ protected:
 private:
     Octree* _tree;
     QString _filename;
+    OctreeEditJournal _editJournal;
     int _persistInterval;
     bool _initialLoadComplete;
 
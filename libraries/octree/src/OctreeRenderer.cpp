@@ -9,6 +9,7 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <stdint.h>
 
@@ -146,20 +147,45 @@ void OctreeRenderer::processDatagram(const QByteArray& dataByteArray, const Shar
     }
 }
 
-bool OctreeRenderer::renderOperation(OctreeElement* element, void* extraData) {
-    RenderArgs* args = static_cast<RenderArgs*>(extraData);
-    if (element->isInView(*args->_viewFrustum)) {
-        if (element->hasContent()) {
-            if (element->calculateShouldRender(args->_viewFrustum, args->_sizeScale, args->_boundaryLevelAdjust)) {
-                args->_renderer->renderElement(element, args);
-            } else {
-                return false; // if we shouldn't render, then we also should stop recursing.
-            }
-        }
-        return true; // continue recursing
+void OctreeRenderer::renderSubtree(OctreeElement* element, ViewFrustum::location location, float furthestDistance,
+                                   RenderArgs* args, int recursionCount) {
+    if (recursionCount > DANGEROUSLY_DEEP_RECURSION) {
+        qDebug() << "OctreeRenderer::renderSubtree() reached DANGEROUSLY_DEEP_RECURSION, bailing!";
+        return;
     }
+
     // if not in view stop recursing
-    return false;
+    if (location == ViewFrustum::OUTSIDE) {
+        return;
+    }
+    if (element->hasContent()) {
+        if (element->calculateShouldRender(furthestDistance, args->_sizeScale, args->_boundaryLevelAdjust)) {
+            args->_renderer->renderElement(element, args);
+        } else {
+            return; // if we shouldn't render, then we also should stop recursing.
+        }
+    }
+    if (element->isLeaf()) {
+        return;
+    }
+
+    // where the children all are at once, and how far for the LOD - the children of an element that's fully in view are
+    // too, whatever the keyhole makes of them
+    ViewFrustum::location childLocations[NUMBER_OF_CHILDREN];
+    float childDistances[NUMBER_OF_CHILDREN];
+    float childFurthestDistances[NUMBER_OF_CHILDREN];
+    AACube cube = element->getAACube();
+    cube.scale(TREE_SCALE);
+    args->_viewFrustum->childCubesInFrustum(cube, childLocations, childDistances, childFurthestDistances);
+    if (location == ViewFrustum::INSIDE) {
+        std::fill(childLocations, childLocations + NUMBER_OF_CHILDREN, ViewFrustum::INSIDE);
+    }
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        OctreeElement* child = element->getChildAtIndex(i);
+        if (child) {
+            renderSubtree(child, childLocations[i], childFurthestDistances[i], args, recursionCount + 1);
+        }
+    }
 }
 
 void OctreeRenderer::render(RenderArgs::RenderMode renderMode, RenderArgs::RenderSide renderSide) {
@@ -167,7 +193,8 @@ void OctreeRenderer::render(RenderArgs::RenderMode renderMode, RenderArgs::Rende
                                         0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
     if (_tree) {
         _tree->lockForRead();
-        _tree->recurseTreeWithOperation(renderOperation, &args);
+        OctreeElement* root = _tree->getRoot();
+        renderSubtree(root, root->inFrustum(*_viewFrustum), root->furthestDistanceToCamera(*_viewFrustum), &args);
         _tree->unlock();
     }
     _meshesConsidered = args._meshesConsidered;
@@ -57,7 +57,11 @@ public:
     ViewFrustum* getViewFrustum() const { return _viewFrustum; }
     void setViewFrustum(ViewFrustum* viewFrustum) { _viewFrustum = viewFrustum; }
 
-    static bool renderOperation(OctreeElement* element, void* extraData);
+    /// Renders the elements of the subtree that are in view and in LOD. The caller knows where the element is in the
+    /// view and how far its furthest point is, and each element finds both for all of its children at once for the next
+    /// level down.
+    static void renderSubtree(OctreeElement* element, ViewFrustum::location location, float furthestDistance,
+                              RenderArgs* args, int recursionCount = 0);
 
     /// clears the tree
     virtual void clear();
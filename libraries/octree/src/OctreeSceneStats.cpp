@@ -381,6 +381,25 @@ void OctreeSceneStats::childBitsRemoved(bool includesExistsBits, bool includesCo
     _treesRemoved++;
 }
 
+void OctreeSceneStats::subtreeSentFromCache(const OctreeElement* element, bool includesExistsBits) {
+    // a cached subtree was sent in full, so every element below was traversed and sent, and every level has its bitmasks
+    colorBitsWritten();
+    if (includesExistsBits) {
+        existsBitsWritten();
+    }
+    existsInPacketBitsWritten();
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        const OctreeElement* child = element->getChildAtIndex(i);
+        if (child) {
+            traversed(child);
+            colorSent(child);
+            if (!child->isLeaf()) {
+                subtreeSentFromCache(child, includesExistsBits);
+            }
+        }
+    }
+}
+
 int OctreeSceneStats::packIntoMessage(unsigned char* destinationBuffer, int availableBytes) {
     unsigned char* bufferStart = destinationBuffer;
     
@@ -89,6 +89,9 @@ public:
     /// Fix up tracking statistics in case where bitmasks were removed for some reason
     void childBitsRemoved(bool includesExistsBits, bool includesColors);
 
+    /// Track the elements and bitmasks below a element whose subtree was sent from the encode cache, as encoding it would
+    void subtreeSentFromCache(const OctreeElement* element, bool includesExistsBits);
+
     /// Pack the details of the statistics into a buffer for sending as a network packet
     int packIntoMessage(unsigned char* destinationBuffer, int availableBytes);
 
@@ -231,42 +231,39 @@ ViewFrustum::location ViewFrustum::sphereInKeyhole(const glm::vec3& center, floa
 }
 
 
-// A box is inside a sphere if all of its corners are inside the sphere
-// A box intersects a sphere if any of its edges (as rays) interesect the sphere
-// A box is outside a sphere if none of its edges (as rays) interesect the sphere
-ViewFrustum::location ViewFrustum::cubeInKeyhole(const AACube& cube) const {
-
-    // First check to see if the cube is in the bounding cube for the sphere, if it's not, then we can short circuit
-    // this and not check with sphere penetration which is more expensive
-    if (!_keyholeBoundingCube.contains(cube)) {
-        return OUTSIDE;
-    }
-
-    glm::vec3 penetration;
-    bool intersects = cube.findSpherePenetration(_position, _keyholeRadius, penetration);
-
-    ViewFrustum::location result = OUTSIDE;
-
-    // if the cube intersects the sphere, then it may also be inside... calculate further
-    if (intersects) {
-        result = INTERSECT;
+// the squared distances from a point to the closest point of a cube and to its furthest corner, an axis at a time
+static inline float nearestDistanceSquaredToCube(float cornerX, float cornerY, float cornerZ, float scale,
+                                                 const glm::vec3& point) {
+    float nearX = std::max(0.0f, std::max(cornerX - point.x, point.x - (cornerX + scale)));
+    float nearY = std::max(0.0f, std::max(cornerY - point.y, point.y - (cornerY + scale)));
+    float nearZ = std::max(0.0f, std::max(cornerZ - point.z, point.z - (cornerZ + scale)));
+    return nearX * nearX + nearY * nearY + nearZ * nearZ;
+}
 
-        // test all the corners, if they are all inside the sphere, the entire cube is in the sphere
-        bool allPointsInside = true; // assume the best
-        for (int v = BOTTOM_LEFT_NEAR; v < TOP_LEFT_FAR; v++) {
-            glm::vec3 vertex = cube.getVertex((BoxVertex)v);
-            if (!pointInKeyhole(vertex)) {
-                allPointsInside = false;
-                break;
-            }
-        }
+static inline float furthestDistanceSquaredToCube(float cornerX, float cornerY, float cornerZ, float scale,
+                                                  const glm::vec3& point) {
+    float farX = std::max(fabsf(cornerX - point.x), fabsf(cornerX + scale - point.x));
+    float farY = std::max(fabsf(cornerY - point.y), fabsf(cornerY + scale - point.y));
+    float farZ = std::max(fabsf(cornerZ - point.z), fabsf(cornerZ + scale - point.z));
+    return farX * farX + farY * farY + farZ * farZ;
+}
 
-        if (allPointsInside) {
-            result = INSIDE;
-        }
+// A cube intersects a sphere if its closest point is inside the sphere, and is inside it if its furthest corner is.
+// Both cubeInKeyhole() and childCubesInFrustum() decide here, so that they always agree
+static inline ViewFrustum::location cubeInSphere(float nearestDistanceSquared, float furthestDistanceSquared,
+                                                 float radius) {
+    float radiusSquared = radius * radius;
+    if (furthestDistanceSquared < radiusSquared) {
+        return ViewFrustum::INSIDE;
     }
+    return (nearestDistanceSquared < radiusSquared) ? ViewFrustum::INTERSECT : ViewFrustum::OUTSIDE;
+}
 
-    return result;
+ViewFrustum::location ViewFrustum::cubeInKeyhole(const AACube& cube) const {
+    const glm::vec3& corner = cube.getCorner();
+    float scale = cube.getScale();
+    return cubeInSphere(nearestDistanceSquaredToCube(corner.x, corner.y, corner.z, scale, _position),
+                        furthestDistanceSquaredToCube(corner.x, corner.y, corner.z, scale, _position), _keyholeRadius);
 }
 
 // A box is inside a sphere if all of its corners are inside the sphere
@@ -392,6 +389,77 @@ ViewFrustum::location ViewFrustum::cubeInFrustum(const AACube& cube) const {
     return regularResult;
 }
 
+void ViewFrustum::childCubesInFrustum(const AACube& cube, ViewFrustum::location locations[NUMBER_OF_CHILDREN],
+                                      float distancesToCamera[NUMBER_OF_CHILDREN],
+                                      float furthestDistancesToCamera[NUMBER_OF_CHILDREN]) const {
+    const glm::vec3& corner = cube.getCorner();
+    float childScale = cube.getScale() * 0.5f;
+
+    // the corners of the children, which are offset from the parent's by the bits of their index: x 4, y 2 and z 1
+    float childX[NUMBER_OF_CHILDREN];
+    float childY[NUMBER_OF_CHILDREN];
+    float childZ[NUMBER_OF_CHILDREN];
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        childX[i] = corner.x + childScale * (float)((i >> 2) & 1);
+        childY[i] = corner.y + childScale * (float)((i >> 1) & 1);
+        childZ[i] = corner.z + childScale * (float)(i & 1);
+    }
+
+    float halfChildScale = childScale * 0.5f;
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        float x = _position.x - (childX[i] + halfChildScale);
+        float y = _position.y - (childY[i] + halfChildScale);
+        float z = _position.z - (childZ[i] + halfChildScale);
+        distancesToCamera[i] = sqrtf(x * x + y * y + z * z);
+    }
+
+    // a child is outside the frustum if its P vertex is behind any plane, and intersects it if its N vertex is - for
+    // every child these are the same offsets from its corner, so only the corner's distance differs
+    bool outsideFrustum[NUMBER_OF_CHILDREN] = { false, false, false, false, false, false, false, false };
+    bool intersectsFrustum[NUMBER_OF_CHILDREN] = { false, false, false, false, false, false, false, false };
+    for (int p = 0; p < 6; p++) {
+        const glm::vec3& normal = _planes[p].getNormal();
+        float dCoefficient = _planes[p].getDCoefficient();
+        float vertexPOffset = childScale * (std::max(normal.x, 0.0f) + std::max(normal.y, 0.0f) + std::max(normal.z, 0.0f));
+        float vertexNOffset = childScale * (std::min(normal.x, 0.0f) + std::min(normal.y, 0.0f) + std::min(normal.z, 0.0f));
+        for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+            float cornerDistance = dCoefficient + normal.x * childX[i] + normal.y * childY[i] + normal.z * childZ[i];
+            outsideFrustum[i] |= (cornerDistance + vertexPOffset < 0.0f);
+            intersectsFrustum[i] |= (cornerDistance + vertexNOffset < 0.0f);
+        }
+    }
+
+    // the furthest corners, which the LOD goes by, and the keyhole
+    float furthestDistancesSquared[NUMBER_OF_CHILDREN];
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        furthestDistancesSquared[i] = furthestDistanceSquaredToCube(childX[i], childY[i], childZ[i], childScale, _position);
+    }
+    if (furthestDistancesToCamera) {
+        for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+            furthestDistancesToCamera[i] = sqrtf(furthestDistancesSquared[i]);
+        }
+    }
+    ViewFrustum::location keyholeLocations[NUMBER_OF_CHILDREN] = { OUTSIDE, OUTSIDE, OUTSIDE, OUTSIDE,
+                                                                   OUTSIDE, OUTSIDE, OUTSIDE, OUTSIDE };
+    if (_keyholeRadius >= 0.0f) {
+        for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+            keyholeLocations[i] = cubeInSphere(nearestDistanceSquaredToCube(childX[i], childY[i], childZ[i], childScale,
+                                                   _position), furthestDistancesSquared[i], _keyholeRadius);
+        }
+    }
+
+    // and put them together the way cubeInFrustum() does
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        if (keyholeLocations[i] == INSIDE) {
+            locations[i] = INSIDE;
+        } else if (outsideFrustum[i]) {
+            locations[i] = keyholeLocations[i];
+        } else {
+            locations[i] = intersectsFrustum[i] ? INTERSECT : INSIDE;
+        }
+    }
+}
+
 ViewFrustum::location ViewFrustum::boxInFrustum(const AABox& box) const {
 
     ViewFrustum::location regularResult = INSIDE;
@@ -100,6 +100,14 @@ public:
     ViewFrustum::location cubeInFrustum(const AACube& cube) const;
     ViewFrustum::location boxInFrustum(const AABox& box) const;
 
+    /// Classifies the eight children of a cube (in TREE_SCALE, indexed like an octree element's children) as
+    /// cubeInFrustum() would, and finds the distances from the camera to their centers and, if asked, to their furthest
+    /// corners, which the LOD goes by. The children share the parent's axes, so each plane is lined up against the
+    /// parent once and the children are offsets from that, in straight loops over all eight.
+    void childCubesInFrustum(const AACube& cube, ViewFrustum::location locations[NUMBER_OF_CHILDREN],
+                             float distancesToCamera[NUMBER_OF_CHILDREN],
+                             float furthestDistancesToCamera[NUMBER_OF_CHILDREN] = NULL) const;
+
     // some frustum comparisons
     bool matches(const ViewFrustum& compareTo, bool debug = false) const;
     bool matches(const ViewFrustum* compareTo, bool debug = false) const { return matches(*compareTo, debug); }
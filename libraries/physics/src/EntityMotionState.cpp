@@ -18,6 +18,7 @@
 #include "EntityMotionState.h"
 
 QSet<EntityItem*>* _outgoingEntityList;
+bool _isAuthoritative = false;
 
 // static 
 void EntityMotionState::setOutgoingEntityList(QSet<EntityItem*>* list) {
@@ -31,6 +32,11 @@ void EntityMotionState::enqueueOutgoingEntity(EntityItem* entity) {
     _outgoingEntityList->insert(entity);
 }
 
+// static
+void EntityMotionState::setIsAuthoritative(bool isAuthoritative) {
+    _isAuthoritative = isAuthoritative;
+}
+
 EntityMotionState::EntityMotionState(EntityItem* entity) 
     :   _entity(entity) {
     assert(entity != NULL);
@@ -43,6 +49,10 @@ EntityMotionState::~EntityMotionState() {
 }
 
 MotionType EntityMotionState::computeMotionType() const {
+    if (!_isAuthoritative && _entity->getSimulatedByServer()) {
+        // the entity server runs the physics of this entity, here the body only follows what the server sends
+        return MOTION_TYPE_KINEMATIC;
+    }
     // HACK: According to EntityTree the meaning of "static" is "not moving" whereas
     // to Bullet it means "can't move".  For demo purposes we temporarily interpret
     // Entity::weightless to mean Bullet::static.
@@ -63,6 +73,13 @@ void EntityMotionState::getWorldTransform(btTransform& worldTrans) const {
 // This callback is invoked by the physics simulation at the end of each simulation frame...
 // iff the corresponding RigidBody is DYNAMIC and has moved.
 void EntityMotionState::setWorldTransform(const btTransform& worldTrans) {
+    if (_isAuthoritative) {
+        // the body has moved, whether the EntityItem needs to follow is decided by updateEntity()
+        _outgoingPacketFlags = DIRTY_PHYSICS_FLAGS;
+        EntityMotionState::enqueueOutgoingEntity(_entity);
+        return;
+    }
+
     _entity->setPositionInMeters(bulletToGLM(worldTrans.getOrigin()) + ObjectMotionState::getWorldOffset());
     _entity->setRotation(bulletToGLM(worldTrans.getRotation()));
 
@@ -141,55 +158,75 @@ void EntityMotionState::computeShapeInfo(ShapeInfo& info) {
     _entity->computeShapeInfo(info);
 }
 
+// private
+void EntityMotionState::captureSentState() {
+#ifdef USE_BULLET_PHYSICS
+    if (_outgoingPacketFlags & EntityItem::DIRTY_POSITION) {
+        btTransform worldTrans = _body->getWorldTransform();
+        _sentPosition = bulletToGLM(worldTrans.getOrigin());
+        _sentRotation = bulletToGLM(worldTrans.getRotation());
+    }
+
+    if (_outgoingPacketFlags & EntityItem::DIRTY_VELOCITY) {
+        if (_body->isActive()) {
+            _sentVelocity = bulletToGLM(_body->getLinearVelocity());
+            _sentAngularVelocity = bulletToGLM(_body->getAngularVelocity());
+
+            // if the speeds are very small we zero them out
+            const float MINIMUM_EXTRAPOLATION_SPEED_SQUARED = 1.0e-4f; // 1cm/sec
+            bool zeroSpeed = (glm::length2(_sentVelocity) < MINIMUM_EXTRAPOLATION_SPEED_SQUARED);
+            if (zeroSpeed) {
+                _sentVelocity = glm::vec3(0.0f);
+            }
+            const float MINIMUM_EXTRAPOLATION_SPIN_SQUARED = 0.004f; // ~0.01 rotation/sec
+            bool zeroSpin = glm::length2(_sentAngularVelocity) < MINIMUM_EXTRAPOLATION_SPIN_SQUARED;
+            if (zeroSpin) {
+                _sentAngularVelocity = glm::vec3(0.0f);
+            }
+
+            _sentMoving = ! (zeroSpeed && zeroSpin);
+        } else {
+            _sentVelocity = _sentAngularVelocity = glm::vec3(0.0f);
+            _sentMoving = false;
+        }
+        _sentAcceleration = bulletToGLM(_body->getGravity());
+    }
+
+    // RELIABLE_SEND_HACK: count number of updates for entities at rest so we can stop sending them after some limit.
+    if (_sentMoving) {
+        _numNonMovingUpdates = 0;
+    } else {
+        _numNonMovingUpdates++;
+    }
+#endif // USE_BULLET_PHYSICS
+}
+
+bool EntityMotionState::shouldSendUpdate(uint32_t simulationFrame) {
+    if (!_isAuthoritative && _entity->getSimulatedByServer()) {
+        // our results would only fight with the entity server's own
+        return false;
+    }
+    return ObjectMotionState::shouldSendUpdate(simulationFrame);
+}
+
 void EntityMotionState::sendUpdate(OctreeEditPacketSender* packetSender, uint32_t frame) {
 #ifdef USE_BULLET_PHYSICS
     if (_outgoingPacketFlags) {
         EntityItemProperties properties = _entity->getProperties();
+        captureSentState();
 
         if (_outgoingPacketFlags & EntityItem::DIRTY_POSITION) {
-            btTransform worldTrans = _body->getWorldTransform();
-            _sentPosition = bulletToGLM(worldTrans.getOrigin());
             properties.setPosition(_sentPosition + ObjectMotionState::getWorldOffset());
-        
-            _sentRotation = bulletToGLM(worldTrans.getRotation());
             properties.setRotation(_sentRotation);
         }
     
         if (_outgoingPacketFlags & EntityItem::DIRTY_VELOCITY) {
-            if (_body->isActive()) {
-                _sentVelocity = bulletToGLM(_body->getLinearVelocity());
-                _sentAngularVelocity = bulletToGLM(_body->getAngularVelocity());
-
-                // if the speeds are very small we zero them out
-                const float MINIMUM_EXTRAPOLATION_SPEED_SQUARED = 1.0e-4f; // 1cm/sec
-                bool zeroSpeed = (glm::length2(_sentVelocity) < MINIMUM_EXTRAPOLATION_SPEED_SQUARED);
-                if (zeroSpeed) {
-                    _sentVelocity = glm::vec3(0.0f);
-                }
-                const float MINIMUM_EXTRAPOLATION_SPIN_SQUARED = 0.004f; // ~0.01 rotation/sec
-                bool zeroSpin = glm::length2(_sentAngularVelocity) < MINIMUM_EXTRAPOLATION_SPIN_SQUARED;
-                if (zeroSpin) {
-                    _sentAngularVelocity = glm::vec3(0.0f);
-                }
-
-                _sentMoving = ! (zeroSpeed && zeroSpin);
-            } else {
-                _sentVelocity = _sentAngularVelocity = glm::vec3(0.0f);
-                _sentMoving = false;
-            }
             properties.setVelocity(_sentVelocity);
-            _sentAcceleration = bulletToGLM(_body->getGravity());
             properties.setGravity(_sentAcceleration);
             // DANGER! EntityItem stores angularVelocity in degrees/sec!!!
             properties.setAngularVelocity(glm::degrees(_sentAngularVelocity));
         }
 
-        // RELIABLE_SEND_HACK: count number of updates for entities at rest so we can stop sending them after some limit.
-        if (_sentMoving) {
-            _numNonMovingUpdates = 0;
-        } else {
-            _numNonMovingUpdates++;
-        }
         if (_numNonMovingUpdates <= 1) {
             // we only update lastEdited when we're sending new physics data 
             // (i.e. NOT when we just simulate the positions forward, nore when we resend non-moving data)
@@ -211,3 +248,36 @@ void EntityMotionState::sendUpdate(OctreeEditPacketSender* packetSender, uint32_
     }
 #endif // USE_BULLET_PHYSICS
 }
+
+void EntityMotionState::updateEntity(uint32_t frame) {
+#ifdef USE_BULLET_PHYSICS
+    if (_outgoingPacketFlags) {
+        captureSentState();
+
+        EntityPropertyFlags changedProperties;
+        if (_outgoingPacketFlags & EntityItem::DIRTY_POSITION) {
+            _entity->setPositionInMeters(_sentPosition + ObjectMotionState::getWorldOffset());
+            _entity->setRotation(_sentRotation);
+            changedProperties += PROP_POSITION;
+            changedProperties += PROP_ROTATION;
+        }
+
+        if (_outgoingPacketFlags & EntityItem::DIRTY_VELOCITY) {
+            _entity->setVelocityInMeters(_sentVelocity);
+            _entity->setGravityInMeters(_sentAcceleration);
+            // DANGER! EntityItem stores angularVelocity in degrees/sec!!!
+            _entity->setAngularVelocity(glm::degrees(_sentAngularVelocity));
+            changedProperties += PROP_VELOCITY;
+            changedProperties += PROP_GRAVITY;
+            changedProperties += PROP_ANGULAR_VELOCITY;
+        }
+
+        // we are the authority on this entity, so our clients should take this over whatever they have
+        _entity->setLastEdited(usecTimestampNow());
+        _entity->markAsChangedOnServer(changedProperties);
+
+        _outgoingPacketFlags = DIRTY_PHYSICS_FLAGS;
+        _sentFrame = frame;
+    }
+#endif // USE_BULLET_PHYSICS
+}
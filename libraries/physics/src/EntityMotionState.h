@@ -39,10 +39,15 @@ public:
     static void setOutgoingEntityList(QSet<EntityItem*>* list);
     static void enqueueOutgoingEntity(EntityItem* entity);
 
+    // When the simulation is authoritative (it is the entity server's own) the EntityItem holds what was last sent
+    // to the clients, so the physics results are only copied into it by updateEntity() when they need to be sent.
+    static void setIsAuthoritative(bool isAuthoritative);
+
     EntityMotionState(EntityItem* item);
     virtual ~EntityMotionState();
 
-    /// \return MOTION_TYPE_DYNAMIC or MOTION_TYPE_STATIC based on params set in EntityItem
+    /// \return MOTION_TYPE_DYNAMIC or MOTION_TYPE_STATIC based on params set in EntityItem,
+    /// or MOTION_TYPE_KINEMATIC on a client when the entity server simulates the entity
     MotionType computeMotionType() const;
 
 #ifdef USE_BULLET_PHYSICS
@@ -59,12 +64,20 @@ public:
 
     void computeShapeInfo(ShapeInfo& info);
 
+    bool shouldSendUpdate(uint32_t simulationFrame);
     void sendUpdate(OctreeEditPacketSender* packetSender, uint32_t frame);
 
+    /// copies the physics results into the EntityItem, for an authoritative simulation to send them to its clients
+    void updateEntity(uint32_t frame);
+
+    EntityItem* getEntity() const { return _entity; }
+
     uint32_t getIncomingDirtyFlags() const { return _entity->getDirtyFlags(); }
     void clearIncomingDirtyFlags(uint32_t flags) { _entity->clearDirtyFlags(flags); }
 
 protected:
+    void captureSentState();
+
     EntityItem* _entity;
 };
 
@@ -40,13 +40,30 @@ void PhysicsEngine::updateEntitiesInternal(const quint64& now) {
     // (4) send outgoing packets
 
     // this is step (4)
+    if (isAuthoritative()) {
+        // only the bodies that moved since the last update can have something new to send, sleeping ones are never visited
+        QSet<EntityItem*>::iterator entityItr = _entitiesThatMoved.begin();
+        while (entityItr != _entitiesThatMoved.end()) {
+            _outgoingPackets.insert(static_cast<ObjectMotionState*>((*entityItr)->getPhysicsInfo()));
+            ++entityItr;
+        }
+        _entitiesThatMoved.clear();
+    }
+
     QSet<ObjectMotionState*>::iterator stateItr = _outgoingPackets.begin();
     while (stateItr != _outgoingPackets.end()) {
         ObjectMotionState* state = *stateItr;
         if (state->doesNotNeedToSendUpdate()) {
             stateItr = _outgoingPackets.erase(stateItr);
         } else if (state->shouldSendUpdate(_frameCount)) {
-            state->sendUpdate(_entityPacketSender, _frameCount);
+            if (isAuthoritative()) {
+                // the entity is changed in the tree, which sends it to every client that can see it
+                EntityMotionState* entityState = static_cast<EntityMotionState*>(state);
+                entityState->updateEntity(_frameCount);
+                _entitiesToBeSorted.insert(entityState->getEntity());
+            } else {
+                state->sendUpdate(_entityPacketSender, _frameCount);
+            }
             ++stateItr;
         } else {
             ++stateItr;
@@ -79,6 +96,7 @@ void PhysicsEngine::removeEntityInternal(EntityItem* entity) {
         _entityMotionStates.remove(motionState);
         _incomingChanges.remove(motionState);
         _outgoingPackets.remove(motionState);
+        _entitiesThatMoved.remove(entity);
         delete motionState;
     }
 }
@@ -97,6 +115,11 @@ void PhysicsEngine::entityChangedInternal(EntityItem* entity) {
 }
 
 void PhysicsEngine::sortEntitiesThatMovedInternal() {
+    if (isAuthoritative()) {
+        // the entities being sorted are the ones we just sent, they're already in the outgoingPackets list
+        return;
+    }
+
     // entities that have been simulated forward (hence in the _entitiesToBeSorted list) 
     // also need to be put in the outgoingPackets list
     QSet<EntityItem*>::iterator entityItr = _entitiesToBeSorted.begin();
@@ -120,6 +143,7 @@ void PhysicsEngine::clearEntitiesInternal() {
     _entityMotionStates.clear();
     _incomingChanges.clear();
     _outgoingPackets.clear();
+    _entitiesThatMoved.clear();
 }
 // end EntitySimulation overrides
 
@@ -191,9 +215,14 @@ void PhysicsEngine::init(EntityEditPacketSender* packetSender) {
         }
     }
 
-    assert(packetSender);
     _entityPacketSender = packetSender;
-    EntityMotionState::setOutgoingEntityList(&_entitiesToBeSorted);
+    EntityMotionState::setIsAuthoritative(isAuthoritative());
+    if (isAuthoritative()) {
+        // moved bodies are only copied into their entities when they need to be sent, which happens in step (4)
+        EntityMotionState::setOutgoingEntityList(&_entitiesThatMoved);
+    } else {
+        EntityMotionState::setOutgoingEntityList(&_entitiesToBeSorted);
+    }
 }
 
 const float FIXED_SUBSTEP = 1.0f / 60.0f;
@@ -44,8 +44,12 @@ public:
     void sortEntitiesThatMovedInternal();
     void clearEntitiesInternal();
 
+    /// \param packetSender sends the changes this simulation makes to the entity server, NULL when this simulation is
+    /// the entity server's own, in which case it is the authority and its changes go out to the entity server's clients
     virtual void init(EntityEditPacketSender* packetSender);
 
+    virtual bool isAuthoritative() const { return !_entityPacketSender; }
+
     void stepSimulation();
 
     /// \param offset position of simulation origin in domain-frame
@@ -90,6 +94,7 @@ private:
     QSet<EntityMotionState*> _entityMotionStates; // all entities that we track
     QSet<ObjectMotionState*> _incomingChanges; // entities with pending physics changes by script or packet
     QSet<ObjectMotionState*> _outgoingPackets; // MotionStates with pending changes that need to be sent over wire
+    QSet<EntityItem*> _entitiesThatMoved; // entities whose bodies moved, when the simulation is authoritative
 
     EntityEditPacketSender* _entityPacketSender;
 
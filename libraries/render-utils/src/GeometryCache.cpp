@@ -1798,6 +1798,64 @@ void NetworkGeometry::setTextureWithNameToURL(const QString& name, const QUrl& u
     }
 }
 
+QSharedPointer<const QVector<TriangleBVH> > NetworkGeometry::getMeshTriangleBVHs() {
+    // models pick against the hierarchies on the main thread and the entity scripting interface on script threads, so
+    // they're built by whichever asks first while the others wait, and handed out only once finished
+    QMutexLocker locker(&_meshTriangleBVHsMutex);
+    if (_meshTriangleBVHs) {
+        return _meshTriangleBVHs;
+    }
+    QVector<TriangleBVH>* meshTriangleBVHs = new QVector<TriangleBVH>(_geometry.meshes.size());
+    for (int i = 0; i < _geometry.meshes.size(); i++) {
+        const FBXMesh& mesh = _geometry.meshes.at(i);
+        glm::mat4 meshToGeometry = _geometry.offset * mesh.modelTransform;
+
+        QVector<glm::vec3> vertices(mesh.vertices.size());
+        for (int j = 0; j < mesh.vertices.size(); j++) {
+            vertices[j] = glm::vec3(meshToGeometry * glm::vec4(mesh.vertices.at(j), 1.0f));
+        }
+
+        QVector<Triangle> triangles;
+        foreach (const FBXMeshPart& part, mesh.parts) {
+            const int INDICES_PER_TRIANGLE = 3;
+            const int INDICES_PER_QUAD = 4;
+
+            for (int j = 0; j + INDICES_PER_QUAD <= part.quadIndices.size(); j += INDICES_PER_QUAD) {
+                const glm::vec3& v0 = vertices.at(part.quadIndices.at(j));
+                const glm::vec3& v1 = vertices.at(part.quadIndices.at(j + 1));
+                const glm::vec3& v2 = vertices.at(part.quadIndices.at(j + 2));
+                const glm::vec3& v3 = vertices.at(part.quadIndices.at(j + 3));
+
+                // Sam's recommended triangle slices
+                Triangle tri1 = { v0, v1, v3 };
+                Triangle tri2 = { v1, v2, v3 };
+                triangles.append(tri1);
+                triangles.append(tri2);
+            }
+            for (int j = 0; j + INDICES_PER_TRIANGLE <= part.triangleIndices.size(); j += INDICES_PER_TRIANGLE) {
+                Triangle tri = { vertices.at(part.triangleIndices.at(j)), vertices.at(part.triangleIndices.at(j + 1)),
+                    vertices.at(part.triangleIndices.at(j + 2)) };
+                triangles.append(tri);
+            }
+        }
+        (*meshTriangleBVHs)[i].build(triangles);
+    }
+    _meshTriangleBVHs = QSharedPointer<const QVector<TriangleBVH> >(meshTriangleBVHs);
+    return _meshTriangleBVHs;
+}
+
+QSharedPointer<const QVector<PackedBlendshapes> > NetworkGeometry::getPackedBlendshapes() {
+    if (!_packedBlendshapes) {
+        QVector<PackedBlendshapes>* packedBlendshapes = new QVector<PackedBlendshapes>();
+        packedBlendshapes->reserve(_geometry.meshes.size());
+        foreach (const FBXMesh& mesh, _geometry.meshes) {
+            packedBlendshapes->append(PackedBlendshapes(mesh));
+        }
+        _packedBlendshapes = QSharedPointer<const QVector<PackedBlendshapes> >(packedBlendshapes);
+    }
+    return _packedBlendshapes;
+}
+
 QStringList NetworkGeometry::getTextureNames() const {
     QStringList result;
     for (int i = 0; i < _meshes.size(); i++) {
@@ -1910,8 +1968,13 @@ void GeometryReader::run() {
 
 void NetworkGeometry::init() {
     _mapping = QVariantHash();
-    _geometry = FBXGeometry();
+    {
+        QMutexLocker locker(&_meshTriangleBVHsMutex);
+        _geometry = FBXGeometry();
+        _meshTriangleBVHs.clear();
+    }
     _meshes.clear();
+    _packedBlendshapes.clear();
     _lods.clear();
     _pendingTextureChanges.clear();
     _request.setUrl(_url);
@@ -1970,7 +2033,13 @@ void NetworkGeometry::reinsert() {
 }
 
 void NetworkGeometry::setGeometry(const FBXGeometry& geometry) {
-    _geometry = geometry;
+    {
+        // anyone still picking against the old hierarchies keeps them until done
+        QMutexLocker locker(&_meshTriangleBVHsMutex);
+        _geometry = geometry;
+        _meshTriangleBVHs.clear();
+    }
+    _packedBlendshapes.clear();
 
     TextureCache::SharedPointer textureCache = DependencyManager::get<TextureCache>();
     
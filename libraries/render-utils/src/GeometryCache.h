@@ -16,12 +16,15 @@
 #include <gpu/GPUConfig.h>
 
 #include <QMap>
+#include <QMutex>
 #include <QOpenGLBuffer>
 
 #include <DependencyManager.h>
 #include <ResourceCache.h>
 
 #include <FBXReader.h>
+#include <PackedBlendshapes.h>
+#include <TriangleBVH.h>
 
 #include <AnimationCache.h>
 
@@ -212,6 +215,15 @@ public:
     const FBXGeometry& getFBXGeometry() const { return _geometry; }
     const QVector<NetworkMesh>& getMeshes() const { return _meshes; }
 
+    /// Returns a hierarchy over the triangles of each mesh, in the geometry's frame (with the offset applied but before
+    /// any model's scale, rotation and translation), built the first time it's asked for and shared by all models.
+    /// May be called from any thread; the hierarchies returned stay valid after the geometry has changed.
+    QSharedPointer<const QVector<TriangleBVH> > getMeshTriangleBVHs();
+
+    /// Returns each mesh's blendshapes packed for blending, built the first time it's asked for and shared with the
+    /// blenders, which may still be using it after the geometry has changed.
+    QSharedPointer<const QVector<PackedBlendshapes> > getPackedBlendshapes();
+
     QVector<int> getJointMappings(const AnimationPointer& animation);
 
     virtual void setLoadPriority(const QPointer<QObject>& owner, float priority);
@@ -244,6 +256,9 @@ private:
     QMap<float, QSharedPointer<NetworkGeometry> > _lods;
     FBXGeometry _geometry;
     QVector<NetworkMesh> _meshes;
+    QMutex _meshTriangleBVHsMutex; // guards _meshTriangleBVHs and, against the builder, _geometry
+    QSharedPointer<const QVector<TriangleBVH> > _meshTriangleBVHs;
+    QSharedPointer<const QVector<PackedBlendshapes> > _packedBlendshapes;
     
     QWeakPointer<NetworkGeometry> _lodParent;
     
@@ -63,7 +63,6 @@ using namespace std;
 
 static int modelPointerTypeId = qRegisterMetaType<QPointer<Model> >();
 static int weakNetworkGeometryPointerTypeId = qRegisterMetaType<QWeakPointer<NetworkGeometry> >();
-static int vec3VectorTypeId = qRegisterMetaType<QVector<glm::vec3> >();
 float Model::FAKE_DIMENSION_PLACEHOLDER = -1.0f;
 
 Model::Model(QObject* parent) :
@@ -80,8 +79,9 @@ Model::Model(QObject* parent) :
     _url("http://invalid.com"),
     _blendNumber(0),
     _appliedBlendNumber(0),
+    _pendingBlendNumber(0),
+    _blendRequested(false),
     _calculatedMeshBoxesValid(false),
-    _calculatedMeshTrianglesValid(false),
     _meshGroupsKnown(false) {
     
     // we may have been created in the network thread, but we live in the main thread
@@ -402,7 +402,9 @@ bool Model::updateGeometry() {
    
     if (needToRebuild) {
         const FBXGeometry& fbxGeometry = geometry->getFBXGeometry();
-        foreach (const FBXMesh& mesh, fbxGeometry.meshes) {
+        _blendedMeshes = QSharedPointer<QVector<BlendedMesh> >(new QVector<BlendedMesh>(fbxGeometry.meshes.size()));
+        for (int i = 0; i < fbxGeometry.meshes.size(); i++) {
+            const FBXMesh& mesh = fbxGeometry.meshes.at(i);
             MeshState state;
             state.clusterMatrices.resize(mesh.clusters.size());
             _meshStates.append(state);    
@@ -413,6 +415,7 @@ bool Model::updateGeometry() {
                 buffer->setSubData(0, mesh.vertices.size() * sizeof(glm::vec3), (gpu::Resource::Byte*) mesh.vertices.constData());
                 buffer->setSubData(mesh.vertices.size() * sizeof(glm::vec3),
                     mesh.normals.size() * sizeof(glm::vec3), (gpu::Resource::Byte*) mesh.normals.constData());
+                (*_blendedMeshes)[i].reset(mesh);
             }
             _blendedVertexBuffers.push_back(buffer);
         }
@@ -485,30 +488,48 @@ bool Model::findRayIntersectionAgainstSubMeshes(const glm::vec3& origin, const g
 
         const FBXGeometry& geometry = _geometry->getFBXGeometry();
 
+        // the submesh boxes are otherwise only brought up to date for rendering
+        recalculateMeshBoxes();
+
+        // The triangles are kept in the geometry's frame, shared by every model using it, so rather than moving them
+        // into the world we move the ray into their frame. Its direction is normalized there, so that the triangle test's
+        // epsilon doesn't depend on the model's scale, and distances along it are converted back by the length the
+        // direction had. A mirroring scale turns the triangles inside out, so their winding must be flipped.
+        glm::vec3 geometryFrameOrigin, geometryFrameDirection;
+        float geometryFrameDirectionLength = 1.0f;
+        bool flipWinding = false;
+        QSharedPointer<const QVector<TriangleBVH> > meshTriangleBVHs;
+        if (pickAgainstTriangles) {
+            if (_scale.x == 0.0f || _scale.y == 0.0f || _scale.z == 0.0f) {
+                return intersectedSomething; // the model is flattened, there are no triangles to hit
+            }
+            glm::quat inverseRotation = glm::inverse(_rotation);
+            geometryFrameOrigin = (inverseRotation * (origin - _translation)) / _scale - _offset;
+            geometryFrameDirection = (inverseRotation * direction) / _scale;
+            geometryFrameDirectionLength = glm::length(geometryFrameDirection);
+            if (geometryFrameDirectionLength == 0.0f) {
+                return intersectedSomething;
+            }
+            geometryFrameDirection /= geometryFrameDirectionLength;
+            flipWinding = (_scale.x * _scale.y * _scale.z) < 0.0f;
+            meshTriangleBVHs = _geometry->getMeshTriangleBVHs();
+        }
+
         // If we hit the models box, then consider the submeshes...
         foreach(const AABox& subMeshBox, _calculatedMeshBoxes) {
 
             if (subMeshBox.findRayIntersection(origin, direction, distanceToSubMesh, subMeshFace)) {
                 if (distanceToSubMesh < bestDistance) {
                     if (pickAgainstTriangles) {
-                        if (!_calculatedMeshTrianglesValid) {
-                            recalculateMeshBoxes(pickAgainstTriangles);
-                        }
                         // check our triangles here....
-                        const QVector<Triangle>& meshTriangles = _calculatedMeshTriangles[subMeshIndex];
-                        int t = 0;
-                        foreach (const Triangle& triangle, meshTriangles) {
-                            t++;
-                        
-                            float thisTriangleDistance;
-                            if (findRayTriangleIntersection(origin, direction, triangle, thisTriangleDistance)) {
-                                if (thisTriangleDistance < bestDistance) {
-                                    bestDistance = thisTriangleDistance;
-                                    intersectedSomething = true;
-                                    face = subMeshFace;
-                                    extraInfo = geometry.getModelNameOfMesh(subMeshIndex);
-                                }
-                            }
+                        const TriangleBVH& meshTriangles = meshTriangleBVHs->at(subMeshIndex);
+                        float geometryFrameDistance = bestDistance * geometryFrameDirectionLength;
+                        if (meshTriangles.findRayIntersection(geometryFrameOrigin, geometryFrameDirection,
+                                                              geometryFrameDistance, flipWinding)) {
+                            bestDistance = geometryFrameDistance / geometryFrameDirectionLength;
+                            intersectedSomething = true;
+                            face = subMeshFace;
+                            extraInfo = geometry.getModelNameOfMesh(subMeshIndex);
                         }
                     } else {
                         // this is the non-triangle picking case...
@@ -533,79 +554,18 @@ bool Model::findRayIntersectionAgainstSubMeshes(const glm::vec3& origin, const g
 }
 
 // TODO: we seem to call this too often when things haven't actually changed... look into optimizing this
-void Model::recalculateMeshBoxes(bool pickAgainstTriangles) {
-    bool calculatedMeshTrianglesNeeded = pickAgainstTriangles && !_calculatedMeshTrianglesValid;
-
-    if (!_calculatedMeshBoxesValid || calculatedMeshTrianglesNeeded) {
+void Model::recalculateMeshBoxes() {
+    if (!_calculatedMeshBoxesValid) {
         const FBXGeometry& geometry = _geometry->getFBXGeometry();
         int numberOfMeshes = geometry.meshes.size();
         _calculatedMeshBoxes.resize(numberOfMeshes);
-        _calculatedMeshTriangles.clear();
-        _calculatedMeshTriangles.resize(numberOfMeshes);
         for (int i = 0; i < numberOfMeshes; i++) {
             const FBXMesh& mesh = geometry.meshes.at(i);
             Extents scaledMeshExtents = calculateScaledOffsetExtents(mesh.meshExtents);
 
             _calculatedMeshBoxes[i] = AABox(scaledMeshExtents);
-
-            if (pickAgainstTriangles) {
-                QVector<Triangle> thisMeshTriangles;
-                for (int j = 0; j < mesh.parts.size(); j++) {
-                    const FBXMeshPart& part = mesh.parts.at(j);
-
-                    const int INDICES_PER_TRIANGLE = 3;
-                    const int INDICES_PER_QUAD = 4;
-
-                    if (part.quadIndices.size() > 0) {
-                        int numberOfQuads = part.quadIndices.size() / INDICES_PER_QUAD;
-                        int vIndex = 0;
-                        for (int q = 0; q < numberOfQuads; q++) {
-                            int i0 = part.quadIndices[vIndex++];
-                            int i1 = part.quadIndices[vIndex++];
-                            int i2 = part.quadIndices[vIndex++];
-                            int i3 = part.quadIndices[vIndex++];
-
-                            glm::vec3 v0 = calculateScaledOffsetPoint(glm::vec3(mesh.modelTransform * glm::vec4(mesh.vertices[i0], 1.0f)));
-                            glm::vec3 v1 = calculateScaledOffsetPoint(glm::vec3(mesh.modelTransform * glm::vec4(mesh.vertices[i1], 1.0f)));
-                            glm::vec3 v2 = calculateScaledOffsetPoint(glm::vec3(mesh.modelTransform * glm::vec4(mesh.vertices[i2], 1.0f)));
-                            glm::vec3 v3 = calculateScaledOffsetPoint(glm::vec3(mesh.modelTransform * glm::vec4(mesh.vertices[i3], 1.0f)));
-                        
-                            // Sam's recommended triangle slices
-                            Triangle tri1 = { v0, v1, v3 };
-                            Triangle tri2 = { v1, v2, v3 };
-                        
-                            // NOTE: Random guy on the internet's recommended triangle slices
-                            //Triangle tri1 = { v0, v1, v2 };
-                            //Triangle tri2 = { v2, v3, v0 };
-                        
-                            thisMeshTriangles.push_back(tri1);
-                            thisMeshTriangles.push_back(tri2);
-                        }
-                    }
-
-                    if (part.triangleIndices.size() > 0) {
-                        int numberOfTris = part.triangleIndices.size() / INDICES_PER_TRIANGLE;
-                        int vIndex = 0;
-                        for (int t = 0; t < numberOfTris; t++) {
-                            int i0 = part.triangleIndices[vIndex++];
-                            int i1 = part.triangleIndices[vIndex++];
-                            int i2 = part.triangleIndices[vIndex++];
-
-                            glm::vec3 v0 = calculateScaledOffsetPoint(glm::vec3(mesh.modelTransform * glm::vec4(mesh.vertices[i0], 1.0f)));
-                            glm::vec3 v1 = calculateScaledOffsetPoint(glm::vec3(mesh.modelTransform * glm::vec4(mesh.vertices[i1], 1.0f)));
-                            glm::vec3 v2 = calculateScaledOffsetPoint(glm::vec3(mesh.modelTransform * glm::vec4(mesh.vertices[i2], 1.0f)));
-
-                            Triangle tri = { v0, v1, v2 };
-
-                            thisMeshTriangles.push_back(tri);
-                        }
-                    }
-                }
-                _calculatedMeshTriangles[i] = thisMeshTriangles;
-            }
         }
         _calculatedMeshBoxesValid = true;
-        _calculatedMeshTrianglesValid = pickAgainstTriangles;
     }
 }
 
@@ -1038,7 +998,8 @@ class Blender : public QRunnable {
 public:
 
     Blender(Model* model, int blendNumber, const QWeakPointer<NetworkGeometry>& geometry,
-        const QVector<FBXMesh>& meshes, const QVector<float>& blendshapeCoefficients);
+        const QSharedPointer<const QVector<PackedBlendshapes> >& blendshapes,
+        const QSharedPointer<QVector<BlendedMesh> >& meshes, const QVector<float>& blendshapeCoefficients);
     
     virtual void run();
 
@@ -1047,53 +1008,36 @@ private:
     QPointer<Model> _model;
     int _blendNumber;
     QWeakPointer<NetworkGeometry> _geometry;
-    QVector<FBXMesh> _meshes;
+    QSharedPointer<const QVector<PackedBlendshapes> > _blendshapes;
+    QSharedPointer<QVector<BlendedMesh> > _meshes;
     QVector<float> _blendshapeCoefficients;
 };
 
 Blender::Blender(Model* model, int blendNumber, const QWeakPointer<NetworkGeometry>& geometry,
-        const QVector<FBXMesh>& meshes, const QVector<float>& blendshapeCoefficients) :
+        const QSharedPointer<const QVector<PackedBlendshapes> >& blendshapes,
+        const QSharedPointer<QVector<BlendedMesh> >& meshes, const QVector<float>& blendshapeCoefficients) :
     _model(model),
     _blendNumber(blendNumber),
     _geometry(geometry),
+    _blendshapes(blendshapes),
     _meshes(meshes),
     _blendshapeCoefficients(blendshapeCoefficients) {
 }
 
 void Blender::run() {
-    QVector<glm::vec3> vertices, normals;
     if (!_model.isNull()) {
-        int offset = 0;
-        foreach (const FBXMesh& mesh, _meshes) {
-            if (mesh.blendshapes.isEmpty()) {
-                continue;
-            }
-            vertices += mesh.vertices;
-            normals += mesh.normals;
-            glm::vec3* meshVertices = vertices.data() + offset;
-            glm::vec3* meshNormals = normals.data() + offset;
-            offset += mesh.vertices.size();
-            const float NORMAL_COEFFICIENT_SCALE = 0.01f;
-            for (int i = 0, n = qMin(_blendshapeCoefficients.size(), mesh.blendshapes.size()); i < n; i++) {
-                float vertexCoefficient = _blendshapeCoefficients.at(i);
-                if (vertexCoefficient < EPSILON) {
-                    continue;
-                }
-                float normalCoefficient = vertexCoefficient * NORMAL_COEFFICIENT_SCALE;
-                const FBXBlendshape& blendshape = mesh.blendshapes.at(i);
-                for (int j = 0; j < blendshape.indices.size(); j++) {
-                    int index = blendshape.indices.at(j);
-                    meshVertices[index] += blendshape.vertices.at(j) * vertexCoefficient;
-                    meshNormals[index] += blendshape.normals.at(j) * normalCoefficient;
-                }
+        // the model keeps the blended meshes between blends and doesn't touch them while we're in flight
+        for (int i = 0, n = qMin(_blendshapes->size(), _meshes->size()); i < n; i++) {
+            const PackedBlendshapes& blendshapes = _blendshapes->at(i);
+            if (!blendshapes.isEmpty()) {
+                (*_meshes)[i].blend(blendshapes, _blendshapeCoefficients);
             }
         }
     }
     // post the result to the geometry cache, which will dispatch to the model if still alive
     QMetaObject::invokeMethod(DependencyManager::get<ModelBlender>().data(), "setBlendedVertices",
         Q_ARG(const QPointer<Model>&, _model), Q_ARG(int, _blendNumber),
-        Q_ARG(const QWeakPointer<NetworkGeometry>&, _geometry), Q_ARG(const QVector<glm::vec3>&, vertices),
-        Q_ARG(const QVector<glm::vec3>&, normals));
+        Q_ARG(const QWeakPointer<NetworkGeometry>&, _geometry));
 }
 
 void Model::setScaleToFit(bool scaleToFit, const glm::vec3& dimensions) {
@@ -1177,7 +1121,6 @@ void Model::simulate(float deltaTime, bool fullUpdate) {
                     
     if (isActive() && fullUpdate) {
         _calculatedMeshBoxesValid = false; // if we have to simulate, we need to assume our mesh boxes are all invalid
-        _calculatedMeshTrianglesValid = false;
 
         // check for scale to fit
         if (_scaleToFit && !_scaledToFit) {
@@ -1518,34 +1461,54 @@ void Model::renderJointCollisionShapes(float alpha) {
 
 bool Model::maybeStartBlender() {
     const FBXGeometry& fbxGeometry = _geometry->getFBXGeometry();
-    if (fbxGeometry.hasBlendedMeshes()) {
-        QThreadPool::globalInstance()->start(new Blender(this, ++_blendNumber, _geometry,
-            fbxGeometry.meshes, _blendshapeCoefficients));
-        return true;
+    if (!fbxGeometry.hasBlendedMeshes() || !_blendedMeshes) {
+        return false;
+    }
+    if (_pendingBlendNumber != 0) {
+        // the blender in flight owns the blended meshes until it finishes
+        _blendRequested = true;
+        return false;
     }
-    return false;
+    _pendingBlendNumber = ++_blendNumber;
+    QThreadPool::globalInstance()->start(new Blender(this, _pendingBlendNumber, _geometry,
+        _geometry->getPackedBlendshapes(), _blendedMeshes, _blendshapeCoefficients));
+    return true;
 }
 
-void Model::setBlendedVertices(int blendNumber, const QWeakPointer<NetworkGeometry>& geometry,
-        const QVector<glm::vec3>& vertices, const QVector<glm::vec3>& normals) {
-    if (_geometry != geometry || _blendedVertexBuffers.empty() || blendNumber < _appliedBlendNumber) {
-        return;
+void Model::setBlendedVertices(int blendNumber, const QWeakPointer<NetworkGeometry>& geometry) {
+    if (blendNumber == _pendingBlendNumber) {
+        _pendingBlendNumber = 0;
     }
-    _appliedBlendNumber = blendNumber;
-    const FBXGeometry& fbxGeometry = _geometry->getFBXGeometry();    
-    int index = 0;
-    for (int i = 0; i < fbxGeometry.meshes.size(); i++) {
-        const FBXMesh& mesh = fbxGeometry.meshes.at(i);
-        if (mesh.blendshapes.isEmpty()) {
-            continue;
-        }
-
-        gpu::BufferPointer& buffer = _blendedVertexBuffers[i];
-        buffer->setSubData(0, mesh.vertices.size() * sizeof(glm::vec3), (gpu::Resource::Byte*) vertices.constData() + index*sizeof(glm::vec3));
-        buffer->setSubData(mesh.vertices.size() * sizeof(glm::vec3),
-            mesh.normals.size() * sizeof(glm::vec3), (gpu::Resource::Byte*) normals.constData() + index*sizeof(glm::vec3));
+    if (_geometry == geometry && !_blendedVertexBuffers.empty() && _blendedMeshes && blendNumber >= _appliedBlendNumber) {
+        _appliedBlendNumber = blendNumber;
+        const FBXGeometry& fbxGeometry = _geometry->getFBXGeometry();
+        for (int i = 0; i < fbxGeometry.meshes.size(); i++) {
+            const FBXMesh& mesh = fbxGeometry.meshes.at(i);
+            if (mesh.blendshapes.isEmpty()) {
+                continue;
+            }
 
-        index += mesh.vertices.size();
+            // only the vertices the blend moved or put back need to go to the buffer
+            BlendedMesh& blendedMesh = (*_blendedMeshes)[i];
+            int first = blendedMesh.getFirstChangedVertex();
+            int count = blendedMesh.getNumChangedVertices();
+            if (count == 0) {
+                continue;
+            }
+            gpu::BufferPointer& buffer = _blendedVertexBuffers[i];
+            buffer->setSubData(first * sizeof(glm::vec3), count * sizeof(glm::vec3),
+                (gpu::Resource::Byte*) (blendedMesh.getVertices().constData() + first));
+            int normalCount = qMin(count, mesh.normals.size() - first);
+            if (normalCount > 0) {
+                buffer->setSubData((mesh.vertices.size() + first) * sizeof(glm::vec3), normalCount * sizeof(glm::vec3),
+                    (gpu::Resource::Byte*) (blendedMesh.getNormals().constData() + first));
+            }
+            blendedMesh.clearChanges();
+        }
+    }
+    if (_pendingBlendNumber == 0 && _blendRequested) {
+        _blendRequested = false;
+        DependencyManager::get<ModelBlender>()->noteRequiresBlend(this);
     }
 }
 
@@ -1569,6 +1532,7 @@ void Model::deleteGeometry() {
     }
     _attachments.clear();
     _blendedVertexBuffers.clear();
+    _blendedMeshes.clear();
     _jointStates.clear();
     _meshStates.clear();
     clearShapes();
@@ -2504,9 +2468,9 @@ void ModelBlender::noteRequiresBlend(Model* model) {
 }
 
 void ModelBlender::setBlendedVertices(const QPointer<Model>& model, int blendNumber,
-        const QWeakPointer<NetworkGeometry>& geometry, const QVector<glm::vec3>& vertices, const QVector<glm::vec3>& normals) {
+        const QWeakPointer<NetworkGeometry>& geometry) {
     if (!model.isNull()) {
-        model->setBlendedVertices(blendNumber, geometry, vertices, normals);
+        model->setBlendedVertices(blendNumber, geometry);
     }
     _pendingBlenders--;
     while (!_modelsRequiringBlends.isEmpty()) {
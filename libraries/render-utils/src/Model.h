@@ -185,11 +185,11 @@ public:
 
     virtual void renderJointCollisionShapes(float alpha);
     
+    /// Starts a blend unless one is already in flight, in which case another is started when it finishes.
     bool maybeStartBlender();
     
-    /// Sets blended vertices computed in a separate thread.
-    void setBlendedVertices(int blendNumber, const QWeakPointer<NetworkGeometry>& geometry,
-        const QVector<glm::vec3>& vertices, const QVector<glm::vec3>& normals);
+    /// Uploads the vertices changed by a blend computed in a separate thread.
+    void setBlendedVertices(int blendNumber, const QWeakPointer<NetworkGeometry>& geometry);
 
     void setShowTrueJointTransforms(bool show) { _showTrueJointTransforms = show; }
 
@@ -291,6 +291,7 @@ private:
     QUrl _url;
 
     gpu::Buffers _blendedVertexBuffers;
+    QSharedPointer<QVector<BlendedMesh> > _blendedMeshes; // written by the blender in flight, if any
     std::vector<Transform> _transforms;
     gpu::Batch _renderBatch;
 
@@ -305,6 +306,8 @@ private:
     QVector<float> _blendedBlendshapeCoefficients;
     int _blendNumber;
     int _appliedBlendNumber;
+    int _pendingBlendNumber; // zero when no blend is in flight
+    bool _blendRequested;
 
     static ProgramObject _program;
     static ProgramObject _normalMapProgram;
@@ -371,11 +374,8 @@ private:
 
     QVector<AABox> _calculatedMeshBoxes; // world coordinate AABoxes for all sub mesh boxes
     bool _calculatedMeshBoxesValid;
-    
-    QVector< QVector<Triangle> > _calculatedMeshTriangles; // world coordinate triangles for all sub meshes
-    bool _calculatedMeshTrianglesValid;
 
-    void recalculateMeshBoxes(bool pickAgainstTriangles = false);
+    void recalculateMeshBoxes();
 
     void segregateMeshGroups(); // used to calculate our list of translucent vs opaque meshes
 
@@ -464,7 +464,6 @@ private:
 
 Q_DECLARE_METATYPE(QPointer<Model>)
 Q_DECLARE_METATYPE(QWeakPointer<NetworkGeometry>)
-Q_DECLARE_METATYPE(QVector<glm::vec3>)
 
 /// Handle management of pending models that need blending
 class ModelBlender : public QObject  {
@@ -477,8 +476,7 @@ public:
     void noteRequiresBlend(Model* model);
 
 public slots:
-    void setBlendedVertices(const QPointer<Model>& model, int blendNumber, const QWeakPointer<NetworkGeometry>& geometry,
-        const QVector<glm::vec3>& vertices, const QVector<glm::vec3>& normals);
+    void setBlendedVertices(const QPointer<Model>& model, int blendNumber, const QWeakPointer<NetworkGeometry>& geometry);
 
 private:
     ModelBlender();
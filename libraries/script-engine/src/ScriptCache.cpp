@@ -0,0 +1,147 @@
+//
+//  ScriptCache.cpp
+//  libraries/script-engine/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QEventLoop>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QThread>
+#include <QtNetwork/QNetworkDiskCache>
+#include <QtNetwork/QNetworkReply>
+#include <QtNetwork/QNetworkRequest>
+
+#include <NetworkAccessManager.h>
+#include <SharedUtil.h>
+
+#include "ScriptCache.h"
+
+const int HTTP_OK = 200;
+const int HTTP_NOT_MODIFIED = 304;
+
+ScriptCache::ScriptCache() {
+    // the requests are made from the main thread, which is always processing events, whichever thread asked first
+    if (QCoreApplication::instance()) {
+        moveToThread(QCoreApplication::instance()->thread());
+    }
+}
+
+QNetworkAccessManager& ScriptCache::getNetworkAccessManager() {
+    // the manager is this thread's, which doesn't have the disk cache that the thread that set up the process may have
+    // given its own. The cache has a directory of its own too, since two disk caches can't share one
+    QNetworkAccessManager& networkAccessManager = NetworkAccessManager::getInstance();
+    if (!networkAccessManager.cache()) {
+        QNetworkDiskCache* cache = new QNetworkDiskCache();
+        QString cachePath = QStandardPaths::writableLocation(QStandardPaths::DataLocation);
+        cache->setCacheDirectory((!cachePath.isEmpty() ? cachePath : "scriptCache") + "/scripts");
+        networkAccessManager.setCache(cache);
+    }
+    return networkAccessManager;
+}
+
+bool ScriptCache::isCacheable(const QUrl& url) {
+    return url.scheme() == "http" || url.scheme() == "https" || url.scheme() == "ftp";
+}
+
+QScriptProgram ScriptCache::getProgram(const QUrl& url) {
+    QMutexLocker locker(&_entriesMutex);
+    QHash<QUrl, Entry>::iterator entry = _entries.find(url);
+    if (entry == _entries.end()) {
+        return QScriptProgram();
+    }
+
+    // keep using what we have while we check whether it's changed
+    if (!entry->isLoading && usecTimestampNow() - entry->validated > SCRIPT_CACHE_REVALIDATE_USECS) {
+        entry->isLoading = true;
+        QMetaObject::invokeMethod(this, "startRequest", Qt::QueuedConnection, Q_ARG(const QUrl&, url));
+    }
+    return QScriptProgram(entry->program.sourceCode(), entry->program.fileName());
+}
+
+void ScriptCache::loadPrograms(const QList<QUrl>& urls) {
+    // listen before starting anything, so that a request finishing right away can't be missed
+    QEventLoop loop;
+    connect(this, &ScriptCache::loadingFinished, &loop, &QEventLoop::quit);
+
+    {
+        QMutexLocker locker(&_entriesMutex);
+        foreach (const QUrl& url, urls) {
+            Entry& entry = _entries[url];
+            if (!entry.isLoading && entry.program.isNull()) {
+                entry.isLoading = true;
+                QMetaObject::invokeMethod(this, "startRequest", Qt::QueuedConnection, Q_ARG(const QUrl&, url));
+            }
+        }
+    }
+
+    while (isLoading(urls)) {
+        loop.exec();
+    }
+}
+
+bool ScriptCache::isLoading(const QList<QUrl>& urls) {
+    QMutexLocker locker(&_entriesMutex);
+    foreach (const QUrl& url, urls) {
+        QHash<QUrl, Entry>::const_iterator entry = _entries.constFind(url);
+
+        // a revalidation doesn't hold anyone up as long as there's a program to go on with
+        if (entry != _entries.constEnd() && entry->isLoading && entry->program.isNull()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ScriptCache::startRequest(const QUrl& url) {
+    QNetworkRequest request(url);
+    {
+        QMutexLocker locker(&_entriesMutex);
+        const Entry& entry = _entries[url];
+        if (!entry.program.isNull() && !entry.etag.isEmpty()) {
+            request.setRawHeader("If-None-Match", entry.etag);
+        }
+    }
+    qDebug() << "Downloading script at" << url.toString();
+    QNetworkReply* reply = getNetworkAccessManager().get(request);
+    connect(reply, &QNetworkReply::finished, this, &ScriptCache::handleReply);
+}
+
+void ScriptCache::handleReply() {
+    QNetworkReply* reply = static_cast<QNetworkReply*>(sender());
+    QUrl url = reply->request().url();
+    int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+    // read outside of the lock, scripts can be large
+    QScriptProgram program;
+    if (reply->error() == QNetworkReply::NoError && statusCode == HTTP_OK) {
+        program = QScriptProgram(QString(reply->readAll()), url.toString());
+    }
+    {
+        QMutexLocker locker(&_entriesMutex);
+        Entry& entry = _entries[url];
+        entry.isLoading = false;
+        if (!program.isNull()) {
+            entry.program = program;
+            entry.etag = reply->rawHeader("ETag");
+            entry.validated = usecTimestampNow();
+
+        } else if (statusCode == HTTP_NOT_MODIFIED) {
+            entry.validated = usecTimestampNow();
+
+        } else if (entry.program.isNull()) {
+            qDebug() << "ERROR Loading script at" << url.toString() << ":" << reply->errorString();
+
+            // forget the failure so that the next engine to ask tries again
+            _entries.remove(url);
+        }
+    }
+    reply->deleteLater();
+
+    emit loadingFinished();
+}
@@ -0,0 +1,79 @@
+//
+//  ScriptCache.h
+//  libraries/script-engine/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_ScriptCache_h
+#define hifi_ScriptCache_h
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QUrl>
+#include <QtScript/QScriptProgram>
+
+#include <DependencyManager.h>
+
+class QNetworkAccessManager;
+
+// how long a script is used as is before it's checked against the server's copy again
+const quint64 SCRIPT_CACHE_REVALIDATE_USECS = 60 * 1000 * 1000;
+
+/// The scripts downloaded by every script engine in the process, so that a library included by many scripts is
+/// downloaded once. Scripts are kept by URL, and revalidated against their ETags now and then while the
+/// copy on hand goes on being used. The downloads also go through a disk cache, so that a restarted process
+/// revalidates what it had rather than downloading it all again. Any thread may use the cache.
+class ScriptCache : public QObject {
+    Q_OBJECT
+    SINGLETON_DEPENDENCY(ScriptCache)
+
+public:
+    /// Returns the script at the URL, or a null program if it hasn't been loaded (or couldn't be). QtScript compiles a
+    /// program for the engine that last ran it, so each call gets a program of its own that the caller can keep and run
+    /// as often as it likes without recompiling.
+    QScriptProgram getProgram(const QUrl& url);
+
+    /// Loads the scripts at the URLs that haven't been, all at once rather than one after another, and waits for them
+    /// while processing the calling thread's events. Returns right away if every script is already loaded.
+    void loadPrograms(const QList<QUrl>& urls);
+
+    /// whether the script at the URL is downloaded, and so kept here - local scripts are just read again
+    static bool isCacheable(const QUrl& url);
+
+signals:
+    void loadingFinished();
+
+private slots:
+    void startRequest(const QUrl& url);
+    void handleReply();
+
+private:
+    ScriptCache();
+
+    class Entry {
+    public:
+        Entry() : validated(0), isLoading(false) { }
+
+        QScriptProgram program;
+        QByteArray etag;
+        quint64 validated;
+        bool isLoading;
+    };
+
+    bool isLoading(const QList<QUrl>& urls);
+
+    /// the manager our requests go through, with a disk cache set up the first time
+    QNetworkAccessManager& getNetworkAccessManager();
+
+    QMutex _entriesMutex;
+    QHash<QUrl, Entry> _entries;
+};
+
+#endif // hifi_ScriptCache_h
@@ -11,6 +11,7 @@
 
 #include <QtCore/QCoreApplication>
 #include <QtCore/QEventLoop>
+#include <QtCore/QSet>
 #include <QtCore/QTimer>
 #include <QtCore/QThread>
 #include <QtNetwork/QNetworkRequest>
@@ -34,6 +35,7 @@
 #include "DataViewClass.h"
 #include "EventTypes.h"
 #include "MenuItemProperties.h"
+#include "ScriptCache.h"
 #include "ScriptEngine.h"
 #include "TypedArrays.h"
 #include "XMLHttpRequestClass.h"
@@ -77,6 +79,7 @@ ScriptEngine::ScriptEngine(const QString& scriptContents, const QString& fileNam
     _isRunning(false),
     _isInitialized(false),
     _isAvatar(false),
+    _isHostedAvatar(false),
     _avatarIdentityTimer(NULL),
     _avatarBillboardTimer(NULL),
     _timerFunctionMap(),
@@ -91,7 +94,8 @@ ScriptEngine::ScriptEngine(const QString& scriptContents, const QString& fileNam
     _vec3Library(),
     _uuidLibrary(),
     _isUserLoaded(false),
-    _arrayBufferClass(new ArrayBufferClass(this))
+    _arrayBufferClass(new ArrayBufferClass(this)),
+    _lastUpdate(0)
 {
 }
 
@@ -290,6 +294,8 @@ void ScriptEngine::evaluate() {
         init();
     }
 
+    loadIncludes();
+
     QScriptValue result = evaluate(_scriptContents);
 
     if (hasUncaughtException()) {
@@ -324,30 +330,13 @@ void ScriptEngine::sendAvatarBillboardPacket() {
 }
 
 void ScriptEngine::run() {
-    if (!_isInitialized) {
-        init();
-    }
-    _isRunning = true;
-    _isFinished = false;
-    emit runningStateChanged();
-
-    QScriptValue result = evaluate(_scriptContents);
-    if (hasUncaughtException()) {
-        int line = uncaughtExceptionLineNumber();
-        qDebug() << "Uncaught exception at (" << _fileNameString << ") line" << line << ":" << result.toString();
-        emit errorMessage("Uncaught exception at (" + _fileNameString + ") line" + QString::number(line) + ":" + result.toString());
-        clearExceptions();
-    }
+    startRunning();
 
     QElapsedTimer startTime;
     startTime.start();
 
     int thisFrame = 0;
 
-    NodeList* nodeList = NodeList::getInstance();
-
-    qint64 lastUpdate = usecTimestampNow();
-
     while (!_isFinished) {
         int usecToSleep = (thisFrame++ * SCRIPT_DATA_CALLBACK_USECS) - startTime.nsecsElapsed() / 1000; // nsec to usec
         if (usecToSleep > 0) {
@@ -364,134 +353,180 @@ void ScriptEngine::run() {
             break;
         }
 
-        if (_entityScriptingInterface.getEntityPacketSender()->serversExist()) {
-            // release the queue of edit entity messages.
-            _entityScriptingInterface.getEntityPacketSender()->releaseQueuedMessages();
+        releaseEntityEditPackets();
 
-            // since we're in non-threaded mode, call process so that the packets are sent
-            if (!_entityScriptingInterface.getEntityPacketSender()->isThreaded()) {
-                _entityScriptingInterface.getEntityPacketSender()->process();
-            }
+        runFrame();
+    }
+
+    finishRunning();
+
+    // If we were on a thread, then wait till it's done
+    if (thread()) {
+        thread()->quit();
+    }
+}
+
+void ScriptEngine::startRunning() {
+    if (!_isInitialized) {
+        init();
+    }
+    _isRunning = true;
+    _isFinished = false;
+    emit runningStateChanged();
+
+    loadIncludes();
+
+    QScriptValue result = evaluate(_scriptContents);
+    if (hasUncaughtException()) {
+        int line = uncaughtExceptionLineNumber();
+        qDebug() << "Uncaught exception at (" << _fileNameString << ") line" << line << ":" << result.toString();
+        emit errorMessage("Uncaught exception at (" + _fileNameString + ") line" + QString::number(line) + ":" + result.toString());
+        clearExceptions();
+    }
+
+    _lastUpdate = usecTimestampNow();
+}
+
+void ScriptEngine::runFrame() {
+    if (_isAvatar && _avatarData) {
+        QByteArray avatarPacket;
+        if (_isHostedAvatar) {
+            avatarPacket = byteArrayWithPopulatedHeader(PacketTypeHostedAvatarData);
+            avatarPacket.append(_avatarData->getSessionUUID().toRfc4122());
+        } else {
+            avatarPacket = byteArrayWithPopulatedHeader(PacketTypeAvatarData);
         }
+        avatarPacket.append(_avatarData->toByteArray());
 
-        if (_isAvatar && _avatarData) {
+        NodeList::getInstance()->broadcastToNodes(avatarPacket, NodeSet() << NodeType::AvatarMixer);
 
-            const int SCRIPT_AUDIO_BUFFER_SAMPLES = floor(((SCRIPT_DATA_CALLBACK_USECS * AudioConstants::SAMPLE_RATE)
-                                                           / (1000 * 1000)) + 0.5);
-            const int SCRIPT_AUDIO_BUFFER_BYTES = SCRIPT_AUDIO_BUFFER_SAMPLES * sizeof(int16_t);
+        if (_isListeningToAudioStream || _avatarSound) {
+            sendAvatarAudioFrame();
+        }
+    }
 
-            QByteArray avatarPacket = byteArrayWithPopulatedHeader(PacketTypeAvatarData);
-            avatarPacket.append(_avatarData->toByteArray());
+    quint64 now = usecTimestampNow();
+    float deltaTime = (float) (now - _lastUpdate) / (float) USECS_PER_SECOND;
 
-            nodeList->broadcastToNodes(avatarPacket, NodeSet() << NodeType::AvatarMixer);
+    if (hasUncaughtException()) {
+        int line = uncaughtExceptionLineNumber();
+        qDebug() << "Uncaught exception at (" << _fileNameString << ") line" << line << ":" << uncaughtException().toString();
+        emit errorMessage("Uncaught exception at (" + _fileNameString + ") line" + QString::number(line) + ":" + uncaughtException().toString());
+        clearExceptions();
+    }
 
-            if (_isListeningToAudioStream || _avatarSound) {
-                // if we have an avatar audio stream then send it out to our audio-mixer
-                bool silentFrame = true;
+    emit update(deltaTime);
+    _lastUpdate = now;
+}
 
-                int16_t numAvailableSamples = SCRIPT_AUDIO_BUFFER_SAMPLES;
-                const int16_t* nextSoundOutput = NULL;
+void ScriptEngine::sendAvatarAudioFrame() {
+    const int SCRIPT_AUDIO_BUFFER_SAMPLES = floor(((SCRIPT_DATA_CALLBACK_USECS * AudioConstants::SAMPLE_RATE)
+                                                   / (1000 * 1000)) + 0.5);
+    const int SCRIPT_AUDIO_BUFFER_BYTES = SCRIPT_AUDIO_BUFFER_SAMPLES * sizeof(int16_t);
 
-                if (_avatarSound) {
+    // if we have an avatar audio stream then send it out to our audio-mixer
+    bool silentFrame = true;
 
-                    const QByteArray& soundByteArray = _avatarSound->getByteArray();
-                    nextSoundOutput = reinterpret_cast<const int16_t*>(soundByteArray.data()
-                                                                       + _numAvatarSoundSentBytes);
+    int16_t numAvailableSamples = SCRIPT_AUDIO_BUFFER_SAMPLES;
+    const int16_t* nextSoundOutput = NULL;
 
-                    int numAvailableBytes = (soundByteArray.size() - _numAvatarSoundSentBytes) > SCRIPT_AUDIO_BUFFER_BYTES
-                        ? SCRIPT_AUDIO_BUFFER_BYTES
-                        : soundByteArray.size() - _numAvatarSoundSentBytes;
-                    numAvailableSamples = numAvailableBytes / sizeof(int16_t);
+    if (_avatarSound) {
 
+        const QByteArray& soundByteArray = _avatarSound->getByteArray();
+        nextSoundOutput = reinterpret_cast<const int16_t*>(soundByteArray.data()
+                                                           + _numAvatarSoundSentBytes);
 
-                    // check if the all of the _numAvatarAudioBufferSamples to be sent are silence
-                    for (int i = 0; i < numAvailableSamples; ++i) {
-                        if (nextSoundOutput[i] != 0) {
-                            silentFrame = false;
-                            break;
-                        }
-                    }
+        int numAvailableBytes = (soundByteArray.size() - _numAvatarSoundSentBytes) > SCRIPT_AUDIO_BUFFER_BYTES
+            ? SCRIPT_AUDIO_BUFFER_BYTES
+            : soundByteArray.size() - _numAvatarSoundSentBytes;
+        numAvailableSamples = numAvailableBytes / sizeof(int16_t);
 
-                    _numAvatarSoundSentBytes += numAvailableBytes;
-                    if (_numAvatarSoundSentBytes == soundByteArray.size()) {
-                        // we're done with this sound object - so set our pointer back to NULL
-                        // and our sent bytes back to zero
-                        _avatarSound = NULL;
-                        _numAvatarSoundSentBytes = 0;
-                    }
-                }
-                
-                QByteArray audioPacket = byteArrayWithPopulatedHeader(silentFrame
-                                                                      ? PacketTypeSilentAudioFrame
-                                                                      : PacketTypeMicrophoneAudioNoEcho);
-
-                QDataStream packetStream(&audioPacket, QIODevice::Append);
-
-                // pack a placeholder value for sequence number for now, will be packed when destination node is known
-                int numPreSequenceNumberBytes = audioPacket.size();
-                packetStream << (quint16) 0;
-
-                if (silentFrame) {
-                    if (!_isListeningToAudioStream) {
-                        // if we have a silent frame and we're not listening then just send nothing and break out of here
-                        break;
-                    }
-
-                    // write the number of silent samples so the audio-mixer can uphold timing
-                    packetStream.writeRawData(reinterpret_cast<const char*>(&SCRIPT_AUDIO_BUFFER_SAMPLES), sizeof(int16_t));
-
-                    // use the orientation and position of this avatar for the source of this audio
-                    packetStream.writeRawData(reinterpret_cast<const char*>(&_avatarData->getPosition()), sizeof(glm::vec3));
-                    glm::quat headOrientation = _avatarData->getHeadOrientation();
-                    packetStream.writeRawData(reinterpret_cast<const char*>(&headOrientation), sizeof(glm::quat));
-
-                } else if (nextSoundOutput) {
-                    // assume scripted avatar audio is mono and set channel flag to zero
-                    packetStream << (quint8)0;
-
-                    // use the orientation and position of this avatar for the source of this audio
-                    packetStream.writeRawData(reinterpret_cast<const char*>(&_avatarData->getPosition()), sizeof(glm::vec3));
-                    glm::quat headOrientation = _avatarData->getHeadOrientation();
-                    packetStream.writeRawData(reinterpret_cast<const char*>(&headOrientation), sizeof(glm::quat));
-
-                    // write the raw audio data
-                    packetStream.writeRawData(reinterpret_cast<const char*>(nextSoundOutput), numAvailableSamples * sizeof(int16_t));
-                }
-                
-                // write audio packet to AudioMixer nodes
-                NodeList* nodeList = NodeList::getInstance();
-                nodeList->eachNode([this, &nodeList, &audioPacket, &numPreSequenceNumberBytes](const SharedNodePointer& node){
-                    // only send to nodes of type AudioMixer
-                    if (node->getType() == NodeType::AudioMixer) {
-                        // pack sequence number
-                        quint16 sequence = _outgoingScriptAudioSequenceNumbers[node->getUUID()]++;
-                        memcpy(audioPacket.data() + numPreSequenceNumberBytes, &sequence, sizeof(quint16));
-                        
-                        // send audio packet
-                        nodeList->writeDatagram(audioPacket, node);
-                    }
-                });
+
+        // check if the all of the _numAvatarAudioBufferSamples to be sent are silence
+        for (int i = 0; i < numAvailableSamples; ++i) {
+            if (nextSoundOutput[i] != 0) {
+                silentFrame = false;
+                break;
             }
         }
 
-        qint64 now = usecTimestampNow();
-        float deltaTime = (float) (now - lastUpdate) / (float) USECS_PER_SECOND;
-
-        if (hasUncaughtException()) {
-            int line = uncaughtExceptionLineNumber();
-            qDebug() << "Uncaught exception at (" << _fileNameString << ") line" << line << ":" << uncaughtException().toString();
-            emit errorMessage("Uncaught exception at (" + _fileNameString + ") line" + QString::number(line) + ":" + uncaughtException().toString());
-            clearExceptions();
+        _numAvatarSoundSentBytes += numAvailableBytes;
+        if (_numAvatarSoundSentBytes == soundByteArray.size()) {
+            // we're done with this sound object - so set our pointer back to NULL
+            // and our sent bytes back to zero
+            _avatarSound = NULL;
+            _numAvatarSoundSentBytes = 0;
         }
+    }
 
-        emit update(deltaTime);
-        lastUpdate = now;
+    if (silentFrame && !_isListeningToAudioStream) {
+        // if we have a silent frame and we're not listening then just send nothing
+        return;
     }
+
+    QByteArray audioPacket = byteArrayWithPopulatedHeader(silentFrame
+                                                          ? PacketTypeSilentAudioFrame
+                                                          : PacketTypeMicrophoneAudioNoEcho);
+
+    QDataStream packetStream(&audioPacket, QIODevice::Append);
+
+    // pack a placeholder value for sequence number for now, will be packed when destination node is known
+    int numPreSequenceNumberBytes = audioPacket.size();
+    packetStream << (quint16) 0;
+
+    if (silentFrame) {
+        // write the number of silent samples so the audio-mixer can uphold timing
+        packetStream.writeRawData(reinterpret_cast<const char*>(&SCRIPT_AUDIO_BUFFER_SAMPLES), sizeof(int16_t));
+
+        // use the orientation and position of this avatar for the source of this audio
+        packetStream.writeRawData(reinterpret_cast<const char*>(&_avatarData->getPosition()), sizeof(glm::vec3));
+        glm::quat headOrientation = _avatarData->getHeadOrientation();
+        packetStream.writeRawData(reinterpret_cast<const char*>(&headOrientation), sizeof(glm::quat));
+
+    } else if (nextSoundOutput) {
+        // assume scripted avatar audio is mono and set channel flag to zero
+        packetStream << (quint8)0;
+
+        // use the orientation and position of this avatar for the source of this audio
+        packetStream.writeRawData(reinterpret_cast<const char*>(&_avatarData->getPosition()), sizeof(glm::vec3));
+        glm::quat headOrientation = _avatarData->getHeadOrientation();
+        packetStream.writeRawData(reinterpret_cast<const char*>(&headOrientation), sizeof(glm::quat));
+
+        // write the raw audio data
+        packetStream.writeRawData(reinterpret_cast<const char*>(nextSoundOutput), numAvailableSamples * sizeof(int16_t));
+    }
+
+    // write audio packet to AudioMixer nodes
+    NodeList* nodeList = NodeList::getInstance();
+    nodeList->eachNode([this, &nodeList, &audioPacket, &numPreSequenceNumberBytes](const SharedNodePointer& node){
+        // only send to nodes of type AudioMixer
+        if (node->getType() == NodeType::AudioMixer) {
+            // pack sequence number
+            quint16 sequence = _outgoingScriptAudioSequenceNumbers[node->getUUID()]++;
+            memcpy(audioPacket.data() + numPreSequenceNumberBytes, &sequence, sizeof(quint16));
+
+            // send audio packet
+            nodeList->writeDatagram(audioPacket, node);
+        }
+    });
+}
+
+void ScriptEngine::finishRunning() {
     emit scriptEnding();
 
     // kill the avatar identity timer
     delete _avatarIdentityTimer;
+    _avatarIdentityTimer = NULL;
+
+    releaseEntityEditPackets();
 
+    emit finished(_fileNameString);
+
+    _isRunning = false;
+    emit runningStateChanged();
+}
+
+void ScriptEngine::releaseEntityEditPackets() {
     if (_entityScriptingInterface.getEntityPacketSender()->serversExist()) {
         // release the queue of edit entity messages.
         _entityScriptingInterface.getEntityPacketSender()->releaseQueuedMessages();
@@ -501,16 +536,6 @@ void ScriptEngine::run() {
             _entityScriptingInterface.getEntityPacketSender()->process();
         }
     }
-
-    // If we were on a thread, then wait till it's done
-    if (thread()) {
-        thread()->quit();
-    }
-
-    emit finished(_fileNameString);
-
-    _isRunning = false;
-    emit runningStateChanged();
 }
 
 void ScriptEngine::stop() {
@@ -595,19 +620,73 @@ void ScriptEngine::print(const QString& message) {
     emit printedMessage(message);
 }
 
+void ScriptEngine::loadIncludes() {
+    // resolved like include() resolves them, relative to our script however deeply they're nested
+    QList<QUrl> includes = findIncludes(_scriptContents);
+    QSet<QUrl> found = includes.toSet();
+    ScriptCache* scriptCache = DependencyManager::get<ScriptCache>().data();
+    while (!includes.isEmpty()) {
+        scriptCache->loadPrograms(includes);
+
+        QList<QUrl> nestedIncludes;
+        foreach (const QUrl& url, includes) {
+            foreach (const QUrl& nestedURL, findIncludes(scriptCache->getProgram(url).sourceCode())) {
+                if (!found.contains(nestedURL)) {
+                    found.insert(nestedURL);
+                    nestedIncludes.append(nestedURL);
+                }
+            }
+        }
+        includes = nestedIncludes;
+    }
+}
+
+QList<QUrl> ScriptEngine::findIncludes(const QString& scriptContents) const {
+    // only includes of literal names can be found ahead of time, others are downloaded when they're reached
+    static const QRegExp INCLUDE_REGEX("\\binclude\\s*\\(\\s*([\"'])([^\"']+)\\1\\s*\\)");
+    QRegExp includeRegex(INCLUDE_REGEX); // QRegExp keeps its matches, so each call needs its own
+    QList<QUrl> includes;
+    for (int position = 0; (position = includeRegex.indexIn(scriptContents, position)) != -1;
+            position += includeRegex.matchedLength()) {
+        QUrl url = resolvePath(includeRegex.cap(2));
+        if (ScriptCache::isCacheable(url) && !includes.contains(url)) {
+            includes.append(url);
+        }
+    }
+    return includes;
+}
+
 void ScriptEngine::include(const QString& includeFile) {
     QUrl url = resolvePath(includeFile);
     QString includeContents;
 
-    if (url.scheme() == "http" || url.scheme() == "https" || url.scheme() == "ftp") {
-        QNetworkAccessManager& networkAccessManager = NetworkAccessManager::getInstance();
-        QNetworkReply* reply = networkAccessManager.get(QNetworkRequest(url));
-        qDebug() << "Downloading included script at" << includeFile;
-        QEventLoop loop;
-        QObject::connect(reply, SIGNAL(finished()), &loop, SLOT(quit()));
-        loop.exec();
-        includeContents = reply->readAll();
-        reply->deleteLater();
+    if (ScriptCache::isCacheable(url)) {
+        QScriptProgram program = _includedPrograms.value(url);
+        if (program.isNull()) {
+            ScriptCache* scriptCache = DependencyManager::get<ScriptCache>().data();
+            program = scriptCache->getProgram(url);
+            if (program.isNull()) {
+                // not one that could be found ahead of time, so we wait for it
+                qDebug() << "Downloading included script at" << includeFile;
+                scriptCache->loadPrograms(QList<QUrl>() << url);
+                program = scriptCache->getProgram(url);
+            }
+            if (program.isNull()) {
+                qDebug() << "ERROR Including file:" << url.toString();
+                emit errorMessage("ERROR Including file:" + url.toString());
+                return;
+            }
+            _includedPrograms.insert(url, program);
+        }
+
+        QScriptValue result = QScriptEngine::evaluate(program);
+        if (hasUncaughtException()) {
+            int line = uncaughtExceptionLineNumber();
+            qDebug() << "Uncaught exception at (" << includeFile << ") line" << line << ":" << result.toString();
+            emit errorMessage("Uncaught exception at (" + includeFile + ") line" + QString::number(line) + ":" + result.toString());
+            clearExceptions();
+        }
+        return;
     } else {
 #ifdef _WIN32
         QString fileName = url.toString();
@@ -17,6 +17,7 @@
 #include <QtCore/QObject>
 #include <QtCore/QUrl>
 #include <QtScript/QScriptEngine>
+#include <QtScript/QScriptProgram>
 
 #include <AnimationCache.h>
 #include <AudioScriptingInterface.h>
@@ -63,6 +64,9 @@ public:
     bool isAvatar() const { return _isAvatar; }
 
     void setAvatarData(AvatarData* avatarData, const QString& objectName);
+
+    /// the avatar is one of several an agent hosts, its data goes out with its session UUID so the mixer tells them apart
+    void setIsHostedAvatar(bool isHostedAvatar) { _isHostedAvatar = isHostedAvatar; }
     void setAvatarHashMap(AvatarHashMap* avatarHashMap, const QString& objectName);
 
     bool isListeningToAudioStream() const { return _isListeningToAudioStream; }
@@ -73,8 +77,22 @@ public:
 
     void init();
     void run(); /// runs continuously until Agent.stop() is called
+
+    /// The pieces of run(), for a host that paces the frames of many scripts itself: startRunning() evaluates the
+    /// script, runFrame() sends the avatar's data and audio and emits update, and finishRunning() ends the script once
+    /// it has been stopped. The host processes the engine's events and releases the entity edits between frames.
+    void startRunning();
+    void runFrame();
+    void finishRunning();
+
+    /// sends the entity edits queued by every script, which share one packet sender
+    static void releaseEntityEditPackets();
     void evaluate(); /// initializes the engine, and evaluates the script, but then returns control to caller
 
+    /// Downloads the scripts that the script includes by name, and those that they include in turn, into the script
+    /// cache, all of each level at once. Called before the script is evaluated, so that include() needn't wait then.
+    void loadIncludes();
+
     void timerFired();
 
     bool hasScript() const { return !_scriptContents.isEmpty(); }
@@ -123,6 +141,7 @@ protected:
     bool _isRunning;
     bool _isInitialized;
     bool _isAvatar;
+    bool _isHostedAvatar;
     QTimer* _avatarIdentityTimer;
     QTimer* _avatarBillboardTimer;
     QHash<QTimer*, QScriptValue> _timerFunctionMap;
@@ -133,8 +152,10 @@ protected:
 private:
     void sendAvatarIdentityPacket();
     void sendAvatarBillboardPacket();
+    void sendAvatarAudioFrame();
 
     QObject* setupTimerWithInterval(const QScriptValue& function, int intervalMS, bool isSingleShot);
+    QList<QUrl> findIncludes(const QString& scriptContents) const;
     void stopTimer(QTimer* timer);
 
     static EntityScriptingInterface _entityScriptingInterface;
@@ -151,6 +172,8 @@ private:
     ArrayBufferClass* _arrayBufferClass;
 
     QHash<QUuid, quint16> _outgoingScriptAudioSequenceNumbers;
+    QHash<QUrl, QScriptProgram> _includedPrograms; // compiled for this engine the first time they're included
+    quint64 _lastUpdate;
 private slots:
     void handleScriptDownload();
 };
@@ -110,6 +110,55 @@ int unpackOrientationQuatFromBytes(const unsigned char* buffer, glm::quat& quatO
     return sizeof(quatParts);
 }
 
+const float SMALLEST_THREE_COMPONENT_RANGE = 1.0f / sqrtf(2.0f);
+const int SMALLEST_THREE_INDEX_BITS = 2;
+
+uint64_t packOrientationQuatSmallestThree(const glm::quat& quatInput, int bitsPerComponent) {
+    glm::quat quatNormalized = glm::normalize(quatInput);
+    float components[4] = { quatNormalized.x, quatNormalized.y, quatNormalized.z, quatNormalized.w };
+    
+    int largestIndex = 0;
+    for (int i = 1; i < 4; i++) {
+        if (fabsf(components[i]) > fabsf(components[largestIndex])) {
+            largestIndex = i;
+        }
+    }
+    
+    // q and -q are the same rotation, so flip the quat if need be to make the dropped component positive
+    float sign = (components[largestIndex] < 0.0f) ? -1.0f : 1.0f;
+    
+    const uint64_t MAX_COMPONENT_VALUE = (1ULL << bitsPerComponent) - 1;
+    uint64_t packedQuat = largestIndex;
+    for (int i = 0; i < 4; i++) {
+        if (i != largestIndex) {
+            float ratio = (sign * components[i] + SMALLEST_THREE_COMPONENT_RANGE) / (2.0f * SMALLEST_THREE_COMPONENT_RANGE);
+            ratio = glm::clamp(ratio, 0.0f, 1.0f);
+            packedQuat = (packedQuat << bitsPerComponent) | (uint64_t)(ratio * MAX_COMPONENT_VALUE + 0.5f);
+        }
+    }
+    return packedQuat;
+}
+
+glm::quat unpackOrientationQuatSmallestThree(uint64_t packedQuat, int bitsPerComponent) {
+    const uint64_t MAX_COMPONENT_VALUE = (1ULL << bitsPerComponent) - 1;
+    int largestIndex = (packedQuat >> (3 * bitsPerComponent)) & ((1 << SMALLEST_THREE_INDEX_BITS) - 1);
+    
+    float components[4];
+    float sumOfSquares = 0.0f;
+    int shift = 2 * bitsPerComponent;
+    for (int i = 0; i < 4; i++) {
+        if (i != largestIndex) {
+            float ratio = ((packedQuat >> shift) & MAX_COMPONENT_VALUE) / (float)MAX_COMPONENT_VALUE;
+            components[i] = (ratio * 2.0f - 1.0f) * SMALLEST_THREE_COMPONENT_RANGE;
+            sumOfSquares += components[i] * components[i];
+            shift -= bitsPerComponent;
+        }
+    }
+    components[largestIndex] = sqrtf(glm::max(0.0f, 1.0f - sumOfSquares));
+    
+    return glm::normalize(glm::quat(components[3], components[0], components[1], components[2]));
+}
+
 //  Safe version of glm::eulerAngles; uses the factorization method described in David Eberly's
 //  http://www.geometrictools.com/Documentation/EulerAngles.pdf (via Clyde,
 // https://github.com/threerings/clyde/blob/master/src/main/java/com/threerings/math/Quaternion.java)
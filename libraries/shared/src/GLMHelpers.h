@@ -35,6 +35,12 @@ int unpackFloatAngleFromTwoByte(const uint16_t* byteAnglePointer, float* destina
 int packOrientationQuatToBytes(unsigned char* buffer, const glm::quat& quatInput);
 int unpackOrientationQuatFromBytes(const unsigned char* buffer, glm::quat& quatOutput);
 
+// Orientation Quats can also be sent as their three smallest components, which are known to be between -1/sqrt(2) and
+// 1/sqrt(2), plus the index of the largest one - each of the three is quantized to bitsPerComponent bits (at most 20) and
+// the result fits in the low 2 + 3 * bitsPerComponent bits
+uint64_t packOrientationQuatSmallestThree(const glm::quat& quatInput, int bitsPerComponent);
+glm::quat unpackOrientationQuatSmallestThree(uint64_t packedQuat, int bitsPerComponent);
+
 // Ratios need the be highly accurate when less than 10, but not very accurate above 10, and they
 // are never greater than 1000 to 1, this allows us to encode each component in 16bits
 int packFloatRatioToTwoByte(unsigned char* buffer, float ratio);
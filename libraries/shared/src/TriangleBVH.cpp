@@ -0,0 +1,199 @@
+//
+//  TriangleBVH.cpp
+//  libraries/shared/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+#include <limits>
+
+#include "TriangleBVH.h"
+
+const int MAX_TRIANGLES_PER_LEAF = 4;
+
+// the hierarchy is split at the median, so this is far deeper than any we will build
+const int MAX_TRAVERSAL_DEPTH = 64;
+
+class CentroidAxisLess {
+public:
+    CentroidAxisLess(const QVector<glm::vec3>& centroids, int axis) : _centroids(centroids), _axis(axis) { }
+    bool operator()(int first, int second) const { return _centroids.at(first)[_axis] < _centroids.at(second)[_axis]; }
+private:
+    const QVector<glm::vec3>& _centroids;
+    int _axis;
+};
+
+// the slab test, with the reciprocal of the ray direction so that axis aligned rays need no special case
+static bool findRayBoxIntersection(const glm::vec3& origin, const glm::vec3& inverseDirection,
+                                   const glm::vec3& minimum, const glm::vec3& maximum, float& distance) {
+    glm::vec3 nearPlanes = (minimum - origin) * inverseDirection;
+    glm::vec3 farPlanes = (maximum - origin) * inverseDirection;
+    glm::vec3 entries = glm::min(nearPlanes, farPlanes);
+    glm::vec3 exits = glm::max(nearPlanes, farPlanes);
+
+    float entry = glm::max(glm::max(entries.x, entries.y), glm::max(entries.z, 0.0f));
+    float exit = glm::min(glm::min(exits.x, exits.y), exits.z);
+    if (entry > exit) {
+        return false;
+    }
+    distance = entry;
+    return true;
+}
+
+TriangleBVH::TriangleBVH() {
+}
+
+TriangleBVH::TriangleBVH(const QVector<Triangle>& triangles) {
+    build(triangles);
+}
+
+void TriangleBVH::build(const QVector<Triangle>& triangles) {
+    _nodes.clear();
+    _triangles.clear();
+    if (triangles.isEmpty()) {
+        return;
+    }
+
+    QVector<int> order(triangles.size());
+    QVector<glm::vec3> centroids(triangles.size());
+    for (int i = 0; i < triangles.size(); i++) {
+        const Triangle& triangle = triangles.at(i);
+        order[i] = i;
+        centroids[i] = (triangle.v0 + triangle.v1 + triangle.v2) / 3.0f;
+    }
+
+    // leaves end up with at least two triangles when there are that many, so there are no more nodes than triangles
+    _nodes.reserve(triangles.size());
+    _nodes.append(Node());
+    buildNode(order, centroids, 0, 0, triangles.size());
+
+    _triangles.resize(triangles.size());
+    for (int i = 0; i < order.size(); i++) {
+        _triangles[i] = triangles.at(order.at(i));
+    }
+
+    // leaves can only have been given their triangles' bounds once the triangles were in place
+    for (int i = _nodes.size() - 1; i >= 0; i--) {
+        Node& node = _nodes[i];
+        if (node.numTriangles > 0) {
+            node.minimum = glm::vec3(std::numeric_limits<float>::max());
+            node.maximum = glm::vec3(-std::numeric_limits<float>::max());
+            for (int j = node.first; j < node.first + node.numTriangles; j++) {
+                const Triangle& triangle = _triangles.at(j);
+                node.minimum = glm::min(node.minimum, glm::min(triangle.v0, glm::min(triangle.v1, triangle.v2)));
+                node.maximum = glm::max(node.maximum, glm::max(triangle.v0, glm::max(triangle.v1, triangle.v2)));
+            }
+        } else {
+            // children always come after their parents
+            const Node& firstChild = _nodes.at(node.first);
+            const Node& secondChild = _nodes.at(node.first + 1);
+            node.minimum = glm::min(firstChild.minimum, secondChild.minimum);
+            node.maximum = glm::max(firstChild.maximum, secondChild.maximum);
+        }
+    }
+}
+
+void TriangleBVH::buildNode(QVector<int>& order, const QVector<glm::vec3>& centroids, int nodeIndex, int first, int count) {
+    if (count <= MAX_TRIANGLES_PER_LEAF) {
+        _nodes[nodeIndex].first = first;
+        _nodes[nodeIndex].numTriangles = count;
+        return;
+    }
+
+    // split at the median centroid along the axis the centroids are most spread out on
+    glm::vec3 minimum = centroids.at(order.at(first));
+    glm::vec3 maximum = minimum;
+    for (int i = first + 1; i < first + count; i++) {
+        minimum = glm::min(minimum, centroids.at(order.at(i)));
+        maximum = glm::max(maximum, centroids.at(order.at(i)));
+    }
+    glm::vec3 spread = maximum - minimum;
+    int axis = (spread.x > spread.y) ? ((spread.x > spread.z) ? 0 : 2) : ((spread.y > spread.z) ? 1 : 2);
+
+    int half = count / 2;
+    std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+                     CentroidAxisLess(centroids, axis));
+
+    int firstChild = _nodes.size();
+    _nodes[nodeIndex].first = firstChild;
+    _nodes[nodeIndex].numTriangles = 0;
+    _nodes.append(Node());
+    _nodes.append(Node());
+
+    buildNode(order, centroids, firstChild, first, half);
+    buildNode(order, centroids, firstChild + 1, first + half, count - half);
+}
+
+bool TriangleBVH::findRayIntersection(const glm::vec3& origin, const glm::vec3& direction, float& distance,
+                                      bool flipWinding) const {
+    if (_nodes.isEmpty()) {
+        return false;
+    }
+    glm::vec3 inverseDirection = 1.0f / direction;
+    float nodeDistance;
+    if (!findRayBoxIntersection(origin, inverseDirection, _nodes.at(0).minimum, _nodes.at(0).maximum, nodeDistance) ||
+            nodeDistance >= distance) {
+        return false;
+    }
+
+    bool intersected = false;
+    int stack[MAX_TRAVERSAL_DEPTH];
+    float stackDistances[MAX_TRAVERSAL_DEPTH];
+    int stackSize = 0;
+    stack[stackSize] = 0;
+    stackDistances[stackSize++] = nodeDistance;
+
+    while (stackSize > 0) {
+        --stackSize;
+        if (stackDistances[stackSize] >= distance) {
+            continue; // we've hit something nearer than anything in this node since it was pushed
+        }
+        const Node& node = _nodes.at(stack[stackSize]);
+
+        if (node.numTriangles > 0) {
+            for (int i = node.first; i < node.first + node.numTriangles; i++) {
+                const Triangle& triangle = _triangles.at(i);
+                float triangleDistance;
+                bool hit = flipWinding ?
+                    findRayTriangleIntersection(origin, direction, triangle.v2, triangle.v1, triangle.v0, triangleDistance) :
+                    findRayTriangleIntersection(origin, direction, triangle.v0, triangle.v1, triangle.v2, triangleDistance);
+                if (hit && triangleDistance < distance) {
+                    distance = triangleDistance;
+                    intersected = true;
+                }
+            }
+            continue;
+        }
+
+        float firstDistance, secondDistance;
+        const Node& firstChild = _nodes.at(node.first);
+        const Node& secondChild = _nodes.at(node.first + 1);
+        bool hitFirst = findRayBoxIntersection(origin, inverseDirection, firstChild.minimum, firstChild.maximum,
+            firstDistance) && firstDistance < distance;
+        bool hitSecond = findRayBoxIntersection(origin, inverseDirection, secondChild.minimum, secondChild.maximum,
+            secondDistance) && secondDistance < distance;
+
+        // push the farther child first, so that the nearer one is visited first and can prune the other
+        if (hitFirst && hitSecond && firstDistance < secondDistance) {
+            stack[stackSize] = node.first + 1;
+            stackDistances[stackSize++] = secondDistance;
+            stack[stackSize] = node.first;
+            stackDistances[stackSize++] = firstDistance;
+        } else {
+            if (hitFirst) {
+                stack[stackSize] = node.first;
+                stackDistances[stackSize++] = firstDistance;
+            }
+            if (hitSecond) {
+                stack[stackSize] = node.first + 1;
+                stackDistances[stackSize++] = secondDistance;
+            }
+        }
+    }
+    return intersected;
+}
@@ -0,0 +1,55 @@
+//
+//  TriangleBVH.h
+//  libraries/shared/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_TriangleBVH_h
+#define hifi_TriangleBVH_h
+
+#include <glm/glm.hpp>
+
+#include <QtCore/QVector>
+
+#include "GeometryUtil.h"
+
+/// A bounding volume hierarchy over a set of triangles, for ray picking against them without testing every one.
+class TriangleBVH {
+public:
+    TriangleBVH();
+    TriangleBVH(const QVector<Triangle>& triangles);
+
+    /// replaces the hierarchy with one over these triangles
+    void build(const QVector<Triangle>& triangles);
+
+    bool isEmpty() const { return _triangles.isEmpty(); }
+    int getNumTriangles() const { return _triangles.size(); }
+
+    /// Finds the nearest triangle the ray hits. The direction needn't be normalized, distances are in units of its length.
+    /// \param distance[in,out] on input the distance beyond which hits are ignored, on output the distance to the hit
+    /// \param flipWinding true to test the triangles as though wound the other way, as they are after a mirroring
+    /// \return true if a triangle nearer than the input distance was hit
+    bool findRayIntersection(const glm::vec3& origin, const glm::vec3& direction, float& distance,
+                             bool flipWinding = false) const;
+
+private:
+    class Node {
+    public:
+        glm::vec3 minimum;
+        glm::vec3 maximum;
+        int first; // the first child node of an interior node, which is followed by the second, or a leaf's first triangle
+        int numTriangles; // zero for interior nodes
+    };
+
+    void buildNode(QVector<int>& order, const QVector<glm::vec3>& centroids, int nodeIndex, int first, int count);
+
+    QVector<Node> _nodes;
+    QVector<Triangle> _triangles; // ordered so that each leaf's triangles are contiguous
+};
+
+#endif // hifi_TriangleBVH_h
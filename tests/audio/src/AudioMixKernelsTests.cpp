@@ -0,0 +1,206 @@
+//
+//  AudioMixKernelsTests.cpp
+//  tests/audio/src
+//
+//  Created on 3/4/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <QDebug>
+
+#include <AudioConstants.h>
+#include <AudioMixKernels.h>
+#include <SharedUtil.h>
+
+#include "AudioMixKernelsTests.h"
+
+const int FRAME_SAMPLES = AudioConstants::NETWORK_FRAME_SAMPLES_STEREO;
+const int FRAME_SAMPLES_PER_CHANNEL = AudioConstants::NETWORK_FRAME_SAMPLES_PER_CHANNEL;
+const int MAX_DELAY_SAMPLES = 20;
+
+// the vectorized kernels may fuse or reorder the float arithmetic, so they're allowed to differ from the scalar ones by a
+// rounding error relative to the size of the mix, and by one once saturated
+const float MIX_TOLERANCE = 1.0e-5f;
+const int SATURATED_TOLERANCE = 1;
+
+static bool mixSamplesMatch(float sample, float expected) {
+    return fabsf(sample - expected) <= MIX_TOLERANCE * std::max(1.0f, fabsf(expected));
+}
+
+static void fillWithNoise(int16_t* samples, int numSamples) {
+    for (int i = 0; i < numSamples; i++) {
+        samples[i] = (int16_t)((rand() % 65536) - 32768);
+    }
+}
+
+static int16_t clampSample(int sample) {
+    return (int16_t)std::max(AudioConstants::MIN_SAMPLE_VALUE, std::min(AudioConstants::MAX_SAMPLE_VALUE, sample));
+}
+
+// the per-sample int16 mixing the audio-mixer did before the kernels - a mono spread with a delayed weak channel,
+// followed by a clamped accumulate of the pre-mix into the listener's mix
+static void legacyAddMonoSource(int16_t* mix, int16_t* preMix, const int16_t* source,
+                                float leftGain, float rightGain, int delaySamples) {
+    memset(preMix, 0, (FRAME_SAMPLES + MAX_DELAY_SAMPLES * 2) * sizeof(int16_t));
+
+    int delayedIndex = 1;
+    for (int i = 0; i < delaySamples; i++) {
+        preMix[delayedIndex] += source[i] * rightGain;
+        delayedIndex += 2;
+    }
+
+    const int16_t* frame = source + delaySamples;
+    int leftIndex = 0;
+    int rightIndex = 1 + delaySamples * 2;
+    for (int i = 0; i < FRAME_SAMPLES_PER_CHANNEL; i++) {
+        if (leftIndex <= FRAME_SAMPLES) {
+            preMix[leftIndex] += (int16_t)(frame[i] * leftGain);
+        }
+        if (rightIndex <= FRAME_SAMPLES) {
+            preMix[rightIndex] += (int16_t)(frame[i] * rightGain);
+        }
+        leftIndex += 2;
+        rightIndex += 2;
+    }
+
+    for (int s = 0; s < FRAME_SAMPLES; s++) {
+        mix[s] = clampSample(mix[s] + preMix[s]);
+    }
+}
+
+static void legacyAddStereoSource(int16_t* mix, int16_t* preMix, const int16_t* source, float gain) {
+    memset(preMix, 0, (FRAME_SAMPLES + MAX_DELAY_SAMPLES * 2) * sizeof(int16_t));
+
+    for (int s = 0; s < FRAME_SAMPLES; s++) {
+        preMix[s] = clampSample(preMix[s] + (int)(source[s] * gain));
+    }
+
+    for (int s = 0; s < FRAME_SAMPLES; s++) {
+        mix[s] = clampSample(mix[s] + preMix[s]);
+    }
+}
+
+void AudioMixKernelsTests::kernelsMatchScalarTests() {
+    int16_t source[FRAME_SAMPLES + MAX_DELAY_SAMPLES];
+    fillWithNoise(source, FRAME_SAMPLES + MAX_DELAY_SAMPLES);
+
+    float vectorMix[FRAME_SAMPLES];
+    float scalarMix[FRAME_SAMPLES];
+    memset(vectorMix, 0, sizeof(vectorMix));
+    memset(scalarMix, 0, sizeof(scalarMix));
+
+    for (int delay = 0; delay <= MAX_DELAY_SAMPLES; delay += 3) {
+        bool rightIsDelayed = (delay % 2) == 0;
+        AudioMixKernels::addMonoToStereo(vectorMix, source, FRAME_SAMPLES_PER_CHANNEL, 0.25f, 0.5f, delay, rightIsDelayed);
+        AudioMixKernels::Scalar::addMonoToStereo(scalarMix, source, FRAME_SAMPLES_PER_CHANNEL, 0.25f, 0.5f,
+                                                 delay, rightIsDelayed);
+    }
+
+    // odd lengths make sure the scalar tails of the vectorized kernels are exercised
+    AudioMixKernels::addStereo(vectorMix, source + 1, FRAME_SAMPLES - 3, 0.75f);
+    AudioMixKernels::Scalar::addStereo(scalarMix, source + 1, FRAME_SAMPLES - 3, 0.75f);
+
+    AudioMixKernels::addSamples(vectorMix, source + 2, FRAME_SAMPLES - 5);
+    AudioMixKernels::Scalar::addSamples(scalarMix, source + 2, FRAME_SAMPLES - 5);
+
+    for (int i = 0; i < FRAME_SAMPLES; i++) {
+        if (!mixSamplesMatch(vectorMix[i], scalarMix[i])) {
+            qDebug() << "FAILED - accumulated sample" << i << "is" << vectorMix[i] << "expected" << scalarMix[i];
+            return;
+        }
+    }
+
+    int16_t vectorOutput[FRAME_SAMPLES];
+    int16_t scalarOutput[FRAME_SAMPLES];
+    AudioMixKernels::saturateToInt16(vectorOutput, vectorMix, FRAME_SAMPLES - 1);
+    AudioMixKernels::Scalar::saturateToInt16(scalarOutput, scalarMix, FRAME_SAMPLES - 1);
+
+    for (int i = 0; i < FRAME_SAMPLES - 1; i++) {
+        if (abs(vectorOutput[i] - scalarOutput[i]) > SATURATED_TOLERANCE) {
+            qDebug() << "FAILED - saturated sample" << i << "is" << vectorOutput[i] << "expected" << scalarOutput[i];
+            return;
+        }
+    }
+
+    qDebug() << "PASSED -" << AudioMixKernels::getInstructionSetName() << "kernels match the scalar kernels";
+}
+
+void AudioMixKernelsTests::mixingBenchmark() {
+    const int NUM_SOURCES = 64;
+    const int NUM_LISTENERS = 100;
+
+    int16_t* sources = new int16_t[NUM_SOURCES * (FRAME_SAMPLES + MAX_DELAY_SAMPLES)];
+    fillWithNoise(sources, NUM_SOURCES * (FRAME_SAMPLES + MAX_DELAY_SAMPLES));
+
+    int16_t legacyMix[FRAME_SAMPLES + MAX_DELAY_SAMPLES * 2];
+    int16_t legacyPreMix[FRAME_SAMPLES + MAX_DELAY_SAMPLES * 2];
+    float mix[FRAME_SAMPLES];
+    int16_t output[FRAME_SAMPLES];
+
+    // every other source is mono with a varying delay, the rest are stereo
+    quint64 start = usecTimestampNow();
+    for (int listener = 0; listener < NUM_LISTENERS; listener++) {
+        memset(legacyMix, 0, sizeof(legacyMix));
+        for (int i = 0; i < NUM_SOURCES; i++) {
+            const int16_t* source = sources + i * (FRAME_SAMPLES + MAX_DELAY_SAMPLES);
+            if (i % 2 == 0) {
+                legacyAddMonoSource(legacyMix, legacyPreMix, source, 0.1f, 0.05f, i % MAX_DELAY_SAMPLES);
+            } else {
+                legacyAddStereoSource(legacyMix, legacyPreMix, source, 0.1f);
+            }
+        }
+    }
+    quint64 legacyUsecs = usecTimestampNow() - start;
+
+    start = usecTimestampNow();
+    for (int listener = 0; listener < NUM_LISTENERS; listener++) {
+        memset(mix, 0, sizeof(mix));
+        for (int i = 0; i < NUM_SOURCES; i++) {
+            const int16_t* source = sources + i * (FRAME_SAMPLES + MAX_DELAY_SAMPLES);
+            if (i % 2 == 0) {
+                AudioMixKernels::Scalar::addMonoToStereo(mix, source, FRAME_SAMPLES_PER_CHANNEL, 0.1f, 0.05f,
+                                                         i % MAX_DELAY_SAMPLES, true);
+            } else {
+                AudioMixKernels::Scalar::addStereo(mix, source, FRAME_SAMPLES, 0.1f);
+            }
+        }
+        AudioMixKernels::Scalar::saturateToInt16(output, mix, FRAME_SAMPLES);
+    }
+    quint64 scalarUsecs = usecTimestampNow() - start;
+
+    start = usecTimestampNow();
+    for (int listener = 0; listener < NUM_LISTENERS; listener++) {
+        memset(mix, 0, sizeof(mix));
+        for (int i = 0; i < NUM_SOURCES; i++) {
+            const int16_t* source = sources + i * (FRAME_SAMPLES + MAX_DELAY_SAMPLES);
+            if (i % 2 == 0) {
+                AudioMixKernels::addMonoToStereo(mix, source, FRAME_SAMPLES_PER_CHANNEL, 0.1f, 0.05f,
+                                                 i % MAX_DELAY_SAMPLES, true);
+            } else {
+                AudioMixKernels::addStereo(mix, source, FRAME_SAMPLES, 0.1f);
+            }
+        }
+        AudioMixKernels::saturateToInt16(output, mix, FRAME_SAMPLES);
+    }
+    quint64 kernelUsecs = usecTimestampNow() - start;
+
+    delete[] sources;
+
+    qDebug() << "TIME - mixing" << NUM_SOURCES << "sources for" << NUM_LISTENERS << "listeners";
+    qDebug() << "    int16 per-source clamp path:" << legacyUsecs << "usecs";
+    qDebug() << "    scalar kernels:" << scalarUsecs << "usecs";
+    qDebug() << "   " << AudioMixKernels::getInstructionSetName() << "kernels:" << kernelUsecs << "usecs";
+}
+
+void AudioMixKernelsTests::runAllTests() {
+    kernelsMatchScalarTests();
+    mixingBenchmark();
+}
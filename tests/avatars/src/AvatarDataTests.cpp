@@ -0,0 +1,114 @@
+//
+//  AvatarDataTests.cpp
+//  tests/avatars/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <math.h>
+
+#include <QDebug>
+
+#include <AvatarData.h>
+#include <GLMHelpers.h>
+#include <SharedUtil.h>
+
+#include "AvatarDataTests.h"
+
+const int NUM_JOINTS = 20;
+
+// delta positions are fixed point with 10 bits after the point
+const float POSITION_TOLERANCE = 1.0e-3f;
+
+// how far from 1 the dot product of a sent and a received rotation may be at the default joint precision
+const float ROTATION_TOLERANCE = 1.0e-4f;
+
+static glm::quat randomRotation() {
+    glm::vec3 axis(randFloatInRange(-1.0f, 1.0f), randFloatInRange(-1.0f, 1.0f), randFloatInRange(-1.0f, 1.0f));
+    if (glm::length(axis) < EPSILON) {
+        axis = glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+    return glm::angleAxis(randFloatInRange(-PI, PI), glm::normalize(axis));
+}
+
+static bool avatarsMatch(const QString& what, const AvatarData& sent, const AvatarData& received) {
+    if (glm::length(received.getPosition() - sent.getPosition()) > POSITION_TOLERANCE) {
+        qDebug() << "FAILED -" << what << "position is" << received.getPosition().x << received.getPosition().y
+            << received.getPosition().z << "expected" << sent.getPosition().x << sent.getPosition().y << sent.getPosition().z;
+        return false;
+    }
+    for (int i = 0; i < NUM_JOINTS; i++) {
+        if (received.isJointDataValid(i) != sent.isJointDataValid(i)) {
+            qDebug() << "FAILED -" << what << "joint" << i << "validity is" << received.isJointDataValid(i);
+            return false;
+        }
+        // q and -q are the same rotation
+        if (sent.isJointDataValid(i)
+            && 1.0f - fabsf(glm::dot(received.getJointRotation(i), sent.getJointRotation(i))) > ROTATION_TOLERANCE) {
+            qDebug() << "FAILED -" << what << "joint" << i << "rotation doesn't match";
+            return false;
+        }
+    }
+    return true;
+}
+
+void AvatarDataTests::keyframeAndDeltaTests() {
+    AvatarData sender;
+    sender.setPosition(glm::vec3(100.0f, 2.5f, -40.0f));
+    for (int i = 0; i < NUM_JOINTS; i++) {
+        sender.setJointData(i, randomRotation());
+    }
+    sender.clearJointData(NUM_JOINTS / 2);
+
+    AvatarDataKeyframe keyframe;
+    QByteArray keyframeByteArray = sender.toKeyframeByteArray(keyframe, 1, DEFAULT_JOINT_ROTATION_BITS);
+
+    AvatarData receiver;
+    int bytesRead = receiver.parseDataAtOffset(keyframeByteArray, 0);
+    if (bytesRead != keyframeByteArray.size()) {
+        qDebug() << "FAILED - keyframe parsed" << bytesRead << "bytes of" << keyframeByteArray.size();
+        return;
+    }
+    if (!avatarsMatch("keyframe", sender, receiver)) {
+        return;
+    }
+
+    // move a little and turn a few joints, which a delta against the keyframe carries
+    sender.setPosition(sender.getPosition() + glm::vec3(0.5f, -0.25f, 3.0f));
+    sender.setJointData(0, randomRotation());
+    sender.setJointData(NUM_JOINTS / 2, randomRotation());
+    sender.clearJointData(NUM_JOINTS - 1);
+
+    QByteArray deltaByteArray = sender.toDeltaByteArray(keyframe);
+    if (deltaByteArray.isEmpty() || deltaByteArray.size() >= keyframeByteArray.size()) {
+        qDebug() << "FAILED - delta is" << deltaByteArray.size() << "bytes, keyframe is" << keyframeByteArray.size();
+        return;
+    }
+
+    bytesRead = receiver.parseDataAtOffset(deltaByteArray, 0);
+    if (bytesRead != deltaByteArray.size()) {
+        qDebug() << "FAILED - delta parsed" << bytesRead << "bytes of" << deltaByteArray.size();
+        return;
+    }
+    if (!avatarsMatch("delta", sender, receiver)) {
+        return;
+    }
+
+    // too far from the keyframe for a delta, a new keyframe has to go out instead
+    sender.setPosition(sender.getPosition() + glm::vec3(100.0f, 0.0f, 0.0f));
+    if (!sender.toDeltaByteArray(keyframe).isEmpty()) {
+        qDebug() << "FAILED - delta encoded for an avatar that moved past the keyframe's range";
+        return;
+    }
+
+    qDebug() << "PASSED - keyframe of" << keyframeByteArray.size() << "bytes and delta of" << deltaByteArray.size()
+        << "bytes decode back to the avatar";
+}
+
+void AvatarDataTests::runAllTests() {
+    keyframeAndDeltaTests();
+}
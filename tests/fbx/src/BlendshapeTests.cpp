@@ -0,0 +1,190 @@
+//
+//  BlendshapeTests.cpp
+//  tests/fbx/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include <FBXReader.h>
+#include <PackedBlendshapes.h>
+#include <SharedUtil.h>
+
+#include "BlendshapeTests.h"
+
+const float NORMAL_COEFFICIENT_SCALE = 0.01f;
+const float BLEND_TOLERANCE = 0.0001f;
+
+// blends the way Blender::run used to, starting each time from a full copy of the mesh
+static void blendFully(const FBXMesh& mesh, const QVector<float>& coefficients,
+                       QVector<glm::vec3>& vertices, QVector<glm::vec3>& normals) {
+    vertices = mesh.vertices;
+    normals = mesh.normals;
+    for (int i = 0, n = qMin(coefficients.size(), mesh.blendshapes.size()); i < n; i++) {
+        float vertexCoefficient = coefficients.at(i);
+        if (vertexCoefficient < EPSILON) {
+            continue;
+        }
+        float normalCoefficient = vertexCoefficient * NORMAL_COEFFICIENT_SCALE;
+        const FBXBlendshape& blendshape = mesh.blendshapes.at(i);
+        for (int j = 0; j < blendshape.indices.size(); j++) {
+            int index = blendshape.indices.at(j);
+            vertices[index] += blendshape.vertices.at(j) * vertexCoefficient;
+            if (j < blendshape.normals.size() && index < normals.size()) {
+                normals[index] += blendshape.normals.at(j) * normalCoefficient;
+            }
+        }
+    }
+}
+
+static bool matches(const QVector<glm::vec3>& first, const QVector<glm::vec3>& second) {
+    if (first.size() != second.size()) {
+        return false;
+    }
+    for (int i = 0; i < first.size(); i++) {
+        if (glm::distance(first.at(i), second.at(i)) > BLEND_TOLERANCE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// face tracking drives a handful of blendshapes at a time, so most coefficients are zero
+static QVector<float> randCoefficients(int numBlendshapes) {
+    const float ACTIVE_PROBABILITY = 0.2f;
+    QVector<float> coefficients(numBlendshapes, 0.0f);
+    for (int i = 0; i < numBlendshapes; i++) {
+        if (randFloat() < ACTIVE_PROBABILITY) {
+            coefficients[i] = randFloat();
+        }
+    }
+    return coefficients;
+}
+
+static FBXBlendshape makeBlendshape(const QVector<int>& indices) {
+    FBXBlendshape blendshape;
+    blendshape.indices = indices;
+    for (int i = 0; i < indices.size(); i++) {
+        blendshape.vertices.append(glm::vec3(randFloat(), randFloat(), randFloat()));
+        blendshape.normals.append(glm::vec3(randFloat(), randFloat(), randFloat()));
+    }
+    return blendshape;
+}
+
+// checks a blend sequence against full blends, with repeated indices and a blendshape switched off and back on
+static int testSmallMesh() {
+    const int NUM_VERTICES = 20;
+    FBXMesh mesh;
+    for (int i = 0; i < NUM_VERTICES; i++) {
+        mesh.vertices.append(glm::vec3(i, 0.0f, 0.0f));
+        mesh.normals.append(glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+    mesh.blendshapes.append(makeBlendshape(QVector<int>() << 2 << 3 << 5));
+    mesh.blendshapes.append(makeBlendshape(QVector<int>() << 15 << 12 << 15));
+    mesh.blendshapes.append(makeBlendshape(QVector<int>() << 5 << 17));
+
+    QVector<QVector<float> > sequence;
+    sequence.append(QVector<float>() << 1.0f << 0.0f << 0.0f);
+    sequence.append(QVector<float>() << 0.5f << 0.25f << 0.0f);
+    sequence.append(QVector<float>() << 0.0f << 0.25f << 0.0f);
+    sequence.append(QVector<float>() << 0.0f << 0.0f << 0.0f);
+    sequence.append(QVector<float>() << 0.0f << 0.0f << 1.0f << 1.0f);
+    sequence.append(QVector<float>() << 0.75f);
+
+    PackedBlendshapes packed(mesh);
+    BlendedMesh blended;
+    blended.reset(mesh);
+    int failures = 0;
+    for (int i = 0; i < sequence.size(); i++) {
+        QVector<glm::vec3> expectedVertices, expectedNormals;
+        blendFully(mesh, sequence.at(i), expectedVertices, expectedNormals);
+        blended.blend(packed, sequence.at(i));
+        if (!matches(blended.getVertices(), expectedVertices) || !matches(blended.getNormals(), expectedNormals)) {
+            qDebug() << "FAILED - blend" << i << "of the small mesh differs from a full blend";
+            failures++;
+        }
+        // the changed range should cover just the vertices the first blendshape moves
+        if (i == 0 && (blended.getFirstChangedVertex() != 2 || blended.getNumChangedVertices() != 4)) {
+            qDebug() << "FAILED - the first blend changed vertices" << blended.getFirstChangedVertex()
+                << "to" << blended.getFirstChangedVertex() + blended.getNumChangedVertices() << "rather than 2 to 6";
+            failures++;
+        }
+        blended.clearChanges();
+    }
+    if (packed.getNumPackedVertices() != 6) {
+        qDebug() << "FAILED - packed" << packed.getNumPackedVertices() << "vertices, expected 6";
+        failures++;
+    }
+    return failures;
+}
+
+// times blending over the default head, which is what face tracked avatars blend every frame
+static int testHead() {
+    QString path = QFileInfo(__FILE__).dir().filePath("../../../interface/resources/meshes/defaultAvatar/head.fbx");
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "SKIPPED - couldn't open" << path;
+        return 0;
+    }
+    FBXGeometry geometry = readFBX(file.readAll(), QVariantHash());
+
+    const int NUM_BLENDS = 1000;
+    int failures = 0;
+    foreach (const FBXMesh& mesh, geometry.meshes) {
+        if (mesh.blendshapes.isEmpty()) {
+            continue;
+        }
+        QVector<QVector<float> > sequence;
+        for (int i = 0; i < NUM_BLENDS; i++) {
+            sequence.append(randCoefficients(mesh.blendshapes.size()));
+        }
+
+        QVector<glm::vec3> vertices, normals;
+        quint64 start = usecTimestampNow();
+        foreach (const QVector<float>& coefficients, sequence) {
+            blendFully(mesh, coefficients, vertices, normals);
+        }
+        quint64 fullUsecs = usecTimestampNow() - start;
+
+        start = usecTimestampNow();
+        PackedBlendshapes packed(mesh);
+        quint64 packUsecs = usecTimestampNow() - start;
+
+        BlendedMesh blended;
+        blended.reset(mesh);
+        start = usecTimestampNow();
+        foreach (const QVector<float>& coefficients, sequence) {
+            blended.blend(packed, coefficients);
+            blended.clearChanges();
+        }
+        quint64 packedUsecs = usecTimestampNow() - start;
+
+        // the last blend of each should have landed in the same place
+        if (!matches(blended.getVertices(), vertices) || !matches(blended.getNormals(), normals)) {
+            qDebug() << "FAILED - packed blending of the head differs from a full blend";
+            failures++;
+        }
+        qDebug() << "TIME - blending" << mesh.vertices.size() << "vertices," << mesh.blendshapes.size() << "blendshapes,"
+            << packed.getNumPackedVertices() << "vertices moved by any";
+        qDebug() << "    packing:" << packUsecs << "usecs";
+        qDebug() << "    full copy:" << (float)fullUsecs / NUM_BLENDS << "usecs per blend";
+        qDebug() << "    packed:" << (float)packedUsecs / NUM_BLENDS << "usecs per blend";
+    }
+    return failures;
+}
+
+void BlendshapeTests::runAllTests() {
+    int failures = testSmallMesh();
+    failures += testHead();
+    if (failures == 0) {
+        qDebug() << "PASSED - packed blends match full blends";
+    }
+}
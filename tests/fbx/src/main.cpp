@@ -0,0 +1,21 @@
+//
+//  main.cpp
+//  tests/fbx/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <stdio.h>
+
+#include "BlendshapeTests.h"
+
+int main(int argc, char** argv) {
+    BlendshapeTests::runAllTests();
+    printf("tests complete, press enter to exit\n");
+    getchar();
+    return 0;
+}
@@ -0,0 +1,82 @@
+//
+//  PacketAuthenticatorTests.cpp
+//  tests/networking/src
+//
+//  Created on 3/12/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cassert>
+#include <cstring>
+
+#include <QtCore/QCryptographicHash>
+
+#include <PacketHeaders.h>
+#include <SipHash.h>
+
+#include "PacketAuthenticatorTests.h"
+
+void PacketAuthenticatorTests::runAllTests() {
+    sipHashVectorsTest();
+    packetHashTest();
+}
+
+void PacketAuthenticatorTests::sipHashVectorsTest() {
+    // the reference SipHash-2-4-128 vectors, keyed with 00 01 ... 0f over the messages 00 01 ... (length - 1)
+    const int NUM_VECTORS = 3;
+    const int vectorLengths[NUM_VECTORS] = { 0, 1, 15 };
+    const unsigned char vectorHashes[NUM_VECTORS][NUM_BYTES_SIPHASH_128] = {
+        { 0xa3, 0x81, 0x7f, 0x04, 0xba, 0x25, 0xa8, 0xe6, 0x6d, 0xf6, 0x72, 0x14, 0xc7, 0x55, 0x02, 0x93 },
+        { 0xda, 0x87, 0xc1, 0xd8, 0x6b, 0x99, 0xaf, 0x44, 0x34, 0x76, 0x59, 0x11, 0x9b, 0x22, 0xfc, 0x45 },
+        { 0x54, 0x93, 0xe9, 0x99, 0x33, 0xb0, 0xa8, 0x11, 0x7e, 0x08, 0xec, 0x0f, 0x97, 0xcf, 0xc3, 0xd9 }
+    };
+
+    unsigned char key[NUM_BYTES_SIPHASH_KEY];
+    for (int i = 0; i < NUM_BYTES_SIPHASH_KEY; i++) {
+        key[i] = i;
+    }
+
+    unsigned char message[16];
+    for (int i = 0; i < 16; i++) {
+        message[i] = i;
+    }
+
+    for (int i = 0; i < NUM_VECTORS; i++) {
+        unsigned char hash[NUM_BYTES_SIPHASH_128];
+        sipHash128(key, message, vectorLengths[i], hash);
+        assert(memcmp(hash, vectorHashes[i], NUM_BYTES_SIPHASH_128) == 0);
+    }
+}
+
+void PacketAuthenticatorTests::packetHashTest() {
+    QUuid senderUUID = QUuid::createUuid();
+    QUuid connectionSecret = QUuid::createUuid();
+
+    QByteArray packet = byteArrayWithPopulatedHeader(PacketTypeAvatarData, senderUUID);
+    packet.append("some avatar data to authenticate");
+    int numHeaderBytes = numBytesForPacketHeader(packet);
+
+    // the in place MD5 hash has to match what the hash of the copied packet data and secret used to be
+    QByteArray expectedMD5 = QCryptographicHash::hash(packet.mid(numHeaderBytes) + connectionSecret.toRfc4122(),
+                                                      QCryptographicHash::Md5);
+    assert(hashForPacketAndConnectionUUID(packet, connectionSecret) == expectedMD5);
+
+    PacketAuthenticator_t authenticators[] = { PacketAuthenticator::MD5, PacketAuthenticator::SipHash };
+    for (int i = 0; i < 2; i++) {
+        QByteArray signedPacket = packet;
+        replaceHashInPacketGivenConnectionUUID(signedPacket, connectionSecret, authenticators[i]);
+        assert(hashFromPacketHeader(signedPacket) == hashForPacketAndConnectionUUID(packet, connectionSecret,
+                                                                                    authenticators[i]));
+        assert(packetHashMatchesConnectionUUID(signedPacket, connectionSecret, authenticators[i]));
+
+        // a different secret, authenticator or payload must not verify
+        assert(!packetHashMatchesConnectionUUID(signedPacket, QUuid::createUuid(), authenticators[i]));
+        assert(!packetHashMatchesConnectionUUID(signedPacket, connectionSecret, authenticators[1 - i]));
+
+        signedPacket[signedPacket.size() - 1] = signedPacket[signedPacket.size() - 1] ^ 1;
+        assert(!packetHashMatchesConnectionUUID(signedPacket, connectionSecret, authenticators[i]));
+    }
+}
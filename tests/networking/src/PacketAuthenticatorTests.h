@@ -0,0 +1,23 @@
+//
+//  PacketAuthenticatorTests.h
+//  tests/networking/src
+//
+//  Created on 3/12/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_PacketAuthenticatorTests_h
+#define hifi_PacketAuthenticatorTests_h
+
+namespace PacketAuthenticatorTests {
+
+    void runAllTests();
+
+    void sipHashVectorsTest();
+    void packetHashTest();
+};
+
+#endif // hifi_PacketAuthenticatorTests_h
@@ -0,0 +1,344 @@
+//
+//  EditJournalTests.cpp
+//  tests/octree/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include <EntityItemProperties.h>
+#include <EntityTree.h>
+#include <LimitedNodeList.h>
+#include <OctreeEditJournal.h>
+#include <OctreePersistThread.h>
+#include <SharedUtil.h>
+
+#include "EditJournalTests.h"
+
+const int NUM_ENTITIES = 12;
+
+// long enough that the tests' persist threads only save when they're told to
+const int TEST_PERSIST_INTERVAL_MSECS = 60 * 60 * 1000;
+
+// a persist thread that isn't started, so that the tests can load and save when they choose
+class TestPersistThread : public OctreePersistThread {
+public:
+    TestPersistThread(Octree* tree, const QString& filename) :
+        OctreePersistThread(tree, filename, TEST_PERSIST_INTERVAL_MSECS) { }
+
+    void load() { process(); }
+    void save() { persist(); }
+};
+
+// applies an edit the way the server does when it arrives in an edit packet
+static int processEdit(EntityTree& tree, PacketType packetType, const unsigned char* editData, int length) {
+    tree.lockForWrite();
+    int processedBytes = tree.processEditPacketData(packetType, editData, length, editData, length,
+                                                    SharedNodePointer());
+    tree.unlock();
+    return processedBytes;
+}
+
+static void createEntity(EntityTree& tree, const glm::vec3& position) {
+    EntityItemID entityID(NEW_ENTITY, EntityItemID::getNextCreatorTokenID(), false);
+    EntityItemProperties properties;
+    properties.setType(EntityTypes::Box);
+    properties.setPosition(position);
+
+    unsigned char editData[MAX_PACKET_SIZE];
+    int length = 0;
+    if (EntityItemProperties::encodeEntityEditPacket(PacketTypeEntityAddOrEdit, entityID, properties,
+                                                     editData, MAX_PACKET_SIZE, length)) {
+        processEdit(tree, PacketTypeEntityAddOrEdit, editData, length);
+    }
+}
+
+static void moveEntity(EntityTree& tree, const QUuid& id, const glm::vec3& position) {
+    EntityItemProperties properties;
+    properties.setPosition(position);
+
+    unsigned char editData[MAX_PACKET_SIZE];
+    int length = 0;
+    if (EntityItemProperties::encodeEntityEditPacket(PacketTypeEntityAddOrEdit, EntityItemID(id), properties,
+                                                     editData, MAX_PACKET_SIZE, length)) {
+        processEdit(tree, PacketTypeEntityAddOrEdit, editData, length);
+    }
+}
+
+static void eraseEntity(EntityTree& tree, const QUuid& id) {
+    unsigned char editData[MAX_PACKET_SIZE];
+    size_t length = 0;
+    if (EntityItemProperties::encodeEraseEntityMessage(EntityItemID(id), editData, MAX_PACKET_SIZE, length)) {
+        processEdit(tree, PacketTypeEntityErase, editData, length);
+    }
+}
+
+// the position of every entity in the tree by its ID, which is what the tests compare trees by
+static QHash<QUuid, glm::vec3> getEntityPositions(EntityTree& tree) {
+    QVector<const EntityItem*> entities;
+    tree.findEntities(glm::vec3(0.5f, 0.5f, 0.5f), 1.0f, entities);
+
+    QHash<QUuid, glm::vec3> positions;
+    foreach (const EntityItem* entity, entities) {
+        positions.insert(entity->getID(), entity->getPosition());
+    }
+    return positions;
+}
+
+static bool compareEntityPositions(EntityTree& tree, EntityTree& expectedTree, bool verbose) {
+    QHash<QUuid, glm::vec3> positions = getEntityPositions(tree);
+    QHash<QUuid, glm::vec3> expectedPositions = getEntityPositions(expectedTree);
+    if (positions == expectedPositions) {
+        return true;
+    }
+    if (verbose) {
+        foreach (const QUuid& id, expectedPositions.keys()) {
+            if (!positions.contains(id)) {
+                qDebug() << "    missing entity:" << id;
+            } else if (positions.value(id) != expectedPositions.value(id)) {
+                qDebug() << "    misplaced entity:" << id;
+            }
+        }
+        foreach (const QUuid& id, positions.keys()) {
+            if (!expectedPositions.contains(id)) {
+                qDebug() << "    unexpected entity:" << id;
+            }
+        }
+    }
+    return false;
+}
+
+// creates entities, then moves some of them and erases others
+static void makeEdits(EntityTree& tree) {
+    for (int i = 0; i < NUM_ENTITIES; i++) {
+        createEntity(tree, glm::vec3(1.0f + i, 1.0f, 1.0f));
+    }
+    int i = 0;
+    foreach (const QUuid& id, getEntityPositions(tree).keys()) {
+        if (i % 3 == 1) {
+            moveEntity(tree, id, glm::vec3(1.0f + i, 2.0f, 3.0f));
+        } else if (i % 3 == 2) {
+            eraseEntity(tree, id);
+        }
+        i++;
+    }
+}
+
+void EditJournalTests::replayTests(bool verbose) {
+    QTemporaryDir directory;
+    OctreeEditJournal journal(directory.path() + "/replay.journal");
+
+    EntityTree tree;
+    tree.setIsServer(true);
+    journal.open();
+    tree.setEditJournal(&journal);
+    makeEdits(tree);
+    tree.setEditJournal(NULL);
+    journal.close();
+
+    // the creates are replayed under the IDs the tree assigned, so the later edits find their entities
+    EntityTree replayTree;
+    replayTree.setIsServer(true);
+    replayTree.lockForWrite();
+    int editsReplayed = journal.replay(&replayTree);
+    replayTree.unlock();
+
+    if (editsReplayed != (int)journal.getRecordsAppended()) {
+        qDebug() << "FAILED - replayed" << editsReplayed << "edits of" << journal.getRecordsAppended() << "journaled";
+    } else if (!compareEntityPositions(replayTree, tree, verbose)) {
+        qDebug() << "FAILED - replaying the journal into a fresh tree didn't recreate the journaled tree";
+    } else {
+        qDebug() << "PASSED - replayed" << editsReplayed << "journaled edits into a fresh tree, which has the same"
+            << getEntityPositions(tree).size() << "entities under the same IDs";
+    }
+
+    // a crash between writing a snapshot and truncating the journal replays edits the tree already has
+    replayTree.lockForWrite();
+    journal.replay(&replayTree);
+    replayTree.unlock();
+
+    if (compareEntityPositions(replayTree, tree, verbose)) {
+        qDebug() << "PASSED - replaying the journal over a tree that has its edits leaves the tree as it was";
+    } else {
+        qDebug() << "FAILED - replaying the journal over a tree that has its edits changed the tree";
+    }
+}
+
+void EditJournalTests::partialRecordTests(bool verbose) {
+    QTemporaryDir directory;
+    QString journalFilename = directory.path() + "/partial.journal";
+    OctreeEditJournal journal(journalFilename);
+
+    // the tree as it was before its last edit, which is the one we cut short
+    EntityTree tree;
+    tree.setIsServer(true);
+    journal.open();
+    tree.setEditJournal(&journal);
+    makeEdits(tree);
+
+    EntityTree expectedTree;
+    expectedTree.setIsServer(true);
+    expectedTree.lockForWrite();
+    journal.replay(&expectedTree);
+    expectedTree.unlock();
+
+    eraseEntity(tree, getEntityPositions(tree).keys().first());
+    tree.setEditJournal(NULL);
+    journal.close();
+
+    // as if we crashed while the last record was being written
+    const int MISSING_BYTES = 3;
+    QFile::resize(journalFilename, QFileInfo(journalFilename).size() - MISSING_BYTES);
+
+    EntityTree replayTree;
+    replayTree.setIsServer(true);
+    replayTree.lockForWrite();
+    int editsReplayed = journal.replay(&replayTree);
+    replayTree.unlock();
+
+    if (editsReplayed != (int)journal.getRecordsAppended() - 1) {
+        qDebug() << "FAILED - replayed" << editsReplayed << "edits of a journal with"
+            << journal.getRecordsAppended() - 1 << "whole records";
+    } else if (!compareEntityPositions(replayTree, expectedTree, verbose)) {
+        qDebug() << "FAILED - replaying a journal that ends in a partial record didn't recreate the tree before it";
+    } else {
+        qDebug() << "PASSED - a partial record at the end of the journal is skipped";
+    }
+}
+
+void EditJournalTests::discardFirstBytesTests(bool verbose) {
+    QTemporaryDir directory;
+    QString journalFilename = directory.path() + "/discard.journal";
+    OctreeEditJournal journal(journalFilename);
+
+    EntityTree tree;
+    tree.setIsServer(true);
+    journal.open();
+    tree.setEditJournal(&journal);
+    makeEdits(tree);
+
+    // a snapshot taken now has the edits so far, which we stand in for with a tree replayed from a copy of the journal
+    qint64 snapshotJournalSize = journal.getSize();
+    QString snapshotJournalFilename = directory.path() + "/snapshot.journal";
+    QFile::copy(journalFilename, snapshotJournalFilename);
+    OctreeEditJournal snapshotJournal(snapshotJournalFilename);
+
+    EntityTree snapshotTree;
+    snapshotTree.setIsServer(true);
+    snapshotTree.lockForWrite();
+    snapshotJournal.replay(&snapshotTree);
+    snapshotTree.unlock();
+
+    // then edits come in while the snapshot is being written
+    quint64 recordsBeforeSnapshotWritten = journal.getRecordsAppended();
+    createEntity(tree, glm::vec3(1.0f, 4.0f, 1.0f));
+    moveEntity(tree, getEntityPositions(tree).keys().first(), glm::vec3(2.0f, 4.0f, 1.0f));
+    eraseEntity(tree, getEntityPositions(tree).keys().last());
+    int laterEdits = journal.getRecordsAppended() - recordsBeforeSnapshotWritten;
+    qint64 journalSize = journal.getSize();
+
+    if (!journal.discardFirstBytes(snapshotJournalSize)) {
+        qDebug() << "FAILED - couldn't discard the records in the snapshot";
+        return;
+    }
+    if (journal.getSize() != journalSize - snapshotJournalSize) {
+        qDebug() << "FAILED - the journal is" << journal.getSize() << "bytes after discarding"
+            << snapshotJournalSize << "of" << journalSize;
+        return;
+    }
+
+    // and the journal is still appended to
+    createEntity(tree, glm::vec3(1.0f, 5.0f, 1.0f));
+    laterEdits++;
+    tree.setEditJournal(NULL);
+    journal.close();
+
+    snapshotTree.lockForWrite();
+    int editsReplayed = journal.replay(&snapshotTree);
+    snapshotTree.unlock();
+
+    if (editsReplayed != laterEdits) {
+        qDebug() << "FAILED - replayed" << editsReplayed << "edits over the snapshot, expected" << laterEdits;
+    } else if (!compareEntityPositions(snapshotTree, tree, verbose)) {
+        qDebug() << "FAILED - the edits kept after discarding didn't bring the snapshot up to date";
+    } else {
+        qDebug() << "PASSED - discarding the records in a snapshot kept the" << laterEdits << "edits made since";
+    }
+}
+
+void EditJournalTests::persistTests(bool verbose) {
+    QTemporaryDir directory;
+    QString filename = directory.path() + "/entities.svo";
+    QString journalFilename = filename + ".journal";
+    QString snapshotFilename = filename + ".snapshot";
+
+    EntityTree tree;
+    tree.setIsServer(true);
+    TestPersistThread persistThread(&tree, filename);
+    persistThread.load();
+
+    makeEdits(tree);
+    tree.setDirtyBit();
+    persistThread.save();
+
+    if (!QFile::exists(filename) || QFile::exists(snapshotFilename)) {
+        qDebug() << "FAILED - the snapshot didn't replace the persist file";
+        return;
+    }
+    if (QFileInfo(journalFilename).size() != 0) {
+        qDebug() << "FAILED - the journal kept" << QFileInfo(journalFilename).size() << "bytes the snapshot has";
+        return;
+    }
+
+    // then more edits, and we crash before the next snapshot
+    createEntity(tree, glm::vec3(1.0f, 6.0f, 1.0f));
+    eraseEntity(tree, getEntityPositions(tree).keys().first());
+    tree.setEditJournal(NULL);
+
+    {
+        EntityTree loadedTree;
+        loadedTree.setIsServer(true);
+        TestPersistThread loadThread(&loadedTree, filename);
+        loadThread.load();
+        loadedTree.setEditJournal(NULL);
+
+        if (compareEntityPositions(loadedTree, tree, verbose)) {
+            qDebug() << "PASSED - loading the persist file and replaying the journal recreated the tree";
+        } else {
+            qDebug() << "FAILED - loading the persist file and replaying the journal didn't recreate the tree";
+        }
+    }
+
+    // as if we crashed after removing the persist file, but before the snapshot took its place
+    QFile::rename(filename, snapshotFilename);
+    {
+        EntityTree loadedTree;
+        loadedTree.setIsServer(true);
+        TestPersistThread loadThread(&loadedTree, filename);
+        loadThread.load();
+        loadedTree.setEditJournal(NULL);
+
+        if (!QFile::exists(filename) || QFile::exists(snapshotFilename)) {
+            qDebug() << "FAILED - the snapshot left without a persist file didn't become the persist file";
+        } else if (!compareEntityPositions(loadedTree, tree, verbose)) {
+            qDebug() << "FAILED - loading the snapshot left without a persist file didn't recreate the tree";
+        } else {
+            qDebug() << "PASSED - a snapshot left without a persist file is loaded in its place";
+        }
+    }
+}
+
+void EditJournalTests::runAllTests(bool verbose) {
+    replayTests(verbose);
+    partialRecordTests(verbose);
+    discardFirstBytesTests(verbose);
+    persistTests(verbose);
+}
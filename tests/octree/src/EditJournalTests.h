@@ -0,0 +1,25 @@
+//
+//  EditJournalTests.h
+//  tests/octree/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_EditJournalTests_h
+#define hifi_EditJournalTests_h
+
+namespace EditJournalTests {
+
+    void runAllTests(bool verbose = false);
+
+    void replayTests(bool verbose = false);
+    void partialRecordTests(bool verbose = false);
+    void discardFirstBytesTests(bool verbose = false);
+    void persistTests(bool verbose = false);
+}
+
+#endif // hifi_EditJournalTests_h
@@ -0,0 +1,305 @@
+//
+//  EntitySimulationTests.cpp
+//  tests/octree/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <QDebug>
+
+#include <BoxEntityItem.h>
+#include <EntityCollisionGrid.h>
+#include <EntityItemProperties.h>
+#include <EntityTree.h>
+#include <SharedUtil.h>
+#include <SimpleEntitySimulation.h>
+
+#include "EntitySimulationTests.h"
+
+static EntityItem* createMortalEntity(quint64 created, float lifetime) {
+    EntityItemProperties properties;
+    properties.setCreated(created);
+
+    EntityItem* entity = new BoxEntityItem(EntityItemID(QUuid::createUuid()), properties);
+    entity->setLifetime(lifetime);
+    return entity;
+}
+
+// how EntitySimulation used to find expired entities, a scan of every mortal entity whenever one was due to expire
+static void legacyExpireMortalEntities(QSet<EntityItem*>& mortalEntities, quint64& nextExpiry, const quint64& now,
+                                       QSet<EntityItem*>& entitiesToDelete) {
+    if (now > nextExpiry) {
+        nextExpiry = quint64(-1);
+        QSet<EntityItem*>::iterator itemItr = mortalEntities.begin();
+        while (itemItr != mortalEntities.end()) {
+            EntityItem* entity = *itemItr;
+            quint64 expiry = entity->getExpiry();
+            if (expiry < now) {
+                entitiesToDelete.insert(entity);
+                itemItr = mortalEntities.erase(itemItr);
+            } else {
+                if (expiry < nextExpiry) {
+                    nextExpiry = expiry;
+                }
+                ++itemItr;
+            }
+        }
+    }
+}
+
+void EntitySimulationTests::expiryTests(bool verbose) {
+    const int NUM_ENTITIES = 1000;
+    const float EXPIRED_LIFETIME = 5.0f;
+    const float LONG_LIFETIME = 3600.0f;
+
+    EntityTree tree;
+    SimpleEntitySimulation simulation;
+    simulation.setEntityTree(&tree);
+
+    // everything was created ten seconds ago, so the even entities have already expired
+    quint64 created = usecTimestampNow() - 10 * USECS_PER_SECOND;
+    QVector<EntityItem*> entities;
+    QSet<EntityItem*> expectedToExpire;
+
+    for (int i = 0; i < NUM_ENTITIES; i++) {
+        EntityItem* entity = createMortalEntity(created, (i % 2 == 0) ? EXPIRED_LIFETIME : LONG_LIFETIME);
+        entities.append(entity);
+        simulation.addEntity(entity);
+    }
+
+    for (int i = 0; i < NUM_ENTITIES; i++) {
+        EntityItem* entity = entities[i];
+
+        if (i % 10 == 0) {
+            // an expired entity whose lifetime was extended
+            entity->updateLifetime(LONG_LIFETIME);
+            simulation.entityChanged(entity);
+        } else if (i % 10 == 1) {
+            // a long lived entity whose lifetime was cut short
+            entity->updateLifetime(1.0f);
+            simulation.entityChanged(entity);
+            expectedToExpire.insert(entity);
+        } else if (i % 10 == 2) {
+            // an expired entity that left the simulation
+            simulation.removeEntity(entity);
+        } else if (i % 10 == 3) {
+            // a long lived entity that became immortal
+            entity->updateLifetime(ENTITY_ITEM_IMMORTAL_LIFETIME);
+            simulation.entityChanged(entity);
+        } else if (i % 2 == 0) {
+            expectedToExpire.insert(entity);
+        }
+    }
+
+    QSet<EntityItem*> entitiesToDelete;
+    simulation.updateEntities(entitiesToDelete);
+
+    if (entitiesToDelete == expectedToExpire) {
+        qDebug() << "PASSED - expired" << entitiesToDelete.size() << "of" << NUM_ENTITIES << "mortal entities";
+    } else {
+        qDebug() << "FAILED - expired" << entitiesToDelete.size() << "entities, expected" << expectedToExpire.size();
+        if (verbose) {
+            foreach (EntityItem* entity, entitiesToDelete - expectedToExpire) {
+                qDebug() << "    unexpectedly expired:" << entity->getEntityItemID();
+            }
+            foreach (EntityItem* entity, expectedToExpire - entitiesToDelete) {
+                qDebug() << "    did not expire:" << entity->getEntityItemID();
+            }
+        }
+    }
+
+    // nothing else should expire on the next update
+    entitiesToDelete.clear();
+    simulation.updateEntities(entitiesToDelete);
+    if (!entitiesToDelete.isEmpty()) {
+        qDebug() << "FAILED -" << entitiesToDelete.size() << "entities expired twice or early";
+    }
+
+    simulation.clearEntities();
+    simulation.setEntityTree(NULL);
+    qDeleteAll(entities);
+}
+
+void EntitySimulationTests::expiryBenchmark(bool verbose) {
+    const int NUM_ENTITIES = 100000;
+    const int NUM_SHORT_LIVED_ENTITIES = NUM_ENTITIES / 100;
+    const float SHORT_LIFETIME_SPREAD = 0.1f;
+    const float LONG_LIFETIME = 3600.0f;
+    const quint64 BENCHMARK_USECS = 200 * USECS_PER_MSEC;
+
+    // a handful of the entities expire over the first tenth of a second, the rest live for an hour
+    float shortLifetimeStep = SHORT_LIFETIME_SPREAD / NUM_SHORT_LIVED_ENTITIES;
+
+    // first the full scans EntitySimulation used to do
+    QVector<EntityItem*> legacyEntities;
+    QSet<EntityItem*> legacyMortalEntities;
+    QSet<EntityItem*> legacyEntitiesToDelete;
+    quint64 legacyNextExpiry = 0;
+
+    quint64 created = usecTimestampNow();
+    for (int i = 0; i < NUM_ENTITIES; i++) {
+        float lifetime = (i % 100 == 0) ? (i / 100) * shortLifetimeStep : LONG_LIFETIME;
+        EntityItem* entity = createMortalEntity(created, lifetime);
+        legacyEntities.append(entity);
+        legacyMortalEntities.insert(entity);
+    }
+
+    int legacyTicks = 0;
+    quint64 legacyUsecs = 0;
+    quint64 now = usecTimestampNow();
+    while (now - created < BENCHMARK_USECS) {
+        legacyExpireMortalEntities(legacyMortalEntities, legacyNextExpiry, now, legacyEntitiesToDelete);
+        legacyTicks++;
+
+        quint64 tickEnd = usecTimestampNow();
+        legacyUsecs += tickEnd - now;
+        now = tickEnd;
+    }
+    qDeleteAll(legacyEntities);
+
+    // then the expiry queue
+    EntityTree tree;
+    SimpleEntitySimulation simulation;
+    simulation.setEntityTree(&tree);
+    QVector<EntityItem*> entities;
+    QSet<EntityItem*> entitiesToDelete;
+
+    created = usecTimestampNow();
+    for (int i = 0; i < NUM_ENTITIES; i++) {
+        float lifetime = (i % 100 == 0) ? (i / 100) * shortLifetimeStep : LONG_LIFETIME;
+        EntityItem* entity = createMortalEntity(created, lifetime);
+        entities.append(entity);
+        simulation.addEntity(entity);
+    }
+    quint64 addUsecs = usecTimestampNow() - created;
+
+    int ticks = 0;
+    quint64 usecs = 0;
+    now = usecTimestampNow();
+    while (now - created < BENCHMARK_USECS) {
+        simulation.updateEntities(entitiesToDelete);
+        ticks++;
+
+        quint64 tickEnd = usecTimestampNow();
+        usecs += tickEnd - now;
+        now = tickEnd;
+    }
+
+    if (entitiesToDelete.size() == NUM_SHORT_LIVED_ENTITIES) {
+        qDebug() << "PASSED - expired all" << NUM_SHORT_LIVED_ENTITIES << "short lived entities";
+    } else {
+        qDebug() << "FAILED - expired" << entitiesToDelete.size() << "entities, expected" << NUM_SHORT_LIVED_ENTITIES;
+    }
+
+    simulation.clearEntities();
+    simulation.setEntityTree(NULL);
+    qDeleteAll(entities);
+
+    qDebug() << "TIME - expiring" << NUM_SHORT_LIVED_ENTITIES << "of" << NUM_ENTITIES << "mortal entities over"
+        << BENCHMARK_USECS / USECS_PER_MSEC << "msecs";
+    qDebug() << "    full scans:" << legacyTicks << "ticks," << (float)legacyUsecs / legacyTicks << "usecs per tick";
+    qDebug() << "    expiry queue:" << ticks << "ticks," << (float)usecs / ticks << "usecs per tick";
+    if (verbose) {
+        qDebug() << "    adding entities to the simulation:" << addUsecs << "usecs";
+    }
+}
+
+static bool boundingSpheresOverlap(EntityItem* entityA, EntityItem* entityB) {
+    const Shape& shapeA = entityA->getCollisionShapeInMeters();
+    const Shape& shapeB = entityB->getCollisionShapeInMeters();
+    float totalRadius = shapeA.getBoundingRadius() + shapeB.getBoundingRadius();
+    return glm::distance(shapeA.getTranslation(), shapeB.getTranslation()) <= totalRadius;
+}
+
+// every pair of entities whose bounding spheres overlap should be found by the grid, and no entity listed twice
+static int checkCollisionGrid(const EntityCollisionGrid& grid, const QVector<EntityItem*>& entities, bool verbose) {
+    int failures = 0;
+    QVector<EntityItem*> nearbyEntities;
+    foreach (EntityItem* entity, entities) {
+        nearbyEntities.clear();
+        grid.findNearbyEntities(entity, nearbyEntities);
+
+        QSet<EntityItem*> nearbySet = nearbyEntities.toList().toSet();
+        if (nearbySet.size() != nearbyEntities.size() || nearbySet.contains(entity)) {
+            failures++;
+            if (verbose) {
+                qDebug() << "    duplicate or self in nearby entities of" << entity->getEntityItemID();
+            }
+        }
+        foreach (EntityItem* otherEntity, entities) {
+            if (otherEntity != entity && grid.contains(otherEntity) && boundingSpheresOverlap(entity, otherEntity)
+                    && !nearbySet.contains(otherEntity)) {
+                failures++;
+                if (verbose) {
+                    qDebug() << "    missed" << otherEntity->getEntityItemID() << "near" << entity->getEntityItemID();
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+void EntitySimulationTests::collisionGridTests(bool verbose) {
+    const int NUM_ENTITIES = 500;
+    const int NUM_MOVES = 10;
+    const float REGION_SIZE = 64.0f; // meters
+    const float MAX_STEP = 3.0f; // meters
+    const glm::vec3 REGION_CORNER = glm::vec3(0.5f) - glm::vec3(0.5f * REGION_SIZE / (float)TREE_SCALE);
+
+    EntityCollisionGrid grid;
+    QVector<EntityItem*> entities;
+
+    for (int i = 0; i < NUM_ENTITIES; i++) {
+        EntityItem* entity = new BoxEntityItem(EntityItemID(QUuid::createUuid()), EntityItemProperties());
+        entity->setPosition(REGION_CORNER + glm::vec3(randFloat(), randFloat(), randFloat()) *
+            (REGION_SIZE / (float)TREE_SCALE));
+        entity->setDimensionsInMeters(glm::vec3(randFloatInRange(0.2f, 2.0f)));
+        entities.append(entity);
+        grid.updateEntity(entity);
+    }
+
+    // one entity too big to bin, and one that doesn't collide
+    entities[0]->setDimensionsInMeters(glm::vec3(REGION_SIZE));
+    grid.updateEntity(entities[0]);
+    entities[1]->setIgnoreForCollisions(true);
+    grid.updateEntity(entities[1]);
+
+    int failures = checkCollisionGrid(grid, entities, verbose);
+    if (grid.contains(entities[1]) || grid.size() != NUM_ENTITIES - 1) {
+        failures++;
+        if (verbose) {
+            qDebug() << "    grid holds" << grid.size() << "entities, expected" << NUM_ENTITIES - 1;
+        }
+    }
+
+    // move half of the entities around, removing a few along the way
+    for (int move = 0; move < NUM_MOVES; move++) {
+        for (int i = 2; i < entities.size(); i += 2) {
+            glm::vec3 step = glm::vec3(randFloatInRange(-MAX_STEP, MAX_STEP), randFloatInRange(-MAX_STEP, MAX_STEP),
+                randFloatInRange(-MAX_STEP, MAX_STEP));
+            entities[i]->setPosition(entities[i]->getPosition() + step / (float)TREE_SCALE);
+            grid.updateEntity(entities[i]);
+        }
+        grid.removeEntity(entities[entities.size() - 1 - move]);
+        failures += checkCollisionGrid(grid, entities, verbose);
+    }
+
+    if (failures == 0) {
+        qDebug() << "PASSED - collision grid found every overlapping pair of" << NUM_ENTITIES << "entities";
+    } else {
+        qDebug() << "FAILED - collision grid had" << failures << "failures";
+    }
+
+    grid.clear();
+    qDeleteAll(entities);
+}
+
+void EntitySimulationTests::runAllTests(bool verbose) {
+    expiryTests(verbose);
+    expiryBenchmark(verbose);
+    collisionGridTests(verbose);
+}
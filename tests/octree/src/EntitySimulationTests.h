@@ -0,0 +1,24 @@
+//
+//  EntitySimulationTests.h
+//  tests/octree/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_EntitySimulationTests_h
+#define hifi_EntitySimulationTests_h
+
+namespace EntitySimulationTests {
+
+    void runAllTests(bool verbose = false);
+
+    void expiryTests(bool verbose = false);
+    void expiryBenchmark(bool verbose = false);
+    void collisionGridTests(bool verbose = false);
+}
+
+#endif // hifi_EntitySimulationTests_h
@@ -511,14 +511,142 @@ void EntityTests::entityTreeTests(bool verbose) {
                         << "elapsed Find=" << elapsedInMSecsFind << "msecs";
     }
 
+    {
+        testsTaken++;
+        QString testName = "merge edits to the same entity";
+        if (verbose) {
+            qDebug() << "Test" << testsTaken <<":" << qPrintable(testName);
+        }
+
+        EntityItemProperties firstEdit;
+        firstEdit.setPosition(positionNearOriginInMeters);
+        firstEdit.setVisible(false);
+        EntityItemProperties secondEdit;
+        secondEdit.setPosition(positionAtCenterInMeters);
+        secondEdit.setLifetime(oneMeter);
+
+        // the later position wins, and what only one of the edits changed is kept
+        firstEdit.merge(secondEdit);
+        bool passed = firstEdit.getPosition() == positionAtCenterInMeters && firstEdit.visibleChanged() &&
+            !firstEdit.getVisible() && firstEdit.lifetimeChanged() && !firstEdit.dimensionsChanged();
+        if (passed) {
+            testsPassed++;
+        } else {
+            testsFailed++;
+            qDebug() << "FAILED - Test" << testsTaken <<":" << qPrintable(testName);
+        }
+    }
+
+    {
+        testsTaken++;
+        QString testName = "send clients that have an entity only what changed";
+        if (verbose) {
+            qDebug() << "Test" << testsTaken <<":" << qPrintable(testName);
+        }
+
+        EntityTree deltaTree;
+        EntityItemID deltaEntityID(QUuid::createUuid());
+        deltaEntityID.isKnownID = false;
+        EntityItem* entity = deltaTree.addEntity(deltaEntityID, properties);
+        entity->markAsChangedOnServer();
+
+        // the client's last scene started after the entity was created, and only its position changed since
+        OctreeSentItems sentItems;
+        EncodeBitstreamParams params;
+        params.forceSendScene = false;
+        params.sentItems = &sentItems;
+        params.lastViewFrustumSent = entity->getLastChangedOnServer() + 1;
+        while (usecTimestampNow() < params.lastViewFrustumSent) { }
+        entity->markAsChangedOnServer(EntityPropertyFlags(PROP_POSITION));
+
+        EntityPropertyFlags newToClient = entity->getPropertiesToSend(params);
+        sentItems.insert(entity->getID());
+        EntityPropertyFlags hadEntity = entity->getPropertiesToSend(params);
+
+        bool newToClientGetsAll = newToClient.getHasProperty(PROP_POSITION) && newToClient.getHasProperty(PROP_SCRIPT);
+        bool hadGetsChanges = hadEntity.getHasProperty(PROP_POSITION) && !hadEntity.getHasProperty(PROP_ROTATION) &&
+            !hadEntity.getHasProperty(PROP_SCRIPT);
+
+        bool passed = newToClientGetsAll && hadGetsChanges;
+        if (passed) {
+            testsPassed++;
+        } else {
+            testsFailed++;
+            qDebug() << "FAILED - Test" << testsTaken <<":" << qPrintable(testName);
+        }
+    }
+
     qDebug() << "   tests passed:" << testsPassed << "out of" << testsTaken;
     if (verbose) {
         qDebug() << "******************************************************************************************";
     }
 }
 
+void EntityTests::entityTreeEncodeBenchmark(bool verbose) {
+    const int BENCHMARK_ENTITIES = 50000;
+    const int BENCHMARK_CLIENTS = 16;
+    const int BENCHMARK_SCENES = 2;
+
+    if (verbose) {
+        qDebug() << "******************************************************************************************";
+    }
+
+    qDebug() << "EntityTests::entityTreeEncodeBenchmark()";
+
+    EntityTree tree;
+    EntityItemProperties properties;
+    for (int i = 0; i < BENCHMARK_ENTITIES; i++) {
+        EntityItemID entityID(QUuid::createUuid());
+        entityID.isKnownID = false; // this is a temporary workaround to allow local tree entities to be added with known IDs
+        properties.setPosition(glm::vec3(randFloatInRange(1.0f, (float)TREE_SCALE - 1.0f),
+                                         randFloatInRange(1.0f, (float)TREE_SCALE - 1.0f),
+                                         randFloatInRange(1.0f, (float)TREE_SCALE - 1.0f)));
+        tree.addEntity(entityID, properties);
+    }
+
+    // every client keeps its encode data from scene to scene, like OctreeQueryNode does
+    OctreeElementExtraEncodeData extraEncodeData[BENCHMARK_CLIENTS];
+    OctreePacketData packetData;
+    int packets = 0;
+
+    quint64 start = usecTimestampNow();
+    for (int scene = 0; scene < BENCHMARK_SCENES; scene++) {
+        for (int client = 0; client < BENCHMARK_CLIENTS; client++) {
+            OctreeElementBag elementBag;
+            elementBag.insert(tree.getRoot());
+            while (!elementBag.isEmpty()) {
+                OctreeElement* subTree = elementBag.extract();
+                EncodeBitstreamParams params(INT_MAX, IGNORE_VIEW_FRUSTUM, WANT_COLOR, NO_EXISTS_BITS);
+                params.extraEncodeData = &extraEncodeData[client];
+                int bytesWritten = tree.encodeTreeBitstream(subTree, &packetData, elementBag, params);
+
+                // a full packet is sent, and the element goes back in the bag for the next one
+                if (bytesWritten == 0 && params.stopReason == EncodeBitstreamParams::DIDNT_FIT) {
+                    packetData.reset();
+                    elementBag.insert(subTree);
+                    packets++;
+                }
+            }
+            packetData.reset();
+            packets++;
+            tree.releaseSceneEncodeData(&extraEncodeData[client]);
+        }
+    }
+    quint64 end = usecTimestampNow();
+
+    float elapsedInMSecs = (float)(end - start) / (float)USECS_PER_MSEC;
+    qDebug() << "TIME - encode" << BENCHMARK_ENTITIES << "entities for" << BENCHMARK_CLIENTS << "clients,"
+        << BENCHMARK_SCENES << "scenes each:" << "packets=" << packets << "elapsed=" << elapsedInMSecs << "msecs"
+        << "per scene=" << (elapsedInMSecs / (BENCHMARK_CLIENTS * BENCHMARK_SCENES)) << "msecs";
+
+    if (verbose) {
+        qDebug() << "******************************************************************************************";
+    }
+}
+
 
 void EntityTests::runAllTests(bool verbose) {
     entityTreeTests(verbose);
+    entityTreeEncodeBenchmark(verbose);
 }
 
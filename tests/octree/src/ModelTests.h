@@ -14,6 +14,7 @@
 
 namespace EntityTests {
     void entityTreeTests(bool verbose = false);
+    void entityTreeEncodeBenchmark(bool verbose = false);
     void runAllTests(bool verbose = false);
 }
 
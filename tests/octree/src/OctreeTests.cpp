@@ -1437,10 +1437,192 @@ void OctreeTests::modelItemTests(bool verbose) {
 #endif 
 }
 
+static bool countElementOperation(OctreeElement* element, void* extraData) {
+    (*static_cast<int*>(extraData))++;
+    return true; // keep going
+}
+
+void OctreeTests::childLayoutBenchmark(bool verbose) {
+    const int BENCHMARK_ENTITIES = 50000;
+    const int BENCHMARK_WALKS = 20;
+    const int BENCHMARK_SCENES = 4;
+
+    if (verbose) {
+        qDebug() << "******************************************************************************************";
+    }
+
+    qDebug() << "OctreeTests::childLayoutBenchmark()";
+
+    // both layouts get the same tree
+    QVector<glm::vec3> positions;
+    for (int i = 0; i < BENCHMARK_ENTITIES; i++) {
+        positions << glm::vec3(randFloatInRange(1.0f, (float)TREE_SCALE - 1.0f),
+                               randFloatInRange(1.0f, (float)TREE_SCALE - 1.0f),
+                               randFloatInRange(1.0f, (float)TREE_SCALE - 1.0f));
+    }
+
+    bool wasLinearChildren = OctreeElement::getLinearChildren();
+    int elementCounts[2];
+    int bytesEncoded[2];
+
+    for (int layout = 0; layout < 2; layout++) {
+        bool linearChildren = (layout == 1);
+        OctreeElement::setLinearChildren(linearChildren);
+        const char* layoutName = linearChildren ? "linear children" : "external children";
+
+        // the root is made by the tree, so it has to be made after the layout is picked
+        EntityTree tree;
+        EntityItemProperties properties;
+
+        quint64 start = usecTimestampNow();
+        foreach (const glm::vec3& position, positions) {
+            EntityItemID entityID(QUuid::createUuid());
+            entityID.isKnownID = false; // this is a temporary workaround to allow local tree entities to be added with known IDs
+            properties.setPosition(position);
+            tree.addEntity(entityID, properties);
+        }
+        quint64 end = usecTimestampNow();
+        qDebug() << "TIME -" << layoutName << "- add" << BENCHMARK_ENTITIES << "entities elapsed="
+            << ((float)(end - start) / (float)USECS_PER_MSEC) << "msecs";
+
+        start = usecTimestampNow();
+        for (int walk = 0; walk < BENCHMARK_WALKS; walk++) {
+            elementCounts[layout] = 0;
+            tree.recurseTreeWithOperation(countElementOperation, &elementCounts[layout]);
+        }
+        end = usecTimestampNow();
+        qDebug() << "TIME -" << layoutName << "- walk" << elementCounts[layout] << "elements" << BENCHMARK_WALKS
+            << "times elapsed=" << ((float)(end - start) / (float)USECS_PER_MSEC) << "msecs";
+
+        OctreeElementExtraEncodeData extraEncodeData;
+        OctreePacketData packetData;
+        start = usecTimestampNow();
+        for (int scene = 0; scene < BENCHMARK_SCENES; scene++) {
+            bytesEncoded[layout] = 0;
+            OctreeElementBag elementBag;
+            elementBag.insert(tree.getRoot());
+            while (!elementBag.isEmpty()) {
+                OctreeElement* subTree = elementBag.extract();
+                EncodeBitstreamParams params(INT_MAX, IGNORE_VIEW_FRUSTUM, WANT_COLOR, NO_EXISTS_BITS);
+                params.extraEncodeData = &extraEncodeData;
+                int bytesWritten = tree.encodeTreeBitstream(subTree, &packetData, elementBag, params);
+                bytesEncoded[layout] += bytesWritten;
+                if (bytesWritten == 0 && params.stopReason == EncodeBitstreamParams::DIDNT_FIT) {
+                    packetData.reset();
+                    elementBag.insert(subTree);
+                }
+            }
+            packetData.reset();
+            tree.releaseSceneEncodeData(&extraEncodeData);
+        }
+        end = usecTimestampNow();
+        qDebug() << "TIME -" << layoutName << "- encode" << BENCHMARK_SCENES << "scenes of" << bytesEncoded[layout]
+            << "bytes elapsed=" << ((float)(end - start) / (float)USECS_PER_MSEC) << "msecs";
+    }
+    OctreeElement::setLinearChildren(wasLinearChildren);
+
+    if (elementCounts[0] != elementCounts[1]) {
+        qDebug() << "FAILED - the layouts built different trees:" << elementCounts[0] << "and" << elementCounts[1]
+            << "elements";
+    }
+
+    // the linear tree is gone, so all but the one slab kept for the next tree should have gone back to the heap
+    if (OctreeElement::getChildBlockSlabCount() > 1) {
+        qDebug() << "FAILED -" << OctreeElement::getChildBlockSlabCount() << "child block slabs kept after the tree went";
+    }
+
+    if (verbose) {
+        qDebug() << "******************************************************************************************";
+    }
+}
+
+void OctreeTests::viewFrustumTests(bool verbose) {
+    const int TEST_CUBES = 1000;
+    int testsTaken = 0;
+    int testsPassed = 0;
+    int testsFailed = 0;
+
+    if (verbose) {
+        qDebug() << "******************************************************************************************";
+    }
+
+    qDebug() << "OctreeTests::viewFrustumTests()";
+
+    ViewFrustum viewFrustum;
+    viewFrustum.setPosition(glm::vec3(TREE_SCALE * 0.5f, TREE_SCALE * 0.5f, TREE_SCALE * 0.5f));
+    viewFrustum.setOrientation(glm::quat(glm::vec3(0.1f, 0.7f, 0.0f)));
+    viewFrustum.setFieldOfView(60.0f);
+    viewFrustum.setAspectRatio(16.0f / 9.0f);
+    viewFrustum.setNearClip(0.1f);
+    viewFrustum.setFarClip(TREE_SCALE);
+
+    // without a keyhole, and with one big enough to take in whole cubes and cut through others
+    const float KEYHOLE_RADII[] = { -1.0f, TREE_SCALE * 0.1f };
+    for (int keyhole = 0; keyhole < 2; keyhole++) {
+        viewFrustum.setKeyholeRadius(KEYHOLE_RADII[keyhole]);
+        viewFrustum.calculate();
+
+        testsTaken++;
+        QString testName = QString("children classified at once match one at a time, keyhole radius %1")
+            .arg(KEYHOLE_RADII[keyhole]);
+        if (verbose) {
+            qDebug() << "Test" << testsTaken <<":" << qPrintable(testName);
+        }
+
+        int mismatches = 0;
+        int keyholeInsides = 0;
+        for (int i = 0; i < TEST_CUBES; i++) {
+            float scale = TREE_SCALE / powf(2.0f, (float)(rand() % 8));
+            glm::vec3 corner(randFloatInRange(0.0f, TREE_SCALE - scale), randFloatInRange(0.0f, TREE_SCALE - scale),
+                             randFloatInRange(0.0f, TREE_SCALE - scale));
+            ViewFrustum::location locations[NUMBER_OF_CHILDREN];
+            float distances[NUMBER_OF_CHILDREN];
+            float furthestDistances[NUMBER_OF_CHILDREN];
+            viewFrustum.childCubesInFrustum(AACube(corner, scale), locations, distances, furthestDistances);
+
+            float childScale = scale * 0.5f;
+            for (int child = 0; child < NUMBER_OF_CHILDREN; child++) {
+                glm::vec3 childCorner = corner + childScale *
+                    glm::vec3((float)((child >> 2) & 1), (float)((child >> 1) & 1), (float)(child & 1));
+                AACube childCube(childCorner, childScale);
+                float distance = viewFrustum.distanceToCamera(childCube.calcCenter());
+                glm::vec3 furthestPoint;
+                viewFrustum.getFurthestPointFromCamera(childCube, furthestPoint);
+                float furthestDistance = viewFrustum.distanceToCamera(furthestPoint);
+                if (locations[child] != viewFrustum.cubeInFrustum(childCube) ||
+                        fabsf(distances[child] - distance) > distance * 0.0001f ||
+                        fabsf(furthestDistances[child] - furthestDistance) > furthestDistance * 0.0001f) {
+                    mismatches++;
+                }
+                if (KEYHOLE_RADII[keyhole] > 0.0f && furthestDistance < KEYHOLE_RADII[keyhole]) {
+                    keyholeInsides++;
+                }
+            }
+        }
+
+        // the keyhole case is only tested if some of the cubes were wholly inside it
+        bool passed = (mismatches == 0) && (KEYHOLE_RADII[keyhole] < 0.0f || keyholeInsides > 0);
+        if (passed) {
+            testsPassed++;
+        } else {
+            testsFailed++;
+            qDebug() << "FAILED - Test" << testsTaken <<":" << qPrintable(testName) << "mismatches=" << mismatches
+                << "keyholeInsides=" << keyholeInsides;
+        }
+    }
+
+    qDebug() << "   tests passed:" << testsPassed << "out of" << testsTaken;
+    if (verbose) {
+        qDebug() << "******************************************************************************************";
+    }
+}
+
 
 void OctreeTests::runAllTests(bool verbose) {
     propertyFlagsTests(verbose);
     byteCountCodingTests(verbose);
     modelItemTests(verbose);
+    childLayoutBenchmark(verbose);
+    viewFrustumTests(verbose);
 }
 
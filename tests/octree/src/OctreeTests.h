@@ -17,6 +17,8 @@ namespace OctreeTests {
     void propertyFlagsTests(bool verbose);
     void byteCountCodingTests(bool verbose);
     void modelItemTests(bool verbose);
+    void childLayoutBenchmark(bool verbose);
+    void viewFrustumTests(bool verbose);
 
     void runAllTests(bool verbose); 
 }
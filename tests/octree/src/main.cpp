@@ -9,6 +9,8 @@
 //
 
 #include "AABoxCubeTests.h"
+#include "EditJournalTests.h"
+#include "EntitySimulationTests.h"
 #include "ModelTests.h" // needs to be EntityTests.h soon
 #include "OctreeTests.h"
 #include "SharedUtil.h"
@@ -20,5 +22,7 @@ int main(int argc, const char* argv[]) {
     //OctreeTests::runAllTests(verbose);
     //AABoxCubeTests::runAllTests(verbose);
     EntityTests::runAllTests(verbose);
+    EntitySimulationTests::runAllTests(verbose);
+    EditJournalTests::runAllTests(verbose);
     return 0;
 }
@@ -0,0 +1,140 @@
+//
+//  ScriptEngineTests.cpp
+//  tests/script-engine/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <QDebug>
+#include <QSet>
+#include <QThread>
+#include <QVector>
+
+#include <AvatarData.h>
+#include <EntityItemID.h>
+#include <ScriptEngine.h>
+
+#include "ScriptEngineTests.h"
+
+const int NUM_SCRIPTS = 8;
+const int NUM_FRAMES = 60;
+const int NUM_TOKENS_PER_THREAD = 10000;
+
+// one of several scripts run at once, each on its own thread with its own engine and avatar, the way a script host
+// runs them
+class HostedScriptThread : public QThread {
+public:
+    HostedScriptThread(int index) : _index(index), _position(0.0f) { }
+
+    const glm::vec3& getPosition() const { return _position; }
+
+protected:
+    virtual void run() {
+        // the engine has to be used on the thread that makes it
+        QString scriptContents = QString("var frames = 0;"
+            "Script.update.connect(function(deltaTime) {"
+            "    frames++;"
+            "    Avatar.position = { x: %1, y: frames, z: 0 };"
+            "});").arg(_index);
+        ScriptEngine scriptEngine(scriptContents, QString("hosted%1.js").arg(_index));
+        AvatarData avatar;
+        scriptEngine.setAvatarData(&avatar, "Avatar");
+        scriptEngine.init();
+
+        // not an avatar, so nothing is sent
+        scriptEngine.startRunning();
+        for (int i = 0; i < NUM_FRAMES; i++) {
+            scriptEngine.runFrame();
+        }
+        scriptEngine.finishRunning();
+
+        _position = avatar.getPosition();
+    }
+
+private:
+    int _index;
+    glm::vec3 _position;
+};
+
+class CreatorTokenThread : public QThread {
+public:
+    const QVector<uint32_t>& getTokens() const { return _tokens; }
+
+protected:
+    virtual void run() {
+        for (int i = 0; i < NUM_TOKENS_PER_THREAD; i++) {
+            _tokens.append(EntityItemID::getNextCreatorTokenID());
+        }
+    }
+
+private:
+    QVector<uint32_t> _tokens;
+};
+
+void ScriptEngineTests::hostedScriptsTests() {
+    QVector<HostedScriptThread*> threads;
+    for (int i = 0; i < NUM_SCRIPTS; i++) {
+        threads.append(new HostedScriptThread(i));
+    }
+    foreach (HostedScriptThread* thread, threads) {
+        thread->start();
+    }
+    foreach (HostedScriptThread* thread, threads) {
+        thread->wait();
+    }
+
+    // each script moved only its own avatar, once per frame
+    bool passed = true;
+    for (int i = 0; i < NUM_SCRIPTS; i++) {
+        glm::vec3 expected((float)i, (float)NUM_FRAMES, 0.0f);
+        const glm::vec3& position = threads.at(i)->getPosition();
+        if (position != expected) {
+            qDebug() << "FAILED - script" << i << "left its avatar at" << position.x << position.y << position.z
+                << "expected" << expected.x << expected.y << expected.z;
+            passed = false;
+        }
+    }
+    qDeleteAll(threads);
+
+    if (passed) {
+        qDebug() << "PASSED -" << NUM_SCRIPTS << "scripts run at once each moved their own avatar";
+    }
+}
+
+void ScriptEngineTests::creatorTokenTests() {
+    QVector<CreatorTokenThread*> threads;
+    for (int i = 0; i < NUM_SCRIPTS; i++) {
+        threads.append(new CreatorTokenThread());
+    }
+    foreach (CreatorTokenThread* thread, threads) {
+        thread->start();
+    }
+    foreach (CreatorTokenThread* thread, threads) {
+        thread->wait();
+    }
+
+    // the scripts of a host make entities at once, and no two can get the same token
+    QSet<uint32_t> tokens;
+    foreach (CreatorTokenThread* thread, threads) {
+        foreach (uint32_t token, thread->getTokens()) {
+            tokens.insert(token);
+        }
+    }
+    qDeleteAll(threads);
+
+    if (tokens.size() != NUM_SCRIPTS * NUM_TOKENS_PER_THREAD) {
+        qDebug() << "FAILED - got" << tokens.size() << "distinct creator tokens of"
+            << NUM_SCRIPTS * NUM_TOKENS_PER_THREAD;
+        return;
+    }
+    qDebug() << "PASSED - creator tokens taken from" << NUM_SCRIPTS << "threads at once are all distinct";
+}
+
+void ScriptEngineTests::runAllTests() {
+    hostedScriptsTests();
+    creatorTokenTests();
+}
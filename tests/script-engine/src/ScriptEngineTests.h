@@ -0,0 +1,21 @@
+//
+//  ScriptEngineTests.h
+//  tests/script-engine/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_ScriptEngineTests_h
+#define hifi_ScriptEngineTests_h
+
+namespace ScriptEngineTests {
+    void hostedScriptsTests();
+    void creatorTokenTests();
+    void runAllTests();
+}
+
+#endif // hifi_ScriptEngineTests_h
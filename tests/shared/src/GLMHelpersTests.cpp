@@ -0,0 +1,70 @@
+//
+//  GLMHelpersTests.cpp
+//  tests/shared/src
+//
+//  Created on 3/9/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <iostream>
+#include <stdlib.h>
+
+#include <GLMHelpers.h>
+#include <SharedUtil.h>
+
+#include "GLMHelpersTests.h"
+
+static glm::quat randomRotation() {
+    glm::vec3 axis(randFloatInRange(-1.0f, 1.0f), randFloatInRange(-1.0f, 1.0f), randFloatInRange(-1.0f, 1.0f));
+    if (glm::length(axis) < EPSILON) {
+        axis = glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+    return glm::angleAxis(randFloatInRange(-PI, PI), glm::normalize(axis));
+}
+
+void GLMHelpersTests::testSmallestThreeQuatPacking() {
+    const int NUM_ROTATIONS = 1000;
+    const int BITS_TO_TEST[] = { 6, 9, 12, 16, 20 };
+    const int NUM_BITS_TO_TEST = sizeof(BITS_TO_TEST) / sizeof(BITS_TO_TEST[0]);
+    
+    for (int b = 0; b < NUM_BITS_TO_TEST; b++) {
+        int bitsPerComponent = BITS_TO_TEST[b];
+        
+        // each component is off by at most half a step of its quantization
+        float maxComponentError = 1.0f / sqrtf(2.0f) / ((1 << bitsPerComponent) - 1);
+        float maxError = 0.0f;
+        
+        for (int i = 0; i < NUM_ROTATIONS; i++) {
+            glm::quat rotation = randomRotation();
+            uint64_t packed = packOrientationQuatSmallestThree(rotation, bitsPerComponent);
+            
+            if (packed >> (2 + 3 * bitsPerComponent)) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: packed quat uses more than "
+                    << 2 + 3 * bitsPerComponent << " bits" << std::endl;
+                return;
+            }
+            
+            glm::quat unpacked = unpackOrientationQuatSmallestThree(packed, bitsPerComponent);
+            
+            // q and -q are the same rotation
+            float error = 1.0f - fabsf(glm::dot(rotation, unpacked));
+            maxError = glm::max(maxError, error);
+            
+            if (error > 4.0f * maxComponentError) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: " << bitsPerComponent
+                    << " bit smallest three quat is off by " << error << std::endl;
+                return;
+            }
+        }
+        
+        std::cout << "smallest three quats with " << bitsPerComponent << " bits per component: max error "
+            << maxError << std::endl;
+    }
+}
+
+void GLMHelpersTests::runAllTests() {
+    testSmallestThreeQuatPacking();
+}
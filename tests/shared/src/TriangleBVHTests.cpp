@@ -0,0 +1,119 @@
+//
+//  TriangleBVHTests.cpp
+//  tests/shared/src
+//
+//  Created on 3/13/15.
+//  Copyright 2015 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <limits>
+
+#include <QDebug>
+
+#include <SharedUtil.h>
+#include <TriangleBVH.h>
+
+#include "TriangleBVHTests.h"
+
+static glm::vec3 randVector(float range) {
+    return glm::vec3(randFloatInRange(-range, range), randFloatInRange(-range, range), randFloatInRange(-range, range));
+}
+
+// the nearest hit the way Model used to find it, by testing every triangle
+static bool findNearestTriangle(const QVector<Triangle>& triangles, const glm::vec3& origin, const glm::vec3& direction,
+                                float& distance) {
+    bool intersected = false;
+    foreach (const Triangle& triangle, triangles) {
+        float triangleDistance;
+        if (findRayTriangleIntersection(origin, direction, triangle, triangleDistance) && triangleDistance < distance) {
+            distance = triangleDistance;
+            intersected = true;
+        }
+    }
+    return intersected;
+}
+
+void TriangleBVHTests::runAllTests() {
+    const int NUM_TRIANGLES = 20000;
+    const int NUM_RAYS = 1000;
+    const float SCENE_SIZE = 10.0f;
+    const float TRIANGLE_SIZE = 0.2f;
+    const float DISTANCE_TOLERANCE = 0.0001f;
+
+    QVector<Triangle> triangles;
+    for (int i = 0; i < NUM_TRIANGLES; i++) {
+        glm::vec3 center = randVector(SCENE_SIZE);
+        Triangle triangle = { center + randVector(TRIANGLE_SIZE), center + randVector(TRIANGLE_SIZE),
+            center + randVector(TRIANGLE_SIZE) };
+        triangles.append(triangle);
+    }
+
+    quint64 start = usecTimestampNow();
+    TriangleBVH bvh(triangles);
+    quint64 buildUsecs = usecTimestampNow() - start;
+
+    QVector<glm::vec3> origins, directions;
+    for (int i = 0; i < NUM_RAYS; i++) {
+        // rays from outside the scene toward somewhere inside it, with unnormalized directions
+        origins.append(randVector(2.0f * SCENE_SIZE));
+        directions.append((randVector(SCENE_SIZE) - origins.last()) * randFloatInRange(0.1f, 2.0f));
+    }
+
+    int failures = 0;
+    int hits = 0;
+    quint64 bruteForceUsecs = 0;
+    quint64 bvhUsecs = 0;
+    for (int i = 0; i < NUM_RAYS; i++) {
+        float expectedDistance = std::numeric_limits<float>::max();
+        start = usecTimestampNow();
+        bool expectedHit = findNearestTriangle(triangles, origins.at(i), directions.at(i), expectedDistance);
+        bruteForceUsecs += usecTimestampNow() - start;
+
+        float distance = std::numeric_limits<float>::max();
+        start = usecTimestampNow();
+        bool hit = bvh.findRayIntersection(origins.at(i), directions.at(i), distance);
+        bvhUsecs += usecTimestampNow() - start;
+
+        if (hit != expectedHit || (hit && fabsf(distance - expectedDistance) > DISTANCE_TOLERANCE)) {
+            qDebug() << "FAILED - ray" << i << "hit" << hit << distance << "expected" << expectedHit << expectedDistance;
+            failures++;
+        }
+        if (hit) {
+            hits++;
+
+            // a hit nearer than the start distance is all we should find
+            float nearerDistance = expectedDistance;
+            if (bvh.findRayIntersection(origins.at(i), directions.at(i), nearerDistance)) {
+                qDebug() << "FAILED - ray" << i << "hit beyond its limit";
+                failures++;
+            }
+        }
+    }
+
+    // a triangle wound the other way is only hit when the winding is flipped
+    Triangle facing = { glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(-1.0f, -1.0f, 0.0f), glm::vec3(1.0f, -1.0f, 0.0f) };
+    QVector<Triangle> single;
+    single.append(facing);
+    TriangleBVH singleBVH(single);
+    glm::vec3 origin(0.0f, 0.0f, 1.0f);
+    glm::vec3 direction(0.0f, 0.0f, -1.0f);
+    float forwardDistance = std::numeric_limits<float>::max();
+    float flippedDistance = std::numeric_limits<float>::max();
+    float expectedForwardDistance = std::numeric_limits<float>::max();
+    bool expectedForward = findNearestTriangle(single, origin, direction, expectedForwardDistance);
+    if (singleBVH.findRayIntersection(origin, direction, forwardDistance) != expectedForward ||
+            singleBVH.findRayIntersection(origin, direction, flippedDistance, true) == expectedForward) {
+        qDebug() << "FAILED - flipping the winding didn't flip which side of the triangle is hit";
+        failures++;
+    }
+
+    if (failures == 0) {
+        qDebug() << "PASSED -" << NUM_RAYS << "rays against" << NUM_TRIANGLES << "triangles," << hits << "hits";
+    }
+    qDebug() << "TIME - building the hierarchy:" << buildUsecs << "usecs";
+    qDebug() << "    every triangle:" << (float)bruteForceUsecs / NUM_RAYS << "usecs per ray";
+    qDebug() << "    hierarchy:" << (float)bvhUsecs / NUM_RAYS << "usecs per ray";
+}
@@ -9,13 +9,17 @@
 //
 
 #include "AngularConstraintTests.h"
+#include "GLMHelpersTests.h"
 #include "MovingPercentileTests.h"
 #include "MovingMinMaxAvgTests.h"
+#include "TriangleBVHTests.h"
 
 int main(int argc, char** argv) {
     MovingMinMaxAvgTests::runAllTests();
     MovingPercentileTests::runAllTests();
     AngularConstraintTests::runAllTests();
+    GLMHelpersTests::runAllTests();
+    TriangleBVHTests::runAllTests();
     printf("tests complete, press enter to exit\n");
     getchar();
     return 0;